@@ -17,17 +17,42 @@ RWTexture2D<float4> OutputTexture : register(u0);
 #define A_GPU 1
 #define A_HLSL 1
 #define CAS_BETTER_DIAGONALS 1
+#ifndef CAS_HALF
+#define CAS_HALF 0
+#endif
+#ifndef RADIUS_TEST
+#define RADIUS_TEST 1
+#endif
+#ifndef DEBUG_MODE
+#define DEBUG_MODE 0
+#endif
+#ifndef PERIPHERY_LANCZOS
+#define PERIPHERY_LANCZOS 0
+#endif
+#if CAS_HALF
+#define A_HALF 1
+#define CAS_PACKED_ONLY 1
+#endif
 
 #include "ffx_a.h"
 
+#if CAS_HALF
+AH3 CasLoadH(ASW2 p) {
+	return AH3(InputTexture.Load(int3(ASU2(p) + inputOffset, 0)).rgb);
+}
+
+void CasInputH(inout AH2 r, inout AH2 g, inout AH2 b) {}
+#else
 AF3 CasLoad(ASU2 p) {
 	return InputTexture.Load(int3(p + inputOffset, 0)).rgb;
 }
 
 // for transforming to linear color space, not needed (?)
 void CasInput(inout AF1 r, inout AF1 g, inout AF1 b) {}
+#endif
 
 #include "ffx_cas.h"
+#include "../lanczos/lanczos.h"
 
 #if CAS_SHARPEN_ONLY
 #define WITHOUT_UPSCALE true
@@ -35,17 +60,38 @@ void CasInput(inout AF1 r, inout AF1 g, inout AF1 b) {}
 #define WITHOUT_UPSCALE false
 #endif
 
+#if CAS_HALF
+// filters two 8x8 tiles at once: pos and pos + (8, 0)
+void Cas(int2 pos) {
+	AH2 cR, cG, cB;
+	AH4 c0, c1;
+	CasFilterH(cR, cG, cB, pos, const0, const1, WITHOUT_UPSCALE);
+	CasDepack(c0, c1, cR, cG, cB);
+	OutputTexture[ASU2(pos) + outputOffset] = AF4(AF3(c0.rgb), 1);
+	OutputTexture[ASU2(pos) + ASU2(8, 0) + outputOffset] = AF4(AF3(c1.rgb), 1);
+}
+#else
 void Cas(int2 pos) {
 	AF3 c;
 	CasFilter(c.r, c.g, c.b, pos, const0, const1, WITHOUT_UPSCALE);
 	OutputTexture[ASU2(pos)+outputOffset] = AF4(c, 1);
 }
+#endif
 
 void Bilinear(int2 pos) {
+#if DEBUG_MODE
+	// tint the area outside the radius
+	AF4 mul = AF4(1, 0.6, 0.6, 1);
+#else
 	AF4 mul = AF4(1, 1, 1, 1);
+#endif
+#if PERIPHERY_LANCZOS && !CAS_SHARPEN_ONLY
+	AF3 c = Lanczos2(InputTexture, (float2(pos) + 0.5) * AF2_AU2(const0.xy) + float2(inputOffset));
+#else
 	float2 samplePos = ((float2(pos) + 0.5) * AF2_AU2(const0.xy) + float2(inputOffset)) / float2(inputTextureSize);
 	//float2 samplePos = (float2(pos + outputOffset) + 0.5) / outputTextureSize;
 	AF3 c = InputTexture.SampleLevel(samLinearClamp, samplePos, 0).rgb;
+#endif
 	OutputTexture[ASU2(pos) + outputOffset] = AF4(c, 1) * mul;
 }
 
@@ -53,10 +99,17 @@ void Bilinear(int2 pos) {
 void main(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID) {
 	AU2 gxy = ARmp8x8( LocalThreadId.x ) + AU2(WorkGroupId.x << 4u, WorkGroupId.y << 4u);
 
+#if RADIUS_TEST
 	AU2 groupCentre = AU2((WorkGroupId.x << 4u) + 8u, (WorkGroupId.y << 4u) + 8u);
 	AU2 dc = projCentre - groupCentre;
 	if (dot(dc, dc) <= squaredRadius) {
+#endif
 		// only apply CAS for workgroups inside the configured radius
+#if CAS_HALF
+		Cas(gxy);
+		gxy.y += 8u;
+		Cas(gxy);
+#else
 		Cas(gxy);
 		gxy.x += 8u;
 		Cas(gxy);
@@ -64,6 +117,8 @@ void main(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID
 		Cas(gxy);
 		gxy.x -= 8u;
 		Cas(gxy);
+#endif
+#if RADIUS_TEST
 	}
 	else {
 		// resort to cheaper bilinear sampling
@@ -75,4 +130,5 @@ void main(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID
 		gxy.x -= 8u;
 		Bilinear(gxy);
 	}
+#endif
 }
@@ -19,6 +19,9 @@ namespace vrperfkit {
 		if (s == "cas") {
 			return UpscaleMethod::CAS;
 		}
+		if (s == "lanczos") {
+			return UpscaleMethod::LANCZOS;
+		}
 		LOG_INFO << "Unknown upscaling method " << s << ", defaulting to NIS";
 		return UpscaleMethod::NIS;
 	}
@@ -31,6 +34,59 @@ namespace vrperfkit {
 			return "NIS";
 		case UpscaleMethod::CAS:
 			return "CAS";
+		case UpscaleMethod::LANCZOS:
+			return "Lanczos";
+		}
+
+		return "Unknown";
+	}
+
+	PeripheryFilter PeripheryFilterFromString(std::string s) {
+		std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+		if (s == "bilinear") {
+			return PeripheryFilter::BILINEAR;
+		}
+		if (s == "lanczos") {
+			return PeripheryFilter::LANCZOS;
+		}
+		LOG_INFO << "Unknown periphery filter " << s << ", defaulting to bilinear";
+		return PeripheryFilter::BILINEAR;
+	}
+
+	QualityTier QualityTierFromString(std::string s) {
+		std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+		if (s == "performance") {
+			return QualityTier::PERFORMANCE;
+		}
+		if (s == "balanced") {
+			return QualityTier::BALANCED;
+		}
+		if (s == "quality") {
+			return QualityTier::QUALITY;
+		}
+		LOG_INFO << "Unknown quality tier " << s << ", defaulting to balanced";
+		return QualityTier::BALANCED;
+	}
+
+	std::string QualityTierToString(QualityTier tier) {
+		switch (tier) {
+		case QualityTier::PERFORMANCE:
+			return "performance";
+		case QualityTier::BALANCED:
+			return "balanced";
+		case QualityTier::QUALITY:
+			return "quality";
+		}
+
+		return "Unknown";
+	}
+
+	std::string PeripheryFilterToString(PeripheryFilter filter) {
+		switch (filter) {
+		case PeripheryFilter::BILINEAR:
+			return "bilinear";
+		case PeripheryFilter::LANCZOS:
+			return "lanczos";
 		}
 
 		return "Unknown";
@@ -44,6 +100,9 @@ namespace vrperfkit {
 		if (s == "rdm") {
 			return FixedFoveatedMethod::RDM;
 		}
+		if (s == "checkerboard") {
+			return FixedFoveatedMethod::CHECKERBOARD;
+		}
 		LOG_INFO << "Unknown fixed foveated method " << s << ", defaulting to VRS";
 		return FixedFoveatedMethod::VRS;
 	}
@@ -54,6 +113,36 @@ namespace vrperfkit {
 			return "VRS";
 		case FixedFoveatedMethod::RDM:
 			return "RDM";
+		case FixedFoveatedMethod::CHECKERBOARD:
+			return "Checkerboard";
+		}
+
+		return "Unknown";
+	}
+
+	HiddenMaskMode HiddenMaskModeFromString(std::string s) {
+		std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+		if (s == "radial") {
+			return HiddenMaskMode::RADIAL;
+		}
+		if (s == "mesh") {
+			return HiddenMaskMode::AREA_MESH;
+		}
+		if (s == "both") {
+			return HiddenMaskMode::BOTH;
+		}
+		LOG_INFO << "Unknown hidden mask mode " << s << ", defaulting to radial";
+		return HiddenMaskMode::RADIAL;
+	}
+
+	std::string HiddenMaskModeToString(HiddenMaskMode mode) {
+		switch (mode) {
+		case HiddenMaskMode::RADIAL:
+			return "radial";
+		case HiddenMaskMode::AREA_MESH:
+			return "mesh";
+		case HiddenMaskMode::BOTH:
+			return "both";
 		}
 
 		return "Unknown";
@@ -96,6 +185,32 @@ namespace vrperfkit {
 		return toggle ? "enabled" : "disabled";
 	}
 
+	namespace {
+		void LoadRdmPattern(const YAML::Node &ffrCfg, RdmPattern &pattern) {
+			RdmPattern loaded = pattern;
+			loaded.clusterSize = ffrCfg["rdmClusterSize"].as<uint32_t>(loaded.clusterSize);
+			YAML::Node levels = ffrCfg["rdmLevels"];
+			if (levels.IsSequence()) {
+				loaded.levelCount = (uint32_t)levels.size();
+				try {
+					for (uint32_t i = 0; i < std::min(loaded.levelCount, 3u); ++i) {
+						loaded.levels[i] = RdmLevelFromString(levels[i].as<std::string>());
+					}
+				}
+				catch (const std::runtime_error &e) {
+					LOG_ERROR << e.what() << ", keeping the default RDM levels";
+					return;
+				}
+			}
+			std::string error;
+			if (!IsValidRdmPattern(loaded, error)) {
+				LOG_ERROR << error << ", keeping the default RDM pattern";
+				return;
+			}
+			pattern = loaded;
+		}
+	}
+
 	Config g_config;
 
 	void LoadConfig(const fs::path &configPath) {
@@ -122,6 +237,12 @@ namespace vrperfkit {
 			upscaling.sharpness = std::max(0.f, upscaleCfg["sharpness"].as<float>(upscaling.sharpness));
 			upscaling.radius = std::max(0.f, upscaleCfg["radius"].as<float>(upscaling.radius));
 			upscaling.applyMipBias = upscaleCfg["applyMipBias"].as<bool>(upscaling.applyMipBias);
+			upscaling.halfPrecision = upscaleCfg["halfPrecision"].as<bool>(upscaling.halfPrecision);
+			upscaling.peripheryFilter = PeripheryFilterFromString(upscaleCfg["peripheryFilter"].as<std::string>(PeripheryFilterToString(upscaling.peripheryFilter)));
+			upscaling.nisPerformance = upscaleCfg["nisPerformance"].as<bool>(upscaling.nisPerformance);
+			upscaling.autoSelect = upscaleCfg["autoSelect"].as<bool>(upscaling.autoSelect);
+			upscaling.qualityTier = QualityTierFromString(upscaleCfg["qualityTier"].as<std::string>(QualityTierToString(upscaling.qualityTier)));
+			upscaling.cropToVisible = upscaleCfg["cropToVisible"].as<bool>(upscaling.cropToVisible);
 
 			YAML::Node dxvkCfg = cfg["dxvk"];
 			DxvkConfig &dxvk = g_config.dxvk;
@@ -135,11 +256,20 @@ namespace vrperfkit {
 			ffr.apply = ffr.enabled;
 			ffr.method = FFRMethodFromString(ffrCfg["method"].as<std::string>(FFRMethodToString(ffr.method)));
 			ffr.favorHorizontal = ffrCfg["favorHorizontal"].as<bool>(ffr.favorHorizontal);
+			LoadRdmPattern(ffrCfg, ffr.rdmPattern);
+			ffr.rdmTemporalPhases = ffrCfg["rdmTemporalPhases"].as<uint32_t>(ffr.rdmTemporalPhases);
+			if (!IsValidRdmPhaseCount(ffr.rdmTemporalPhases)) {
+				LOG_ERROR << "RDM temporal phases must be 1, 2 or 4, disabling temporal RDM";
+				ffr.rdmTemporalPhases = 1;
+			}
+			ffr.rdmHistoryWeight = std::min(std::max(0.f, ffrCfg["rdmHistoryWeight"].as<float>(ffr.rdmHistoryWeight)), 0.9f);
+			ffr.checkerboardWholeEye = ffrCfg["checkerboardWholeEye"].as<bool>(ffr.checkerboardWholeEye);
 			ffr.innerRadius = ffrCfg["innerRadius"].as<float>(ffr.innerRadius);
 			ffr.midRadius = ffrCfg["midRadius"].as<float>(ffr.midRadius);
 			ffr.outerRadius = ffrCfg["outerRadius"].as<float>(ffr.outerRadius);
 			ffr.edgeRadius = ffrCfg["edgeRadius"].as<float>(ffr.edgeRadius);
 			ffr.verticalOffset = ffrCfg["verticalOffset"].as<float>(ffr.verticalOffset);
+			ffr.targetSavings = std::min(std::max(0.f, ffrCfg["targetSavings"].as<float>(ffr.targetSavings)), 1.f);
 			ffr.preciseResolution = ffrCfg["preciseResolution"].as<bool>(ffr.preciseResolution);
 			ffr.ignoreFirstTargetRenders = ffrCfg["ignoreFirstTargetRenders"].as<int>(ffr.ignoreFirstTargetRenders);
 			ffr.ignoreLastTargetRenders = ffrCfg["ignoreLastTargetRenders"].as<int>(ffr.ignoreLastTargetRenders);
@@ -162,8 +292,10 @@ namespace vrperfkit {
 			YAML::Node hiddenMaskCfg = cfg["hiddenMask"];
 			HiddenRadialMask &hiddenMask= g_config.hiddenMask;
 			hiddenMask.enabled = hiddenMaskCfg["enabled"].as<bool>(hiddenMask.enabled);
+			hiddenMask.mode = HiddenMaskModeFromString(hiddenMaskCfg["mode"].as<std::string>(HiddenMaskModeToString(hiddenMask.mode)));
 			hiddenMask.edgeRadius = std::max(0.f, hiddenMaskCfg["edgeRadius"].as<float>(hiddenMask.edgeRadius));
 			hiddenMask.maxRadius = hiddenMask.edgeRadius;
+			hiddenMask.targetSavings = std::min(std::max(0.f, hiddenMaskCfg["targetSavings"].as<float>(hiddenMask.targetSavings)), 1.f);
 			hiddenMask.preciseResolution = hiddenMaskCfg["preciseResolution"].as<bool>(hiddenMask.preciseResolution);
 			hiddenMask.ignoreFirstTargetRenders = hiddenMaskCfg["ignoreFirstTargetRenders"].as<int>(hiddenMask.ignoreFirstTargetRenders);
 			hiddenMask.ignoreLastTargetRenders = hiddenMaskCfg["ignoreLastTargetRenders"].as<int>(hiddenMask.ignoreLastTargetRenders);
@@ -187,7 +319,8 @@ namespace vrperfkit {
 			}
 
 			if (g_config.ffr.enabled) {
-				if (g_config.ffr.method == FixedFoveatedMethod::RDM) {
+				// checkerboard rendering draws the RDM mask as well
+				if (g_config.ffr.method != FixedFoveatedMethod::VRS) {
 					g_config.ffr.fastMode = false;
 					g_config.ffrFastModeUsesHRMCount = false;
 					g_config.hiddenMask.enabled = false;
@@ -221,11 +354,20 @@ namespace vrperfkit {
 		LOG_INFO << "  Upscaling is " << PrintToggle(g_config.upscaling.enabled);
 		if (g_config.upscaling.enabled) {
 			LOG_INFO << "    * Method:        " << MethodToString(g_config.upscaling.method);
+			if (g_config.upscaling.autoSelect) {
+				LOG_INFO << "    * Auto select:   " << QualityTierToString(g_config.upscaling.qualityTier) << " quality tier";
+			}
 			LOG_INFO << "    * Render scale:  " << std::setprecision(6) << g_config.upscaling.renderScale * g_config.upscaling.renderScale * 100 << "%";
 			LOG_INFO << "    * Render factor: " << std::setprecision(6) << g_config.upscaling.renderScale;
 			LOG_INFO << "    * Sharpness:     " << std::setprecision(6) << g_config.upscaling.sharpness;
 			LOG_INFO << "    * Radius:        " << std::setprecision(6) << g_config.upscaling.radius;
 			LOG_INFO << "    * MIP bias:      " << PrintToggle(g_config.upscaling.applyMipBias);
+			LOG_INFO << "    * FP16 shaders:  " << PrintToggle(g_config.upscaling.halfPrecision);
+			LOG_INFO << "    * Periphery:     " << PeripheryFilterToString(g_config.upscaling.peripheryFilter);
+			if (g_config.upscaling.method == UpscaleMethod::NIS || g_config.upscaling.autoSelect) {
+				LOG_INFO << "    * NIS 4-tap:     " << PrintToggle(g_config.upscaling.nisPerformance);
+			}
+			LOG_INFO << "    * Crop visible:  " << PrintToggle(g_config.upscaling.cropToVisible);
 		}
 		LOG_INFO << "  Game Mode:         " << GameModeToString(g_config.gameMode);
 		if ((g_config.ffr.enabled && g_config.ffr.dynamic) || (g_config.hiddenMask.enabled && g_config.hiddenMask.dynamic)) {
@@ -239,6 +381,18 @@ namespace vrperfkit {
 			LOG_INFO << "    * Outer radius:  " << std::setprecision(6) << g_config.ffr.outerRadius;
 			if (g_config.ffr.method == FixedFoveatedMethod::RDM) {
 				LOG_INFO << "    * Edge radius:   " << std::setprecision(6) << g_config.ffr.edgeRadius;
+				LOG_INFO << "    * Pattern:       " << RdmPatternToString(g_config.ffr.rdmPattern);
+				if (g_config.ffr.rdmTemporalPhases > 1) {
+					LOG_INFO << "    * Phases:        " << g_config.ffr.rdmTemporalPhases << ", history weight " << std::setprecision(6) << g_config.ffr.rdmHistoryWeight;
+				}
+			}
+			if (g_config.ffr.method == FixedFoveatedMethod::CHECKERBOARD) {
+				LOG_INFO << "    * Edge radius:   " << std::setprecision(6) << g_config.ffr.edgeRadius;
+				LOG_INFO << "    * Whole eye:     " << PrintToggle(g_config.ffr.checkerboardWholeEye);
+				LOG_INFO << "    * History:       " << std::setprecision(6) << g_config.ffr.rdmHistoryWeight;
+			}
+			if (g_config.ffr.targetSavings > 0) {
+				LOG_INFO << "    * Target saving: " << std::setprecision(6) << g_config.ffr.targetSavings * 100 << "%";
 			}
 			LOG_INFO << "    * Precise res:   " << PrintToggle(g_config.ffr.preciseResolution);
 			LOG_INFO << "    * No first rend: " << std::setprecision(6) << g_config.ffr.ignoreFirstTargetRenders;
@@ -270,7 +424,11 @@ namespace vrperfkit {
 
 		LOG_INFO << "  Hidden radial mask is " << PrintToggle(g_config.hiddenMask.enabled);
 		if (g_config.hiddenMask.enabled) {
+			LOG_INFO << "    * Mode:          " << HiddenMaskModeToString(g_config.hiddenMask.mode);
 			LOG_INFO << "    * Edge radius:   " << std::setprecision(6) << g_config.hiddenMask.edgeRadius;
+			if (g_config.hiddenMask.targetSavings > 0) {
+				LOG_INFO << "    * Target saving: " << std::setprecision(6) << g_config.hiddenMask.targetSavings * 100 << "%";
+			}
 			LOG_INFO << "    * Precise res:   " << PrintToggle(g_config.hiddenMask.preciseResolution);
 			LOG_INFO << "    * No first rend: " << std::setprecision(6) << g_config.hiddenMask.ignoreFirstTargetRenders;
 			LOG_INFO << "    * No last rend:  " << std::setprecision(6) << g_config.hiddenMask.ignoreLastTargetRenders;
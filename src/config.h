@@ -1,5 +1,6 @@
 #pragma once
 #include "types.h"
+#include "hrm/radial_density_mask.h"
 
 #include <filesystem>
 
@@ -11,6 +12,12 @@ namespace vrperfkit {
 		float sharpness = 0.30f;
 		float radius = 0.95f;
 		bool applyMipBias = true;
+		bool halfPrecision = false;
+		PeripheryFilter peripheryFilter = PeripheryFilter::BILINEAR;
+		bool nisPerformance = false;
+		bool autoSelect = false;
+		QualityTier qualityTier = QualityTier::BALANCED;
+		bool cropToVisible = false;
 	};
 
 	struct DxvkConfig {
@@ -30,7 +37,13 @@ namespace vrperfkit {
 		float midRadius = 0.65f;
 		float outerRadius = 0.80f;
 		float edgeRadius = 1.15f;
+		float verticalOffset = 0.f;
+		float targetSavings = 0.f;
 		bool favorHorizontal = true;
+		RdmPattern rdmPattern;
+		uint32_t rdmTemporalPhases = 1;
+		float rdmHistoryWeight = 0.5f;
+		bool checkerboardWholeEye = false;
 		std::string overrideSingleEyeOrder;
 		bool fastMode = false;
 		bool dynamic = false;
@@ -50,7 +63,9 @@ namespace vrperfkit {
 
 	struct HiddenRadialMask {
 		bool enabled = false;
+		HiddenMaskMode mode = HiddenMaskMode::RADIAL;
 		float edgeRadius = 1.15f;
+		float targetSavings = 0.f;
 		bool dynamic = false;
 		bool dynamicChangeRadius = false;
 		float targetFrameTime = 0.0167f;
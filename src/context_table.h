@@ -0,0 +1,163 @@
+#pragma once
+#include "snapshot_list.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace vrperfkit {
+	// Maps the D3D11 objects the hooks are called on (contexts, devices) to the object handling
+	// them, for lookups from any thread on every hooked call. The primary entry, usually the
+	// immediate context of the last injector, is checked first with a single load; the others are
+	// searched in an immutable list. Entries change only when injectors are created or destroyed,
+	// which publishes new copies under a lock. Replaced copies are freed by SnapshotList after a grace
+	// period, since a reader may still be in one.
+	//
+	// Aliases cache objects that are resolved through another key, such as deferred contexts through
+	// their device. They may be released while their value lives on, and another object may then get
+	// the same address, so each alias keeps a token of its object:
+	//   Lifetime::Token                                  default constructed for entries that never expire
+	//   static bool IsCurrent(const Token &token)        false once the object was released
+	// Find ignores an alias whose object was released, and the next write drops it.
+	template<typename Value, typename Lifetime>
+	class ContextTable {
+	public:
+		typedef typename Lifetime::Token Token;
+
+		enum class Hit {
+			PRIMARY,
+			FALLBACK,
+			// the key is an alias of a released object
+			STALE,
+			MISS,
+		};
+
+		// at most maxAliases aliases are kept, since every entry is copied into each new list
+		explicit ContextTable(size_t maxAliases) : maxAliases(maxAliases), primary(nullptr), current(Publish(Entries())) {}
+		ContextTable(const ContextTable &) = delete;
+		ContextTable & operator=(const ContextTable &) = delete;
+
+		// the value of key, or nullptr; hit tells where it was found
+		Value * Find(const void *key, Hit *hit = nullptr) const {
+			const Entry *first = primary.load(std::memory_order_acquire);
+			if (first != nullptr && first->key == key) {
+				if (hit != nullptr) *hit = Hit::PRIMARY;
+				return first->value;
+			}
+			for (const Entry &entry : *current.load(std::memory_order_acquire)) {
+				if (entry.key == key) {
+					if (!Lifetime::IsCurrent(entry.token)) {
+						if (hit != nullptr) *hit = Hit::STALE;
+						return nullptr;
+					}
+					if (hit != nullptr) *hit = Hit::FALLBACK;
+					return entry.value;
+				}
+			}
+			if (hit != nullptr) *hit = Hit::MISS;
+			return nullptr;
+		}
+
+		// adds key, or replaces its entry; a primary key is checked before all others
+		void Insert(const void *key, Value *value, bool isPrimary = false) {
+			std::lock_guard<std::mutex> lock (writeMutex);
+			Entries entries = *current.load(std::memory_order_relaxed);
+			DropReleased(entries);
+			auto it = std::find_if(entries.begin(), entries.end(), [&](const Entry &entry) { return entry.key == key; });
+			if (it != entries.end()) {
+				*it = Entry { key, value, Token(), false };
+			} else {
+				entries.push_back(Entry { key, value, Token(), false });
+			}
+			current.store(Publish(std::move(entries)), std::memory_order_release);
+
+			const Entry *first = primary.load(std::memory_order_relaxed);
+			if (isPrimary || (first != nullptr && first->key == key)) {
+				primary.store(primaries.Publish(Entry { key, value, Token(), false }), std::memory_order_release);
+			}
+		}
+
+		// Adds key as an alias with the value of existingKey and returns that value, or nullptr if
+		// existingKey is not in the table. Both happen under the lock, so key never gets the value of
+		// a removed key. Once maxAliases aliases are kept, the value is returned without adding key.
+		Value * Alias(const void *key, const void *existingKey, Token token) {
+			std::lock_guard<std::mutex> lock (writeMutex);
+			Entries entries = *current.load(std::memory_order_relaxed);
+			bool dropped = DropReleased(entries);
+			auto existing = std::find_if(entries.begin(), entries.end(), [&](const Entry &entry) { return entry.key == existingKey; });
+			Value *value = existing != entries.end() ? existing->value : nullptr;
+			auto it = std::find_if(entries.begin(), entries.end(), [&](const Entry &entry) { return entry.key == key; });
+			if (value == nullptr || (it == entries.end() && CountAliases(entries) >= maxAliases)) {
+				if (dropped) {
+					current.store(Publish(std::move(entries)), std::memory_order_release);
+				}
+				return value;
+			}
+			if (it != entries.end()) {
+				*it = Entry { key, value, std::move(token), true };
+			} else {
+				entries.push_back(Entry { key, value, std::move(token), true });
+			}
+			current.store(Publish(std::move(entries)), std::memory_order_release);
+			return value;
+		}
+
+		// removes all keys of value
+		void Remove(const Value *value) {
+			std::lock_guard<std::mutex> lock (writeMutex);
+			Entries entries = *current.load(std::memory_order_relaxed);
+			DropReleased(entries);
+			entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const Entry &entry) { return entry.value == value; }), entries.end());
+			current.store(Publish(std::move(entries)), std::memory_order_release);
+
+			const Entry *first = primary.load(std::memory_order_relaxed);
+			if (first != nullptr && first->value == value) {
+				primary.store(nullptr, std::memory_order_release);
+			}
+		}
+
+		size_t Size() const {
+			return current.load(std::memory_order_acquire)->size();
+		}
+
+		// aliases in the table, including those of released objects that no write has dropped yet
+		size_t Aliases() const {
+			return aliases.load(std::memory_order_acquire);
+		}
+
+	private:
+		struct Entry {
+			const void *key;
+			Value *value;
+			Token token;
+			bool alias;
+		};
+		typedef std::vector<Entry> Entries;
+
+		static size_t CountAliases(const Entries &entries) {
+			return std::count_if(entries.begin(), entries.end(), [](const Entry &entry) { return entry.alias; });
+		}
+
+		// false if all entries are current
+		static bool DropReleased(Entries &entries) {
+			auto end = std::remove_if(entries.begin(), entries.end(), [](const Entry &entry) { return !Lifetime::IsCurrent(entry.token); });
+			bool dropped = end != entries.end();
+			entries.erase(end, entries.end());
+			return dropped;
+		}
+
+		const Entries * Publish(Entries &&entries) {
+			aliases.store(CountAliases(entries), std::memory_order_release);
+			return snapshots.Publish(std::move(entries));
+		}
+
+		SnapshotList<Entry> primaries;
+		SnapshotList<Entries> snapshots;
+		const size_t maxAliases;
+		std::atomic<size_t> aliases { 0 };
+		std::atomic<const Entry*> primary;
+		std::atomic<const Entries*> current;
+		std::mutex writeMutex;
+	};
+}
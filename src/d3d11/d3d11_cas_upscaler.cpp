@@ -28,8 +28,18 @@ namespace vrperfkit {
 		LOG_INFO << "Creating D3D11 resources for CAS upscaling...";
 		device->GetImmediateContext(context.GetAddressOf());
 
-		CheckResult("creating CAS upscale shader", device->CreateComputeShader(g_CASUpscaleShader, sizeof(g_CASUpscaleShader), nullptr, upscaleShader.GetAddressOf()));
-		CheckResult("creating CAS sharpen shader", device->CreateComputeShader(g_CASSharpenShader, sizeof(g_CASSharpenShader), nullptr, sharpenShader.GetAddressOf()));
+		bool halfPrecision = g_config.upscaling.halfPrecision && SupportsHalfPrecisionShaders(device);
+		if (halfPrecision) {
+			LOG_INFO << "Using FP16 CAS shaders";
+		} else if (g_config.upscaling.halfPrecision) {
+			LOG_INFO << "GPU does not support 16-bit shader precision, falling back to FP32 CAS shaders";
+		}
+		// both CAS shaders share the same permutation layout, the upscale shader has an additional periphery filter bit
+		bool peripheryLanczos = g_config.upscaling.peripheryFilter == PeripheryFilter::LANCZOS;
+		sharpenBits = halfPrecision ? g_CASSharpenShader_CAS_HALF : 0;
+		upscaleBits = sharpenBits | (peripheryLanczos ? g_CASUpscaleShader_PERIPHERY_LANCZOS : 0);
+		CreateComputeShaderPermutations(device, "CAS upscale shader", g_CASUpscaleShader, g_CASUpscaleShader_CAS_HALF | g_CASUpscaleShader_PERIPHERY_LANCZOS, upscaleBits, upscaleShaders);
+		CreateComputeShaderPermutations(device, "CAS sharpen shader", g_CASSharpenShader, g_CASSharpenShader_CAS_HALF, sharpenBits, sharpenShaders);
 
 		constantsBuffer = CreateConstantsBuffer(device, sizeof(ShaderConstants));
 		sampler = CreateLinearSampler(device);
@@ -59,7 +69,7 @@ namespace vrperfkit {
 		constants.inputTextureSize[1] = td.Height;
 		constants.outputTextureSize[0] = otd.Width;
 		constants.outputTextureSize[1] = otd.Height;
-		float radius = 0.5f * g_config.upscaling.radius * outputViewport.height;
+		float radius = 0.5f * g_config.upscaling.radius * input.radiusScale * outputViewport.height;
 		constants.projCentre[0] = outputViewport.width * input.projectionCenter.x;
 		constants.projCentre[1] = outputViewport.height * input.projectionCenter.y;
 		constants.squaredRadius = radius * radius;
@@ -67,12 +77,15 @@ namespace vrperfkit {
 		context->UpdateSubresource(constantsBuffer.Get(), 0, nullptr, &constants, 0, 0);
 		context->CSSetConstantBuffers(0, 1, constantsBuffer.GetAddressOf());
 
+		bool radiusTest = NeedsRadiusTest(outputViewport.width, outputViewport.height, constants.projCentre[0], constants.projCentre[1], radius);
+		uint32_t variant = (radiusTest ? g_CASUpscaleShader_RADIUS_TEST : 0)
+			| (g_config.debugMode ? g_CASUpscaleShader_DEBUG_MODE : 0);
 		if (input.inputViewport != outputViewport) {
 			// full upscaling pass
-			context->CSSetShader(upscaleShader.Get(), nullptr, 0);
+			context->CSSetShader(upscaleShaders[upscaleBits | variant].Get(), nullptr, 0);
 		} else {
 			// just sharpening
-			context->CSSetShader(sharpenShader.Get(), nullptr, 0);
+			context->CSSetShader(sharpenShaders[sharpenBits | variant].Get(), nullptr, 0);
 		}
 		context->Dispatch((outputViewport.width + 15) >> 4, (outputViewport.height + 15) >> 4, 1);
 	}
@@ -14,8 +14,11 @@ namespace vrperfkit {
 
 	private:
 		ComPtr<ID3D11DeviceContext> context;
-		ComPtr<ID3D11ComputeShader> upscaleShader;
-		ComPtr<ID3D11ComputeShader> sharpenShader;
+		// permutations: radius test, debug mode, FP16 (+ periphery filter for upscaling)
+		ComPtr<ID3D11ComputeShader> upscaleShaders[16];
+		ComPtr<ID3D11ComputeShader> sharpenShaders[8];
+		uint32_t upscaleBits = 0;
+		uint32_t sharpenBits = 0;
 		ComPtr<ID3D11Buffer> constantsBuffer;
 		ComPtr<ID3D11SamplerState> sampler;
 	};
@@ -30,8 +30,17 @@ namespace vrperfkit {
 
 	D3D11FsrUpscaler::D3D11FsrUpscaler(ID3D11Device *device, uint32_t outputWidth, uint32_t outputHeight, DXGI_FORMAT format) {
 		LOG_INFO << "Creating D3D11 resources for FSR upscaling...";
-		CheckResult("creating FSR upscale shader", device->CreateComputeShader(g_FSRUpscaleShader, sizeof(g_FSRUpscaleShader), nullptr, upscaleShader.GetAddressOf()));
-		CheckResult("creating FSR sharpen shader", device->CreateComputeShader(g_FSRSharpenShader, sizeof(g_FSRSharpenShader), nullptr, sharpenShader.GetAddressOf()));
+		bool halfPrecision = g_config.upscaling.halfPrecision && SupportsHalfPrecisionShaders(device);
+		if (halfPrecision) {
+			LOG_INFO << "Using FP16 FSR shaders";
+		} else if (g_config.upscaling.halfPrecision) {
+			LOG_INFO << "GPU does not support 16-bit shader precision, falling back to FP32 FSR shaders";
+		}
+		bool peripheryLanczos = g_config.upscaling.peripheryFilter == PeripheryFilter::LANCZOS;
+		upscaleBits = (halfPrecision ? g_FSRUpscaleShader_FSR_HALF : 0) | (peripheryLanczos ? g_FSRUpscaleShader_PERIPHERY_LANCZOS : 0);
+		sharpenBits = halfPrecision ? g_FSRSharpenShader_FSR_HALF : 0;
+		CreateComputeShaderPermutations(device, "FSR upscale shader", g_FSRUpscaleShader, g_FSRUpscaleShader_FSR_HALF | g_FSRUpscaleShader_PERIPHERY_LANCZOS, upscaleBits, upscaleShaders);
+		CreateComputeShaderPermutations(device, "FSR sharpen shader", g_FSRSharpenShader, g_FSRSharpenShader_FSR_HALF, sharpenBits, sharpenShaders);
 
 		constantsBuffer = CreateConstantsBuffer(device, max(sizeof(UpscaleShaderConstants), sizeof(SharpenShaderConstants)));
 		upscaledTexture = CreatePostProcessTexture(device, outputWidth, outputHeight, format);
@@ -50,7 +59,9 @@ namespace vrperfkit {
 		ID3D11ShaderResourceView *srvs[1] = {input.inputView};
 		UINT uavCount = -1;
 		ID3D11UnorderedAccessView *uavs[] = {upscaledUav.Get()};
-		float radius = 0.5f * g_config.upscaling.radius * outputViewport.height;
+		float radius = 0.5f * g_config.upscaling.radius * input.radiusScale * outputViewport.height;
+		bool radiusTest = NeedsRadiusTest(outputViewport.width, outputViewport.height,
+			outputViewport.width * input.projectionCenter.x, outputViewport.height * input.projectionCenter.y, radius);
 
 		if (input.inputViewport != outputViewport) {
 			// upscaling pass
@@ -69,7 +80,8 @@ namespace vrperfkit {
 			context->CSSetUnorderedAccessViews(0, 1, uavs, &uavCount);
 			context->CSSetConstantBuffers(0, 1, constantsBuffer.GetAddressOf());
 			context->CSSetShaderResources(0, 1, srvs);
-			context->CSSetShader(upscaleShader.Get(), nullptr, 0);
+			uint32_t upscaleVariant = upscaleBits | (radiusTest ? g_FSRUpscaleShader_RADIUS_TEST : 0);
+			context->CSSetShader(upscaleShaders[upscaleVariant].Get(), nullptr, 0);
 			context->Dispatch((outputViewport.width + 15) >> 4, (outputViewport.height + 15) >> 4, 1);
 			srvs[0] = upscaledView.Get();
 		}
@@ -89,7 +101,10 @@ namespace vrperfkit {
 		context->CSSetUnorderedAccessViews(0, 1, uavs, &uavCount);
 		context->CSSetConstantBuffers(0, 1, constantsBuffer.GetAddressOf());
 		context->CSSetShaderResources(0, 1, srvs);
-		context->CSSetShader(sharpenShader.Get(), nullptr, 0);
+		uint32_t sharpenVariant = sharpenBits
+			| (radiusTest ? g_FSRSharpenShader_RADIUS_TEST : 0)
+			| (g_config.debugMode ? g_FSRSharpenShader_DEBUG_MODE : 0);
+		context->CSSetShader(sharpenShaders[sharpenVariant].Get(), nullptr, 0);
 		context->Dispatch((outputViewport.width + 15) >> 4, (outputViewport.height + 15) >> 4, 1);
 	}
 }
@@ -2,6 +2,8 @@
 
 #include "logging.h"
 
+#include <algorithm>
+#include <d3d11_3.h>
 #include <sstream>
 
 namespace {
@@ -58,6 +60,30 @@ namespace vrperfkit {
 		return sampler;
 	}
 
+	bool SupportsHalfPrecisionShaders(ID3D11Device *device) {
+		D3D11_FEATURE_DATA_SHADER_MIN_PRECISION_SUPPORT support = {};
+		if (FAILED(device->CheckFeatureSupport(D3D11_FEATURE_SHADER_MIN_PRECISION_SUPPORT, &support, sizeof(support)))) {
+			return false;
+		}
+		// compute shaders count as "other" shader stages
+		return (support.AllOtherShaderStagesMinPrecision & D3D11_SHADER_MIN_PRECISION_16_BIT) != 0;
+	}
+
+	bool SupportsRenderTargetArrayIndexFromVertexShader(ID3D11Device *device) {
+		D3D11_FEATURE_DATA_D3D11_OPTIONS3 options = {};
+		if (FAILED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS3, &options, sizeof(options)))) {
+			return false;
+		}
+		return options.VPAndRTArrayIndexFromAnyShaderFeedingRasterizer != FALSE;
+	}
+
+	bool NeedsRadiusTest(uint32_t width, uint32_t height, float centreX, float centreY, float radius) {
+		// distance to the farthest corner
+		float dx = centreX > width - centreX ? centreX : width - centreX;
+		float dy = centreY > height - centreY ? centreY : height - centreY;
+		return dx * dx + dy * dy > radius * radius;
+	}
+
 	DXGI_FORMAT TranslateTypelessFormats(DXGI_FORMAT format) {
 		switch (format) {
 		case DXGI_FORMAT_R32G32B32A32_TYPELESS:
@@ -101,61 +127,380 @@ namespace vrperfkit {
 		}
 	}
 
-	void StoreD3D11State(ID3D11DeviceContext *context, D3D11State &state) {
-		context->VSGetShader(state.vertexShader.ReleaseAndGetAddressOf(), nullptr, nullptr);
-		context->PSGetShader(state.pixelShader.ReleaseAndGetAddressOf(), nullptr, nullptr);
-		context->CSGetShader(state.computeShader.ReleaseAndGetAddressOf(), nullptr, nullptr);
-		context->IAGetInputLayout( state.inputLayout.ReleaseAndGetAddressOf() );
-		context->IAGetPrimitiveTopology( &state.topology );
-		context->IAGetVertexBuffers( 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, state.vertexBuffers, state.strides, state.offsets );
-		context->IAGetIndexBuffer(state.indexBuffer.ReleaseAndGetAddressOf(), &state.format, &state.offset);
-		context->OMGetRenderTargets( D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, state.renderTargets, state.depthStencil.GetAddressOf() );
-		context->RSGetState( state.rasterizerState.ReleaseAndGetAddressOf() );
-		context->OMGetDepthStencilState( state.depthStencilState.ReleaseAndGetAddressOf(), &state.stencilRef );
-		context->RSGetViewports( &state.numViewports, nullptr );
-		context->RSGetViewports( &state.numViewports, state.viewports );
-		context->VSGetConstantBuffers( 0, 1, state.vsConstantBuffer.GetAddressOf() );
-		context->PSGetConstantBuffers( 0, 1, state.psConstantBuffer.GetAddressOf() );
-		context->CSGetConstantBuffers(0, 1, state.csConstantBuffer.GetAddressOf());
-		context->CSGetShaderResources(0, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, state.csShaderResources);
-		context->CSGetUnorderedAccessViews(0, D3D11_1_UAV_SLOT_COUNT, state.csUavs);
+	bool IsFloatFormat(DXGI_FORMAT format) {
+		switch (TranslateTypelessFormats(format)) {
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		case DXGI_FORMAT_R32G32B32_FLOAT:
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R11G11B10_FLOAT:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	namespace {
+		DXGI_FORMAT TypelessGroup(DXGI_FORMAT format) {
+			switch (format) {
+			case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+			case DXGI_FORMAT_R8G8B8A8_UNORM:
+			case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			case DXGI_FORMAT_R8G8B8A8_UINT:
+			case DXGI_FORMAT_R8G8B8A8_SNORM:
+			case DXGI_FORMAT_R8G8B8A8_SINT:
+				return DXGI_FORMAT_R8G8B8A8_TYPELESS;
+			case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+			case DXGI_FORMAT_B8G8R8A8_UNORM:
+			case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+				return DXGI_FORMAT_B8G8R8A8_TYPELESS;
+			case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+			case DXGI_FORMAT_B8G8R8X8_UNORM:
+			case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+				return DXGI_FORMAT_B8G8R8X8_TYPELESS;
+			case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+			case DXGI_FORMAT_R10G10B10A2_UNORM:
+			case DXGI_FORMAT_R10G10B10A2_UINT:
+				return DXGI_FORMAT_R10G10B10A2_TYPELESS;
+			case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+			case DXGI_FORMAT_R16G16B16A16_FLOAT:
+			case DXGI_FORMAT_R16G16B16A16_UNORM:
+			case DXGI_FORMAT_R16G16B16A16_UINT:
+			case DXGI_FORMAT_R16G16B16A16_SNORM:
+			case DXGI_FORMAT_R16G16B16A16_SINT:
+				return DXGI_FORMAT_R16G16B16A16_TYPELESS;
+			case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+			case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			case DXGI_FORMAT_R32G32B32A32_UINT:
+			case DXGI_FORMAT_R32G32B32A32_SINT:
+				return DXGI_FORMAT_R32G32B32A32_TYPELESS;
+			default:
+				return format;
+			}
+		}
 	}
 
-	void RestoreD3D11State(ID3D11DeviceContext *context, const D3D11State &state) {
-		context->VSSetShader(state.vertexShader.Get(), nullptr, 0);
-		context->PSSetShader(state.pixelShader.Get(), nullptr, 0);
-		context->CSSetShader(state.computeShader.Get(), nullptr, 0);
-		context->IASetInputLayout( state.inputLayout.Get() );
-		context->IASetPrimitiveTopology( state.topology );
-		context->IASetVertexBuffers( 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, state.vertexBuffers, state.strides, state.offsets );
-		for (int i = 0; i < D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; ++i) {
-			if (state.vertexBuffers[i])
-				state.vertexBuffers[i]->Release();
-		}
-		context->IASetIndexBuffer( state.indexBuffer.Get(), state.format, state.offset );
-		context->OMSetRenderTargets( D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, state.renderTargets, state.depthStencil.Get() );
-		for (int i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i) {
-			if (state.renderTargets[i]) {
-				state.renderTargets[i]->Release();
+	bool AreCopyCompatibleFormats(DXGI_FORMAT a, DXGI_FORMAT b) {
+		return TypelessGroup(a) == TypelessGroup(b);
+	}
+
+	namespace {
+		// private data of a resource whose views are cached, marks the token expired when the
+		// resource releases it on destruction
+		class __declspec(uuid("5a1e3c9f-8d2b-4e61-9f47-2c6b0d8a71e3")) LifetimeTracker : public IUnknown {
+		public:
+			LifetimeTracker() : destroyed(std::make_shared<std::atomic<bool>>(false)) {}
+			~LifetimeTracker() {
+				destroyed->store(true, std::memory_order_release);
+			}
+
+			HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **object) override {
+				if (object == nullptr) {
+					return E_POINTER;
+				}
+				if (riid == __uuidof(IUnknown)) {
+					AddRef();
+					*object = static_cast<IUnknown*>(this);
+					return S_OK;
+				}
+				*object = nullptr;
+				return E_NOINTERFACE;
+			}
+			ULONG STDMETHODCALLTYPE AddRef() override {
+				return ++refCount;
+			}
+			ULONG STDMETHODCALLTYPE Release() override {
+				ULONG count = --refCount;
+				if (count == 0) {
+					delete this;
+				}
+				return count;
+			}
+
+			std::shared_ptr<std::atomic<bool>> destroyed;
+
+		private:
+			std::atomic<ULONG> refCount = 1;
+		};
+	}
+
+	D3D11ResourceLifetime::Token D3D11ResourceLifetime::Track(ID3D11DeviceChild *resource) {
+		// a resource in several caches shares one tracker; the private data getter adds a reference
+		ComPtr<LifetimeTracker> tracker;
+		UINT size = sizeof(LifetimeTracker*);
+		if (SUCCEEDED(resource->GetPrivateData(__uuidof(LifetimeTracker), &size, tracker.GetAddressOf())) && tracker != nullptr) {
+			return tracker->destroyed;
+		}
+		tracker.Attach(new LifetimeTracker);
+		if (FAILED(resource->SetPrivateDataInterface(__uuidof(LifetimeTracker), tracker.Get()))) {
+			return nullptr;
+		}
+		return tracker->destroyed;
+	}
+
+#ifdef _DEBUG
+	namespace {
+		typedef std::vector<std::pair<std::string, uint64_t>> StateAudit;
+
+		// records the objects by address and drops the references the getter added
+		template<typename T>
+		void AuditObjects(StateAudit &audit, const char *name, T **objects, UINT count) {
+			for (UINT i = 0; i < count; ++i) {
+				audit.emplace_back(std::string(name) + " " + std::to_string(i), (uint64_t)(uintptr_t)objects[i]);
+				if (objects[i]) {
+					objects[i]->Release();
+				}
+			}
+		}
+
+		template<typename T>
+		void AuditObject(StateAudit &audit, const char *name, T *object) {
+			AuditObjects(audit, name, &object, 1);
+			audit.back().first = name;
+		}
+
+		void AuditBytes(StateAudit &audit, const char *name, const void *data, size_t size) {
+			// FNV-1a
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < size; ++i) {
+				hash = (hash ^ ((const uint8_t*)data)[i]) * 1099511628211ull;
+			}
+			audit.emplace_back(name, hash);
+		}
+
+		void SnapshotD3D11State(ID3D11DeviceContext *context, StateAudit &audit) {
+			audit.clear();
+
+			ID3D11InputLayout *inputLayout;
+			context->IAGetInputLayout( &inputLayout );
+			AuditObject(audit, "input layout", inputLayout);
+			D3D11_PRIMITIVE_TOPOLOGY topology;
+			context->IAGetPrimitiveTopology( &topology );
+			audit.emplace_back("topology", topology);
+			ID3D11Buffer *vertexBuffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+			UINT strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+			UINT offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+			context->IAGetVertexBuffers( 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, vertexBuffers, strides, offsets );
+			AuditObjects(audit, "vertex buffer", vertexBuffers, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
+			AuditBytes(audit, "vertex buffer strides", strides, sizeof(strides));
+			AuditBytes(audit, "vertex buffer offsets", offsets, sizeof(offsets));
+			ID3D11Buffer *indexBuffer;
+			DXGI_FORMAT format;
+			UINT offset;
+			context->IAGetIndexBuffer( &indexBuffer, &format, &offset );
+			AuditObject(audit, "index buffer", indexBuffer);
+			audit.emplace_back("index format", format);
+			audit.emplace_back("index offset", offset);
+
+			ID3D11VertexShader *vs;
+			context->VSGetShader( &vs, nullptr, nullptr );
+			AuditObject(audit, "vertex shader", vs);
+			ID3D11HullShader *hs;
+			context->HSGetShader( &hs, nullptr, nullptr );
+			AuditObject(audit, "hull shader", hs);
+			ID3D11DomainShader *ds;
+			context->DSGetShader( &ds, nullptr, nullptr );
+			AuditObject(audit, "domain shader", ds);
+			ID3D11GeometryShader *gs;
+			context->GSGetShader( &gs, nullptr, nullptr );
+			AuditObject(audit, "geometry shader", gs);
+			ID3D11PixelShader *ps;
+			context->PSGetShader( &ps, nullptr, nullptr );
+			AuditObject(audit, "pixel shader", ps);
+			ID3D11ComputeShader *cs;
+			context->CSGetShader( &cs, nullptr, nullptr );
+			AuditObject(audit, "compute shader", cs);
+
+			ID3D11Buffer *constantBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+			context->VSGetConstantBuffers( 0, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, constantBuffers );
+			AuditObjects(audit, "VS constant buffer", constantBuffers, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+			context->PSGetConstantBuffers( 0, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, constantBuffers );
+			AuditObjects(audit, "PS constant buffer", constantBuffers, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+			context->CSGetConstantBuffers( 0, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, constantBuffers );
+			AuditObjects(audit, "CS constant buffer", constantBuffers, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+			ID3D11ShaderResourceView *srvs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+			context->PSGetShaderResources( 0, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, srvs );
+			AuditObjects(audit, "PS shader resource", srvs, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+			context->CSGetShaderResources( 0, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, srvs );
+			AuditObjects(audit, "CS shader resource", srvs, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+			ID3D11SamplerState *samplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+			context->PSGetSamplers( 0, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, samplers );
+			AuditObjects(audit, "PS sampler", samplers, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT);
+			context->CSGetSamplers( 0, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, samplers );
+			AuditObjects(audit, "CS sampler", samplers, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT);
+			ID3D11UnorderedAccessView *uavs[D3D11_1_UAV_SLOT_COUNT];
+			context->CSGetUnorderedAccessViews( 0, D3D11_1_UAV_SLOT_COUNT, uavs );
+			AuditObjects(audit, "CS UAV", uavs, D3D11_1_UAV_SLOT_COUNT);
+
+			ID3D11RasterizerState *rasterizerState;
+			context->RSGetState( &rasterizerState );
+			AuditObject(audit, "rasterizer state", rasterizerState);
+			D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+			UINT numViewports = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+			context->RSGetViewports( &numViewports, viewports );
+			audit.emplace_back("viewport count", numViewports);
+			AuditBytes(audit, "viewports", viewports, numViewports * sizeof(D3D11_VIEWPORT));
+			D3D11_RECT scissorRects[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+			UINT numScissorRects = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+			context->RSGetScissorRects( &numScissorRects, scissorRects );
+			audit.emplace_back("scissor rect count", numScissorRects);
+			AuditBytes(audit, "scissor rects", scissorRects, numScissorRects * sizeof(D3D11_RECT));
+
+			ID3D11RenderTargetView *renderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+			ID3D11DepthStencilView *depthStencil;
+			context->OMGetRenderTargets( D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, renderTargets, &depthStencil );
+			AuditObjects(audit, "render target", renderTargets, D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT);
+			AuditObject(audit, "depth stencil view", depthStencil);
+			ID3D11BlendState *blendState;
+			FLOAT blendFactor[4];
+			UINT sampleMask;
+			context->OMGetBlendState( &blendState, blendFactor, &sampleMask );
+			AuditObject(audit, "blend state", blendState);
+			AuditBytes(audit, "blend factor", blendFactor, sizeof(blendFactor));
+			audit.emplace_back("sample mask", sampleMask);
+			ID3D11DepthStencilState *depthStencilState;
+			UINT stencilRef;
+			context->OMGetDepthStencilState( &depthStencilState, &stencilRef );
+			AuditObject(audit, "depth stencil state", depthStencilState);
+			audit.emplace_back("stencil ref", stencilRef);
+		}
+	}
+#endif
+
+	D3D11State::~D3D11State() {
+		auto release = [](auto **objects, UINT count) {
+			for (UINT i = 0; i < count; ++i) {
+				if (objects[i]) {
+					objects[i]->Release();
+				}
+			}
+		};
+		release(vertexBuffers, footprint.vertexBuffers);
+		if (footprint.touches & TOUCHES_RENDER_TARGETS) {
+			release(renderTargets, D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT);
+		}
+		release(vsConstantBuffers, footprint.vsConstantBuffers);
+		release(csConstantBuffers, footprint.csConstantBuffers);
+		release(csShaderResources, footprint.csShaderResources);
+		release(csUavs, footprint.csUavs);
+		release(csSamplers, footprint.csSamplers);
+	}
+
+	void StoreD3D11State(ID3D11DeviceContext *context, const D3D11StateFootprint &footprint, D3D11State &state) {
+		D3D11StateFootprint &saved = state.footprint;
+		saved = footprint;
+		for (UINT *count : { &saved.vertexBuffers, &saved.vsConstantBuffers, &saved.csConstantBuffers, &saved.csShaderResources, &saved.csUavs, &saved.csSamplers }) {
+			if (*count > kMaxSavedSlots) {
+				LOG_ERROR << "State footprint of " << footprint.pass << " has more than " << kMaxSavedSlots << " slots of a kind";
+				*count = kMaxSavedSlots;
 			}
 		}
-		context->RSSetState( state.rasterizerState.Get() );
-		context->OMSetDepthStencilState( state.depthStencilState.Get(), state.stencilRef );
-		context->RSSetViewports( state.numViewports, state.viewports );
-		context->VSSetConstantBuffers( 0, 1, state.vsConstantBuffer.GetAddressOf() );
-		context->PSSetConstantBuffers( 0, 1, state.psConstantBuffer.GetAddressOf() );
-		context->CSSetConstantBuffers(0, 1, state.csConstantBuffer.GetAddressOf());
-		context->CSSetShaderResources(0, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, state.csShaderResources);
-		for (int i = 0; i < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; ++i) {
-			if (state.csShaderResources[i])
-				state.csShaderResources[i]->Release();
-		}
-		UINT initial = 0;
-		context->CSSetUnorderedAccessViews(0, D3D11_1_UAV_SLOT_COUNT, state.csUavs, &initial);
-		for (int i = 0; i < D3D11_1_UAV_SLOT_COUNT; ++i) {
-			if (state.csUavs[i])
-				state.csUavs[i]->Release();
+
+		if (saved.touches & TOUCHES_VERTEX_SHADER) {
+			context->VSGetShader( state.vertexShader.ReleaseAndGetAddressOf(), nullptr, nullptr );
+		}
+		if (saved.touches & TOUCHES_PIXEL_SHADER) {
+			context->PSGetShader( state.pixelShader.ReleaseAndGetAddressOf(), nullptr, nullptr );
+		}
+		if (saved.touches & TOUCHES_COMPUTE_SHADER) {
+			context->CSGetShader( state.computeShader.ReleaseAndGetAddressOf(), nullptr, nullptr );
+		}
+		if (saved.touches & TOUCHES_INPUT_ASSEMBLER) {
+			context->IAGetInputLayout( state.inputLayout.ReleaseAndGetAddressOf() );
+			context->IAGetPrimitiveTopology( &state.topology );
+			context->IAGetIndexBuffer( state.indexBuffer.ReleaseAndGetAddressOf(), &state.format, &state.offset );
+		}
+		if (saved.vertexBuffers > 0) {
+			context->IAGetVertexBuffers( 0, saved.vertexBuffers, state.vertexBuffers, state.strides, state.offsets );
+		}
+		if (saved.touches & TOUCHES_RENDER_TARGETS) {
+			context->OMGetRenderTargets( D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, state.renderTargets, state.depthStencil.ReleaseAndGetAddressOf() );
+		}
+		if (saved.touches & TOUCHES_RASTERIZER) {
+			context->RSGetState( state.rasterizerState.ReleaseAndGetAddressOf() );
+			state.numViewports = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+			context->RSGetViewports( &state.numViewports, state.viewports );
+		}
+		if (saved.touches & TOUCHES_DEPTH_STENCIL_STATE) {
+			context->OMGetDepthStencilState( state.depthStencilState.ReleaseAndGetAddressOf(), &state.stencilRef );
+		}
+		if (saved.vsConstantBuffers > 0) {
+			context->VSGetConstantBuffers( 0, saved.vsConstantBuffers, state.vsConstantBuffers );
+		}
+		if (saved.csConstantBuffers > 0) {
+			context->CSGetConstantBuffers( 0, saved.csConstantBuffers, state.csConstantBuffers );
+		}
+		if (saved.csShaderResources > 0) {
+			context->CSGetShaderResources( 0, saved.csShaderResources, state.csShaderResources );
+		}
+		if (saved.csUavs > 0) {
+			context->CSGetUnorderedAccessViews( 0, saved.csUavs, state.csUavs );
+		}
+		if (saved.csSamplers > 0) {
+			context->CSGetSamplers( 0, saved.csSamplers, state.csSamplers );
+		}
+
+#ifdef _DEBUG
+		SnapshotD3D11State(context, state.audit);
+#endif
+	}
+
+	void RestoreD3D11State(ID3D11DeviceContext *context, const D3D11State &state) {
+		const D3D11StateFootprint &saved = state.footprint;
+		if (saved.touches & TOUCHES_VERTEX_SHADER) {
+			context->VSSetShader( state.vertexShader.Get(), nullptr, 0 );
+		}
+		if (saved.touches & TOUCHES_PIXEL_SHADER) {
+			context->PSSetShader( state.pixelShader.Get(), nullptr, 0 );
+		}
+		if (saved.touches & TOUCHES_COMPUTE_SHADER) {
+			context->CSSetShader( state.computeShader.Get(), nullptr, 0 );
+		}
+		if (saved.touches & TOUCHES_INPUT_ASSEMBLER) {
+			context->IASetInputLayout( state.inputLayout.Get() );
+			context->IASetPrimitiveTopology( state.topology );
+			context->IASetIndexBuffer( state.indexBuffer.Get(), state.format, state.offset );
+		}
+		if (saved.vertexBuffers > 0) {
+			context->IASetVertexBuffers( 0, saved.vertexBuffers, state.vertexBuffers, state.strides, state.offsets );
+		}
+		if (saved.touches & TOUCHES_RENDER_TARGETS) {
+			context->OMSetRenderTargets( D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, state.renderTargets, state.depthStencil.Get() );
+		}
+		if (saved.touches & TOUCHES_RASTERIZER) {
+			context->RSSetState( state.rasterizerState.Get() );
+			context->RSSetViewports( state.numViewports, state.viewports );
+		}
+		if (saved.touches & TOUCHES_DEPTH_STENCIL_STATE) {
+			context->OMSetDepthStencilState( state.depthStencilState.Get(), state.stencilRef );
+		}
+		if (saved.vsConstantBuffers > 0) {
+			context->VSSetConstantBuffers( 0, saved.vsConstantBuffers, state.vsConstantBuffers );
+		}
+		if (saved.csConstantBuffers > 0) {
+			context->CSSetConstantBuffers( 0, saved.csConstantBuffers, state.csConstantBuffers );
+		}
+		if (saved.csShaderResources > 0) {
+			context->CSSetShaderResources( 0, saved.csShaderResources, state.csShaderResources );
+		}
+		if (saved.csUavs > 0) {
+			// keep the append counters of the game's UAVs
+			UINT initial[kMaxSavedSlots];
+			std::fill(initial, initial + kMaxSavedSlots, UINT(-1));
+			context->CSSetUnorderedAccessViews( 0, saved.csUavs, state.csUavs, initial );
+		}
+		if (saved.csSamplers > 0) {
+			context->CSSetSamplers( 0, saved.csSamplers, state.csSamplers );
+		}
+
+#ifdef _DEBUG
+		StateAudit after;
+		SnapshotD3D11State(context, after);
+		for (size_t i = 0; i < after.size() && i < state.audit.size(); ++i) {
+			if (after[i].second != state.audit[i].second) {
+				LOG_ERROR << "State audit: " << saved.pass << " left " << after[i].first << " changed";
+			}
 		}
+#endif
 	}
 
 	ComPtr<ID3D11ShaderResourceView> CreateShaderResourceView(ID3D11Device *device, ID3D11Texture2D *texture, int arrayIndex) {
@@ -1,7 +1,13 @@
 #pragma once
+#include "view_cache.h"
+
 #include <wrl/client.h>
 #include <d3d11.h>
+#include <atomic>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 using Microsoft::WRL::ComPtr;
 
@@ -14,37 +20,117 @@ namespace vrperfkit {
 	ComPtr<ID3D11Texture2D> CreatePostProcessTexture(ID3D11Device *device, uint32_t width, uint32_t height, DXGI_FORMAT format);
 	ComPtr<ID3D11Buffer> CreateConstantsBuffer(ID3D11Device *device, uint32_t size);
 	ComPtr<ID3D11SamplerState> CreateLinearSampler(ID3D11Device *device);
+	bool SupportsHalfPrecisionShaders(ID3D11Device *device);
+	// SV_RenderTargetArrayIndex and SV_ViewportArrayIndex written by a vertex shader (D3D11.3)
+	bool SupportsRenderTargetArrayIndexFromVertexShader(ID3D11Device *device);
+
+	// Creates the shaders from a permutation table generated by set_compute_shader(... PERMUTATIONS ...)
+	// for all variants whose bits within fixedMask match fixedBits. The others are left empty.
+	template<typename Permutation, size_t N>
+	void CreateComputeShaderPermutations(ID3D11Device *device, const std::string &name, const Permutation (&permutations)[N],
+			uint32_t fixedMask, uint32_t fixedBits, ComPtr<ID3D11ComputeShader> (&shaders)[N]) {
+		for (uint32_t i = 0; i < N; ++i) {
+			if ((i & fixedMask) == fixedBits) {
+				CheckResult("creating " + name, device->CreateComputeShader(permutations[i].bytecode, permutations[i].size, nullptr, shaders[i].GetAddressOf()));
+			}
+		}
+	}
+
+	// false if the circle around the centre covers the whole area, so the shaders can skip the radius test
+	bool NeedsRadiusTest(uint32_t width, uint32_t height, float centreX, float centreY, float radius);
 
 	DXGI_FORMAT TranslateTypelessFormats(DXGI_FORMAT format);
 	DXGI_FORMAT MakeSrgbFormatsTypeless(DXGI_FORMAT format);
 	bool IsSrgbFormat(DXGI_FORMAT format);
+	bool IsFloatFormat(DXGI_FORMAT format);
+	// CopySubresourceRegion only copies between formats of the same typeless group
+	bool AreCopyCompatibleFormats(DXGI_FORMAT a, DXGI_FORMAT b);
+
+	// Lifetime of ViewCache and ContextTable entries for D3D11 resources and contexts: Track attaches
+	// a small COM object as private data, which D3D11 releases when the object is destroyed, and the
+	// token notes that. A live object keeps its address, so a token that is not expired still belongs
+	// to the object it was made for.
+	struct D3D11ResourceLifetime {
+		typedef std::shared_ptr<const std::atomic<bool>> Token;
+		static Token Track(ID3D11DeviceChild *resource);
+		static bool IsCurrent(const Token &token) {
+			return token == nullptr || !token->load(std::memory_order_acquire);
+		}
+		static bool IsCurrent(ID3D11DeviceChild *resource, const Token &token) {
+			return IsCurrent(token);
+		}
+	};
+	template<typename Views>
+	using D3D11ViewCache = ViewCache<ID3D11Texture2D, Views, D3D11ResourceLifetime>;
+
+	// pipeline state groups a pass may set, see D3D11StateFootprint
+	enum D3D11StateTouches : uint32_t {
+		TOUCHES_VERTEX_SHADER = 1 << 0,
+		TOUCHES_PIXEL_SHADER = 1 << 1,
+		TOUCHES_COMPUTE_SHADER = 1 << 2,
+		// input layout, topology and index buffer
+		TOUCHES_INPUT_ASSEMBLER = 1 << 3,
+		// all render targets and the depth stencil view, OMSetRenderTargets replaces them together
+		TOUCHES_RENDER_TARGETS = 1 << 4,
+		// rasterizer state and viewports
+		TOUCHES_RASTERIZER = 1 << 5,
+		TOUCHES_DEPTH_STENCIL_STATE = 1 << 6,
+	};
+
+	// maximum number of slots of one kind a footprint can save
+	constexpr UINT kMaxSavedSlots = 4;
 
+	// The state one of our passes sets on the game's context, so that only that is saved and
+	// restored around it. Slot counts start at slot 0.
+	struct D3D11StateFootprint {
+		const char *pass;
+		uint32_t touches;
+		UINT vertexBuffers;
+		UINT vsConstantBuffers;
+		UINT csConstantBuffers;
+		UINT csShaderResources;
+		UINT csUavs;
+		UINT csSamplers;
+	};
+
+	// state saved for a footprint; holds references to the saved objects until destroyed
 	struct D3D11State {
+		D3D11StateFootprint footprint {};
 		ComPtr<ID3D11VertexShader> vertexShader;
 		ComPtr<ID3D11PixelShader> pixelShader;
 		ComPtr<ID3D11ComputeShader> computeShader;
 		ComPtr<ID3D11InputLayout> inputLayout;
 		D3D11_PRIMITIVE_TOPOLOGY topology;
-		ID3D11Buffer *vertexBuffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
-		UINT strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
-		UINT offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
 		ComPtr<ID3D11Buffer> indexBuffer;
 		DXGI_FORMAT format;
 		UINT offset;
-		ID3D11RenderTargetView *renderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+		ID3D11Buffer *vertexBuffers[kMaxSavedSlots] = {};
+		UINT strides[kMaxSavedSlots];
+		UINT offsets[kMaxSavedSlots];
+		ID3D11RenderTargetView *renderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
 		ComPtr<ID3D11DepthStencilView> depthStencil;
 		ComPtr<ID3D11RasterizerState> rasterizerState;
-		ComPtr<ID3D11DepthStencilState> depthStencilState;
-		UINT stencilRef;
 		D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
 		UINT numViewports = 0;
-		ComPtr<ID3D11Buffer> vsConstantBuffer;
-		ComPtr<ID3D11Buffer> psConstantBuffer;
-		ComPtr<ID3D11Buffer> csConstantBuffer;
-		ID3D11ShaderResourceView *csShaderResources[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
-		ID3D11UnorderedAccessView *csUavs[D3D11_1_UAV_SLOT_COUNT];
+		ComPtr<ID3D11DepthStencilState> depthStencilState;
+		UINT stencilRef;
+		ID3D11Buffer *vsConstantBuffers[kMaxSavedSlots] = {};
+		ID3D11Buffer *csConstantBuffers[kMaxSavedSlots] = {};
+		ID3D11ShaderResourceView *csShaderResources[kMaxSavedSlots] = {};
+		ID3D11UnorderedAccessView *csUavs[kMaxSavedSlots] = {};
+		ID3D11SamplerState *csSamplers[kMaxSavedSlots] = {};
+#ifdef _DEBUG
+		// the whole pipeline state before the pass, compared after the restore
+		std::vector<std::pair<std::string, uint64_t>> audit;
+#endif
+
+		D3D11State() = default;
+		D3D11State(const D3D11State &) = delete;
+		D3D11State & operator=(const D3D11State &) = delete;
+		~D3D11State();
 	};
 
-	void StoreD3D11State(ID3D11DeviceContext *context, D3D11State &state);
+	void StoreD3D11State(ID3D11DeviceContext *context, const D3D11StateFootprint &footprint, D3D11State &state);
+	// Debug builds then check that the pass changed nothing outside its footprint and log what it did change.
 	void RestoreD3D11State(ID3D11DeviceContext *context, const D3D11State &state);
 }
@@ -1,11 +1,16 @@
 #include "d3d11_injector.h"
+#include "context_table.h"
 #include "hooks.h"
 
 #include "config.h"
+#include "logging.h"
+
+#include <atomic>
 
 namespace vrperfkit {
 	namespace {
-		bool alreadyInsideHook = false;
+		// per thread, since games may record deferred contexts on several threads at once
+		thread_local bool alreadyInsideHook = false;
 
 		class HookGuard {
 		public:
@@ -24,25 +29,78 @@ namespace vrperfkit {
 			bool state;
 		};
 
-		template<typename T>
-		D3D11Injector *GetInjector(T *object) {
-			D3D11Injector *injector = nullptr;
-			UINT size = sizeof(injector);
-			object->GetPrivateData(__uuidof(D3D11Injector), &size, &injector);
+		// Deferred contexts are cached after the first lookup, up to a limit, since every entry is
+		// copied into each new list. A cached context is tracked by its private data, so a context
+		// created at the address of a released one is resolved again rather than given its injector.
+		const size_t kMaxCachedContexts = 64;
+
+		// immediate contexts and devices of the live injectors, and cached deferred contexts
+		typedef ContextTable<D3D11Injector, D3D11ResourceLifetime> InjectorTable;
+		InjectorTable g_injectors (kMaxCachedContexts);
+
+		// lookups by how they were resolved, counted in debug mode
+		struct InjectorLookupCounters {
+			std::atomic<uint64_t> total { 0 };
+			std::atomic<uint64_t> primary { 0 };
+			std::atomic<uint64_t> fallback { 0 };
+			std::atomic<uint64_t> deferred { 0 };
+			std::atomic<uint64_t> miss { 0 };
+		} g_lookupCounters;
+		const uint64_t kLookupLogInterval = 1 << 20;
+
+		void CountLookup(std::atomic<uint64_t> &counter) {
+			counter.fetch_add(1, std::memory_order_relaxed);
+			uint64_t total = g_lookupCounters.total.fetch_add(1, std::memory_order_relaxed) + 1;
+			if (total % kLookupLogInterval == 0) {
+				auto percent = [total](const std::atomic<uint64_t> &count) { return 100.0 * count.load(std::memory_order_relaxed) / total; };
+				LOG_DEBUG << "Injector lookups: " << total << ", " << percent(g_lookupCounters.primary) << "% immediate context, "
+					<< percent(g_lookupCounters.fallback) << "% other contexts, devices and cached deferred contexts, "
+					<< percent(g_lookupCounters.deferred) << "% deferred contexts resolved through their device, "
+					<< percent(g_lookupCounters.miss) << "% without injector";
+			}
+		}
+
+		// Deferred contexts share the immediate context's vtable and so its hooks. Their injector is the
+		// one of the device they were created from.
+		D3D11Injector *FindInjector(ID3D11DeviceContext *context) {
+			InjectorTable::Hit hit;
+			D3D11Injector *injector = g_injectors.Find(context, &hit);
+			if (injector != nullptr) {
+				if (g_config.debugMode) {
+					CountLookup(hit == InjectorTable::Hit::PRIMARY ? g_lookupCounters.primary : g_lookupCounters.fallback);
+				}
+				return injector;
+			}
+
+			if (context->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED) {
+				ComPtr<ID3D11Device> device;
+				context->GetDevice(device.GetAddressOf());
+				injector = device != nullptr ? g_injectors.Find(device.Get()) : nullptr;
+				// a stale entry is replaced even when the cache is full; contexts whose release cannot be
+				// tracked are not cached
+				if (injector != nullptr && (hit == InjectorTable::Hit::STALE || g_injectors.Aliases() < kMaxCachedContexts)) {
+					if (D3D11ResourceLifetime::Token token = D3D11ResourceLifetime::Track(context)) {
+						injector = g_injectors.Alias(context, device.Get(), std::move(token));
+					}
+				}
+			}
+			if (g_config.debugMode) {
+				CountLookup(injector != nullptr ? g_lookupCounters.deferred : g_lookupCounters.miss);
+			}
 			return injector;
 		}
 
 		void D3D11ContextHook_PSSetSamplers(ID3D11DeviceContext *self, UINT StartSlot, UINT NumSamplers, ID3D11SamplerState * const *ppSamplers) {
 			HookGuard hookGuard;
 
-			D3D11Injector *injector = GetInjector(self);
+			D3D11Injector *injector = FindInjector(self);
 			if (injector != nullptr && !hookGuard.AlreadyInsideHook()) {
-				if (injector->PrePSSetSamplers(StartSlot, NumSamplers, ppSamplers)) {
+				if (injector->PrePSSetSamplers(self, StartSlot, NumSamplers, ppSamplers)) {
 					return;
 				}
 			}
 
-			hooks::CallOriginal(D3D11ContextHook_PSSetSamplers)(self, StartSlot, NumSamplers, ppSamplers);
+			hooks::Original<D3D11ContextHook_PSSetSamplers>()(self, StartSlot, NumSamplers, ppSamplers);
 		}
 
 		void D3D11ContextHook_OMSetRenderTargets(
@@ -51,10 +109,10 @@ namespace vrperfkit {
 				ID3D11DepthStencilView *pDepthStencilView) {
 			HookGuard hookGuard;
 
-			hooks::CallOriginal(D3D11ContextHook_OMSetRenderTargets)(self, NumViews, ppRenderTargetViews, pDepthStencilView);
+			hooks::Original<D3D11ContextHook_OMSetRenderTargets>()(self, NumViews, ppRenderTargetViews, pDepthStencilView);
 
-			if (D3D11Injector *injector = GetInjector(self)) {
-				injector->PostOMSetRenderTargets(NumViews, ppRenderTargetViews, pDepthStencilView);
+			if (D3D11Injector *injector = FindInjector(self)) {
+				injector->PostOMSetRenderTargets(self, NumViews, ppRenderTargetViews, pDepthStencilView);
 			}
 		}
 
@@ -69,10 +127,10 @@ namespace vrperfkit {
 				const UINT *pUAVInitialCounts) {
 			HookGuard hookGuard;
 
-			hooks::CallOriginal(D3D11ContextHook_OMSetRenderTargetsAndUnorderedAccessViews)(self, NumRTVs, ppRenderTargetViews, pDepthStencilView, UAVStartSlot, NumUAVs, ppUnorderedAccessViews, pUAVInitialCounts);
+			hooks::Original<D3D11ContextHook_OMSetRenderTargetsAndUnorderedAccessViews>()(self, NumRTVs, ppRenderTargetViews, pDepthStencilView, UAVStartSlot, NumUAVs, ppUnorderedAccessViews, pUAVInitialCounts);
 
-			if (D3D11Injector *injector = GetInjector(self)) {
-				injector->PostOMSetRenderTargets(NumRTVs, ppRenderTargetViews, pDepthStencilView);
+			if (D3D11Injector *injector = FindInjector(self)) {
+				injector->PostOMSetRenderTargets(self, NumRTVs, ppRenderTargetViews, pDepthStencilView);
 			}
 		}
 
@@ -84,69 +142,78 @@ namespace vrperfkit {
 				UINT8 Stencil) {
 			HookGuard hookGuard;
 
-			hooks::CallOriginal(D3D11ContextHook_ClearDepthStencilView)(self, pDepthStencilView, ClearFlags, Depth, Stencil);
+			hooks::Original<D3D11ContextHook_ClearDepthStencilView>()(self, pDepthStencilView, ClearFlags, Depth, Stencil);
 
-			if (D3D11Injector *injector = GetInjector(self)) {
-				injector->ClearDepthStencilView(pDepthStencilView, ClearFlags, Depth, Stencil);
+			if (D3D11Injector *injector = FindInjector(self)) {
+				injector->ClearDepthStencilView(self, pDepthStencilView, ClearFlags, Depth, Stencil);
 			}
 		}
 	}
 
 	D3D11Injector::D3D11Injector(ComPtr<ID3D11Device> device) {
+		PublishListeners(Listeners());
 		this->device = device;
 		device->GetImmediateContext(context.GetAddressOf());
 
-		D3D11Injector *instance = this;
-		UINT size = sizeof(instance);
-		device->SetPrivateData(__uuidof(D3D11Injector), size, &instance);
-		context->SetPrivateData(__uuidof(D3D11Injector), size, &instance);
+		// the immediate context is where nearly all hooked calls come from
+		g_injectors.Insert(context.Get(), this, true);
+		g_injectors.Insert(device.Get(), this);
 
 		// Upscaling and FFR
 		if (g_config.upscaling.enabled || (g_config.ffr.enabled && g_config.ffr.method == FixedFoveatedMethod::VRS)) {
-			hooks::InstallVirtualFunctionHook("ID3D11DeviceContext::PSSetSamplers", context.Get(), 10, (void*)&D3D11ContextHook_PSSetSamplers);
-			hooks::InstallVirtualFunctionHook("ID3D11DeviceContext::OMSetRenderTargets", context.Get(), 33, (void*)&D3D11ContextHook_OMSetRenderTargets);
-			hooks::InstallVirtualFunctionHook("ID3D11DeviceContext::OMSetRenderTargetsAndUnorderedAccessViews", context.Get(), 34, (void*)&D3D11ContextHook_OMSetRenderTargetsAndUnorderedAccessViews);
+			hooks::InstallVirtualFunctionHook<D3D11ContextHook_PSSetSamplers>("ID3D11DeviceContext::PSSetSamplers", context.Get(), 10);
+			hooks::InstallVirtualFunctionHook<D3D11ContextHook_OMSetRenderTargets>("ID3D11DeviceContext::OMSetRenderTargets", context.Get(), 33);
+			hooks::InstallVirtualFunctionHook<D3D11ContextHook_OMSetRenderTargetsAndUnorderedAccessViews>("ID3D11DeviceContext::OMSetRenderTargetsAndUnorderedAccessViews", context.Get(), 34);
 		}
 
 		// HRM
-		if (g_config.hiddenMask.enabled || (g_config.ffr.enabled && g_config.ffr.method == FixedFoveatedMethod::RDM)) {
-			hooks::InstallVirtualFunctionHook("ID3D11DeviceContext::ClearDepthStencilView", context.Get(), 53, (void*)&D3D11ContextHook_ClearDepthStencilView);
+		if (g_config.hiddenMask.enabled || (g_config.ffr.enabled && g_config.ffr.method != FixedFoveatedMethod::VRS)) {
+			hooks::InstallVirtualFunctionHook<D3D11ContextHook_ClearDepthStencilView>("ID3D11DeviceContext::ClearDepthStencilView", context.Get(), 53);
 		}
 	}
 
 	D3D11Injector::~D3D11Injector() {
 		// Upscaling && FFR
 		if (g_config.upscaling.enabled || (g_config.ffr.enabled && g_config.ffr.method == FixedFoveatedMethod::VRS)) {
-			hooks::RemoveHook((void*)&D3D11ContextHook_PSSetSamplers);
-			hooks::RemoveHook((void*)&D3D11ContextHook_OMSetRenderTargets);
-			hooks::RemoveHook((void*)&D3D11ContextHook_OMSetRenderTargetsAndUnorderedAccessViews);
+			hooks::RemoveHook<D3D11ContextHook_PSSetSamplers>();
+			hooks::RemoveHook<D3D11ContextHook_OMSetRenderTargets>();
+			hooks::RemoveHook<D3D11ContextHook_OMSetRenderTargetsAndUnorderedAccessViews>();
 		}
 		
 		// HRM
-		if (g_config.hiddenMask.enabled || (g_config.ffr.enabled && g_config.ffr.method == FixedFoveatedMethod::RDM)) {
-			hooks::RemoveHook((void*)&D3D11ContextHook_ClearDepthStencilView);
+		if (g_config.hiddenMask.enabled || (g_config.ffr.enabled && g_config.ffr.method != FixedFoveatedMethod::VRS)) {
+			hooks::RemoveHook<D3D11ContextHook_ClearDepthStencilView>();
 		}
 
-		device->SetPrivateData(__uuidof(D3D11Injector), 0, nullptr);
-		context->SetPrivateData(__uuidof(D3D11Injector), 0, nullptr);
+		g_injectors.Remove(this);
 	}
 
 	void D3D11Injector::AddListener(D3D11Listener *listener) {
-		if (std::find(listeners.begin(), listeners.end(), listener) == listeners.end()) {
-			listeners.push_back(listener);
+		std::lock_guard<std::mutex> lock (listenerMutex);
+		Listeners updated = *listeners.load(std::memory_order_relaxed);
+		if (std::find(updated.begin(), updated.end(), listener) == updated.end()) {
+			updated.push_back(listener);
+			PublishListeners(std::move(updated));
 		}
 	}
 
 	void D3D11Injector::RemoveListener(D3D11Listener *listener) {
-		auto it = std::find(listeners.begin(), listeners.end(), listener);
-		if (it != listeners.end()) {
-			listeners.erase(it);
+		std::lock_guard<std::mutex> lock (listenerMutex);
+		Listeners updated = *listeners.load(std::memory_order_relaxed);
+		auto it = std::find(updated.begin(), updated.end(), listener);
+		if (it != updated.end()) {
+			updated.erase(it);
+			PublishListeners(std::move(updated));
 		}
 	}
 
-	bool D3D11Injector::PrePSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState * const *ppSamplers) {
-		for (D3D11Listener *listener : listeners) {
-			if (listener->PrePSSetSamplers(startSlot, numSamplers, ppSamplers)) {
+	void D3D11Injector::PublishListeners(Listeners &&updated) {
+		listeners.store(listenerSnapshots.Publish(std::move(updated)), std::memory_order_release);
+	}
+
+	bool D3D11Injector::PrePSSetSamplers(ID3D11DeviceContext *context, UINT startSlot, UINT numSamplers, ID3D11SamplerState * const *ppSamplers) {
+		for (D3D11Listener *listener : *listeners.load(std::memory_order_acquire)) {
+			if (listener->PrePSSetSamplers(context, startSlot, numSamplers, ppSamplers)) {
 				return true;
 			}
 		}
@@ -154,16 +221,16 @@ namespace vrperfkit {
 		return false;
 	}
 
-	void D3D11Injector::PostOMSetRenderTargets(UINT numViews, ID3D11RenderTargetView *const *renderTargetViews, ID3D11DepthStencilView *depthStencilView) {
-		for (D3D11Listener *listener : listeners) {
-			listener->PostOMSetRenderTargets(numViews, renderTargetViews, depthStencilView);
+	void D3D11Injector::PostOMSetRenderTargets(ID3D11DeviceContext *context, UINT numViews, ID3D11RenderTargetView *const *renderTargetViews, ID3D11DepthStencilView *depthStencilView) {
+		for (D3D11Listener *listener : *listeners.load(std::memory_order_acquire)) {
+			listener->PostOMSetRenderTargets(context, numViews, renderTargetViews, depthStencilView);
 		}
 	}
 
-	HRESULT D3D11Injector::ClearDepthStencilView(ID3D11DepthStencilView *pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil) {
+	HRESULT D3D11Injector::ClearDepthStencilView(ID3D11DeviceContext *context, ID3D11DepthStencilView *pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil) {
 		if (ClearFlags & D3D11_CLEAR_DEPTH) {
-			for (D3D11Listener * listener : listeners) {
-				listener->ClearDepthStencilView(pDepthStencilView, ClearFlags, Depth, Stencil);
+			for (D3D11Listener *listener : *listeners.load(std::memory_order_acquire)) {
+				listener->ClearDepthStencilView(context, pDepthStencilView, ClearFlags, Depth, Stencil);
 			}
 		}
 
@@ -1,21 +1,26 @@
 #pragma once
 #include "d3d11_helper.h"
+#include "snapshot_list.h"
 
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 namespace vrperfkit {
+	// The callbacks run on the thread of the calling context, which is the immediate context or one
+	// of the device's deferred contexts.
 	class D3D11Listener {
 	public:
-		virtual bool PrePSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState *const *ppSamplers) { return false; }
-		virtual void PostOMSetRenderTargets(UINT numViews, ID3D11RenderTargetView *const *renderTargetViews, ID3D11DepthStencilView *depthStencilView) {}
+		virtual bool PrePSSetSamplers(ID3D11DeviceContext *context, UINT startSlot, UINT numSamplers, ID3D11SamplerState *const *ppSamplers) { return false; }
+		virtual void PostOMSetRenderTargets(ID3D11DeviceContext *context, UINT numViews, ID3D11RenderTargetView *const *renderTargetViews, ID3D11DepthStencilView *depthStencilView) {}
 		
-		virtual HRESULT ClearDepthStencilView(ID3D11DepthStencilView *pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil) { return 0; }
+		virtual HRESULT ClearDepthStencilView(ID3D11DeviceContext *context, ID3D11DepthStencilView *pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil) { return 0; }
 
 	protected:
 		~D3D11Listener() = default;
 	};
 
-	class __declspec(uuid("c0d7b492-1bfb-4099-9c67-7144e1f586ed")) D3D11Injector {
+	class D3D11Injector {
 	public:
 		explicit D3D11Injector(ComPtr<ID3D11Device> device);
 		~D3D11Injector();
@@ -23,15 +28,22 @@ namespace vrperfkit {
 		void AddListener(D3D11Listener *listener);
 		void RemoveListener(D3D11Listener *listener);
 
-		bool PrePSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState *const *ppSamplers);
-		void PostOMSetRenderTargets(UINT numViews, ID3D11RenderTargetView *const *renderTargetViews, ID3D11DepthStencilView *depthStencilView);
+		bool PrePSSetSamplers(ID3D11DeviceContext *context, UINT startSlot, UINT numSamplers, ID3D11SamplerState *const *ppSamplers);
+		void PostOMSetRenderTargets(ID3D11DeviceContext *context, UINT numViews, ID3D11RenderTargetView *const *renderTargetViews, ID3D11DepthStencilView *depthStencilView);
 
-		HRESULT ClearDepthStencilView(ID3D11DepthStencilView *pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil);
+		HRESULT ClearDepthStencilView(ID3D11DeviceContext *context, ID3D11DepthStencilView *pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil);
 
 	private:
 		ComPtr<ID3D11Device> device;
 		ComPtr<ID3D11DeviceContext> context;
 
-		std::vector<D3D11Listener*> listeners;
+		// The hooks read the listeners on the game's threads, so changes publish a new list under
+		// listenerMutex. Replaced lists are freed after a grace period, since a hook may still be in one.
+		typedef std::vector<D3D11Listener*> Listeners;
+		SnapshotList<Listeners> listenerSnapshots;
+		std::atomic<const Listeners*> listeners;
+		std::mutex listenerMutex;
+
+		void PublishListeners(Listeners &&updated);
 	};
 }
@@ -0,0 +1,48 @@
+#include "d3d11_lanczos_upscaler.h"
+#include "d3d11_helper.h"
+#include "logging.h"
+#include "shader_lanczos_upscale.h"
+
+namespace vrperfkit {
+	struct LanczosShaderConstants {
+		uint32_t inputOffset[2];
+		uint32_t inputSize[2];
+		uint32_t outputOffset[2];
+		uint32_t outputSize[2];
+		float scale[2];
+		float _padding[2];
+	};
+
+	D3D11LanczosUpscaler::D3D11LanczosUpscaler(ID3D11Device *device) {
+		LOG_INFO << "Creating D3D11 resources for Lanczos upscaling...";
+		device->GetImmediateContext(context.GetAddressOf());
+
+		CheckResult("creating Lanczos upscale shader", device->CreateComputeShader(g_LanczosUpscaleShader, sizeof(g_LanczosUpscaleShader), nullptr, upscaleShader.GetAddressOf()));
+		constantsBuffer = CreateConstantsBuffer(device, sizeof(LanczosShaderConstants));
+	}
+
+	void D3D11LanczosUpscaler::Upscale(const D3D11PostProcessInput &input, const Viewport &outputViewport) {
+		ID3D11ShaderResourceView *srvs[1] = {input.inputView};
+		context->CSSetShaderResources(0, 1, srvs);
+		UINT uavCount = -1;
+		ID3D11UnorderedAccessView *uavs[] = {input.outputUav};
+		context->CSSetUnorderedAccessViews(0, 1, uavs, &uavCount);
+
+		LanczosShaderConstants constants;
+		constants.inputOffset[0] = input.inputViewport.x;
+		constants.inputOffset[1] = input.inputViewport.y;
+		constants.inputSize[0] = input.inputViewport.width;
+		constants.inputSize[1] = input.inputViewport.height;
+		constants.outputOffset[0] = outputViewport.x;
+		constants.outputOffset[1] = outputViewport.y;
+		constants.outputSize[0] = outputViewport.width;
+		constants.outputSize[1] = outputViewport.height;
+		constants.scale[0] = input.inputViewport.width / (float)outputViewport.width;
+		constants.scale[1] = input.inputViewport.height / (float)outputViewport.height;
+		context->UpdateSubresource(constantsBuffer.Get(), 0, nullptr, &constants, 0, 0);
+		context->CSSetConstantBuffers(0, 1, constantsBuffer.GetAddressOf());
+
+		context->CSSetShader(upscaleShader.Get(), nullptr, 0);
+		context->Dispatch((outputViewport.width + 7) >> 3, (outputViewport.height + 7) >> 3, 1);
+	}
+}
@@ -6,20 +6,30 @@
 #include "config.h"
 
 #include "nis/NIS_Config.h"
+#include "nis/nis_coefficients.h"
 
 namespace vrperfkit {
 	D3D11NisUpscaler::D3D11NisUpscaler(ID3D11Device *device) {
 		LOG_INFO << "Creating D3D11 resources for NIS upscaling...";
 		device->GetImmediateContext(context.GetAddressOf());
 
-		CheckResult("creating NIS upscale shader", device->CreateComputeShader(g_NISUpscaleShader, sizeof(g_NISUpscaleShader), nullptr, upscaleShader.GetAddressOf()));
-		CheckResult("creating NIS sharpen shader", device->CreateComputeShader(g_NISSharpenShader, sizeof(g_NISSharpenShader), nullptr, sharpenShader.GetAddressOf()));
+		// the HDR variant depends on the input format, which is only known per frame
+		upscaleBits = (g_config.upscaling.peripheryFilter == PeripheryFilter::LANCZOS ? g_NISUpscaleShader_PERIPHERY_LANCZOS : 0)
+			| (g_config.upscaling.nisPerformance ? g_NISUpscaleShader_NIS_PERFORMANCE : 0);
+		CreateComputeShaderPermutations(device, "NIS upscale shader", g_NISUpscaleShader, g_NISUpscaleShader_PERIPHERY_LANCZOS | g_NISUpscaleShader_NIS_PERFORMANCE, upscaleBits, upscaleShaders);
+		CreateComputeShaderPermutations(device, "NIS sharpen shader", g_NISSharpenShader, 0, 0, sharpenShaders);
 
 		constantsBuffer = CreateConstantsBuffer(device, sizeof(NISConfig));
 		sampler = CreateLinearSampler(device);
 
+		// the shader permutation expects coefficient tables with the matching number of taps
+		NisCoefficients coefficients = GenerateNisCoefficients(g_config.upscaling.nisPerformance ? 4 : kNisMaxFilterTaps);
+		if (g_config.upscaling.nisPerformance) {
+			LOG_INFO << "Using 4-tap NIS upscaling filter";
+		}
+
 		D3D11_TEXTURE2D_DESC td;
-		td.Width = kFilterSize / 4;
+		td.Width = kNisCoefficientStride / 4;
 		td.Height = kPhaseCount;
 		td.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
 		td.BindFlags = D3D11_BIND_SHADER_RESOURCE;
@@ -31,11 +41,11 @@ namespace vrperfkit {
 		td.CPUAccessFlags = 0;
 		td.MiscFlags = 0;
 		D3D11_SUBRESOURCE_DATA texData;
-		texData.pSysMem = coef_scale;
-		texData.SysMemPitch = kFilterSize * 4;
-		texData.SysMemSlicePitch = kFilterSize * 4 * kPhaseCount;
+		texData.pSysMem = coefficients.scaler.data();
+		texData.SysMemPitch = kNisCoefficientStride * sizeof(float);
+		texData.SysMemSlicePitch = kNisCoefficientStride * sizeof(float) * kPhaseCount;
 		CheckResult("creating NIS upscale coefficients texture", device->CreateTexture2D(&td, &texData, scalerCoeffTexture.GetAddressOf()));
-		texData.pSysMem = coef_usm;
+		texData.pSysMem = coefficients.usm.data();
 		CheckResult("creating NIS USM coefficients texture", device->CreateTexture2D(&td, &texData, usmCoeffTexture.GetAddressOf()));
 
 		scalerCoeffView = CreateShaderResourceView(device, scalerCoeffTexture.Get());
@@ -54,29 +64,29 @@ namespace vrperfkit {
 		ID3D11UnorderedAccessView *uavs[] = {input.outputUav};
 		context->CSSetUnorderedAccessViews(0, 1, uavs, &uavCount);
 
+		bool hdr = IsFloatFormat(td.Format);
 		NISConfig constants;
-		NVScalerUpdateConfig(constants, g_config.upscaling.sharpness, input.inputViewport.x, input.inputViewport.y,
-				input.inputViewport.width, input.inputViewport.height, td.Width, td.Height,
-				outputViewport.x, outputViewport.y, outputViewport.width, outputViewport.height,
-				otd.Width, otd.Height);
-		float radius = 0.5f * g_config.upscaling.radius * outputViewport.height;
-		constants.projCentre[0] = outputViewport.width * input.projectionCenter.x;
-		constants.projCentre[1] = outputViewport.height * input.projectionCenter.y;
-		constants.squaredRadius = radius * radius;
-		constants.debugMode = g_config.debugMode;
+		UpdateNisConfig(constants, g_config.upscaling.sharpness, g_config.upscaling.radius * input.radiusScale, input.projectionCenter,
+				input.inputViewport, td.Width, td.Height, outputViewport, otd.Width, otd.Height, hdr, g_config.debugMode);
+		float radius = 0.5f * g_config.upscaling.radius * input.radiusScale * outputViewport.height;
 		context->UpdateSubresource(constantsBuffer.Get(), 0, nullptr, &constants, 0, 0);
 		context->CSSetConstantBuffers(0, 1, constantsBuffer.GetAddressOf());
 
+		// both NIS shaders share the same permutation layout
+		bool radiusTest = NeedsRadiusTest(outputViewport.width, outputViewport.height, constants.projCentre[0], constants.projCentre[1], radius);
+		uint32_t variant = (radiusTest ? g_NISUpscaleShader_RADIUS_TEST : 0)
+			| (g_config.debugMode ? g_NISUpscaleShader_DEBUG_MODE : 0)
+			| (hdr ? g_NISUpscaleShader_NIS_HDR_MODE : 0);
 		if (input.inputViewport != outputViewport) {
 			// full upscaling pass
 			ID3D11ShaderResourceView *coeffViews[2] = {scalerCoeffView.Get(), usmCoeffView.Get()};
 			context->CSSetShaderResources(1, 2, coeffViews);
-			context->CSSetShader(upscaleShader.Get(), nullptr, 0);
+			context->CSSetShader(upscaleShaders[upscaleBits | variant].Get(), nullptr, 0);
 
 			context->Dispatch((UINT)std::ceil(outputViewport.width / 32.f), (UINT)std::ceil(outputViewport.height / 24.f), 1);
 		} else {
 			// just sharpening
-			context->CSSetShader(sharpenShader.Get(), nullptr, 0);
+			context->CSSetShader(sharpenShaders[variant].Get(), nullptr, 0);
 			context->Dispatch((UINT)std::ceil(outputViewport.width / 32.f), (UINT)std::ceil(outputViewport.height / 32.f), 1);
 		}
 	}
@@ -14,8 +14,10 @@ namespace vrperfkit {
 
 	private:
 		ComPtr<ID3D11DeviceContext> context;
-		ComPtr<ID3D11ComputeShader> upscaleShader;
-		ComPtr<ID3D11ComputeShader> sharpenShader;
+		// permutations: radius test, debug mode, HDR input (+ periphery filter and 4-tap filter for upscaling)
+		ComPtr<ID3D11ComputeShader> upscaleShaders[32];
+		ComPtr<ID3D11ComputeShader> sharpenShaders[8];
+		uint32_t upscaleBits = 0;
 		ComPtr<ID3D11Buffer> constantsBuffer;
 		ComPtr<ID3D11SamplerState> sampler;
 		ComPtr<ID3D11Texture2D> scalerCoeffTexture;
@@ -3,22 +3,69 @@
 #include "config.h"
 #include "d3d11_cas_upscaler.h"
 #include "d3d11_fsr_upscaler.h"
+#include "d3d11_lanczos_upscaler.h"
 #include "d3d11_nis_upscaler.h"
+#include "d3d11_upscaler_benchmark.h"
 #include "logging.h"
 #include "hooks.h"
+#include "hrm/mask_mesh.h"
+#include "hrm/radial_density_mask.h"
+#include "visible_bounds.h"
 
-#include "shader_hrm_fullscreen_tri.h"
-#include "shader_hrm_mask.h"
-#include "shader_rdm_mask.h"
+#include "shader_checkerboard_reconstruction.h"
+#include "shader_hrm_mask_mesh.h"
+#include "shader_hrm_mask_mesh_array.h"
 #include "shader_rdm_reconstruction.h"
 
+#include <climits>
+#include <iomanip>
 #include <sstream>
 
 namespace vrperfkit {
+	extern std::filesystem::path g_basePath;
+
+	namespace {
+		// pixels around the visible part of an eye that are still processed: the upscalers' taps
+		// reach up to 3 pixels, and the hidden mask's vertices are rounded to whole pixels
+		const uint32_t kVisibleRectMargin = 4;
+
+		// ApplyRadialDensityMask: the mask mesh draw into the game's depth target
+		const D3D11StateFootprint kMaskingState = {
+			"depth masking",
+			TOUCHES_VERTEX_SHADER | TOUCHES_PIXEL_SHADER | TOUCHES_INPUT_ASSEMBLER | TOUCHES_RENDER_TARGETS | TOUCHES_RASTERIZER | TOUCHES_DEPTH_STENCIL_STATE,
+			1, 1, 0, 0, 0, 0,
+		};
+		// Apply: RDM reconstruction and the upscalers are compute passes with a single UAV, constant
+		// buffer and sampler, and up to three shader resources (NIS, temporal RDM). The render targets are unbound
+		// so the input texture can be read.
+		const D3D11StateFootprint kUpscalingState = {
+			"upscaling",
+			TOUCHES_COMPUTE_SHADER | TOUCHES_RENDER_TARGETS,
+			0, 0, 1, 3, 1, 1,
+		};
+	}
+
+	std::unique_ptr<D3D11Upscaler> CreateD3D11Upscaler(ID3D11Device *device, UpscaleMethod method, const D3D11_TEXTURE2D_DESC &outputDesc) {
+		switch (method) {
+		case UpscaleMethod::FSR:
+			return std::make_unique<D3D11FsrUpscaler>(device, outputDesc.Width, outputDesc.Height, outputDesc.Format);
+		case UpscaleMethod::NIS:
+			return std::make_unique<D3D11NisUpscaler>(device);
+		case UpscaleMethod::CAS:
+			return std::make_unique<D3D11CasUpscaler>(device);
+		case UpscaleMethod::LANCZOS:
+			return std::make_unique<D3D11LanczosUpscaler>(device);
+		}
+		return nullptr;
+	}
+
 	D3D11PostProcessor::D3D11PostProcessor(ComPtr<ID3D11Device> device) : device(device) {
 		enableDynamic = g_config.hiddenMask.dynamic || g_config.ffr.dynamic;
 
-		is_rdm = (g_config.ffr.enabled && g_config.ffr.method == FixedFoveatedMethod::RDM);
+		is_rdm = (g_config.ffr.enabled && g_config.ffr.method != FixedFoveatedMethod::VRS);
+		is_checkerboard = (g_config.ffr.enabled && g_config.ffr.method == FixedFoveatedMethod::CHECKERBOARD);
+		rdmPattern = is_checkerboard ? CheckerboardRdmPattern() : g_config.ffr.rdmPattern;
+		rdmPhases = is_checkerboard ? kCheckerboardPhases : g_config.ffr.rdmTemporalPhases;
 		if (is_rdm) {
 			hiddenMaskApply = g_config.ffr.enabled;
 			preciseResolution = g_config.ffr.preciseResolution;
@@ -39,8 +86,10 @@ namespace vrperfkit {
 		LOG_INFO << "Init PostProcessor";
 	}
 
-	HRESULT D3D11PostProcessor::ClearDepthStencilView(ID3D11DepthStencilView *pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil) {
-		if (pDepthStencilView == nullptr) {
+	HRESULT D3D11PostProcessor::ClearDepthStencilView(ID3D11DeviceContext *context, ID3D11DepthStencilView *pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil) {
+		// the mask is drawn with the immediate context's state; the render target counts would not
+		// follow the order deferred command lists are executed in either
+		if (pDepthStencilView == nullptr || context != this->context.Get()) {
 			return 0;
 		}
 
@@ -68,25 +117,6 @@ namespace vrperfkit {
 		return 0;
 	}
 
-	struct RdmMaskingConstants {
-		float depthOut;
-		float radius[3];
-		float invClusterResolution[2];
-		float projectionCenter[2];
-		float yFix[2];
-		float edgeRadius;
-		float _padding;
-	};
-
-	struct RdmReconstructConstants {
-		int offset[2];
-		float projectionCenter[2];
-		float invClusterResolution[2];
-		float invResolution[2];
-		float radius[3];
-		float edgeRadius;
-	};
-
 	DXGI_FORMAT TranslateTypelessDepthFormats(DXGI_FORMAT format) {
 		switch (format) {
 		case DXGI_FORMAT_R16_TYPELESS:
@@ -113,7 +143,8 @@ namespace vrperfkit {
 			// Otherwise we'll get darkened pictures (applies to Revive mostly)
 			return DXGI_FORMAT_R10G10B10A2_UNORM;
 		default:
-			return DXGI_FORMAT_R8G8B8A8_UNORM;
+			// the upscalers read the RDM reconstruction directly, so keep the precision of HDR input
+			return IsFloatFormat(inputFormat) ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
 		}
 	}
 
@@ -141,6 +172,15 @@ namespace vrperfkit {
 		projY[1] = RY;
 	}
 
+	void D3D11PostProcessor::SetHiddenAreaMesh(int eye, const std::vector<Point<float>> &triangles) {
+		hiddenAreaMeshes[eye] = triangles;
+		for (auto &slot : maskMeshes) {
+			for (MaskMesh &mesh : slot) {
+				mesh.valid = false;
+			}
+		}
+	}
+
 	//void D3D11PostProcessor::PrepareResources(ID3D11Texture2D *inputTexture, vr::EColorSpace colorSpace) {
 	void D3D11PostProcessor::PrepareResources(ID3D11Texture2D *inputTexture) {
 		LOG_INFO << "Creating post-processing resources";
@@ -206,10 +246,22 @@ namespace vrperfkit {
 	}
 
 	void D3D11PostProcessor::PrepareRdmResources(DXGI_FORMAT format) {
-		CheckResult("Creating HRM/RDM fullscreen tri vertex shader", device->CreateVertexShader( g_HRM_FullscreenTriShader, sizeof( g_HRM_FullscreenTriShader ), nullptr, hrmFullTriVertexShader.GetAddressOf() ));
+		CheckResult("Creating HRM/RDM mask mesh vertex shader", device->CreateVertexShader( g_HRM_MaskMeshShader, sizeof( g_HRM_MaskMeshShader ), nullptr, maskMeshVertexShader.GetAddressOf() ));
+		D3D11_INPUT_ELEMENT_DESC maskMeshElement { "POSITION", 0, DXGI_FORMAT_R16G16_UINT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+		CheckResult("Creating HRM/RDM mask mesh input layout", device->CreateInputLayout( &maskMeshElement, 1, g_HRM_MaskMeshShader, sizeof( g_HRM_MaskMeshShader ), maskMeshInputLayout.GetAddressOf() ));
+		if (SupportsRenderTargetArrayIndexFromVertexShader(device.Get())) {
+			CheckResult("Creating HRM/RDM array mask mesh vertex shader", device->CreateVertexShader( g_HRM_MaskMeshArrayShader, sizeof( g_HRM_MaskMeshArrayShader ), nullptr, maskMeshArrayVertexShader.GetAddressOf() ));
+		} else {
+			LOG_INFO << "No render target array index from the vertex shader, masking array textures per slice";
+		}
+		if (is_checkerboard) {
+			CheckResult("Creating checkerboard reconstruction shader", device->CreateComputeShader( g_CheckerboardReconstructionShader, sizeof( g_CheckerboardReconstructionShader ), nullptr, rdmReconstructShader.GetAddressOf() ));
+		} else if (is_rdm) {
+			uint32_t clusterSize = rdmPattern.clusterSize;
+			uint32_t permutation = clusterSize == 4 ? g_RDM_ReconstructionShader_RDM_CLUSTER_4 : clusterSize == 16 ? g_RDM_ReconstructionShader_RDM_CLUSTER_16 : 0;
+			CheckResult("Creating RDM reconstruction shader", device->CreateComputeShader( g_RDM_ReconstructionShader[permutation].bytecode, g_RDM_ReconstructionShader[permutation].size, nullptr, rdmReconstructShader.GetAddressOf() ));
+		}
 		if (is_rdm) {
-			CheckResult("Creating RDM masking shader", device->CreatePixelShader( g_RDM_MaskShader, sizeof( g_RDM_MaskShader ), nullptr, rdmMaskingShader.GetAddressOf() ));
-			CheckResult("Creating RDM reconstruction shader", device->CreateComputeShader( g_RDM_ReconstructionShader, sizeof( g_RDM_ReconstructionShader ), nullptr, rdmReconstructShader.GetAddressOf() ));
 
 			D3D11_TEXTURE2D_DESC td;
 			td.Width = textureWidth;
@@ -223,21 +275,23 @@ namespace vrperfkit {
 			td.SampleDesc.Count = 1;
 			td.SampleDesc.Quality = 0;
 			td.ArraySize = 1;
-			CheckResult("Creating RDM reconstructed texture", device->CreateTexture2D( &td, nullptr, rdmReconstructedTexture.GetAddressOf() ));
 			D3D11_UNORDERED_ACCESS_VIEW_DESC uav;
 			uav.Format = td.Format;
 			uav.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
 			uav.Texture2D.MipSlice = 0;
-			CheckResult("Creating RDM reconstructed UAV", device->CreateUnorderedAccessView( rdmReconstructedTexture.Get(), &uav, rdmReconstructedUav.GetAddressOf() ));
 			D3D11_SHADER_RESOURCE_VIEW_DESC svd;
 			svd.Format = TranslateTypelessFormats(format);
 			svd.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
 			svd.Texture2D.MostDetailedMip = 0;
 			svd.Texture2D.MipLevels = 1;
-			CheckResult("Creating RDM reconstructed view", device->CreateShaderResourceView( rdmReconstructedTexture.Get(), &svd, rdmReconstructedView.GetAddressOf() ));
-
-		} else {
-			CheckResult("Creating HRM masking shader", device->CreatePixelShader( g_HRM_MaskShader, sizeof( g_HRM_MaskShader ), nullptr, hrmMaskingShader.GetAddressOf() ));
+			int targetCount = rdmPhases > 1 ? 4 : 1;
+			for (int i = 0; i < targetCount; ++i) {
+				RdmTarget &target = rdmTargets[i];
+				CheckResult("Creating RDM reconstructed texture", device->CreateTexture2D( &td, nullptr, target.texture.GetAddressOf() ));
+				CheckResult("Creating RDM reconstructed UAV", device->CreateUnorderedAccessView( target.texture.Get(), &uav, target.uav.GetAddressOf() ));
+				CheckResult("Creating RDM reconstructed view", device->CreateShaderResourceView( target.texture.Get(), &svd, target.view.GetAddressOf() ));
+			}
+			rdmHistoryValid[0] = rdmHistoryValid[1] = false;
 		}
 
 		D3D11_DEPTH_STENCIL_DESC dsd;
@@ -276,9 +330,8 @@ namespace vrperfkit {
 		bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 		bd.MiscFlags = 0;
 		bd.StructureByteStride = 0;
-		bd.ByteWidth = sizeof(RdmMaskingConstants);
-		CheckResult("Creating HRM masking constants buffer", device->CreateBuffer( &bd, nullptr, hrmMaskingConstantsBuffer[0].GetAddressOf() ));
-		CheckResult("Creating HRM masking constants buffer", device->CreateBuffer( &bd, nullptr, hrmMaskingConstantsBuffer[1].GetAddressOf() ));
+		bd.ByteWidth = sizeof(MaskMeshConstants);
+		CheckResult("Creating HRM mask mesh constants buffer", device->CreateBuffer( &bd, nullptr, maskMeshConstantsBuffer.GetAddressOf() ));
 
 		if (is_rdm) {
 			bd.ByteWidth = sizeof(RdmReconstructConstants);
@@ -300,7 +353,8 @@ namespace vrperfkit {
 	}
 
 	ID3D11DepthStencilView * D3D11PostProcessor::GetDepthStencilView( ID3D11Texture2D *depthStencilTex, vr::EVREye eye ) {
-		if ( depthStencilViews.find( depthStencilTex ) == depthStencilViews.end() ) {
+		DepthStencilViews *cached = depthStencilViews.Find( depthStencilTex );
+		if ( cached == nullptr ) {
 			LOG_INFO << "Creating depth stencil views for " << std::hex << depthStencilTex << std::dec;
 			D3D11_TEXTURE2D_DESC td;
 			depthStencilTex->GetDesc( &td );
@@ -312,7 +366,8 @@ namespace vrperfkit {
 			dvd.ViewDimension = isMS ? D3D11_DSV_DIMENSION_TEXTURE2DMS : D3D11_DSV_DIMENSION_TEXTURE2D;
 			dvd.Flags = 0;
 			dvd.Texture2D.MipSlice = 0;
-			auto &views = depthStencilViews[depthStencilTex];
+			auto &views = depthStencilViews.Insert( depthStencilTex, DepthStencilViews() );
+			cached = &views;
 			HRESULT result = device->CreateDepthStencilView( depthStencilTex, &dvd, views.view[0].GetAddressOf() );
 			if (FAILED(result)) {
 				LOG_ERROR << "Error creating depth stencil view: " << std::hex << result;
@@ -335,12 +390,31 @@ namespace vrperfkit {
 					LOG_ERROR << "Error creating depth stencil view array slice: " << std::hex << result;
 					return nullptr;
 				}
+				// both slices, for masking both eyes in one draw
+				if (isMS) {
+					dvd.Texture2DMSArray.ArraySize = 2;
+					dvd.Texture2DMSArray.FirstArraySlice = 0;
+				} else {
+					dvd.Texture2DArray.ArraySize = 2;
+					dvd.Texture2DArray.FirstArraySlice = 0;
+				}
+				result = device->CreateDepthStencilView( depthStencilTex, &dvd, views.bothSlices.GetAddressOf() );
+				if (FAILED(result)) {
+					LOG_ERROR << "Error creating depth stencil view of both array slices: " << std::hex << result;
+				}
 			} else {
 				views.view[1] = views.view[0];
 			}
 		}
 
-		return depthStencilViews[depthStencilTex].view[eye].Get();
+		return cached->view[eye].Get();
+	}
+
+	ID3D11DepthStencilView * D3D11PostProcessor::GetStereoDepthStencilView( ID3D11Texture2D *depthStencilTex ) {
+		if (GetDepthStencilView( depthStencilTex, vr::Eye_Left ) == nullptr) {
+			return nullptr;
+		}
+		return depthStencilViews.Find( depthStencilTex )->bothSlices.Get();
 	}
 
 	void D3D11PostProcessor::ApplyRadialDensityMask(ID3D11Texture2D *depthStencilTex, float depth, uint8_t stencil) {
@@ -400,166 +474,328 @@ namespace vrperfkit {
 		uint32_t renderWidth = td.Width * (sideBySide ? 0.5 : 1);
 		uint32_t renderHeight = td.Height;
 
-		// Store D3D11 State before drawing mask
-		ComPtr<ID3D11VertexShader> prevVS;
-		context->VSGetShader(prevVS.GetAddressOf(), nullptr, nullptr);
-		ComPtr<ID3D11PixelShader> prevPS;
-		context->PSGetShader(prevPS.GetAddressOf(), nullptr, nullptr);
-		ComPtr<ID3D11InputLayout> inputLayout;
-		context->IAGetInputLayout( inputLayout.GetAddressOf() );
-		D3D11_PRIMITIVE_TOPOLOGY topology;
-		context->IAGetPrimitiveTopology( &topology );
-		ID3D11Buffer *vertexBuffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
-		UINT strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
-		UINT offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
-		context->IAGetVertexBuffers( 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, vertexBuffers, strides, offsets );
-		ComPtr<ID3D11Buffer> indexBuffer;
-		DXGI_FORMAT format;
-		UINT offset;
-		context->IAGetIndexBuffer(indexBuffer.GetAddressOf(), &format, &offset);
-		ID3D11RenderTargetView *renderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
-		ComPtr<ID3D11DepthStencilView> depthStencil;
-		context->OMGetRenderTargets( D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, renderTargets, depthStencil.GetAddressOf() );
-		ComPtr<ID3D11RasterizerState> rasterizerState;
-		context->RSGetState( rasterizerState.GetAddressOf() );
-		ComPtr<ID3D11DepthStencilState> depthStencilState;
-		UINT stencilRef;
-		context->OMGetDepthStencilState( depthStencilState.GetAddressOf(), &stencilRef );
-		D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
-		UINT numViewports = 0;
-		context->RSGetViewports( &numViewports, nullptr );
-		context->RSGetViewports( &numViewports, viewports );
-		ComPtr<ID3D11Buffer> vsConstantBuffer;
-		context->VSGetConstantBuffers( 0, 1, vsConstantBuffer.GetAddressOf() );
-		ComPtr<ID3D11Buffer> psConstantBuffer;
-		context->PSGetConstantBuffers( 0, 1, psConstantBuffer.GetAddressOf() );
-		
-		context->VSSetShader( hrmFullTriVertexShader.Get(), nullptr, 0 );
-		if (is_rdm) {
-			context->PSSetShader( rdmMaskingShader.Get(), nullptr, 0 );
-		} else {
-			context->PSSetShader( hrmMaskingShader.Get(), nullptr, 0 );
+		D3D11State previousState;
+		StoreD3D11State(context.Get(), kMaskingState, previousState);
+
+		RdmMaskingConstants constants[2];
+		Viewport eyeViewports[2];
+		uint32_t phaseIndex[2];
+		float radius[3];
+		GetRdmRadius(radius);
+		const uint32_t phases = is_rdm ? rdmPhases : 1;
+		for (int eye = 0; eye < 2; ++eye) {
+			bool rightHalf = sideBySide && eye == vr::Eye_Right;
+			SetupRdmMaskingConstants(constants[eye], 0.f, is_rdm ? radius : nullptr, edgeRadius, renderWidth, renderHeight,
+				Point<float>{projX[eye] + (rightHalf ? 1.f : 0.f), projY[eye]}, arrayTex, rdmPattern);
+			// the eye's next reconstruction runs with the same phase
+			GetRdmPhase(phases, rdmFrame[eye], constants[eye].phase);
+			phaseIndex[eye] = rdmFrame[eye] % phases;
+			eyeViewports[eye] = Viewport{ rightHalf ? renderWidth : 0, 0, renderWidth, renderHeight };
+		}
+
+		// Both eyes of a side by side target are masked with one draw, as are the slices of an array
+		// target if the vertex shader can pick the slice. Otherwise each eye is drawn on its own.
+		ID3D11DepthStencilView *stereoView = arrayTex && maskMeshArrayVertexShader ? GetStereoDepthStencilView(depthStencilTex) : nullptr;
+		bool stereo = sideBySide || stereoView != nullptr;
+		const MaskMesh &stereoMesh = stereo ? GetMaskMesh(2, phaseIndex[0], constants, eyeViewports, 2) : maskMeshes[2][0];
+
+		MaskMeshConstants meshConstants;
+		SetupMaskMeshConstants(meshConstants, depth, td.Width, td.Height, stereo ? stereoMesh.secondEyeVertex : UINT_MAX);
+		if (!maskMeshConstantsValid || memcmp(&meshConstants, &uploadedMaskMeshConstants, sizeof(meshConstants)) != 0) {
+			D3D11_MAPPED_SUBRESOURCE mapped { nullptr, 0, 0 };
+			context->Map( maskMeshConstantsBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped );
+			memcpy(mapped.pData, &meshConstants, sizeof(meshConstants));
+			context->Unmap( maskMeshConstantsBuffer.Get(), 0 );
+			uploadedMaskMeshConstants = meshConstants;
+			maskMeshConstantsValid = true;
 		}
-		context->IASetInputLayout( nullptr );
+
+		// the mask mesh covers exactly the masked pixels, so no pixel shader is needed to discard the others
+		context->VSSetShader( stereoView != nullptr ? maskMeshArrayVertexShader.Get() : maskMeshVertexShader.Get(), nullptr, 0 );
+		context->VSSetConstantBuffers( 0, 1, maskMeshConstantsBuffer.GetAddressOf() );
+		context->PSSetShader( nullptr, nullptr, 0 );
+		context->IASetInputLayout( maskMeshInputLayout.Get() );
 		context->IASetPrimitiveTopology( D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
-		context->IASetVertexBuffers( 0, 0, nullptr, nullptr, nullptr );
 		context->IASetIndexBuffer( nullptr, DXGI_FORMAT_UNKNOWN, 0 );
-		context->OMSetRenderTargets( 0, nullptr, GetDepthStencilView(depthStencilTex, currentEye) );
 		context->RSSetState(hrmRasterizerState.Get());
 		context->OMSetDepthStencilState(hrmDepthStencilState.Get(), ~stencil);
 
-		RdmMaskingConstants constants;
-		constants.depthOut = 1.f - depth;
-		if (is_rdm) {
-			constants.radius[0] = g_config.ffr.innerRadius;
-			constants.radius[1] = g_config.ffr.midRadius;
-			constants.radius[2] = g_config.ffr.outerRadius;
-		}
-		constants.edgeRadius = edgeRadius;
-		constants.invClusterResolution[0] = 8.f / renderWidth;
-		constants.invClusterResolution[1] = 8.f / renderHeight;
-		constants.projectionCenter[0] = projX[currentEye];
-		constants.projectionCenter[1] = projY[currentEye];
-		// New Unity engine with array textures renders heads down and then flips the texture before submitting.
-		// so we also need to construct the RDM heads-down in that case.
-		constants.yFix[0] = arrayTex ? -1 : 1;
-		constants.yFix[1] = arrayTex ? renderHeight : 0;
-		D3D11_MAPPED_SUBRESOURCE mapped { nullptr, 0, 0 };
-		context->Map( hrmMaskingConstantsBuffer[currentEye].Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped );
-		memcpy(mapped.pData, &constants, sizeof(constants));
-		context->Unmap( hrmMaskingConstantsBuffer[currentEye].Get(), 0 );
-		context->VSSetConstantBuffers( 0, 1, hrmMaskingConstantsBuffer[currentEye].GetAddressOf() );
-		context->PSSetConstantBuffers( 0, 1, hrmMaskingConstantsBuffer[currentEye].GetAddressOf() );
-
 		D3D11_VIEWPORT vp;
 		vp.TopLeftX = 0;
 		vp.TopLeftY = 0;
 		vp.MinDepth = 0;
 		vp.MaxDepth = 1;
-		vp.Width = renderWidth;
-		vp.Height = renderHeight;
+		vp.Width = td.Width;
+		vp.Height = td.Height;
 		context->RSSetViewports( 1, &vp );
 
-		context->Draw( 3, 0 );
-
-		if (sideBySide || arrayTex) {
-			constants.projectionCenter[0] = projX[vr::Eye_Right] + (sideBySide ? 1.f : 0.f);
-			constants.projectionCenter[1] = projY[vr::Eye_Right];
-			context->Map( hrmMaskingConstantsBuffer[vr::Eye_Right].Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped );
-			memcpy(mapped.pData, &constants, sizeof(constants));
-			context->Unmap( hrmMaskingConstantsBuffer[vr::Eye_Right].Get(), 0 );
-			context->VSSetConstantBuffers( 0, 1, hrmMaskingConstantsBuffer[1].GetAddressOf() );
-			context->PSSetConstantBuffers( 0, 1, hrmMaskingConstantsBuffer[1].GetAddressOf() );
-			context->OMSetRenderTargets( 0, nullptr, GetDepthStencilView(depthStencilTex, vr::Eye_Right) );
-			if (sideBySide) {
-				vp.TopLeftX = renderWidth;
+		if (stereo) {
+			context->OMSetRenderTargets( 0, nullptr, stereoView != nullptr ? stereoView : GetDepthStencilView(depthStencilTex, vr::Eye_Left) );
+			DrawMaskMesh(stereoMesh);
+		} else if (arrayTex) {
+			for (int eye = 0; eye < 2; ++eye) {
+				context->OMSetRenderTargets( 0, nullptr, GetDepthStencilView(depthStencilTex, (vr::EVREye)eye) );
+				DrawMaskMesh(GetMaskMesh(eye, phaseIndex[eye], &constants[eye], &eyeViewports[eye], 1));
 			}
-			context->RSSetViewports( 1, &vp );
-
-			context->Draw( 3, 0 );
+		} else {
+			context->OMSetRenderTargets( 0, nullptr, GetDepthStencilView(depthStencilTex, currentEye) );
+			DrawMaskMesh(GetMaskMesh(currentEye, phaseIndex[currentEye], &constants[currentEye], &eyeViewports[currentEye], 1));
 		}
 		
-		// Restore D3D11 State
-		context->VSSetShader(prevVS.Get(), nullptr, 0);
-		context->PSSetShader(prevPS.Get(), nullptr, 0);
-		context->IASetInputLayout( inputLayout.Get() );
-		context->IASetPrimitiveTopology( topology );
-		context->IASetVertexBuffers( 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, vertexBuffers, strides, offsets );
-		for (int i = 0; i < D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; ++i) {
-			if (vertexBuffers[i])
-				vertexBuffers[i]->Release();
-		}
-		context->IASetIndexBuffer( indexBuffer.Get(), format, offset );
-		context->OMSetRenderTargets( D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, renderTargets, depthStencil.Get() );
-		for (int i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i) {
-			if (renderTargets[i]) {
-				renderTargets[i]->Release();
+		RestoreD3D11State(context.Get(), previousState);
+	}
+
+	const D3D11PostProcessor::MaskMesh & D3D11PostProcessor::GetMaskMesh(int slot, uint32_t phaseIndex, const RdmMaskingConstants *constants, const Viewport *viewports, int eyeCount) {
+		MaskMesh &mesh = maskMeshes[slot][phaseIndex];
+		bool current = mesh.valid && mesh.eyeCount == eyeCount;
+		for (int i = 0; current && i < eyeCount; ++i) {
+			current = mesh.viewports[i] == viewports[i] && memcmp(&mesh.constants[i], &constants[i], sizeof(RdmMaskingConstants)) == 0;
+		}
+		if (current) {
+			return mesh;
+		}
+
+		// the eyes follow each other in one vertex buffer
+		std::vector<MaskVertex> vertices;
+		mesh.secondEyeVertex = UINT_MAX;
+		for (int i = 0; i < eyeCount; ++i) {
+			if (i == 1) {
+				mesh.secondEyeVertex = vertices.size();
+			}
+			int eye = eyeCount == 2 ? i : slot;
+			HiddenMaskMode mode = is_rdm || hiddenAreaMeshes[eye].empty() ? HiddenMaskMode::RADIAL : g_config.hiddenMask.mode;
+			std::vector<MaskVertex> eyeVertices;
+			if (mode != HiddenMaskMode::AREA_MESH) {
+				eyeVertices = GenerateMaskMesh(constants[i], viewports[i], !is_rdm);
 			}
+			if (mode != HiddenMaskMode::RADIAL) {
+				// both meshes write the same depth, so where they overlap it does not matter which one wins
+				std::vector<MaskVertex> areaVertices = GenerateHiddenAreaMaskMesh(hiddenAreaMeshes[eye], viewports[i], constants[i].yFix[0] < 0);
+				eyeVertices.insert(eyeVertices.end(), areaVertices.begin(), areaVertices.end());
+			}
+			vertices.insert(vertices.end(), eyeVertices.begin(), eyeVertices.end());
+			mesh.constants[i] = constants[i];
+			mesh.viewports[i] = viewports[i];
 		}
-		context->RSSetState( rasterizerState.Get() );
-		context->OMSetDepthStencilState( depthStencilState.Get(), stencilRef );
-		context->RSSetViewports( numViewports, viewports );
-		context->VSSetConstantBuffers( 0, 1, vsConstantBuffer.GetAddressOf() );
-		context->PSSetConstantBuffers( 0, 1, psConstantBuffer.GetAddressOf() );
-		
+
+		mesh.vertexBuffer.Reset();
+		mesh.vertexCount = 0;
+		if (!vertices.empty()) {
+			D3D11_BUFFER_DESC bd;
+			bd.Usage = D3D11_USAGE_IMMUTABLE;
+			bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			bd.CPUAccessFlags = 0;
+			bd.MiscFlags = 0;
+			bd.StructureByteStride = 0;
+			bd.ByteWidth = vertices.size() * sizeof(MaskVertex);
+			D3D11_SUBRESOURCE_DATA data { vertices.data(), 0, 0 };
+			if (FAILED(device->CreateBuffer( &bd, &data, mesh.vertexBuffer.ReleaseAndGetAddressOf() ))) {
+				LOG_ERROR << "Failed to create the mask mesh " << slot;
+			} else {
+				mesh.vertexCount = vertices.size();
+			}
+		}
+		mesh.eyeCount = eyeCount;
+		mesh.valid = true;
+		LOG_DEBUG << "Generated mask mesh " << slot << " (phase " << phaseIndex << ") for " << eyeCount << " eye(s): " << mesh.vertexCount << " vertices";
+		return mesh;
 	}
 
-	void D3D11PostProcessor::ReconstructRdmRender(const D3D11PostProcessInput &input) {
-		context->CSSetShader( rdmReconstructShader.Get(), nullptr, 0 );
-		ID3D11Buffer *emptyBind[] = {nullptr};
-		context->CSSetConstantBuffers( 0, 1, emptyBind );
+	void D3D11PostProcessor::DrawMaskMesh(const MaskMesh &mesh) {
+		if (mesh.vertexCount > 0) {
+			UINT stride = sizeof(MaskVertex);
+			UINT offset = 0;
+			context->IASetVertexBuffers( 0, 1, mesh.vertexBuffer.GetAddressOf(), &stride, &offset );
+			context->Draw( mesh.vertexCount, 0 );
+		}
+	}
+
+	const D3D11PostProcessor::RdmTarget & D3D11PostProcessor::ReconstructRdmRender(const D3D11PostProcessInput &input, const Viewport &clip) {
+		// with temporal RDM, the eye's two targets swap every frame
+		const int eye = input.eye;
+		const uint32_t frame = rdmFrame[eye]++;
+		const bool temporal = rdmPhases > 1;
+		const RdmTarget &target = rdmTargets[temporal ? eye * 2 + (frame & 1) : 0];
+		const RdmTarget &history = rdmTargets[temporal ? eye * 2 + (~frame & 1) : 0];
+		bool hasHistory = temporal && rdmHistoryValid[eye] && rdmHistoryViewport[eye] == input.inputViewport;
+		rdmHistoryValid[eye] = temporal;
+		rdmHistoryViewport[eye] = input.inputViewport;
 
 		RdmReconstructConstants constants;
-		constants.offset[0] = input.inputViewport.x;
-		constants.offset[1] = input.inputViewport.y;
-		constants.projectionCenter[0] = projX[input.eye];
-		constants.projectionCenter[1] = projY[input.eye];
-		constants.invResolution[0] = 1.f / textureWidth;
-		constants.invResolution[1] = 1.f / textureHeight;
-		constants.invClusterResolution[0] = 8.f / input.inputViewport.width;
-		constants.invClusterResolution[1] = 8.f / input.inputViewport.height;
-		constants.radius[0] = g_config.ffr.innerRadius;
-		constants.radius[1] = g_config.ffr.midRadius;
-		constants.radius[2] = g_config.ffr.outerRadius;
-		constants.edgeRadius = edgeRadius;
+		float radius[3];
+		GetRdmRadius(radius);
+		SetupRdmReconstructConstants(constants, radius, edgeRadius, input.inputViewport, textureWidth, textureHeight,
+			Point<float>{projX[input.eye], projY[input.eye]}, rdmPattern);
 		if (g_config.gameMode == GameMode::GENERIC_SINGLE && input.eye == vr::Eye_Right) {
 			constants.projectionCenter[0] += 1.f;
 		}
+
+		// The shader only copies the full resolution centre and everything past the edge radius. If
+		// the input can be copied from, that is done by the copy engine and only the annulus dispatched.
+		// Both leave out what the upscaler does not read.
+		bool copied = CopyRdmInput(input, constants, clip, target.texture.Get());
+		const RdmTiles &tiles = GetRdmTiles(eye, constants, copied, clip);
+		if (tiles.groupCount == 0) {
+			return target;
+		}
+
+		// set after the tile list, which is the same in every phase
+		GetRdmPhase(rdmPhases, frame, constants.phase);
+		constants.historyWeight = hasHistory ? g_config.ffr.rdmHistoryWeight : 0.f;
+
+		context->CSSetShader( rdmReconstructShader.Get(), nullptr, 0 );
+		ID3D11Buffer *emptyBind[] = {nullptr};
+		context->CSSetConstantBuffers( 0, 1, emptyBind );
 		D3D11_MAPPED_SUBRESOURCE mapped { nullptr, 0, 0 };
 		context->Map( rdmReconstructConstantsBuffer[input.eye].Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped );
 		memcpy(mapped.pData, &constants, sizeof(constants));
 		context->Unmap( rdmReconstructConstantsBuffer[input.eye].Get(), 0 );
 		UINT uavCount = -1;
-		context->CSSetUnorderedAccessViews( 0, 1, rdmReconstructedUav.GetAddressOf(), &uavCount );
+		context->CSSetUnorderedAccessViews( 0, 1, target.uav.GetAddressOf(), &uavCount );
 		context->CSSetConstantBuffers( 0, 1, rdmReconstructConstantsBuffer[input.eye].GetAddressOf() );
-		ID3D11ShaderResourceView *srvs[1] = {input.inputView};
-		context->CSSetShaderResources( 0, 1, srvs );
+		ID3D11ShaderResourceView *srvs[3] = {input.inputView, tiles.tileView.Get(), temporal ? history.view.Get() : nullptr};
+		context->CSSetShaderResources( 0, 3, srvs );
 		context->CSSetSamplers(0, 1, sampler.GetAddressOf());
-		context->Dispatch( (input.inputViewport.width + 7) / 8, (input.inputViewport.height + 7) / 8, 1 );
+		context->DispatchIndirect( tiles.dispatchArgs.Get(), 0 );
+
+		// unbind the UAV, or binding the reconstruction as the upscaler's input would fail, and the
+		// history, which is the next frame's target
+		ID3D11UnorderedAccessView *emptyUav[] = {nullptr};
+		context->CSSetUnorderedAccessViews( 0, 1, emptyUav, &uavCount );
+		ID3D11ShaderResourceView *emptySrv[] = {nullptr};
+		context->CSSetShaderResources( 2, 1, emptySrv );
+		return target;
 	}
 
-	bool D3D11PostProcessor::Apply(const D3D11PostProcessInput &input, Viewport &outputViewport) {
+	bool D3D11PostProcessor::CopyRdmInput(const D3D11PostProcessInput &input, const RdmReconstructConstants &constants, const Viewport &clip, ID3D11Texture2D *target) {
+		D3D11_SHADER_RESOURCE_VIEW_DESC svd;
+		input.inputView->GetDesc( &svd );
+		UINT slice = 0;
+		if (svd.ViewDimension == D3D11_SRV_DIMENSION_TEXTURE2DARRAY) {
+			slice = svd.Texture2DArray.FirstArraySlice;
+		} else if (svd.ViewDimension != D3D11_SRV_DIMENSION_TEXTURE2D) {
+			return false;
+		}
+
+		ComPtr<ID3D11Resource> resource;
+		input.inputView->GetResource( resource.GetAddressOf() );
+		ComPtr<ID3D11Texture2D> texture;
+		if (FAILED(resource.As( &texture ))) {
+			return false;
+		}
+		D3D11_TEXTURE2D_DESC td, rtd;
+		texture->GetDesc( &td );
+		target->GetDesc( &rtd );
+		if (td.Width != rtd.Width || td.Height != rtd.Height || !AreCopyCompatibleFormats(td.Format, rtd.Format)) {
+			return false;
+		}
+
+		// the area the dispatch would write, so the result is the same as without the copy
+		D3D11_BOX box;
+		box.left = max((UINT)constants.offset[0], clip.x);
+		box.top = max((UINT)constants.offset[1], clip.y);
+		box.front = 0;
+		box.right = min((UINT)constants.areaEnd[0], clip.x + clip.width);
+		box.bottom = min((UINT)constants.areaEnd[1], clip.y + clip.height);
+		box.back = 1;
+		if (box.left >= box.right || box.top >= box.bottom) {
+			return true;
+		}
+		context->CopySubresourceRegion( target, 0, box.left, box.top, 0, texture.Get(), D3D11CalcSubresource(0, slice, td.MipLevels), &box );
+		return true;
+	}
+
+	const D3D11PostProcessor::RdmTiles & D3D11PostProcessor::GetRdmTiles(int eye, const RdmReconstructConstants &constants, bool annulusOnly, const Viewport &clip) {
+		RdmTiles &tiles = rdmTiles[eye];
+		if (tiles.valid && tiles.annulusOnly == annulusOnly && tiles.clip == clip && memcmp(&tiles.constants, &constants, sizeof(constants)) == 0) {
+			return tiles;
+		}
+
+		std::vector<uint32_t> list;
+		uint32_t groups[3];
+		BuildRdmReconstructTiles(constants, annulusOnly, list, groups, &clip);
+		if (list.size() > tiles.tileCapacity) {
+			D3D11_BUFFER_DESC bd;
+			bd.Usage = D3D11_USAGE_DEFAULT;
+			bd.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+			bd.CPUAccessFlags = 0;
+			bd.MiscFlags = 0;
+			bd.StructureByteStride = 0;
+			bd.ByteWidth = list.size() * sizeof(uint32_t);
+			CheckResult("Creating RDM tile buffer", device->CreateBuffer( &bd, nullptr, tiles.tileBuffer.ReleaseAndGetAddressOf() ));
+			D3D11_SHADER_RESOURCE_VIEW_DESC svd;
+			svd.Format = DXGI_FORMAT_R32_UINT;
+			svd.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+			svd.Buffer.FirstElement = 0;
+			svd.Buffer.NumElements = list.size();
+			CheckResult("Creating RDM tile view", device->CreateShaderResourceView( tiles.tileBuffer.Get(), &svd, tiles.tileView.ReleaseAndGetAddressOf() ));
+			tiles.tileCapacity = list.size();
+		}
+		if (tiles.dispatchArgs == nullptr) {
+			D3D11_BUFFER_DESC bd;
+			bd.Usage = D3D11_USAGE_DEFAULT;
+			bd.BindFlags = 0;
+			bd.CPUAccessFlags = 0;
+			bd.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
+			bd.StructureByteStride = 0;
+			bd.ByteWidth = sizeof(groups);
+			CheckResult("Creating RDM dispatch arguments", device->CreateBuffer( &bd, nullptr, tiles.dispatchArgs.GetAddressOf() ));
+		}
+
+		if (!list.empty()) {
+			D3D11_BOX box { 0, 0, 0, (UINT)(list.size() * sizeof(uint32_t)), 1, 1 };
+			context->UpdateSubresource( tiles.tileBuffer.Get(), 0, &box, list.data(), 0, 0 );
+		}
+		context->UpdateSubresource( tiles.dispatchArgs.Get(), 0, nullptr, groups, 0, 0 );
+		tiles.constants = constants;
+		tiles.annulusOnly = annulusOnly;
+		tiles.clip = clip;
+		tiles.groupCount = groups[0] * groups[1] * groups[2];
+		tiles.valid = true;
+		LOG_DEBUG << "RDM reconstruction of eye " << eye << " dispatches " << tiles.groupCount << " groups" << (annulusOnly ? " for the annulus" : "");
+		return tiles;
+	}
+
+	const Viewport & D3D11PostProcessor::GetVisibleRect(const D3D11PostProcessInput &input) {
+		// Past the edge radius nothing is shaded, unless the dynamic hidden mask is switched off.
+		// RDM masks whole clusters, which may reach a cluster further out.
+		float edge = 0.f;
+		uint32_t margin = kVisibleRectMargin;
+		if (is_rdm) {
+			edge = g_config.ffr.edgeRadius;
+			margin += rdmPattern.clusterSize;
+		} else if (g_config.hiddenMask.enabled && (g_config.hiddenMask.mode != HiddenMaskMode::AREA_MESH || hiddenAreaMeshes[input.eye].empty())
+				&& (!g_config.hiddenMask.dynamic || g_config.hiddenMask.dynamicChangeRadius)) {
+			edge = max(g_config.hiddenMask.edgeRadius, g_config.hiddenMask.maxRadius);
+		}
+
+		VisibleRect &visible = visibleRects[input.eye];
+		if (visible.valid && visible.inputViewport == input.inputViewport && visible.edgeRadius == edge
+				&& visible.projectionCenter.x == input.projectionCenter.x && visible.projectionCenter.y == input.projectionCenter.y) {
+			return visible.rect;
+		}
+
+		uint32_t width = input.inputViewport.width, height = input.inputViewport.height;
+		Viewport rect = HiddenAreaMeshVisibleRect(hiddenAreaMeshes[input.eye], width, height, input.flipX, input.flipY);
+		if (edge > 0) {
+			rect = IntersectRects(rect, EdgeRadiusVisibleRect(input.projectionCenter, edge, width, height));
+		}
+		visible.rect = GrowRect(rect, margin, width, height);
+		visible.inputViewport = input.inputViewport;
+		visible.projectionCenter = input.projectionCenter;
+		visible.edgeRadius = edge;
+		visible.valid = true;
+		LOG_INFO << "Visible part of eye " << input.eye << ": " << visible.rect.width << "x" << visible.rect.height
+			<< " at " << visible.rect.x << "," << visible.rect.y << " of " << width << "x" << height;
+		return visible.rect;
+	}
+
+	bool D3D11PostProcessor::Apply(const D3D11PostProcessInput &input, Viewport &outputViewport, Viewport *visibleViewport) {
 		bool didPostprocessing = false;
+		eyeViewport = input.inputViewport;
+		if (eyeViewport.width != budgetWidth || eyeViewport.height != budgetHeight) {
+			ApplyFoveationBudget();
+		}
 /*
 		if (g_config.debugMode) {
 			StartProfiling();
@@ -580,7 +816,7 @@ namespace vrperfkit {
 		if (g_config.upscaling.enabled) {
 			try {
 				D3D11State previousState;
-				StoreD3D11State(context.Get(), previousState);
+				StoreD3D11State(context.Get(), kUpscalingState, previousState);
 
 				// Disable any RTs in case our input texture is still bound; otherwise using it as a view will fail
 				context->OMSetRenderTargets(0, nullptr, nullptr);
@@ -598,16 +834,42 @@ namespace vrperfkit {
 					}
 				}
 
+				// only the part of the eye that can be seen, which gives the same pixels there
+				D3D11PostProcessInput upscaleInput = input;
+				Viewport upscaleViewport = outputViewport;
+				UpscaleCrop crop;
+				if (g_config.upscaling.cropToVisible && CropUpscale(input.inputViewport, outputViewport, GetVisibleRect(input), input.projectionCenter, crop)) {
+					upscaleInput.inputViewport = crop.inputViewport;
+					upscaleInput.projectionCenter = crop.projectionCenter;
+					upscaleInput.radiusScale = crop.radiusScale;
+					upscaleViewport = crop.outputViewport;
+				}
+
+				// the upscaler reads the RDM reconstruction directly, the game's texture is left untouched
 				if (is_rdm) {
-					ReconstructRdmRender(input);
-					context->CopyResource(input.inputTexture, rdmReconstructedTexture.Get());
+					Viewport rdmClip = upscaleInput.inputViewport;
+					if (rdmClip != input.inputViewport) {
+						// the upscaler's taps reach a few pixels past the crop
+						rdmClip.x -= input.inputViewport.x;
+						rdmClip.y -= input.inputViewport.y;
+						rdmClip = GrowRect(rdmClip, kVisibleRectMargin, input.inputViewport.width, input.inputViewport.height);
+						rdmClip.x += input.inputViewport.x;
+						rdmClip.y += input.inputViewport.y;
+					}
+					const RdmTarget &reconstructed = ReconstructRdmRender(input, rdmClip);
+					upscaleInput.inputTexture = reconstructed.texture.Get();
+					upscaleInput.inputView = reconstructed.view.Get();
 				}
 			
-				upscaler->Upscale(input, outputViewport);
+				upscaler->Upscale(upscaleInput, upscaleViewport);
+				if (visibleViewport != nullptr) {
+					*visibleViewport = upscaleViewport;
+				}
 
 				float newLodBias = -log2f(outputViewport.width / (float)input.inputViewport.width);
 				if (newLodBias != mipLodBias) {
 					LOG_DEBUG << "MIP LOD Bias changed from " << mipLodBias << " to " << newLodBias << ", recreating samplers";
+					std::lock_guard<std::mutex> lock (samplerMutex);
 					passThroughSamplers.clear();
 					mappedSamplers.clear();
 					mipLodBias = newLodBias;
@@ -640,7 +902,8 @@ namespace vrperfkit {
 		return didPostprocessing;
 	}
 
-	bool D3D11PostProcessor::PrePSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState * const *ppSamplers) {
+	bool D3D11PostProcessor::PrePSSetSamplers(ID3D11DeviceContext *context, UINT startSlot, UINT numSamplers, ID3D11SamplerState * const *ppSamplers) {
+		std::unique_lock<std::mutex> lock (samplerMutex);
 		if (!g_config.upscaling.applyMipBias) {
 			passThroughSamplers.clear();
 			mappedSamplers.clear();
@@ -648,6 +911,8 @@ namespace vrperfkit {
 		}
 
 		ID3D11SamplerState *samplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+		// keeps the replacements alive until the context holds them, should another thread clear the maps
+		ComPtr<ID3D11SamplerState> replacements[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
 		memcpy(samplers, ppSamplers, numSamplers * sizeof(ID3D11SamplerState*));
 		for (UINT i = 0; i < numSamplers; ++i) {
 			ID3D11SamplerState *orig = samplers[i];
@@ -670,35 +935,158 @@ namespace vrperfkit {
 				passThroughSamplers.insert(mappedSamplers[orig].Get());
 			}
 
-			samplers[i] = mappedSamplers[orig].Get();
+			replacements[i] = mappedSamplers[orig];
+			samplers[i] = replacements[i].Get();
 		}
+		lock.unlock();
 
 		context->PSSetSamplers(startSlot, numSamplers, samplers);
 		return true;
 	}
 
 	void D3D11PostProcessor::PrepareUpscaler(ID3D11Texture2D *outputTexture) {
+		if (g_config.upscaling.autoSelect && !upscaleMethodSelected) {
+			D3D11_TEXTURE2D_DESC td;
+			outputTexture->GetDesc(&td);
+			AutoSelectUpscaleMethod(td);
+			upscaleMethodSelected = true;
+		}
+
 		if (upscaler == nullptr || upscaleMethod != g_config.upscaling.method) {
 			D3D11_TEXTURE2D_DESC td;
 			outputTexture->GetDesc(&td);
 			upscaleMethod = g_config.upscaling.method;
-			switch (upscaleMethod) {
-			case UpscaleMethod::FSR:
-				upscaler.reset(new D3D11FsrUpscaler(device.Get(), td.Width, td.Height, td.Format));
-				break;
-			case UpscaleMethod::NIS:
-				upscaler.reset(new D3D11NisUpscaler(device.Get()));
-				break;
-			case UpscaleMethod::CAS:
-				upscaler.reset(new D3D11CasUpscaler(device.Get()));
-				break;
-			}
+			upscaler = CreateD3D11Upscaler(device.Get(), upscaleMethod, td);
 
+			std::lock_guard<std::mutex> lock (samplerMutex);
 			passThroughSamplers.clear();
 			mappedSamplers.clear();
 		}
 	}
 
+	void D3D11PostProcessor::AutoSelectUpscaleMethod(const D3D11_TEXTURE2D_DESC &outputDesc) {
+		std::filesystem::path cachePath = g_basePath / "vrperfkit_RSF_benchmark.txt";
+		UpscalerBenchmarkCache cache;
+		cache.Load(cachePath);
+
+		UpscalerBenchmarkKey key = GetUpscalerBenchmarkKey(device.Get(), outputDesc);
+		std::vector<UpscalerCost> costs;
+		if (const std::vector<UpscalerCost> *cached = cache.Find(key)) {
+			LOG_INFO << "Using cached upscaler costs for " << outputDesc.Width << "x" << outputDesc.Height << ":";
+			costs = *cached;
+			for (const UpscalerCost &cost : costs) {
+				LOG_INFO << "  " << MethodToString(cost.method) << ": " << cost.milliseconds << " ms";
+			}
+		} else {
+			LOG_INFO << "Measuring upscaler costs for " << outputDesc.Width << "x" << outputDesc.Height << ":";
+			costs = BenchmarkD3D11Upscalers(device.Get(), outputDesc);
+			if (!costs.empty()) {
+				cache.Store(key, costs);
+				cache.Save(cachePath);
+			}
+		}
+
+		UpscaleMethod selected;
+		if (SelectFastestMethod(costs, g_config.upscaling.qualityTier, selected)) {
+			LOG_INFO << "Selected " << MethodToString(selected) << " as the fastest method for the " << QualityTierToString(g_config.upscaling.qualityTier) << " quality tier";
+			g_config.upscaling.method = selected;
+		} else {
+			LOG_INFO << "No measured upscaler meets the " << QualityTierToString(g_config.upscaling.qualityTier) << " quality tier, keeping " << MethodToString(g_config.upscaling.method);
+		}
+	}
+
+
+	void D3D11PostProcessor::GetRdmRadius(float radius[3]) const {
+		// checkerboard rendering of the whole eye starts its only ring at the centre
+		radius[0] = is_checkerboard && g_config.ffr.checkerboardWholeEye ? 0.f : g_config.ffr.innerRadius;
+		radius[1] = g_config.ffr.midRadius;
+		radius[2] = g_config.ffr.outerRadius;
+	}
+
+	std::string D3D11PostProcessor::PredictRadiusStep(FoveationMethod method, float step) const {
+		FoveationSetup setup;
+		setup.method = method;
+		setup.radii.inner = method == FoveationMethod::RDM && is_checkerboard && g_config.ffr.checkerboardWholeEye ? 0.f : g_config.ffr.innerRadius;
+		setup.radii.mid = g_config.ffr.midRadius;
+		setup.radii.outer = g_config.ffr.outerRadius;
+		setup.radii.edge = edgeRadius;
+		setup.width = eyeViewport.width;
+		setup.height = eyeViewport.height;
+		setup.projectionCenter = Point<float>{projX[0], projY[0]};
+		setup.verticalOffset = g_config.ffr.verticalOffset;
+		setup.rdmPattern = rdmPattern;
+		double before = EstimateFoveation(setup).ShadedFraction();
+		if (method == FoveationMethod::HRM) {
+			setup.radii.edge += step;
+		} else {
+			setup.radii.inner += step;
+			setup.radii.mid += step;
+			setup.radii.outer += step;
+		}
+		double after = EstimateFoveation(setup).ShadedFraction();
+
+		std::ostringstream ss;
+		ss << FoveationMethodToString(method) << " radius step " << std::showpos << step << std::noshowpos
+			<< ", predicted shading " << std::setprecision(4) << before * 100 << "% -> " << after * 100 << "% of pixels";
+		return ss.str();
+	}
+
+	void D3D11PostProcessor::ApplyFoveationBudget() {
+		budgetWidth = eyeViewport.width;
+		budgetHeight = eyeViewport.height;
+
+		FoveationSetup setup;
+		setup.radii.inner = g_config.ffr.innerRadius;
+		setup.radii.mid = g_config.ffr.midRadius;
+		setup.radii.outer = g_config.ffr.outerRadius;
+		setup.radii.edge = edgeRadius;
+		setup.width = eyeViewport.width;
+		setup.height = eyeViewport.height;
+		setup.projectionCenter = Point<float>{projX[0], projY[0]};
+		setup.verticalOffset = g_config.ffr.verticalOffset;
+		setup.rdmPattern = rdmPattern;
+
+		if (is_checkerboard && g_config.ffr.checkerboardWholeEye && g_config.ffr.targetSavings > 0) {
+			LOG_INFO << "Checkerboard rendering of the whole eye has no radius to meet the FFR target saving with";
+		} else if (g_config.ffr.enabled && g_config.ffr.targetSavings > 0) {
+			setup.method = is_rdm ? FoveationMethod::RDM : FoveationMethod::VRS;
+			FoveationBudget budget;
+			budget.targetSavings = g_config.ffr.targetSavings;
+			budget.minRadius = g_config.ffr.minRadius;
+			FoveationRadii radii;
+			if (SolveFoveationRadii(setup, budget, radii)) {
+				// the dynamic radius steps keep their configured range
+				g_config.ffr.innerRadius = radii.inner;
+				g_config.ffr.midRadius = radii.mid;
+				g_config.ffr.outerRadius = radii.outer;
+				g_config.ffr.radiusChanged[0] = g_config.ffr.radiusChanged[1] = true;
+				setup.radii = radii;
+				LOG_INFO << "FFR radii for " << setup.width << "x" << setup.height << ": " << radii.inner << ", " << radii.mid << ", " << radii.outer
+					<< ", saving " << EstimateFoveation(setup).Savings() * 100 << "%";
+			} else {
+				LOG_ERROR << "FFR can't save " << g_config.ffr.targetSavings * 100 << "% above the minimum radius " << g_config.ffr.minRadius
+					<< ", keeping the configured radii";
+			}
+		}
+
+		if (g_config.hiddenMask.enabled && g_config.hiddenMask.targetSavings > 0) {
+			setup.method = FoveationMethod::HRM;
+			FoveationBudget budget;
+			budget.targetSavings = g_config.hiddenMask.targetSavings;
+			budget.minRadius = g_config.hiddenMask.minRadius;
+			FoveationRadii radii;
+			if (SolveFoveationRadii(setup, budget, radii)) {
+				g_config.hiddenMask.edgeRadius = radii.edge;
+				edgeRadius = radii.edge;
+				setup.radii = radii;
+				LOG_INFO << "HRM edge radius for " << setup.width << "x" << setup.height << ": " << radii.edge
+					<< ", saving " << EstimateFoveation(setup).Savings() * 100 << "%";
+			} else {
+				LOG_ERROR << "HRM can't save " << g_config.hiddenMask.targetSavings * 100 << "% above the minimum radius " << g_config.hiddenMask.minRadius
+					<< ", keeping the configured edge radius";
+			}
+		}
+	}
 
 	void D3D11PostProcessor::StartDynamicProfiling() {
 		++dynamicSleepCount;
@@ -728,6 +1116,7 @@ namespace vrperfkit {
 				if (frameTime > g_config.hiddenMask.targetFrameTime) {
 					if (g_config.hiddenMask.dynamicChangeRadius) {
 						if ((edgeRadius - g_config.hiddenMask.decreaseRadiusStep) >= g_config.hiddenMask.minRadius) {
+							LOG_DEBUG << PredictRadiusStep(FoveationMethod::HRM, -g_config.hiddenMask.decreaseRadiusStep);
 							edgeRadius -= g_config.hiddenMask.decreaseRadiusStep;
 						}
 					} else {
@@ -736,6 +1125,7 @@ namespace vrperfkit {
 				} else if (frameTime < g_config.hiddenMask.marginFrameTime) {
 					if (g_config.hiddenMask.dynamicChangeRadius) {
 						if ((edgeRadius + g_config.hiddenMask.increaseRadiusStep) <= g_config.hiddenMask.maxRadius) {
+							LOG_DEBUG << PredictRadiusStep(FoveationMethod::HRM, g_config.hiddenMask.increaseRadiusStep);
 							edgeRadius += g_config.hiddenMask.increaseRadiusStep;
 						}
 					} else {
@@ -749,6 +1139,7 @@ namespace vrperfkit {
 				if (frameTime > g_config.ffr.targetFrameTime) {
 					if (g_config.ffr.dynamicChangeRadius) {
 						if ((g_config.ffr.innerRadius - g_config.ffr.decreaseRadiusStep) >= g_config.ffr.minRadius) {
+							LOG_DEBUG << PredictRadiusStep(is_rdm ? FoveationMethod::RDM : FoveationMethod::VRS, -g_config.ffr.decreaseRadiusStep);
 							g_config.ffr.innerRadius -= g_config.ffr.decreaseRadiusStep;
 							g_config.ffr.midRadius -= g_config.ffr.decreaseRadiusStep;
 							g_config.ffr.outerRadius -= g_config.ffr.decreaseRadiusStep;
@@ -761,6 +1152,7 @@ namespace vrperfkit {
 				} else if (frameTime < g_config.ffr.marginFrameTime) {
 					if (g_config.ffr.dynamicChangeRadius) {
 						if ((g_config.ffr.innerRadius + g_config.ffr.increaseRadiusStep) <= g_config.ffr.maxRadius) {
+							LOG_DEBUG << PredictRadiusStep(is_rdm ? FoveationMethod::RDM : FoveationMethod::VRS, g_config.ffr.increaseRadiusStep);
 							g_config.ffr.innerRadius += g_config.ffr.increaseRadiusStep;
 							g_config.ffr.midRadius += g_config.ffr.increaseRadiusStep;
 							g_config.ffr.outerRadius += g_config.ffr.increaseRadiusStep;
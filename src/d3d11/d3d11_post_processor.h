@@ -2,8 +2,13 @@
 #include "types.h"
 #include "d3d11_helper.h"
 #include "d3d11_injector.h"
+#include "foveation_estimate.h"
+#include "hrm/mask_mesh.h"
+#include "hrm/radial_density_mask.h"
 
 #include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -20,6 +25,11 @@ namespace vrperfkit {
 		int eye;
 		TextureMode mode;
 		Point<float> projectionCenter;
+		// upscaling.radius is relative to the eye's height, inputViewport may only be the visible part of it
+		float radiusScale = 1.f;
+		// the eye is stored mirrored in its texture, as with flipped OpenVR texture bounds
+		bool flipX = false;
+		bool flipY = false;
 	};
 
 	class D3D11Upscaler {
@@ -27,26 +37,36 @@ namespace vrperfkit {
 		virtual void Upscale(const D3D11PostProcessInput &input, const Viewport &outputViewport) = 0;
 	};
 
+	std::unique_ptr<D3D11Upscaler> CreateD3D11Upscaler(ID3D11Device *device, UpscaleMethod method, const D3D11_TEXTURE2D_DESC &outputDesc);
+
 	class D3D11PostProcessor : public D3D11Listener {
 	public:
 		D3D11PostProcessor(ComPtr<ID3D11Device> device);
 
-		HRESULT ClearDepthStencilView(ID3D11DepthStencilView *pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil);
+		HRESULT ClearDepthStencilView(ID3D11DeviceContext *context, ID3D11DepthStencilView *pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil) override;
 
-		bool Apply(const D3D11PostProcessInput &input, Viewport &outputViewport);
+		// With upscaling.cropToVisible, only the visible part of outputViewport is written, which
+		// visibleViewport receives. It is outputViewport if the eye is not cropped.
+		bool Apply(const D3D11PostProcessInput &input, Viewport &outputViewport, Viewport *visibleViewport = nullptr);
 
-		bool PrePSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState * const *ppSamplers) override;
+		bool PrePSSetSamplers(ID3D11DeviceContext *context, UINT startSlot, UINT numSamplers, ID3D11SamplerState * const *ppSamplers) override;
 
 		void D3D11PostProcessor::SetProjCenters(float LX, float LY, float RX, float RY);
+		// the runtime's hidden area mesh of an eye as a triangle list in eye texture coordinates, for hiddenMask.mode
+		void D3D11PostProcessor::SetHiddenAreaMesh(int eye, const std::vector<Point<float>> &triangles);
 
 	private:
 		ComPtr<ID3D11Device> device;
 		ComPtr<ID3D11DeviceContext> context;
 		std::unique_ptr<D3D11Upscaler> upscaler;
 		UpscaleMethod upscaleMethod;
+		bool upscaleMethodSelected = false;
 
 		void PrepareUpscaler(ID3D11Texture2D *outputTexture);
+		void AutoSelectUpscaleMethod(const D3D11_TEXTURE2D_DESC &outputDesc);
 
+		// PrePSSetSamplers runs on the threads recording deferred contexts as well
+		std::mutex samplerMutex;
 		std::unordered_set<ID3D11SamplerState*> passThroughSamplers;
 		std::unordered_map<ID3D11SamplerState*, ComPtr<ID3D11SamplerState>> mappedSamplers;
 		float mipLodBias = 0.0f;
@@ -64,14 +84,27 @@ namespace vrperfkit {
 		bool enableDynamic = false;
 		bool hiddenMaskApply = false;
 		bool is_rdm = false;
+		// checkerboard rendering takes the RDM path with its own pattern, phases and reconstruction shader
+		bool is_checkerboard = false;
+		RdmPattern rdmPattern;
+		uint32_t rdmPhases = 1;
 		bool preciseResolution = false;
 		int ignoreFirstTargetRenders = 0;
 		int ignoreLastTargetRenders = 0;
 		int renderOnlyTarget = 0;
 
+		// the ffr radii the RDM mask and reconstruction start their rings at
+		void GetRdmRadius(float radius[3]) const;
+
 		void CreateDynamicProfileQueries();
 		void StartDynamicProfiling();
 		void EndDynamicProfiling();
+		// describes the shading work before and after moving the foveation radii by step, for the debug log
+		std::string PredictRadiusStep(FoveationMethod method, float step) const;
+		// solves the radii for the configured shading budgets once the eye resolution is known
+		void ApplyFoveationBudget();
+		uint32_t budgetWidth = 0;
+		uint32_t budgetHeight = 0;
 
 		ComPtr<ID3D11Texture2D> copiedTexture;
 		ComPtr<ID3D11ShaderResourceView> copiedTextureView;
@@ -81,15 +114,26 @@ namespace vrperfkit {
 		uint32_t textureHeight = 0;
 		bool requiresCopy = false;
 		bool inputIsSrgb = false;
-		ComPtr<ID3D11VertexShader> hrmFullTriVertexShader;
-		ComPtr<ID3D11PixelShader> hrmMaskingShader;
-		ComPtr<ID3D11PixelShader> rdmMaskingShader;
+		ComPtr<ID3D11VertexShader> maskMeshVertexShader;
+		ComPtr<ID3D11VertexShader> maskMeshArrayVertexShader;
+		ComPtr<ID3D11InputLayout> maskMeshInputLayout;
+		ComPtr<ID3D11Buffer> maskMeshConstantsBuffer;
+		MaskMeshConstants uploadedMaskMeshConstants;
+		bool maskMeshConstantsValid = false;
 		ComPtr<ID3D11ComputeShader> rdmReconstructShader;
-		ComPtr<ID3D11Buffer> hrmMaskingConstantsBuffer[2];
 		ComPtr<ID3D11Buffer> rdmReconstructConstantsBuffer[2];
-		ComPtr<ID3D11Texture2D> rdmReconstructedTexture;
-		ComPtr<ID3D11UnorderedAccessView> rdmReconstructedUav;
-		ComPtr<ID3D11ShaderResourceView> rdmReconstructedView;
+		// RDM reconstructions the upscaler reads. With temporal RDM, each eye alternates between two
+		// of them, the other one holding its previous frame, otherwise all eyes use the first.
+		struct RdmTarget {
+			ComPtr<ID3D11Texture2D> texture;
+			ComPtr<ID3D11UnorderedAccessView> uav;
+			ComPtr<ID3D11ShaderResourceView> view;
+		};
+		RdmTarget rdmTargets[4];
+		// frames reconstructed per eye, they pick the phase of the eye's mask and its target
+		uint32_t rdmFrame[2] = {};
+		bool rdmHistoryValid[2] = {};
+		Viewport rdmHistoryViewport[2] {};
 		ComPtr<ID3D11DepthStencilState> hrmDepthStencilState;
 		ComPtr<ID3D11RasterizerState> hrmRasterizerState;
 		float projX[2];
@@ -97,18 +141,66 @@ namespace vrperfkit {
 		int depthClearCount = 0;
 		int depthClearCountMax = 0;
 		float edgeRadius = 1.15f;
+		Viewport eyeViewport {};
+
+		// mask mesh of the last radii and render size, for the left eye, the right eye and both at once,
+		// in each phase of temporal RDM
+		struct MaskMesh {
+			bool valid = false;
+			int eyeCount = 0;
+			RdmMaskingConstants constants[2];
+			Viewport viewports[2];
+			ComPtr<ID3D11Buffer> vertexBuffer;
+			UINT vertexCount = 0;
+			UINT secondEyeVertex = 0;
+		};
+		MaskMesh maskMeshes[3][4];
+		std::vector<Point<float>> hiddenAreaMeshes[2];
+
+		// the visible part of an eye's input viewport, see visible_bounds.h, found again when the
+		// viewport, the projection centre or the edge radius changes
+		struct VisibleRect {
+			bool valid = false;
+			Viewport inputViewport;
+			Point<float> projectionCenter;
+			float edgeRadius = 0.f;
+			Viewport rect;
+		};
+		VisibleRect visibleRects[2];
+
+		// tile list of an eye's reconstruction dispatch, rebuilt when its constants change
+		struct RdmTiles {
+			bool valid = false;
+			bool annulusOnly = false;
+			RdmReconstructConstants constants;
+			Viewport clip;
+			ComPtr<ID3D11Buffer> tileBuffer;
+			ComPtr<ID3D11ShaderResourceView> tileView;
+			UINT tileCapacity = 0;
+			ComPtr<ID3D11Buffer> dispatchArgs;
+			UINT groupCount = 0;
+		};
+		RdmTiles rdmTiles[2];
 		
 		struct DepthStencilViews {
 			ComPtr<ID3D11DepthStencilView> view[2];
+			ComPtr<ID3D11DepthStencilView> bothSlices;
 		};
-		std::unordered_map<ID3D11Texture2D*, DepthStencilViews> depthStencilViews;
+		// games usually mask one or two depth targets, a few more are kept for scene changes
+		D3D11ViewCache<DepthStencilViews> depthStencilViews { 16 };
 
 		bool D3D11PostProcessor::HasBlacklistedTextureName(ID3D11Texture2D *tex);
 		ID3D11DepthStencilView * D3D11PostProcessor::GetDepthStencilView(ID3D11Texture2D *depthStencilTex, vr::EVREye eye);
+		ID3D11DepthStencilView * D3D11PostProcessor::GetStereoDepthStencilView(ID3D11Texture2D *depthStencilTex);
 		void D3D11PostProcessor::PrepareResources(ID3D11Texture2D *inputTexture);
 		void D3D11PostProcessor::PrepareCopyResources(DXGI_FORMAT format);
 		void D3D11PostProcessor::PrepareRdmResources(DXGI_FORMAT format);
 		void D3D11PostProcessor::ApplyRadialDensityMask(ID3D11Texture2D *depthStencilTex, float depth, uint8_t stencil);
-		void D3D11PostProcessor::ReconstructRdmRender(const D3D11PostProcessInput &input);
+		const MaskMesh & D3D11PostProcessor::GetMaskMesh(int slot, uint32_t phaseIndex, const RdmMaskingConstants *constants, const Viewport *viewports, int eyeCount);
+		void D3D11PostProcessor::DrawMaskMesh(const MaskMesh &mesh);
+		const RdmTarget & D3D11PostProcessor::ReconstructRdmRender(const D3D11PostProcessInput &input, const Viewport &clip);
+		bool D3D11PostProcessor::CopyRdmInput(const D3D11PostProcessInput &input, const RdmReconstructConstants &constants, const Viewport &clip, ID3D11Texture2D *target);
+		const RdmTiles & D3D11PostProcessor::GetRdmTiles(int eye, const RdmReconstructConstants &constants, bool annulusOnly, const Viewport &clip);
+		const Viewport & D3D11PostProcessor::GetVisibleRect(const D3D11PostProcessInput &input);
 	};
 }
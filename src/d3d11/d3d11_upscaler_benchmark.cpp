@@ -0,0 +1,150 @@
+#include "d3d11_upscaler_benchmark.h"
+#include "d3d11_helper.h"
+#include "d3d11_post_processor.h"
+#include "config.h"
+#include "logging.h"
+
+#include <dxgi.h>
+
+namespace vrperfkit {
+	namespace {
+		const int kWarmupIterations = 2;
+		const int kTimedIterations = 8;
+		const DWORD kQueryTimeoutMs = 1000;
+
+		bool WaitForQuery(ID3D11DeviceContext *context, ID3D11Query *query, void *data, UINT size) {
+			DWORD start = GetTickCount();
+			HRESULT result;
+			while ((result = context->GetData(query, data, size, 0)) == S_FALSE) {
+				if (GetTickCount() - start > kQueryTimeoutMs) {
+					return false;
+				}
+				Sleep(0);
+			}
+			return result == S_OK;
+		}
+
+		ComPtr<ID3D11Query> CreateQuery(ID3D11Device *device, D3D11_QUERY type) {
+			D3D11_QUERY_DESC qd;
+			qd.Query = type;
+			qd.MiscFlags = 0;
+			ComPtr<ID3D11Query> query;
+			CheckResult("creating benchmark query", device->CreateQuery(&qd, query.GetAddressOf()));
+			return query;
+		}
+
+		// returns the average GPU time of one upscaling pass in milliseconds, or a negative value on failure
+		float TimeUpscaler(ID3D11Device *device, ID3D11DeviceContext *context, D3D11Upscaler &upscaler, const D3D11PostProcessInput &input, const Viewport &outputViewport) {
+			ComPtr<ID3D11Query> disjoint = CreateQuery(device, D3D11_QUERY_TIMESTAMP_DISJOINT);
+			ComPtr<ID3D11Query> start = CreateQuery(device, D3D11_QUERY_TIMESTAMP);
+			ComPtr<ID3D11Query> end = CreateQuery(device, D3D11_QUERY_TIMESTAMP);
+
+			for (int i = 0; i < kWarmupIterations; ++i) {
+				upscaler.Upscale(input, outputViewport);
+			}
+
+			context->Begin(disjoint.Get());
+			context->End(start.Get());
+			for (int i = 0; i < kTimedIterations; ++i) {
+				upscaler.Upscale(input, outputViewport);
+			}
+			context->End(end.Get());
+			context->End(disjoint.Get());
+			context->Flush();
+
+			D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjointData;
+			UINT64 startTime, endTime;
+			if (!WaitForQuery(context, disjoint.Get(), &disjointData, sizeof(disjointData))
+					|| !WaitForQuery(context, start.Get(), &startTime, sizeof(startTime))
+					|| !WaitForQuery(context, end.Get(), &endTime, sizeof(endTime))) {
+				return -1;
+			}
+			if (disjointData.Disjoint || disjointData.Frequency == 0) {
+				return -1;
+			}
+			return (endTime - startTime) * 1000.0 / disjointData.Frequency / kTimedIterations;
+		}
+
+		// the input of the benchmark, from the output size and the render scale
+		Viewport BenchmarkInputViewport(const D3D11_TEXTURE2D_DESC &outputDesc) {
+			return Viewport{0, 0, uint32_t(outputDesc.Width * g_config.upscaling.renderScale), uint32_t(outputDesc.Height * g_config.upscaling.renderScale)};
+		}
+	}
+
+	std::vector<UpscalerCost> BenchmarkD3D11Upscalers(ID3D11Device *device, const D3D11_TEXTURE2D_DESC &outputDesc) {
+		ComPtr<ID3D11DeviceContext> context;
+		device->GetImmediateContext(context.GetAddressOf());
+
+		// scratch textures in a UAV compatible format with the same precision as the real output
+		D3D11_TEXTURE2D_DESC scratchDesc = outputDesc;
+		scratchDesc.Format = IsFloatFormat(TranslateTypelessFormats(outputDesc.Format)) ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+		Viewport inputViewport = BenchmarkInputViewport(outputDesc);
+		ComPtr<ID3D11Texture2D> inputTexture = CreatePostProcessTexture(device, inputViewport.width, inputViewport.height, scratchDesc.Format);
+		ComPtr<ID3D11Texture2D> outputTexture = CreatePostProcessTexture(device, outputDesc.Width, outputDesc.Height, scratchDesc.Format);
+		ComPtr<ID3D11ShaderResourceView> inputView = CreateShaderResourceView(device, inputTexture.Get());
+		ComPtr<ID3D11ShaderResourceView> outputView = CreateShaderResourceView(device, outputTexture.Get());
+		ComPtr<ID3D11UnorderedAccessView> outputUav = CreateUnorderedAccessView(device, outputTexture.Get());
+
+		D3D11PostProcessInput input;
+		input.inputTexture = inputTexture.Get();
+		input.outputTexture = outputTexture.Get();
+		input.inputView = inputView.Get();
+		input.outputView = outputView.Get();
+		input.outputUav = outputUav.Get();
+		input.inputViewport = inputViewport;
+		input.eye = LEFT_EYE;
+		input.mode = TextureMode::SINGLE;
+		input.projectionCenter = Point<float>{0.5f, 0.5f};
+		Viewport outputViewport {0, 0, outputDesc.Width, outputDesc.Height};
+
+		D3D11_TEXTURE2D_DESC upscalerDesc;
+		outputTexture->GetDesc(&upscalerDesc);
+
+		std::vector<UpscalerCost> costs;
+		for (UpscaleMethod method : {UpscaleMethod::FSR, UpscaleMethod::NIS, UpscaleMethod::CAS, UpscaleMethod::LANCZOS}) {
+			try {
+				std::unique_ptr<D3D11Upscaler> upscaler = CreateD3D11Upscaler(device, method, upscalerDesc);
+				float milliseconds = TimeUpscaler(device, context.Get(), *upscaler, input, outputViewport);
+				if (milliseconds < 0) {
+					LOG_INFO << "  " << MethodToString(method) << ": measurement failed";
+					continue;
+				}
+				LOG_INFO << "  " << MethodToString(method) << ": " << milliseconds << " ms";
+				costs.push_back(UpscalerCost{method, milliseconds});
+			}
+			catch (const std::exception &e) {
+				LOG_ERROR << "  " << MethodToString(method) << ": " << e.what();
+			}
+		}
+		return costs;
+	}
+
+	UpscalerBenchmarkKey GetUpscalerBenchmarkKey(ID3D11Device *device, const D3D11_TEXTURE2D_DESC &outputDesc) {
+		UpscalerBenchmarkKey key;
+		key.width = outputDesc.Width;
+		key.height = outputDesc.Height;
+		Viewport inputViewport = BenchmarkInputViewport(outputDesc);
+		key.inputWidth = inputViewport.width;
+		key.inputHeight = inputViewport.height;
+		// the shader permutations the benchmark runs, with the radius test as the upscalers pick it
+		// for the centred projection of the benchmark input
+		float radius = 0.5f * g_config.upscaling.radius * outputDesc.Height;
+		bool radiusTest = NeedsRadiusTest(outputDesc.Width, outputDesc.Height, 0.5f * outputDesc.Width, 0.5f * outputDesc.Height, radius);
+		key.settings = (g_config.upscaling.halfPrecision ? 1 : 0)
+			| (g_config.upscaling.peripheryFilter == PeripheryFilter::LANCZOS ? 2 : 0)
+			| (g_config.upscaling.nisPerformance ? 4 : 0)
+			| (radiusTest ? 8 : 0)
+			| (g_config.debugMode ? 16 : 0);
+
+		ComPtr<IDXGIDevice> dxgiDevice;
+		ComPtr<IDXGIAdapter> adapter;
+		DXGI_ADAPTER_DESC desc;
+		if (SUCCEEDED(device->QueryInterface(dxgiDevice.GetAddressOf()))
+				&& SUCCEEDED(dxgiDevice->GetAdapter(adapter.GetAddressOf()))
+				&& SUCCEEDED(adapter->GetDesc(&desc))) {
+			key.vendorId = desc.VendorId;
+			key.deviceId = desc.DeviceId;
+		}
+		return key;
+	}
+}
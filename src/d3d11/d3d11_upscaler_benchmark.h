@@ -0,0 +1,13 @@
+#pragma once
+#include "upscaler_selection.h"
+
+#include <d3d11.h>
+#include <vector>
+
+namespace vrperfkit {
+	// Times each upscaling method on scratch textures of the size of outputDesc, using GPU timestamp
+	// queries. Methods that fail to initialize or whose measurement is invalid are left out.
+	std::vector<UpscalerCost> BenchmarkD3D11Upscalers(ID3D11Device *device, const D3D11_TEXTURE2D_DESC &outputDesc);
+
+	UpscalerBenchmarkKey GetUpscalerBenchmarkKey(ID3D11Device *device, const D3D11_TEXTURE2D_DESC &outputDesc);
+}
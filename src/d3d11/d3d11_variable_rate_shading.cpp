@@ -1,19 +1,15 @@
 #include "d3d11_variable_rate_shading.h"
 #include "config.h"
+#include "foveation_estimate.h"
 #include "logging.h"
 
 namespace vrperfkit {
 	uint8_t DistanceToVRSLevel(float distance) {
-		if (distance < g_config.ffr.innerRadius) {
-			return 0;
-		}
-		if (distance < g_config.ffr.midRadius) {
-			return 1;
-		}
-		if (distance < g_config.ffr.outerRadius) {
-			return 2;
-		}
-		return 3;
+		FoveationRadii radii;
+		radii.inner = g_config.ffr.innerRadius;
+		radii.mid = g_config.ffr.midRadius;
+		radii.outer = g_config.ffr.outerRadius;
+		return DistanceToVRSLevel(distance, radii);
 	}
 
 	bool ResolutionMatches(int actualSize, int targetSize) {
@@ -29,18 +25,11 @@ namespace vrperfkit {
 
 		for (int y = 0; y < height; ++y) {
 			for (int x = 0; x < halfWidth; ++x) {
-				float fx = float(x) / halfWidth;
-				float fy = float(y) / height;
-				float distance = 2 * sqrtf((fx - leftProjX) * (fx - leftProjX) + (fy - leftProjY - g_config.ffr.verticalOffset) *
-																					 (fy - leftProjY - g_config.ffr.verticalOffset)); //<----------modified this
+				float distance = VrsPatternDistance(x, y, halfWidth, height, leftProjX, leftProjY, g_config.ffr.verticalOffset);
 				data[y * width + x] = DistanceToVRSLevel(distance);
 			}
 			for (int x = halfWidth; x < width; ++x) {
-				float fx = float(x - halfWidth) / halfWidth;
-				float fy = float(y) / height;
-				float distance =
-					2 * sqrtf((fx - rightProjX) * (fx - rightProjX) +
-							  (fy - rightProjY - g_config.ffr.verticalOffset) * (fy - rightProjY - g_config.ffr.verticalOffset)); //<----------modified this
+				float distance = VrsPatternDistance(x - halfWidth, y, halfWidth, height, rightProjX, rightProjY, g_config.ffr.verticalOffset);
 				data[y * width + x] = DistanceToVRSLevel(distance);
 			}
 		}
@@ -53,10 +42,7 @@ namespace vrperfkit {
 
 		for (int y = 0; y < height; ++y) {
 			for (int x = 0; x < width; ++x) {
-				float fx = float(x) / width;
-				float fy = float(y) / height;
-				float distance = 2 * sqrtf((fx - projX) * (fx - projX) +
-										   (fy - projY - g_config.ffr.verticalOffset) * (fy - projY - g_config.ffr.verticalOffset)); //<----------modified this
+				float distance = VrsPatternDistance(x, y, width, height, projX, projY, g_config.ffr.verticalOffset);
 				data[y * width + x] = DistanceToVRSLevel(distance);
 			}
 		}
@@ -67,7 +53,7 @@ namespace vrperfkit {
 	D3D11VariableRateShading::D3D11VariableRateShading(ComPtr<ID3D11Device> device) {
 		active = false;
 
-		if (!g_config.ffr.enabled || g_config.ffr.method == FixedFoveatedMethod::RDM) {
+		if (!g_config.ffr.enabled || g_config.ffr.method != FixedFoveatedMethod::VRS) {
 			return;
 		}
 
@@ -140,8 +126,13 @@ namespace vrperfkit {
 		}
 	}
 
-	void D3D11VariableRateShading::PostOMSetRenderTargets(UINT numViews, ID3D11RenderTargetView * const *renderTargetViews,
+	void D3D11VariableRateShading::PostOMSetRenderTargets(ID3D11DeviceContext *context, UINT numViews, ID3D11RenderTargetView * const *renderTargetViews,
 			ID3D11DepthStencilView *depthStencilView) {
+		if (context != this->context.Get()) {
+			// the shading rate is set on the immediate context, and the render target counts only
+			// follow its order
+			return;
+		}
 		if (!active || numViews == 0 || renderTargetViews == nullptr || renderTargetViews[0] == nullptr || !g_config.ffr.apply || !g_config.ffrApplyFastMode) {
 			DisableVRS();
 			return;
@@ -37,7 +37,7 @@ namespace {
 	}
 
 	HMODULE WINAPI Hook_LoadLibraryA(LPCSTR lpFileName) {
-		HMODULE handle = vrperfkit::hooks::CallOriginal(Hook_LoadLibraryA)(lpFileName);
+		HMODULE handle = vrperfkit::hooks::Original<Hook_LoadLibraryA>()(lpFileName);
 
 		if (handle != nullptr && handle != vrperfkit::g_moduleSelf) {
 			LOG_DEBUG << "LoadLibraryA(" << lpFileName << ")";
@@ -48,7 +48,7 @@ namespace {
 	}
 
 	HMODULE WINAPI Hook_LoadLibraryExA(LPCSTR lpFileName, HANDLE hFile, DWORD dwFlags) {
-		HMODULE handle = vrperfkit::hooks::CallOriginal(Hook_LoadLibraryExA)(lpFileName, hFile, dwFlags);
+		HMODULE handle = vrperfkit::hooks::Original<Hook_LoadLibraryExA>()(lpFileName, hFile, dwFlags);
 
 		if (handle != nullptr && handle != vrperfkit::g_moduleSelf && (dwFlags & (LOAD_LIBRARY_AS_DATAFILE | LOAD_LIBRARY_AS_DATAFILE_EXCLUSIVE | LOAD_LIBRARY_AS_IMAGE_RESOURCE)) == 0) {
 			LOG_DEBUG << "LoadLibraryExA(" << lpFileName << ")";
@@ -59,7 +59,7 @@ namespace {
 	}
 
 	HMODULE WINAPI Hook_LoadLibraryW(LPCWSTR lpFileName) {
-		HMODULE handle = vrperfkit::hooks::CallOriginal(Hook_LoadLibraryW)(lpFileName);
+		HMODULE handle = vrperfkit::hooks::Original<Hook_LoadLibraryW>()(lpFileName);
 
 		if (handle != nullptr && handle != vrperfkit::g_moduleSelf) {
 			LOG_DEBUG << "LoadLibraryW(" << lpFileName << ")";
@@ -70,7 +70,7 @@ namespace {
 	}
 
 	HMODULE WINAPI Hook_LoadLibraryExW(LPCWSTR lpFileName, HANDLE hFile, DWORD dwFlags) {
-		HMODULE handle = vrperfkit::hooks::CallOriginal(Hook_LoadLibraryExW)(lpFileName, hFile, dwFlags);
+		HMODULE handle = vrperfkit::hooks::Original<Hook_LoadLibraryExW>()(lpFileName, hFile, dwFlags);
 
 		if (handle != nullptr && handle != vrperfkit::g_moduleSelf && (dwFlags & (LOAD_LIBRARY_AS_DATAFILE | LOAD_LIBRARY_AS_DATAFILE_EXCLUSIVE | LOAD_LIBRARY_AS_IMAGE_RESOURCE)) == 0) {
 			LOG_DEBUG << "LoadLibraryExW(" << lpFileName << ")";
@@ -102,10 +102,10 @@ namespace {
 		}
 
 		vrperfkit::hooks::Init();
-		vrperfkit::hooks::InstallHook("LoadLibraryA", (void*)&LoadLibraryA, (void*)&Hook_LoadLibraryA);
-		vrperfkit::hooks::InstallHook("LoadLibraryExA", (void*)&LoadLibraryExA, (void*)&Hook_LoadLibraryExA);
-		vrperfkit::hooks::InstallHook("LoadLibraryW", (void*)LoadLibraryW, (void*)Hook_LoadLibraryW);
-		vrperfkit::hooks::InstallHook("LoadLibraryExW", (void*)&LoadLibraryExW, (void*)&Hook_LoadLibraryExW);
+		vrperfkit::hooks::InstallHook<Hook_LoadLibraryA>("LoadLibraryA", (void*)&LoadLibraryA);
+		vrperfkit::hooks::InstallHook<Hook_LoadLibraryExA>("LoadLibraryExA", (void*)&LoadLibraryExA);
+		vrperfkit::hooks::InstallHook<Hook_LoadLibraryW>("LoadLibraryW", (void*)LoadLibraryW);
+		vrperfkit::hooks::InstallHook<Hook_LoadLibraryExW>("LoadLibraryExW", (void*)&LoadLibraryExW);
 		InstallVrHooks();
 	}
 
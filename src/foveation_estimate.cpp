@@ -0,0 +1,235 @@
+#include "foveation_estimate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace vrperfkit {
+	uint8_t DistanceToVRSLevel(float distance, const FoveationRadii &radii) {
+		if (distance < radii.inner) {
+			return 0;
+		}
+		if (distance < radii.mid) {
+			return 1;
+		}
+		if (distance < radii.outer) {
+			return 2;
+		}
+		return 3;
+	}
+
+	float VrsPatternDistance(int x, int y, int width, int height, float projX, float projY, float verticalOffset) {
+		float fx = float(x) / width;
+		float fy = float(y) / height;
+		return 2 * sqrtf((fx - projX) * (fx - projX) + (fy - projY - verticalOffset) * (fy - projY - verticalOffset));
+	}
+
+	FoveationMethod FoveationMethodFromString(std::string s) {
+		std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+		if (s == "vrs") {
+			return FoveationMethod::VRS;
+		}
+		if (s == "rdm") {
+			return FoveationMethod::RDM;
+		}
+		if (s == "hrm") {
+			return FoveationMethod::HRM;
+		}
+		throw std::runtime_error("Unknown foveation method " + s);
+	}
+
+	std::string FoveationMethodToString(FoveationMethod method) {
+		switch (method) {
+		case FoveationMethod::VRS:
+			return "vrs";
+		case FoveationMethod::RDM:
+			return "rdm";
+		case FoveationMethod::HRM:
+			return "hrm";
+		}
+
+		return "Unknown";
+	}
+
+	namespace {
+		// pixels covered by one coarse pixel at each VRS level: 1x1, 2x1 or 1x2, 2x2 and 4x4
+		const uint32_t kVrsLevelArea[4] = { 1, 2, 4, 16 };
+
+		void AddRate(FoveationEstimate &estimate, int ring, uint64_t pixels) {
+			uint64_t *rings[5] = { &estimate.fullRate, &estimate.halfRate, &estimate.quarterRate, &estimate.sixteenthRate, &estimate.culled };
+			*rings[ring] += pixels;
+		}
+
+		// ring of an RDM cluster, in the order IsRdmMasked tests the radii of its constants, which
+		// leave out the rings the pattern has no level for
+		int RdmRing(float distToCenter, const RdmMaskingConstants &constants) {
+			if (distToCenter < constants.radius[0])
+				return 0;
+			if (distToCenter < constants.radius[1])
+				return 1;
+			if (distToCenter < constants.radius[2])
+				return 2;
+			if (distToCenter < constants.edgeRadius)
+				return 3;
+			return 4;
+		}
+
+		RdmMaskingConstants MaskingConstants(const FoveationSetup &setup) {
+			RdmMaskingConstants constants;
+			const float radius[3] = { setup.radii.inner, setup.radii.mid, setup.radii.outer };
+			SetupRdmMaskingConstants(constants, 0.f, setup.method == FoveationMethod::RDM ? radius : nullptr, setup.radii.edge,
+				setup.width, setup.height, setup.projectionCenter, false, setup.rdmPattern);
+			return constants;
+		}
+
+		FoveationEstimate EstimateVrs(const FoveationSetup &setup) {
+			FoveationEstimate estimate;
+			estimate.pixels = (uint64_t)setup.width * setup.height;
+			int tilesX = setup.width / setup.vrsTileSize;
+			int tilesY = setup.height / setup.vrsTileSize;
+			uint64_t tileArea = (uint64_t)setup.vrsTileSize * setup.vrsTileSize;
+			for (int y = 0; y < tilesY; ++y) {
+				for (int x = 0; x < tilesX; ++x) {
+					float distance = VrsPatternDistance(x, y, tilesX, tilesY, setup.projectionCenter.x, setup.projectionCenter.y, setup.verticalOffset);
+					uint8_t level = DistanceToVRSLevel(distance, setup.radii);
+					AddRate(estimate, level, tileArea);
+					estimate.shaded += (double)tileArea / kVrsLevelArea[level];
+				}
+			}
+			// the pattern only covers whole tiles, pixels past it keep the full rate
+			uint64_t uncovered = estimate.pixels - (uint64_t)tilesX * tilesY * tileArea;
+			estimate.fullRate += uncovered;
+			estimate.shaded += uncovered;
+			return estimate;
+		}
+
+		FoveationEstimate EstimateRdm(const FoveationSetup &setup, bool perPixel) {
+			FoveationEstimate estimate;
+			estimate.pixels = (uint64_t)setup.width * setup.height;
+			RdmMaskingConstants constants = MaskingConstants(setup);
+			const uint32_t clusterSize = constants.clusterSize;
+			// unmasked pixels of a whole cluster in each ring, see IsRdmMasked
+			uint32_t shadedPerCluster[5] = { clusterSize * clusterSize, 0, 0, 0, 0 };
+			for (int ring = 1; ring < 4; ++ring) {
+				shadedPerCluster[ring] = RdmShadedPerCluster(constants.levels[ring - 1], clusterSize);
+			}
+			uint32_t clustersX = (setup.width + clusterSize - 1) / clusterSize;
+			uint32_t clustersY = (setup.height + clusterSize - 1) / clusterSize;
+			for (uint32_t cy = 0; cy < clustersY; ++cy) {
+				for (uint32_t cx = 0; cx < clustersX; ++cx) {
+					float distToCenter = RdmDistanceToCenter(constants.invClusterResolution, constants.projectionCenter, (float)cx, (float)cy);
+					int ring = RdmRing(distToCenter, constants);
+
+					uint32_t x0 = cx * clusterSize, y0 = cy * clusterSize;
+					uint32_t x1 = std::min(x0 + clusterSize, setup.width), y1 = std::min(y0 + clusterSize, setup.height);
+					uint64_t area = (uint64_t)(x1 - x0) * (y1 - y0);
+					AddRate(estimate, ring, area);
+					uint64_t shaded = 0;
+					if (!perPixel && area == clusterSize * clusterSize) {
+						shaded = shadedPerCluster[ring];
+					} else {
+						for (uint32_t y = y0; y < y1; ++y) {
+							for (uint32_t x = x0; x < x1; ++x) {
+								shaded += IsRdmMasked(constants, x + 0.5f, y + 0.5f) ? 0 : 1;
+							}
+						}
+					}
+					estimate.shaded += shaded;
+					estimate.masked += area - shaded;
+				}
+			}
+			return estimate;
+		}
+
+		FoveationEstimate EstimateHrm(const FoveationSetup &setup, bool perPixel) {
+			FoveationEstimate estimate;
+			estimate.pixels = (uint64_t)setup.width * setup.height;
+			RdmMaskingConstants constants = MaskingConstants(setup);
+			auto masked = [&](uint32_t x, uint32_t y) { return IsHrmMasked(constants, x + 0.5f, y + 0.5f); };
+			for (uint32_t y = 0; y < setup.height; ++y) {
+				uint64_t shaded = 0;
+				if (perPixel) {
+					for (uint32_t x = 0; x < setup.width; ++x) {
+						shaded += masked(x, y) ? 0 : 1;
+					}
+				} else {
+					uint32_t first, end;
+					if (HrmUnmaskedSpan(constants, 0, setup.width, y, first, end)) {
+						shaded = end - first;
+					}
+				}
+				estimate.fullRate += shaded;
+				estimate.culled += setup.width - shaded;
+				estimate.shaded += shaded;
+				estimate.masked += setup.width - shaded;
+			}
+			return estimate;
+		}
+	}
+
+	FoveationEstimate EstimateFoveation(const FoveationSetup &setup) {
+		switch (setup.method) {
+		case FoveationMethod::VRS:
+			return EstimateVrs(setup);
+		case FoveationMethod::RDM:
+			return EstimateRdm(setup, false);
+		case FoveationMethod::HRM:
+			return EstimateHrm(setup, false);
+		}
+		return FoveationEstimate();
+	}
+
+	FoveationEstimate EstimateFoveationPerPixel(const FoveationSetup &setup) {
+		if (setup.method == FoveationMethod::VRS) {
+			// VRS rates are only defined per tile
+			return EstimateVrs(setup);
+		}
+		return setup.method == FoveationMethod::RDM ? EstimateRdm(setup, true) : EstimateHrm(setup, true);
+	}
+
+	namespace {
+		FoveationRadii MoveRadii(const FoveationSetup &setup, float radius) {
+			FoveationRadii radii = setup.radii;
+			if (setup.method == FoveationMethod::HRM) {
+				radii.edge = radius;
+			} else {
+				radii.mid += radius - radii.inner;
+				radii.outer += radius - radii.inner;
+				radii.inner = radius;
+			}
+			return radii;
+		}
+
+		double SavingsAt(const FoveationSetup &setup, float radius) {
+			FoveationSetup moved = setup;
+			moved.radii = MoveRadii(setup, radius);
+			return EstimateFoveation(moved).Savings();
+		}
+	}
+
+	bool SolveFoveationRadii(const FoveationSetup &setup, const FoveationBudget &budget, FoveationRadii &radii) {
+		// the savings only drop as the radius grows, and the counts are exact, so the bisection always
+		// visits the same radii for the same setup
+		const int kSteps = 24;
+		float lo = budget.minRadius;
+		float hi = std::max(budget.minRadius, budget.maxRadius);
+		if (SavingsAt(setup, lo) < budget.targetSavings) {
+			radii = MoveRadii(setup, lo);
+			return false;
+		}
+		if (SavingsAt(setup, hi) >= budget.targetSavings) {
+			radii = MoveRadii(setup, hi);
+			return true;
+		}
+		for (int i = 0; i < kSteps; ++i) {
+			float mid = lo + (hi - lo) * 0.5f;
+			if (SavingsAt(setup, mid) >= budget.targetSavings) {
+				lo = mid;
+			} else {
+				hi = mid;
+			}
+		}
+		radii = MoveRadii(setup, lo);
+		return true;
+	}
+}
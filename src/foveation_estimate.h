@@ -0,0 +1,89 @@
+#pragma once
+#include "types.h"
+#include "hrm/radial_density_mask.h"
+
+#include <cstdint>
+#include <string>
+
+namespace vrperfkit {
+	// NV_VARIABLE_PIXEL_SHADING_TILE_WIDTH/HEIGHT
+	constexpr uint32_t kVrsTileSize = 16;
+
+	struct FoveationRadii {
+		float inner = 0.50f;
+		float mid = 0.65f;
+		float outer = 0.80f;
+		float edge = 1.15f;
+	};
+
+	// index into the VRS shading rate table for a distance from the projection centre
+	uint8_t DistanceToVRSLevel(float distance, const FoveationRadii &radii);
+	// distance of texel (x, y) of a width x height VRS pattern from the projection centre, measured like the FFR rings
+	float VrsPatternDistance(int x, int y, int width, int height, float projX, float projY, float verticalOffset);
+
+	enum class FoveationMethod {
+		VRS,
+		RDM,
+		HRM,
+	};
+	FoveationMethod FoveationMethodFromString(std::string s);
+	std::string FoveationMethodToString(FoveationMethod method);
+
+	struct FoveationSetup {
+		FoveationMethod method = FoveationMethod::VRS;
+		FoveationRadii radii;
+		// render resolution of one eye
+		uint32_t width = 0;
+		uint32_t height = 0;
+		Point<float> projectionCenter = {0.5f, 0.5f};
+		// ffr.verticalOffset, VRS only
+		float verticalOffset = 0.f;
+		uint32_t vrsTileSize = kVrsTileSize;
+		// ffr.rdmClusterSize and ffr.rdmLevels, RDM only
+		RdmPattern rdmPattern;
+	};
+
+	// Pixels of one eye by the rate their ring is shaded at. VRS shades the rings with coarse pixels,
+	// RDM shades a sparse pattern of them at full rate and reconstructs the rest, HRM only culls.
+	// The RDM rings count by position, whatever level the pattern gives them: halfRate is the first
+	// ring past the inner radius, quarterRate the second and sixteenthRate the third.
+	struct FoveationEstimate {
+		uint64_t pixels = 0;
+		uint64_t fullRate = 0;
+		uint64_t halfRate = 0;
+		uint64_t quarterRate = 0;
+		uint64_t sixteenthRate = 0;
+		// outside the edge radius, not shaded at all
+		uint64_t culled = 0;
+		// pixels the RDM or HRM masking pass writes depth for
+		uint64_t masked = 0;
+		// pixel shader invocations: the unmasked pixels for RDM and HRM, the coarse pixels for VRS
+		double shaded = 0;
+
+		double ShadedFraction() const { return pixels > 0 ? shaded / pixels : 1.0; }
+		double Savings() const { return 1.0 - ShadedFraction(); }
+	};
+
+	// Exact counts for the VRS pattern, the RDM mask or the HRM mask of one single eye texture, as
+	// built by D3D11VariableRateShading and D3D11PostProcessor. Cheap enough to evaluate a radius
+	// step at runtime: VRS works per tile, RDM per cluster and HRM per row.
+	FoveationEstimate EstimateFoveation(const FoveationSetup &setup);
+
+	// The same counts evaluated per pixel, to verify EstimateFoveation
+	FoveationEstimate EstimateFoveationPerPixel(const FoveationSetup &setup);
+
+	// A shading budget: the fraction of the full rate shading work to save, and the range the inner
+	// radius (the edge radius for HRM) may be moved in
+	struct FoveationBudget {
+		float targetSavings = 0.f;
+		float minRadius = 0.f;
+		float maxRadius = 3.f;
+	};
+
+	// Moves the radii of setup as the dynamic radius steps do, so that they save at least the budget's
+	// target: VRS and RDM shift the inner, mid and outer radius together, HRM moves the edge radius.
+	// Picks the largest radius that still meets the target, by a bisection with a fixed number of steps,
+	// so that the result only depends on the setup. Returns false if the target can't be met within
+	// the range, with radii then set to the largest savings possible.
+	bool SolveFoveationRadii(const FoveationSetup &setup, const FoveationBudget &budget, FoveationRadii &radii);
+}
@@ -1,7 +1,20 @@
 #define A_GPU 1
 #define A_HLSL 1
-//#define A_HALF
+#ifndef FSR_HALF
+#define FSR_HALF 0
+#endif
+#ifndef RADIUS_TEST
+#define RADIUS_TEST 1
+#endif
+#ifndef PERIPHERY_LANCZOS
+#define PERIPHERY_LANCZOS 0
+#endif
+#if FSR_HALF
+#define A_HALF 1
+#define FSR_EASU_H 1
+#else
 #define FSR_EASU_F 1
+#endif
 
 #include "ffx_a.h"
 
@@ -19,31 +32,54 @@ SamplerState samLinearClamp : register(s0);
 Texture2D<AF4> InputTexture : register(t0);
 RWTexture2D<AF4> OutputTexture: register(u0);
 
+#if FSR_HALF
+AH4 FsrEasuRH(AF2 p) { AH4 res = AH4(InputTexture.GatherRed(samLinearClamp, p, int2(0, 0))); return res; }
+AH4 FsrEasuGH(AF2 p) { AH4 res = AH4(InputTexture.GatherGreen(samLinearClamp, p, int2(0, 0))); return res; }
+AH4 FsrEasuBH(AF2 p) { AH4 res = AH4(InputTexture.GatherBlue(samLinearClamp, p, int2(0, 0))); return res; }
+#else
 AF4 FsrEasuRF(AF2 p) { AF4 res = InputTexture.GatherRed(samLinearClamp, p, int2(0, 0)); return res; }
 AF4 FsrEasuGF(AF2 p) { AF4 res = InputTexture.GatherGreen(samLinearClamp, p, int2(0, 0)); return res; }
 AF4 FsrEasuBF(AF2 p) { AF4 res = InputTexture.GatherBlue(samLinearClamp, p, int2(0, 0)); return res; }	
+#endif
 
 #include "ffx_fsr1.h"
 
 void Upscale(int2 pos) {
+#if FSR_HALF
+	AH3 c;
+	FsrEasuH(c, pos, Const0, Const1, Const2, Const3);
+	OutputTexture[pos + Const3.zw] = AF4(AF3(c), 1);
+#else
 	AF3 c;
 	FsrEasuF(c, pos, Const0, Const1, Const2, Const3);
 	OutputTexture[pos + Const3.zw] = AF4(c, 1);
+#endif
 }
 
+#if PERIPHERY_LANCZOS
+#include "../lanczos/lanczos.h"
+
+void Bilinear(int2 pos) {
+	AF3 c = Lanczos2(InputTexture, AF2(pos) * AF2_AU2(Const0.xy) + AF2_AU2(Const0.zw) + 0.5);
+	OutputTexture[pos + Const3.zw] = AF4(c, 1);
+}
+#else
 void Bilinear(int2 pos) {
 	float2 samplePos = AF2_AU2(Const1.xy) * (AF2(pos) * AF2_AU2(Const0.xy) + AF2_AU2(Const0.zw) + 0.5);
 	AF3 c = InputTexture.SampleLevel(samLinearClamp, samplePos, 0).rgb;
 	OutputTexture[pos + Const3.zw] = AF4(c, 1);
 }
+#endif
 
 [numthreads(64, 1, 1)]
 void main(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID, uint3 Dtid : SV_DispatchThreadID) {
 	// Do remapping of local xy in workgroup for a more PS-like swizzle pattern.
 	AU2 gxy = ARmp8x8(LocalThreadId.x) + AU2(WorkGroupId.x << 4u, WorkGroupId.y << 4u);
+#if RADIUS_TEST
 	AU2 groupCentre = AU2((WorkGroupId.x << 4u) + 8u, (WorkGroupId.y << 4u) + 8u);
 	AU2 dc = Centre.xy - groupCentre;
 	if (dot(dc, dc) <= SquaredRadius) {
+#endif
 		// only do the expensive EASU for workgroups inside the given radius
 		Upscale(gxy);
 		gxy.x += 8u;
@@ -52,6 +88,7 @@ void main(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID
 		Upscale(gxy);
 		gxy.x -= 8u;
 		Upscale(gxy);
+#if RADIUS_TEST
 	} else {
 		// resort to cheaper bilinear sampling
 		Bilinear(gxy);
@@ -62,4 +99,5 @@ void main(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID
 		gxy.x -= 8u;
 		Bilinear(gxy);
 	}
+#endif
 }
@@ -1,7 +1,20 @@
 #define A_GPU 1
 #define A_HLSL 1
-//#define A_HALF
-#define FSR_RCAS_F
+#ifndef FSR_HALF
+#define FSR_HALF 0
+#endif
+#ifndef RADIUS_TEST
+#define RADIUS_TEST 1
+#endif
+#ifndef DEBUG_MODE
+#define DEBUG_MODE 0
+#endif
+#if FSR_HALF
+#define A_HALF 1
+#define FSR_RCAS_H 1
+#else
+#define FSR_RCAS_F 1
+#endif
 
 #include "ffx_a.h"
 
@@ -16,25 +29,38 @@ SamplerState samLinearClamp : register(s0);
 Texture2D<AF4> InputTexture : register(t0);
 RWTexture2D<AF4> OutputTexture: register(u0);
 
+#if FSR_HALF
+AH4 FsrRcasLoadH(ASW2 p) { return AH4(InputTexture.Load(int3(ASU2(p), 0))); }
+void FsrRcasInputH(inout AH1 r, inout AH1 g, inout AH1 b) {}
+#else
 AF4 FsrRcasLoadF(ASU2 p) { return InputTexture.Load(int3(ASU2(p), 0)); }
 void FsrRcasInputF(inout AF1 r, inout AF1 g, inout AF1 b) {}
+#endif
 
 #include "ffx_fsr1.h"
 
 void Sharpen(int2 pos) {
+#if FSR_HALF
+	AH3 c;
+	FsrRcasH(c.r, c.g, c.b, pos, Const0);
+	OutputTexture[pos] = AF4(AF3(c), 1);
+#else
 	AF3 c;
 	FsrRcasF(c.r, c.g, c.b, pos, Const0);
 	OutputTexture[pos] = AF4(c, 1);
+#endif
 }
 
 [numthreads(64, 1, 1)]
 void main(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID, uint3 Dtid : SV_DispatchThreadID) {
 	// Do remapping of local xy in workgroup for a more PS-like swizzle pattern.
 	AU2 gxy = ARmp8x8(LocalThreadId.x) + AU2(WorkGroupId.x << 4u, WorkGroupId.y << 4u);
+	AU2 pos = gxy + Const0.zw;
+#if RADIUS_TEST
 	AU2 groupCentre = AU2((WorkGroupId.x << 4u) + 8u, (WorkGroupId.y << 4u) + 8u);
 	AU2 dc = ProjCentre - groupCentre;
-	AU2 pos = gxy + Const0.zw;
 	if (dot(dc, dc) <= SquaredRadius) {
+#endif
 		// only do RCAS for workgroups inside the given radius
 		Sharpen(pos);
 		pos.x += 8u;
@@ -43,8 +69,14 @@ void main(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID
 		Sharpen(pos);
 		pos.x -= 8u;
 		Sharpen(pos);
+#if RADIUS_TEST
 	} else {
+#if DEBUG_MODE
+		// tint the area outside the radius
+		AF4 mul = AF4(1, 0.6, 0.6, 1);
+#else
 		AF4 mul = AF4(1, 1, 1, 1);
+#endif
 		OutputTexture[pos] = mul * InputTexture[pos];
 		pos.x += 8u;
 		OutputTexture[pos] = mul * InputTexture[pos];
@@ -53,4 +85,5 @@ void main(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID
 		pos.x -= 8u;
 		OutputTexture[pos] = mul * InputTexture[pos];
 	}
+#endif
 }
@@ -0,0 +1,100 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vrperfkit {
+	namespace hooks {
+		struct HookInfo {
+			intptr_t target;
+			intptr_t original;
+			intptr_t hook;
+		};
+
+		// Installed hooks by detour address. The detours look their original up on whatever thread
+		// the game calls them from, so Find reads an immutable snapshot without locking. Insert and
+		// Remove copy the snapshot under a lock and publish the copy. Replaced snapshots are kept
+		// until Clear, since a reader may still be in one; hooks change only a few times per run.
+		class HookTable {
+		public:
+			HookTable() : current(Publish(Snapshot())) {}
+			HookTable(const HookTable &) = delete;
+			HookTable & operator=(const HookTable &) = delete;
+
+			// the entry of hook, valid until Clear, or nullptr
+			const HookInfo * Find(intptr_t hook) const {
+				const Snapshot &entries = *current.load(std::memory_order_acquire);
+				auto it = std::lower_bound(entries.begin(), entries.end(), hook, ByHook);
+				return it != entries.end() && it->hook == hook ? &*it : nullptr;
+			}
+
+			// adds info, or replaces the entry of the same hook
+			void Insert(const HookInfo &info) {
+				std::lock_guard<std::mutex> lock (writeMutex);
+				Snapshot entries = *current.load(std::memory_order_relaxed);
+				auto it = std::lower_bound(entries.begin(), entries.end(), info.hook, ByHook);
+				if (it != entries.end() && it->hook == info.hook) {
+					*it = info;
+				} else {
+					entries.insert(it, info);
+				}
+				current.store(Publish(std::move(entries)), std::memory_order_release);
+			}
+
+			// false if hook is not installed
+			bool Remove(intptr_t hook) {
+				std::lock_guard<std::mutex> lock (writeMutex);
+				Snapshot entries = *current.load(std::memory_order_relaxed);
+				auto it = std::lower_bound(entries.begin(), entries.end(), hook, ByHook);
+				if (it == entries.end() || it->hook != hook) {
+					return false;
+				}
+				entries.erase(it);
+				current.store(Publish(std::move(entries)), std::memory_order_release);
+				return true;
+			}
+
+			// removes all hooks and frees the snapshots, only once no detour can run anymore
+			void Clear() {
+				std::lock_guard<std::mutex> lock (writeMutex);
+				snapshots.clear();
+				current.store(Publish(Snapshot()), std::memory_order_release);
+			}
+
+			size_t Size() const {
+				return current.load(std::memory_order_acquire)->size();
+			}
+
+		private:
+			// sorted by hook
+			typedef std::vector<HookInfo> Snapshot;
+
+			static bool ByHook(const HookInfo &info, intptr_t hook) {
+				return info.hook < hook;
+			}
+
+			const Snapshot * Publish(Snapshot &&entries) {
+				snapshots.push_back(std::make_unique<const Snapshot>(std::move(entries)));
+				return snapshots.back().get();
+			}
+
+			std::vector<std::unique_ptr<const Snapshot>> snapshots;
+			std::atomic<const Snapshot*> current;
+			std::mutex writeMutex;
+		};
+
+		// The original of one detour, a static per detour function. The hooks write it before they
+		// enable the detour, so the detour finds its original with a single load and no lookup.
+		template<auto Detour>
+		struct OriginalSlot {
+			static inline decltype(Detour) original = nullptr;
+
+			static void ** Address() {
+				return reinterpret_cast<void **>(&original);
+			}
+		};
+	}
+}
@@ -1,17 +1,11 @@
 #include "hooks.h"
 
+#include "hook_table.h"
 #include "logging.h"
 #include "MinHook.h"
 
-#include <unordered_map>
-
 namespace {
-	struct HookInfo {
-		intptr_t target;
-		intptr_t original;
-		intptr_t hook;
-	};
-	std::unordered_map<intptr_t, HookInfo> g_hooksToOriginal;
+	vrperfkit::hooks::HookTable g_hooksToOriginal;
 }
 
 namespace vrperfkit {
@@ -25,16 +19,17 @@ namespace vrperfkit {
 
 		void Shutdown() {
 			MH_Uninitialize();
-			g_hooksToOriginal.clear();
+			g_hooksToOriginal.Clear();
 		}
 
-		void InstallVirtualFunctionHook(const std::string &name, void *instance, uint32_t methodPos, void *detour) {
+		void InstallVirtualFunctionHook(const std::string &name, void *instance, uint32_t methodPos, void *detour, void **originalSlot) {
 			LOG_INFO << "Installing virtual function hook for " << name;
 			LPVOID *vtable = *((LPVOID**)instance);
 			LPVOID pTarget = vtable[methodPos];
 
 			LPVOID pOriginal = nullptr;
-			MH_STATUS result = MH_CreateHook(pTarget, detour, &pOriginal);
+			LPVOID *ppOriginal = originalSlot != nullptr ? originalSlot : &pOriginal;
+			MH_STATUS result = MH_CreateHook(pTarget, detour, ppOriginal);
 			if (result != MH_OK || MH_EnableHook(pTarget) != MH_OK) {
 				if (result == MH_ERROR_ALREADY_CREATED) {
 					LOG_INFO << "  Hook already installed.";
@@ -44,17 +39,16 @@ namespace vrperfkit {
 				return;
 			}
 
-			g_hooksToOriginal[reinterpret_cast<intptr_t>(detour)] = HookInfo {
+			g_hooksToOriginal.Insert(HookInfo {
 				reinterpret_cast<intptr_t>(pTarget),
-				reinterpret_cast<intptr_t>(pOriginal),
+				reinterpret_cast<intptr_t>(*ppOriginal),
 				reinterpret_cast<intptr_t>(detour),
-			};
+			});
 		}
 
 		void RemoveHook(void *detour) {
-			auto entry = g_hooksToOriginal.find(reinterpret_cast<intptr_t>(detour));
-			if (entry != g_hooksToOriginal.end()) {
-				void *target = reinterpret_cast<void *>(entry->second.target);
+			if (const HookInfo *entry = g_hooksToOriginal.Find(reinterpret_cast<intptr_t>(detour))) {
+				void *target = reinterpret_cast<void *>(entry->target);
 				LOG_INFO << "Removing hook to " << target;
 				if (MH_STATUS status; (status = MH_DisableHook(target)) != MH_OK) {
 					LOG_ERROR << "Error when disabling hook to " << target << ": " << status;
@@ -62,34 +56,36 @@ namespace vrperfkit {
 				if (MH_STATUS status; (status = MH_RemoveHook(target)) != MH_OK) {
 					LOG_ERROR << "Error when removing hook to " << target << ": " << status;
 				}
-				g_hooksToOriginal.erase(entry);
+				g_hooksToOriginal.Remove(reinterpret_cast<intptr_t>(detour));
 			}
 		}
 
-		void InstallHook(const std::string &name, void *target, void *detour) {
+		void InstallHook(const std::string &name, void *target, void *detour, void **originalSlot) {
 			LOG_INFO << "Installing hook for " << name << " from " << target << " to " << detour;
 			LPVOID pOriginal = nullptr;
-			if (MH_CreateHook(target, detour, &pOriginal) != MH_OK || MH_EnableHook(target) != MH_OK) {
+			LPVOID *ppOriginal = originalSlot != nullptr ? originalSlot : &pOriginal;
+			if (MH_CreateHook(target, detour, ppOriginal) != MH_OK || MH_EnableHook(target) != MH_OK) {
 				LOG_ERROR << "Failed to install hook for " << name;
 				return;
 			}
 
-			g_hooksToOriginal[reinterpret_cast<intptr_t>(detour)] = HookInfo {
+			g_hooksToOriginal.Insert(HookInfo {
 				reinterpret_cast<intptr_t>(target),
-				reinterpret_cast<intptr_t>(pOriginal),
+				reinterpret_cast<intptr_t>(*ppOriginal),
 				reinterpret_cast<intptr_t>(detour),
-			};
+			});
 		}
 
-		void InstallHookInDll(const std::string &name, HMODULE module, void *detour) {
+		void InstallHookInDll(const std::string &name, HMODULE module, void *detour, void **originalSlot) {
 			LPVOID target = GetProcAddress(module, name.c_str());
 			if (target != nullptr) {
-				InstallHook(name, target, detour);
+				InstallHook(name, target, detour, originalSlot);
 			}
 		}
 
 		intptr_t HookToOriginal(intptr_t hook) {
-			return g_hooksToOriginal[hook].original;
+			const HookInfo *info = g_hooksToOriginal.Find(hook);
+			return info != nullptr ? info->original : 0;
 		}
 	}
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include "hook_table.h"
 #include "logging.h"
 #include "MinHook.h"
 
@@ -22,9 +23,10 @@ namespace vrperfkit {
 			return reinterpret_cast<T>(fn);
 		}
 
-		void InstallHook(const std::string &name, void *target, void *detour);
-		void InstallHookInDll(const std::string &name, HMODULE module, void *detour);
-		void InstallVirtualFunctionHook(const std::string &name, void *instance, uint32_t methodPos, void *detour);
+		// originalSlot, if given, receives the original before the hook is enabled
+		void InstallHook(const std::string &name, void *target, void *detour, void **originalSlot = nullptr);
+		void InstallHookInDll(const std::string &name, HMODULE module, void *detour, void **originalSlot = nullptr);
+		void InstallVirtualFunctionHook(const std::string &name, void *instance, uint32_t methodPos, void *detour, void **originalSlot = nullptr);
 		void RemoveHook(void *detour);
 
 		intptr_t HookToOriginal(intptr_t hook);
@@ -33,5 +35,34 @@ namespace vrperfkit {
 		T CallOriginal(T hookFunction) {
 			return reinterpret_cast<T>(HookToOriginal(reinterpret_cast<intptr_t>(hookFunction)));
 		}
+
+		// Hooks whose detour is known at compile time keep its original in OriginalSlot<Detour>, so
+		// that the detours on the game's hot paths call it through Original<Detour>() without looking
+		// it up in the hook table.
+		template<auto Detour>
+		void InstallHook(const std::string &name, void *target) {
+			InstallHook(name, target, (void*)Detour, OriginalSlot<Detour>::Address());
+		}
+
+		template<auto Detour>
+		void InstallHookInDll(const std::string &name, HMODULE module) {
+			InstallHookInDll(name, module, (void*)Detour, OriginalSlot<Detour>::Address());
+		}
+
+		template<auto Detour>
+		void InstallVirtualFunctionHook(const std::string &name, void *instance, uint32_t methodPos) {
+			InstallVirtualFunctionHook(name, instance, methodPos, (void*)Detour, OriginalSlot<Detour>::Address());
+		}
+
+		template<auto Detour>
+		void RemoveHook() {
+			RemoveHook((void*)Detour);
+			OriginalSlot<Detour>::original = nullptr;
+		}
+
+		template<auto Detour>
+		decltype(Detour) Original() {
+			return OriginalSlot<Detour>::original;
+		}
 	}
 }
@@ -18,6 +18,9 @@ namespace {
 			g_config.upscaling.method = vrperfkit::UpscaleMethod::CAS;
 			break;
 		case vrperfkit::UpscaleMethod::CAS:
+			g_config.upscaling.method = vrperfkit::UpscaleMethod::LANCZOS;
+			break;
+		case vrperfkit::UpscaleMethod::LANCZOS:
 			g_config.upscaling.method = vrperfkit::UpscaleMethod::FSR;
 			break;
 		}
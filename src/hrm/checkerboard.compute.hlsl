@@ -0,0 +1,107 @@
+// Reconstruction of checkerboard rendering: the RDM mask with only the half level, whose 2x2 blocks
+// alternate parity every frame. Same constants and tile lists as reconstruction.compute.hlsl, with
+// the 8x8 clusters of CheckerboardRdmPattern.
+#define CLUSTER_SHIFT 3u
+#define CLUSTER_SIZE (1u << CLUSTER_SHIFT)
+
+Texture2D u_srcTex : register(t0);
+// clusters to reconstruct, x | y << 16, see BuildRdmReconstructTiles
+Buffer<uint> u_tiles : register(t1);
+// this eye's reconstruction of the previous frame, which shaded the other parity
+Texture2D u_historyTex : register(t2);
+
+RWTexture2D<float4> u_dstTex : register(u0);
+
+cbuffer cb : register(b0) {
+	uint2 u_offset;
+	float2 u_projectionCenter;
+	float2 u_invClusterResolution;
+	float2 u_invResolution;
+	float3 u_radius;
+	float edgeRadius;
+	uint2 u_areaEnd;
+	uint u_clusterSize;
+	float u_historyWeight;
+	uint3 u_levels;
+	// u_phase.x is the parity of this frame's shaded blocks, see GetRdmPhase
+	uint2 u_phase;
+};
+
+#define RDM_TILES_PER_ROW 256
+#define RDM_NO_TILE 0xffffffff
+
+// weights of the shaded pixels one and two pixels away from a masked one
+#define NEAR_WEIGHT 0.6666667f
+#define FAR_WEIGHT 0.3333333f
+
+bool isShaded( uint2 uFragCoordHalf )
+{
+	return ( ( uFragCoordHalf.x + uFragCoordHalf.y + u_phase.x ) & 0x01u ) == 0;
+}
+
+/// the texel at uv if the game shaded it: inside the written area and a cluster short of the edge radius
+bool fetchShaded( int2 uv, out float4 value )
+{
+	value = float4( 0, 0, 0, 0 );
+	if( any( uv < int2( u_offset ) ) || any( uv >= int2( u_areaEnd ) ) )
+		return false;
+	float2 toCenter = ( uint2( uv ) >> CLUSTER_SHIFT ) * u_invClusterResolution - u_projectionCenter;
+	if( 2 * length( toCenter ) >= edgeRadius )
+		return false;
+	value = u_srcTex.Load( int3( uv, 0 ) );
+	return true;
+}
+
+/** The blocks left and right, above and below a masked block are shaded:
+		ab xx ef
+		cd xx gh
+	A masked pixel interpolates linearly between the nearest shaded pixel of its row on either side,
+	one and two pixels away, does the same in its column and averages both. Taps the mask covers
+	take the other tap of their axis, or the other axis. lo and hi bound the taps for the history.
+*/
+float4 reconstructCheckerboard( int2 dstUV, out float4 lo, out float4 hi )
+{
+	int2 inBlock = dstUV & 0x01;
+	float4 l, r, u, d;
+	bool hasL = fetchShaded( dstUV + int2( -1 - inBlock.x, 0 ), l );
+	bool hasR = fetchShaded( dstUV + int2( 2 - inBlock.x, 0 ), r );
+	bool hasU = fetchShaded( dstUV + int2( 0, -1 - inBlock.y ), u );
+	bool hasD = fetchShaded( dstUV + int2( 0, 2 - inBlock.y ), d );
+	if( !hasL ) l = r;
+	if( !hasR ) r = l;
+	if( !hasU ) u = d;
+	if( !hasD ) d = u;
+	if( !hasL && !hasR ) { l = u; r = d; }
+	if( !hasU && !hasD ) { u = l; d = r; }
+
+	float4 horizontal = inBlock.x == 0 ? l * NEAR_WEIGHT + r * FAR_WEIGHT : l * FAR_WEIGHT + r * NEAR_WEIGHT;
+	float4 vertical = inBlock.y == 0 ? u * NEAR_WEIGHT + d * FAR_WEIGHT : u * FAR_WEIGHT + d * NEAR_WEIGHT;
+	lo = min( min( l, r ), min( u, d ) );
+	hi = max( max( l, r ), max( u, d ) );
+	return ( horizontal + vertical ) * 0.5f;
+}
+
+[numthreads(CLUSTER_SIZE, CLUSTER_SIZE, 1)]
+void main(uint3 groupID : SV_GroupID, uint3 threadID : SV_GroupThreadID) {
+	uint tile = u_tiles[groupID.y * RDM_TILES_PER_ROW + groupID.x];
+	uint2 currentUV = (uint2(tile & 0xffff, tile >> 16) << CLUSTER_SHIFT) + threadID.xy;
+	if( tile == RDM_NO_TILE || any( currentUV < u_offset ) || any( currentUV >= u_areaEnd ) )
+		return;
+
+	float2 toCenter     = (currentUV >> CLUSTER_SHIFT) * u_invClusterResolution - u_projectionCenter;
+	float  distToCenter = 2 * length(toCenter);
+
+	float4 srcVal = u_srcTex.Load( int3( currentUV, 0 ) );
+	if( distToCenter >= u_radius.x && distToCenter <= edgeRadius && !isShaded( currentUV >> 1u ) )
+	{
+		float4 lo, hi;
+		srcVal = reconstructCheckerboard( int2( currentUV ), lo, hi );
+		// without motion vectors, the other parity's history is clamped to the taps of this frame
+		if( u_historyWeight > 0 )
+		{
+			float4 history = clamp( u_historyTex.Load( int3( currentUV, 0 ) ), lo, hi );
+			srcVal = srcVal + ( history - srcVal ) * u_historyWeight;
+		}
+	}
+	u_dstTex[currentUV] = srcVal;
+}
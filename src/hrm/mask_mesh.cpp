@@ -0,0 +1,110 @@
+#include "mask_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vrperfkit {
+	namespace {
+		// masked pixels [begin, end) of a row
+		struct Run {
+			uint32_t begin;
+			uint32_t end;
+
+			bool operator==(const Run &o) const { return begin == o.begin && end == o.end; }
+		};
+
+		void AddRect(std::vector<MaskVertex> &mesh, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+			MaskVertex tl { (uint16_t)x0, (uint16_t)y0 };
+			MaskVertex tr { (uint16_t)x1, (uint16_t)y0 };
+			MaskVertex bl { (uint16_t)x0, (uint16_t)y1 };
+			MaskVertex br { (uint16_t)x1, (uint16_t)y1 };
+			mesh.insert(mesh.end(), { tl, tr, bl, bl, tr, br });
+		}
+
+		void HrmRuns(const RdmMaskingConstants &constants, const Viewport &viewport, uint32_t y, std::vector<Run> &runs) {
+			uint32_t first, end;
+			uint32_t x0 = viewport.x, x1 = viewport.x + viewport.width;
+			if (!HrmUnmaskedSpan(constants, x0, x1, y, first, end)) {
+				runs.push_back(Run{x0, x1});
+				return;
+			}
+			if (first > x0) {
+				runs.push_back(Run{x0, first});
+			}
+			if (end < x1) {
+				runs.push_back(Run{end, x1});
+			}
+		}
+
+		// The RDM mask is constant in the 2x2 pixel blocks of the shader, so one test per block
+		// boundary is enough. Blocks are aligned in render target coordinates, not to the viewport.
+		void RdmRuns(const RdmMaskingConstants &constants, const Viewport &viewport, uint32_t y, std::vector<Run> &runs) {
+			for (uint32_t x = viewport.x; x < viewport.x + viewport.width; ) {
+				uint32_t next = std::min((x | 1) + 1, viewport.x + viewport.width);
+				if (IsRdmMasked(constants, x + 0.5f, y + 0.5f)) {
+					if (!runs.empty() && runs.back().end == x) {
+						runs.back().end = next;
+					} else {
+						runs.push_back(Run{x, next});
+					}
+				}
+				x = next;
+			}
+		}
+
+		// half pixel row in the shader's coordinates, rows of the same block row have the same runs
+		uint32_t RdmBlockRow(const RdmMaskingConstants &constants, uint32_t y) {
+			return (uint32_t)(((y + 0.5f) * constants.yFix[0] + constants.yFix[1]) * 0.5f);
+		}
+	}
+
+	void SetupMaskMeshConstants(MaskMeshConstants &constants, float depth, uint32_t targetWidth, uint32_t targetHeight, uint32_t secondEyeVertex) {
+		constants.pixelToClip[0] = 2.f / targetWidth;
+		constants.pixelToClip[1] = 2.f / targetHeight;
+		constants.depthOut = 1.f - depth;
+		constants.secondEyeVertex = secondEyeVertex;
+	}
+
+	std::vector<MaskVertex> GenerateMaskMesh(const RdmMaskingConstants &constants, const Viewport &viewport, bool hiddenRadialMask) {
+		std::vector<MaskVertex> mesh;
+		std::vector<Run> open, runs;
+		uint32_t openSince = viewport.y;
+		for (uint32_t y = viewport.y; y <= viewport.y + viewport.height; ++y) {
+			runs.clear();
+			if (y < viewport.y + viewport.height) {
+				if (hiddenRadialMask) {
+					HrmRuns(constants, viewport, y, runs);
+				} else if (y > viewport.y && RdmBlockRow(constants, y) == RdmBlockRow(constants, y - 1)) {
+					runs = open;
+				} else {
+					RdmRuns(constants, viewport, y, runs);
+				}
+			}
+			if (runs == open) {
+				continue;
+			}
+			for (const Run &run : open) {
+				AddRect(mesh, run.begin, openSince, run.end, y);
+			}
+			open.swap(runs);
+			openSince = y;
+		}
+		return mesh;
+	}
+
+	std::vector<MaskVertex> GenerateHiddenAreaMaskMesh(const std::vector<Point<float>> &triangles, const Viewport &viewport, bool flipY) {
+		std::vector<MaskVertex> mesh;
+		mesh.reserve(triangles.size() - triangles.size() % 3);
+		auto toPixel = [](float f, uint32_t offset, uint32_t size) {
+			float pixel = std::round(std::min(std::max(f, 0.f), 1.f) * size);
+			return (uint16_t)(offset + (uint32_t)pixel);
+		};
+		for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+			for (size_t v = i; v < i + 3; ++v) {
+				const Point<float> &uv = triangles[v];
+				mesh.push_back(MaskVertex{ toPixel(uv.x, viewport.x, viewport.width), toPixel(flipY ? 1.f - uv.y : uv.y, viewport.y, viewport.height) });
+			}
+		}
+		return mesh;
+	}
+}
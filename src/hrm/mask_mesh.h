@@ -0,0 +1,38 @@
+#pragma once
+#include "radial_density_mask.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace vrperfkit {
+	// vertex of a mask mesh, in render target pixels (R16G16_UINT)
+	struct MaskVertex {
+		uint16_t x;
+		uint16_t y;
+	};
+
+	// cbuffer of mask_mesh.vert.hlsl
+	struct MaskMeshConstants {
+		float pixelToClip[2];
+		float depthOut;
+		// vertices from here on belong to the right eye, and go to the second slice of an array target
+		uint32_t secondEyeVertex;
+	};
+
+	// Constants to draw a mask mesh into a targetWidth x targetHeight depth target, with a single
+	// viewport covering all of it
+	void SetupMaskMeshConstants(MaskMeshConstants &constants, float depth, uint32_t targetWidth, uint32_t targetHeight, uint32_t secondEyeVertex);
+
+	// Triangle list covering exactly the pixels of viewport that IsRdmMasked (IsHrmMasked with
+	// hiddenRadialMask) masks, as rectangles with pixel aligned corners. Rows with the same masked
+	// runs are merged, so the mesh stays small: the periphery of the RDM mask is mostly whole
+	// clusters and the hidden radial mask two spans per row. viewport and the vertices are in render
+	// target coordinates, so the meshes of both eyes of a side by side target can be drawn at once.
+	std::vector<MaskVertex> GenerateMaskMesh(const RdmMaskingConstants &constants, const Viewport &viewport, bool hiddenRadialMask);
+
+	// Triangle list of the runtime's hidden area mesh of one eye (OpenVR GetHiddenAreaMesh, the Oculus
+	// hidden area stencil), given in eye texture coordinates from 0 to 1 with the origin at the top
+	// left, moved into viewport and turned heads down with flipY, like the masking constants of array
+	// textures. The vertices are rounded to whole pixels and clamped to the viewport.
+	std::vector<MaskVertex> GenerateHiddenAreaMaskMesh(const std::vector<Point<float>> &triangles, const Viewport &viewport, bool flipY);
+}
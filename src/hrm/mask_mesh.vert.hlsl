@@ -0,0 +1,24 @@
+cbuffer cb : register(b0) {
+	float2 pixelToClip;
+	float depthOut;
+	uint secondEyeVertex;
+};
+
+struct VertexOut {
+	float4 position : SV_POSITION;
+#ifdef MASK_MESH_ARRAY
+	// needs VPAndRTArrayIndexFromAnyShaderFeedingRasterizer
+	uint slice : SV_RenderTargetArrayIndex;
+#endif
+};
+
+// mask mesh vertices are in render target pixels, drawn with one viewport covering the whole target
+VertexOut main(uint2 pixel : POSITION, uint vertexId : SV_VertexID) {
+	VertexOut result;
+	result.position.xy = float2(pixel) * (pixelToClip * float2(1.0, -1.0)) + float2(-1.0, 1.0);
+	result.position.zw = float2(depthOut, 1.0);
+#ifdef MASK_MESH_ARRAY
+	result.slice = vertexId >= secondEyeVertex ? 1 : 0;
+#endif
+	return result;
+}
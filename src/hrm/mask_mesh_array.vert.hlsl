@@ -0,0 +1,3 @@
+// both eyes of an array depth target in one draw, each eye's vertices routed to its slice
+#define MASK_MESH_ARRAY
+#include "mask_mesh.vert.hlsl"
@@ -0,0 +1,303 @@
+#include "radial_density_mask.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace vrperfkit {
+	RdmLevel RdmLevelFromString(std::string s) {
+		std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+		if (s == "half") {
+			return RdmLevel::HALF;
+		}
+		if (s == "half2x1") {
+			return RdmLevel::HALF_2X1;
+		}
+		if (s == "half1x2") {
+			return RdmLevel::HALF_1X2;
+		}
+		if (s == "quarter") {
+			return RdmLevel::QUARTER;
+		}
+		if (s == "eighth") {
+			return RdmLevel::EIGHTH;
+		}
+		if (s == "sixteenth") {
+			return RdmLevel::SIXTEENTH;
+		}
+		throw std::runtime_error("Unknown RDM level " + s);
+	}
+
+	std::string RdmLevelToString(RdmLevel level) {
+		switch (level) {
+		case RdmLevel::HALF:
+			return "half";
+		case RdmLevel::HALF_2X1:
+			return "half2x1";
+		case RdmLevel::HALF_1X2:
+			return "half1x2";
+		case RdmLevel::QUARTER:
+			return "quarter";
+		case RdmLevel::EIGHTH:
+			return "eighth";
+		case RdmLevel::SIXTEENTH:
+			return "sixteenth";
+		}
+
+		return "Unknown";
+	}
+
+	bool IsValidRdmPattern(const RdmPattern &pattern, std::string &error) {
+		if (pattern.clusterSize != 4 && pattern.clusterSize != 8 && pattern.clusterSize != 16) {
+			error = "RDM cluster size must be 4, 8 or 16";
+			return false;
+		}
+		if (pattern.levelCount < 1 || pattern.levelCount > 3) {
+			error = "RDM needs 1 to 3 levels";
+			return false;
+		}
+		for (uint32_t i = 0; i < pattern.levelCount; ++i) {
+			RdmLevel level = pattern.levels[i];
+			if (pattern.clusterSize < 8 && (level == RdmLevel::EIGHTH || level == RdmLevel::SIXTEENTH)) {
+				error = "RDM level " + RdmLevelToString(level) + " needs a cluster size of at least 8";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string RdmPatternToString(const RdmPattern &pattern) {
+		std::ostringstream ss;
+		ss << pattern.clusterSize << "x" << pattern.clusterSize << " clusters,";
+		for (uint32_t i = 0; i < pattern.levelCount; ++i) {
+			ss << " " << RdmLevelToString(pattern.levels[i]);
+		}
+		return ss.str();
+	}
+
+	bool IsValidRdmPhaseCount(uint32_t phases) {
+		return phases == 1 || phases == 2 || phases == 4;
+	}
+
+	void GetRdmPhase(uint32_t phases, uint32_t frame, uint32_t phase[2]) {
+		// the second phase moves every level the furthest, so that 2 phases already shade all blocks
+		// of the half levels and the quarter level's blocks on one diagonal
+		const uint32_t kPhases[4][2] = { {0, 0}, {1, 1}, {1, 0}, {0, 1} };
+		uint32_t index = IsValidRdmPhaseCount(phases) ? frame % phases : 0;
+		phase[0] = kPhases[index][0];
+		phase[1] = kPhases[index][1];
+	}
+
+	RdmPattern CheckerboardRdmPattern() {
+		RdmPattern pattern;
+		pattern.levels[0] = RdmLevel::HALF;
+		pattern.levelCount = 1;
+		return pattern;
+	}
+
+	namespace {
+		// rings past the pattern's levels are emptied by moving their start to the edge radius, and
+		// take the last level, should a cluster exactly at the edge radius still fall into them
+		void SetupRings(float radius[3], RdmLevel levels[3], const float *configRadius, float edgeRadius, const RdmPattern &pattern) {
+			uint32_t levelCount = std::min(std::max(pattern.levelCount, 1u), 3u);
+			for (uint32_t i = 0; i < 3; ++i) {
+				radius[i] = configRadius ? (i < levelCount ? configRadius[i] : edgeRadius) : 0.f;
+				levels[i] = pattern.levels[std::min(i, levelCount - 1)];
+			}
+		}
+	}
+
+	void SetupRdmMaskingConstants(RdmMaskingConstants &constants, float depth, const float *radius, float edgeRadius,
+			uint32_t renderWidth, uint32_t renderHeight, const Point<float> &projectionCenter, bool arrayTex, const RdmPattern &pattern) {
+		constants.depthOut = 1.f - depth;
+		SetupRings(constants.radius, constants.levels, radius, edgeRadius, pattern);
+		constants.edgeRadius = edgeRadius;
+		constants.clusterSize = pattern.clusterSize;
+		constants.invClusterResolution[0] = (float)pattern.clusterSize / renderWidth;
+		constants.invClusterResolution[1] = (float)pattern.clusterSize / renderHeight;
+		constants.projectionCenter[0] = projectionCenter.x;
+		constants.projectionCenter[1] = projectionCenter.y;
+		// New Unity engine with array textures renders heads down and then flips the texture before submitting.
+		// so we also need to construct the RDM heads-down in that case.
+		constants.yFix[0] = arrayTex ? -1 : 1;
+		constants.yFix[1] = arrayTex ? renderHeight : 0;
+		constants.phase[0] = constants.phase[1] = 0;
+	}
+
+	void SetupRdmReconstructConstants(RdmReconstructConstants &constants, const float *radius, float edgeRadius,
+			const Viewport &inputViewport, uint32_t textureWidth, uint32_t textureHeight, const Point<float> &projectionCenter,
+			const RdmPattern &pattern) {
+		uint32_t clusterSize = pattern.clusterSize;
+		constants.offset[0] = inputViewport.x;
+		constants.offset[1] = inputViewport.y;
+		constants.projectionCenter[0] = projectionCenter.x;
+		constants.projectionCenter[1] = projectionCenter.y;
+		constants.invResolution[0] = 1.f / textureWidth;
+		constants.invResolution[1] = 1.f / textureHeight;
+		constants.invClusterResolution[0] = (float)clusterSize / inputViewport.width;
+		constants.invClusterResolution[1] = (float)clusterSize / inputViewport.height;
+		SetupRings(constants.radius, constants.levels, radius, edgeRadius, pattern);
+		constants.edgeRadius = edgeRadius;
+		// UAV writes outside of the texture are dropped
+		uint32_t groupsX = (inputViewport.width + clusterSize - 1) / clusterSize;
+		uint32_t groupsY = (inputViewport.height + clusterSize - 1) / clusterSize;
+		constants.areaEnd[0] = std::min(inputViewport.x + groupsX * clusterSize, textureWidth);
+		constants.areaEnd[1] = std::min(inputViewport.y + groupsY * clusterSize, textureHeight);
+		constants.clusterSize = clusterSize;
+		constants.historyWeight = 0.f;
+		constants.phase[0] = constants.phase[1] = 0;
+		constants._padding = constants._padding2[0] = constants._padding2[1] = 0;
+	}
+
+	float RdmDistanceToCenter(const float invClusterResolution[2], const float projectionCenter[2], float clusterX, float clusterY) {
+		float dx = clusterX * invClusterResolution[0] - projectionCenter[0];
+		float dy = clusterY * invClusterResolution[1] - projectionCenter[1];
+		return std::sqrt(dx * dx + dy * dy) * 2;
+	}
+
+	bool IsRdmShaded(RdmLevel level, uint32_t halfX, uint32_t halfY, uint32_t phaseX, uint32_t phaseY) {
+		switch (level) {
+		case RdmLevel::HALF:
+			return ((halfX + halfY + phaseX) & 1) == 0;
+		case RdmLevel::HALF_2X1:
+			return (halfX & 1) == phaseX;
+		case RdmLevel::HALF_1X2:
+			return (halfY & 1) == phaseY;
+		case RdmLevel::QUARTER:
+			return (halfX & 1) == phaseX && (halfY & 1) == phaseY;
+		case RdmLevel::EIGHTH:
+			return (halfX & 3) == 2 * phaseX && (halfY & 1) == phaseY;
+		case RdmLevel::SIXTEENTH:
+			return (halfX & 3) == 2 * phaseX && (halfY & 3) == 2 * phaseY;
+		}
+		return true;
+	}
+
+	uint32_t RdmShadedPerCluster(RdmLevel level, uint32_t clusterSize) {
+		const uint32_t blocks = clusterSize / 2;
+		uint32_t shaded = 0;
+		for (uint32_t y = 0; y < blocks; ++y) {
+			for (uint32_t x = 0; x < blocks; ++x) {
+				shaded += IsRdmShaded(level, x, y) ? 4 : 0;
+			}
+		}
+		return shaded;
+	}
+
+	bool IsRdmMasked(const RdmMaskingConstants &constants, float x, float y) {
+		float posX = x;
+		float posY = y * constants.yFix[0] + constants.yFix[1];
+		float invClusterSize = 1.f / constants.clusterSize;
+		float distToCenter = RdmDistanceToCenter(constants.invClusterResolution, constants.projectionCenter,
+			std::trunc(posX * invClusterSize), std::trunc(posY * invClusterSize));
+
+		uint32_t halfX = (uint32_t)(posX * 0.5f);
+		uint32_t halfY = (uint32_t)(posY * 0.5f);
+		if (distToCenter < constants.radius[0])
+			return false;
+		uint32_t phaseX = constants.phase[0], phaseY = constants.phase[1];
+		if (distToCenter < constants.radius[1])
+			return !IsRdmShaded(constants.levels[0], halfX, halfY, phaseX, phaseY);
+		if (distToCenter < constants.radius[2])
+			return !IsRdmShaded(constants.levels[1], halfX, halfY, phaseX, phaseY);
+		if (distToCenter < constants.edgeRadius)
+			return !IsRdmShaded(constants.levels[2], halfX, halfY, phaseX, phaseY);
+		return true;
+	}
+
+	bool IsHrmMasked(const RdmMaskingConstants &constants, float x, float y) {
+		float posX = x;
+		float posY = y * constants.yFix[0] + constants.yFix[1];
+		float invClusterSize = 1.f / constants.clusterSize;
+		float distToCenter = RdmDistanceToCenter(constants.invClusterResolution, constants.projectionCenter, posX * invClusterSize, posY * invClusterSize);
+		return distToCenter >= constants.edgeRadius;
+	}
+
+	bool HrmUnmaskedSpan(const RdmMaskingConstants &constants, uint32_t x0, uint32_t x1, uint32_t y, uint32_t &first, uint32_t &end) {
+		if (x0 >= x1) {
+			return false;
+		}
+		auto masked = [&](uint32_t x) { return IsHrmMasked(constants, x + 0.5f, y + 0.5f); };
+		// column of the projection centre, in the shader's cluster units
+		float center = constants.projectionCenter[0] / constants.invClusterResolution[0] * constants.clusterSize - 0.5f;
+		uint32_t seed = (uint32_t)std::min(std::max(std::round(center), (float)x0), x1 - 1.f);
+		if (masked(seed) && seed > x0 && !masked(seed - 1)) {
+			--seed;
+		} else if (masked(seed) && seed + 1 < x1 && !masked(seed + 1)) {
+			++seed;
+		}
+		if (masked(seed)) {
+			return false;
+		}
+
+		uint32_t lo = x0, hi = seed;
+		while (lo < hi) {
+			uint32_t mid = (lo + hi) / 2;
+			if (masked(mid)) lo = mid + 1; else hi = mid;
+		}
+		first = lo;
+		lo = seed + 1, hi = x1;
+		while (lo < hi) {
+			uint32_t mid = (lo + hi) / 2;
+			if (masked(mid)) hi = mid; else lo = mid + 1;
+		}
+		end = lo;
+		return true;
+	}
+
+	RdmReconstructMode GetRdmReconstructMode(const RdmReconstructConstants &constants, uint32_t x, uint32_t y) {
+		uint32_t clusterSize = constants.clusterSize;
+		float distToCenter = RdmDistanceToCenter(constants.invClusterResolution, constants.projectionCenter, (float)(x / clusterSize), (float)(y / clusterSize));
+		if (distToCenter < constants.radius[0] || distToCenter > constants.edgeRadius)
+			return RdmReconstructMode::COPY;
+		int ring = distToCenter < constants.radius[1] ? 0 : distToCenter < constants.radius[2] ? 1 : 2;
+		switch (constants.levels[ring]) {
+		case RdmLevel::HALF: {
+			// right next to the border with another density, only the low quality filter can be used
+			float ringEnd = ring < 2 ? constants.radius[ring + 1] : constants.edgeRadius;
+			float border = 2 * constants.invClusterResolution[0];
+			bool inside = distToCenter + border < ringEnd && (ring == 0 || distToCenter - border >= constants.radius[ring]);
+			return inside ? RdmReconstructMode::HALF_RES_HIGH : RdmReconstructMode::HALF_RES_LOW;
+		}
+		case RdmLevel::HALF_2X1:
+			return RdmReconstructMode::HALF_RES_2X1;
+		case RdmLevel::HALF_1X2:
+			return RdmReconstructMode::HALF_RES_1X2;
+		case RdmLevel::QUARTER:
+			return RdmReconstructMode::QUARTER_RES;
+		case RdmLevel::EIGHTH:
+			return RdmReconstructMode::EIGHTH_RES;
+		case RdmLevel::SIXTEENTH:
+			return RdmReconstructMode::SIXTEENTH_RES;
+		}
+		return RdmReconstructMode::COPY;
+	}
+
+	void BuildRdmReconstructTiles(const RdmReconstructConstants &constants, bool annulusOnly, std::vector<uint32_t> &tiles, uint32_t groups[3],
+			const Viewport *clip) {
+		tiles.clear();
+		uint32_t clusterSize = constants.clusterSize;
+		uint32_t x0 = constants.offset[0] / clusterSize, y0 = constants.offset[1] / clusterSize;
+		uint32_t x1 = (constants.areaEnd[0] + clusterSize - 1) / clusterSize;
+		uint32_t y1 = (constants.areaEnd[1] + clusterSize - 1) / clusterSize;
+		if (clip != nullptr) {
+			x0 = std::max(x0, clip->x / clusterSize);
+			y0 = std::max(y0, clip->y / clusterSize);
+			x1 = std::min(x1, (clip->x + clip->width + clusterSize - 1) / clusterSize);
+			y1 = std::min(y1, (clip->y + clip->height + clusterSize - 1) / clusterSize);
+		}
+		for (uint32_t y = y0; y < y1; ++y) {
+			for (uint32_t x = x0; x < x1; ++x) {
+				if (!annulusOnly || GetRdmReconstructMode(constants, x * clusterSize, y * clusterSize) != RdmReconstructMode::COPY) {
+					tiles.push_back(x | y << 16);
+				}
+			}
+		}
+
+		groups[0] = std::min((uint32_t)tiles.size(), kRdmTilesPerRow);
+		groups[1] = ((uint32_t)tiles.size() + kRdmTilesPerRow - 1) / kRdmTilesPerRow;
+		groups[2] = tiles.empty() ? 0 : 1;
+		tiles.resize(groups[0] * groups[1], kRdmNoTile);
+	}
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include "types.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vrperfkit {
+	// RDM shades the periphery in square clusters of 4, 8 or 16 pixels, each cluster at one density
+	constexpr uint32_t kRdmClusterSize = 8;
+
+	// Density a ring of RDM clusters is shaded at, as a pattern of the 2x2 pixel blocks that are
+	// left unmasked. The values are the ones reconstruction.compute.hlsl switches on.
+	enum class RdmLevel : uint32_t {
+		// checkerboard of blocks
+		HALF,
+		// every other column of blocks, like the 2x1 VRS rate
+		HALF_2X1,
+		// every other row of blocks, like the 1x2 VRS rate
+		HALF_1X2,
+		// one block of 2x2
+		QUARTER,
+		// one block of 4x2
+		EIGHTH,
+		// one block of 4x4
+		SIXTEENTH,
+	};
+	RdmLevel RdmLevelFromString(std::string s);
+	std::string RdmLevelToString(RdmLevel level);
+
+	struct RdmPattern {
+		uint32_t clusterSize = kRdmClusterSize;
+		// Densities of the rings from the inner radius outwards, each ring ending at the next radius
+		// and the last at the edge radius. With fewer levels, the last ring given reaches the edge.
+		RdmLevel levels[3] = { RdmLevel::HALF, RdmLevel::QUARTER, RdmLevel::SIXTEENTH };
+		uint32_t levelCount = 3;
+	};
+	// Clusters must be 4, 8 or 16 pixels wide, and hold the whole pattern of each of their levels:
+	// the eighth and sixteenth levels repeat every 8 pixels, so they need clusters of at least 8.
+	bool IsValidRdmPattern(const RdmPattern &pattern, std::string &error);
+	std::string RdmPatternToString(const RdmPattern &pattern);
+
+	// Temporal RDM moves the pattern by a phase every frame, so that the blocks masked in one frame
+	// are shaded in one of the next. A phase is an offset in 2x2 blocks: x flips the checkerboard and
+	// the columns of the half levels, y their rows, and together they pick the shaded block of the
+	// quarter, eighth and sixteenth levels. 1 phase is the static mask, 2 or 4 cycle through them:
+	// 2 phases shade every block of the half levels in turn, 4 also those of the quarter level.
+	bool IsValidRdmPhaseCount(uint32_t phases);
+	void GetRdmPhase(uint32_t phases, uint32_t frame, uint32_t phase[2]);
+
+	// Checkerboard rendering masks with the half level alone, its parity flipping every frame, and
+	// fills the masked blocks in with checkerboard.compute.hlsl instead of reconstruction.compute.hlsl.
+	// The ring starts at the inner radius, or at 0 to cover the whole eye, and ends at the edge radius.
+	constexpr uint32_t kCheckerboardPhases = 2;
+	RdmPattern CheckerboardRdmPattern();
+
+	// values of the mask tests below
+	struct RdmMaskingConstants {
+		float depthOut;
+		float radius[3];
+		float invClusterResolution[2];
+		float projectionCenter[2];
+		float yFix[2];
+		float edgeRadius;
+		uint32_t clusterSize;
+		RdmLevel levels[3];
+		uint32_t phase[2];
+	};
+
+	// cbuffer of reconstruction.compute.hlsl
+	struct RdmReconstructConstants {
+		int offset[2];
+		float projectionCenter[2];
+		float invClusterResolution[2];
+		float invResolution[2];
+		float radius[3];
+		float edgeRadius;
+		// end of the area the reconstruction writes: the eye viewport rounded up to whole clusters,
+		// one thread group each, clipped to the texture
+		int areaEnd[2];
+		// the shader takes it from its permutation
+		uint32_t clusterSize;
+		// share of the previous frame's reconstruction in the pixels masked this frame, 0 without history
+		float historyWeight;
+		RdmLevel levels[3];
+		uint32_t _padding;
+		uint32_t phase[2];
+		uint32_t _padding2[2];
+	};
+
+	// thread groups per row of the tiled reconstruction dispatch, as in reconstruction.compute.hlsl
+	constexpr uint32_t kRdmTilesPerRow = 256;
+	// padding entry of a tile list, its thread group does nothing
+	constexpr uint32_t kRdmNoTile = 0xffffffff;
+
+	// How reconstruction.compute.hlsl fills in a pixel
+	enum class RdmReconstructMode {
+		COPY,
+		HALF_RES_HIGH,
+		HALF_RES_LOW,
+		QUARTER_RES,
+		SIXTEENTH_RES,
+		HALF_RES_2X1,
+		HALF_RES_1X2,
+		EIGHTH_RES,
+	};
+	constexpr int kRdmReconstructModeCount = 8;
+
+	// Masking constants for one eye rendered to renderWidth x renderHeight. radius holds the inner,
+	// mid and outer radius as in the ffr config, or is null for the hidden radial mask. arrayTex
+	// builds the mask heads down, as Unity renders array textures flipped. The radii past the levels
+	// of pattern are moved to the edge radius, so both setups only see the rings that are used.
+	// Both setups leave the phase at 0 and the reconstruction without history.
+	void SetupRdmMaskingConstants(RdmMaskingConstants &constants, float depth, const float *radius, float edgeRadius,
+		uint32_t renderWidth, uint32_t renderHeight, const Point<float> &projectionCenter, bool arrayTex,
+		const RdmPattern &pattern = RdmPattern());
+
+	// Reconstruction constants for the eye rendered to inputViewport of a textureWidth x textureHeight texture
+	void SetupRdmReconstructConstants(RdmReconstructConstants &constants, const float *radius, float edgeRadius,
+		const Viewport &inputViewport, uint32_t textureWidth, uint32_t textureHeight, const Point<float> &projectionCenter,
+		const RdmPattern &pattern = RdmPattern());
+
+	// 2 * the distance of a cluster (or of a pixel position in clusters, for the hidden radial mask)
+	// from the projection centre, as computed by the shaders
+	float RdmDistanceToCenter(const float invClusterResolution[2], const float projectionCenter[2], float clusterX, float clusterY);
+
+	// true if level leaves the 2x2 block (halfX, halfY) unmasked in the phase (phaseX, phaseY)
+	bool IsRdmShaded(RdmLevel level, uint32_t halfX, uint32_t halfY, uint32_t phaseX = 0, uint32_t phaseY = 0);
+	// unmasked pixels of a whole cluster of clusterSize x clusterSize shaded at level
+	uint32_t RdmShadedPerCluster(RdmLevel level, uint32_t clusterSize);
+
+	// true if the radial density mask writes depth at the pixel centre (x, y), so that the game does
+	// not shade it. x and y are render target coordinates as in SV_Position. The mask mesh is built
+	// from this test, and reconstruction.compute.hlsl relies on the pattern.
+	bool IsRdmMasked(const RdmMaskingConstants &constants, float x, float y);
+	// the same for the hidden radial mask
+	bool IsHrmMasked(const RdmMaskingConstants &constants, float x, float y);
+	// The pixels of row y in [x0, x1) the hidden radial mask leaves unmasked form one span around the
+	// projection centre, found by bisection with IsHrmMasked. Returns false if the whole row is masked.
+	bool HrmUnmaskedSpan(const RdmMaskingConstants &constants, uint32_t x0, uint32_t x1, uint32_t y, uint32_t &first, uint32_t &end);
+
+	// branch taken by reconstruction.compute.hlsl for the texel at (x, y), including the viewport offset
+	RdmReconstructMode GetRdmReconstructMode(const RdmReconstructConstants &constants, uint32_t x, uint32_t y);
+
+	// The clusters of the texture that reconstruction.compute.hlsl runs a thread group for, packed
+	// as x | y << 16 in cluster units. With annulusOnly, only the clusters between the inner and the
+	// edge radius, where it does more than copy, otherwise all clusters of the area it writes. The
+	// list is padded with kRdmNoTile to rows of kRdmTilesPerRow, and groups gets the matching
+	// DispatchIndirect arguments. With clip, in texture pixels, only the clusters that overlap it.
+	void BuildRdmReconstructTiles(const RdmReconstructConstants &constants, bool annulusOnly, std::vector<uint32_t> &tiles, uint32_t groups[3],
+		const Viewport *clip = nullptr);
+}
@@ -2,7 +2,21 @@
  * Adapted from Ogre: https://github.com/OGRECave/ogre-next under the MIT license
  */
 
+// cluster size of the RdmPattern: 8x8 pixels, or 4x4 and 16x16 with these permutations
+#if RDM_CLUSTER_4
+#define CLUSTER_SHIFT 2u
+#elif RDM_CLUSTER_16
+#define CLUSTER_SHIFT 4u
+#else
+#define CLUSTER_SHIFT 3u
+#endif
+#define CLUSTER_SIZE (1u << CLUSTER_SHIFT)
+
 Texture2D u_srcTex : register(t0);
+// clusters to reconstruct, x | y << 16, see BuildRdmReconstructTiles
+Buffer<uint> u_tiles : register(t1);
+// this eye's reconstruction of the previous frame, only bound with temporal RDM
+Texture2D u_historyTex : register(t2);
 SamplerState bilinearSampler : register(s0);
 
 RWTexture2D<float4> u_dstTex : register(u0);
@@ -14,14 +28,78 @@ cbuffer cb : register(b0) {
 	float2 u_invResolution;
 	float3 u_radius;
 	float edgeRadius;
+	uint2 u_areaEnd;
+	uint u_clusterSize;
+	float u_historyWeight;
+	// RdmLevel of the rings from the inner radius outwards
+	uint3 u_levels;
+	// offset of the shaded blocks this frame, see GetRdmPhase
+	uint2 u_phase;
 };
 
+#define RDM_TILES_PER_ROW 256
+#define RDM_NO_TILE 0xffffffff
+
+#define LEVEL_HALF 0u
+#define LEVEL_HALF_2X1 1u
+#define LEVEL_HALF_1X2 2u
+#define LEVEL_QUARTER 3u
+#define LEVEL_EIGHTH 4u
+#define LEVEL_SIXTEENTH 5u
+
 // FIXME: AMD/NVIDIA extensions?
 #define anyInvocationARB(value) (value)
 #define imageStore(outImage, iuv, value) outImage[uint2(iuv)] = value
 #define texelFetch(srcImage, iuv, lod) srcImage.Load(int3(iuv, lod))
 #define textureLod(srcTex, uv, lod) srcTex.SampleLevel(bilinearSampler, uv, lod)
 
+/// IsRdmShaded: the block is left unmasked in this frame's phase
+bool isShaded( uint level, uint2 uFragCoordHalf )
+{
+	uint2 block = uFragCoordHalf;
+	if( level == LEVEL_HALF )
+		return ( ( block.x + block.y + u_phase.x ) & 0x01u ) == 0;
+	if( level == LEVEL_HALF_2X1 )
+		return ( block.x & 0x01u ) == u_phase.x;
+	if( level == LEVEL_HALF_1X2 )
+		return ( block.y & 0x01u ) == u_phase.y;
+	if( level == LEVEL_QUARTER )
+		return all( ( block & 0x01u ) == u_phase );
+	if( level == LEVEL_EIGHTH )
+		return ( block.x & 0x03u ) == u_phase.x * 2u && ( block.y & 0x01u ) == u_phase.y;
+	return all( ( block & 0x03u ) == u_phase * 2u );
+}
+
+/// offsets from a pixel to the same pixel of the shaded block of its 2x2, 4x2 or 4x4 group
+int2 quarterResOffset( uint2 uFragCoordHalf )
+{
+	return ( int2( u_phase ) - int2( uFragCoordHalf & 0x01u ) ) * 2;
+}
+
+int2 eighthResOffset( uint2 uFragCoordHalf )
+{
+	return ( int2( u_phase ) * int2( 2, 1 ) - int2( uFragCoordHalf & uint2( 0x03u, 0x01u ) ) ) * 2;
+}
+
+int2 sixteenthResOffset( uint2 uFragCoordHalf )
+{
+	return ( int2( u_phase ) * 2 - int2( uFragCoordHalf & 0x03u ) ) * 2;
+}
+
+/// offset to the shaded block a masked block is filled in from, the left or right one for the half levels
+int2 sourceBlockOffset( uint level, uint2 uFragCoordHalf )
+{
+	if( level == LEVEL_HALF || level == LEVEL_HALF_2X1 )
+		return int2( (uFragCoordHalf.x & 0x01u) != 0 ? -2 : 2, 0 );
+	if( level == LEVEL_HALF_1X2 )
+		return int2( 0, (uFragCoordHalf.y & 0x01u) != 0 ? -2 : 2 );
+	if( level == LEVEL_QUARTER )
+		return quarterResOffset( uFragCoordHalf );
+	if( level == LEVEL_EIGHTH )
+		return eighthResOffset( uFragCoordHalf );
+	return sixteenthResOffset( uFragCoordHalf );
+}
+
 /** Takes the pattern (low quality):
 		ab xx ef xx
 		cd xx gh xx
@@ -33,27 +111,25 @@ cbuffer cb : register(b0) {
 		ij ij mn mn
 		kl kl op op
 */
-void reconstructHalfResLow( int2 dstUV, uint2 uFragCoordHalf )
+float4 reconstructHalfResLow( int2 dstUV, uint2 uFragCoordHalf )
 {
 	int2 offset;
-	if( (uFragCoordHalf.x & 0x01u) != (uFragCoordHalf.y & 0x01u) )
-		offset.x = (uFragCoordHalf.y & 0x01u) == 0 ? -2 : 2;
+	if( !isShaded( LEVEL_HALF, uFragCoordHalf ) )
+		offset.x = (uFragCoordHalf.x & 0x01u) != 0 ? -2 : 2;
 	else
 		offset.x = 0;
 	offset.y = 0;
 
 	int2 uv = dstUV + offset;
-	float4 srcVal = texelFetch( u_srcTex, uv.xy, 0 );
-
-	imageStore( u_dstTex, dstUV, srcVal );
+	return texelFetch( u_srcTex, uv.xy, 0 );
 }
 
 /* Uses Valve's Alex Vlachos Advanced VR Rendering Performance technique
    (bilinear approximation) GDC 2016
 */
-void reconstructHalfResHigh( int2 dstUV, uint2 uFragCoordHalf )
+float4 reconstructHalfResHigh( int2 dstUV, uint2 uFragCoordHalf )
 {
-	if( (uFragCoordHalf.x & 0x01u) != (uFragCoordHalf.y & 0x01u) )
+	if( !isShaded( LEVEL_HALF, uFragCoordHalf ) )
 	{
 		float2 offset0;
 		float2 offset1;
@@ -77,8 +153,7 @@ void reconstructHalfResHigh( int2 dstUV, uint2 uFragCoordHalf )
 		float2 uv1N = ( float2( dstUV ) + offset1N ) * u_invResolution;
 		float4 srcVal1N = textureLod( u_srcTex, uv1N.xy, 0 );
 
-		float4 finalVal = srcVal0 * 0.375f + srcVal1 * 0.375f + srcVal0N * 0.125f + srcVal1N * 0.125f;
-		imageStore( u_dstTex, dstUV, finalVal );
+		return srcVal0 * 0.375f + srcVal1 * 0.375f + srcVal0N * 0.125f + srcVal1N * 0.125f;
 	}
 	else
 	{
@@ -98,13 +173,11 @@ void reconstructHalfResHigh( int2 dstUV, uint2 uFragCoordHalf )
 
 		int idx = (dstUV.x & 0x01) + ((dstUV.y & 0x01) << 1u);
 
-		float4 finalVal =	srcVal * 0.5f +
-							srcTL * weights[(idx + 0)] +
-							srcTR * weights[(idx + 1) & 0x03] +
-							srcBL * weights[(idx + 2) & 0x03] +
-							srcBR * weights[(idx + 3) & 0x03];
-
-		imageStore( u_dstTex, dstUV, finalVal );
+		return	srcVal * 0.5f +
+				srcTL * weights[(idx + 0)] +
+				srcTR * weights[(idx + 1) & 0x03] +
+				srcBL * weights[(idx + 2) & 0x03] +
+				srcBR * weights[(idx + 3) & 0x03];
 	}
 }
 
@@ -119,16 +192,62 @@ void reconstructHalfResHigh( int2 dstUV, uint2 uFragCoordHalf )
 		a b a b
 		c d c d
 */
-void reconstructQuarterRes( int2 dstUV, uint2 uFragCoordHalf )
+float4 reconstructQuarterRes( int2 dstUV, uint2 uFragCoordHalf )
 {
-	int2 offset;
-	offset.x = (uFragCoordHalf.x & 0x01u) == 0 ? 0 : -2;
-	offset.y = (uFragCoordHalf.y & 0x01u) == 0 ? 0 : -2;
+	int2 uv = int2( dstUV ) + quarterResOffset( uFragCoordHalf );
+	return texelFetch( u_srcTex, uv.xy, 0 );
+}
 
-	int2 uv = int2( int2( dstUV ) + offset );
-	float4 srcVal = texelFetch( u_srcTex, uv.xy, 0 );
+/** Takes every other column of blocks:
+		a b x x e f x x
+		c d x x g h x x
+	And outputs the missing columns as the average of their neighbours, or as the one of the same
+	pair at the edge of the cluster, where the other may belong to a cluster of another density:
+		a b (a+e)/2 (b+f)/2 e f g h
+	With the phase moved, the shaded column is the right one of each pair.
+*/
+float4 reconstructHalfRes2x1( int2 dstUV, uint2 uFragCoordHalf )
+{
+	if( isShaded( LEVEL_HALF_2X1, uFragCoordHalf ) )
+		return texelFetch( u_srcTex, dstUV, 0 );
 
-	imageStore( u_dstTex, dstUV, srcVal );
+	int step = (uFragCoordHalf.x & 0x01u) != 0 ? 2 : -2;
+	float4 srcVal = texelFetch( u_srcTex, dstUV + int2( -step, 0 ), 0 );
+	uint inCluster = uint(dstUV.x) & (CLUSTER_SIZE - 1u);
+	if( step > 0 ? inCluster + 2u < CLUSTER_SIZE : inCluster >= 2u )
+		srcVal = ( srcVal + texelFetch( u_srcTex, dstUV + int2( step, 0 ), 0 ) ) * 0.5f;
+	return srcVal;
+}
+
+/// The same with every other row of blocks
+float4 reconstructHalfRes1x2( int2 dstUV, uint2 uFragCoordHalf )
+{
+	if( isShaded( LEVEL_HALF_1X2, uFragCoordHalf ) )
+		return texelFetch( u_srcTex, dstUV, 0 );
+
+	int step = (uFragCoordHalf.y & 0x01u) != 0 ? 2 : -2;
+	float4 srcVal = texelFetch( u_srcTex, dstUV + int2( 0, -step ), 0 );
+	uint inCluster = uint(dstUV.y) & (CLUSTER_SIZE - 1u);
+	if( step > 0 ? inCluster + 2u < CLUSTER_SIZE : inCluster >= 2u )
+		srcVal = ( srcVal + texelFetch( u_srcTex, dstUV + int2( 0, step ), 0 ) ) * 0.5f;
+	return srcVal;
+}
+
+/** Like reconstructQuarterRes, repeating one block of 4x2:
+		a b x x x x x x
+		c d x x x x x x
+		x x x x x x x x
+		x x x x x x x x
+	And outputs:
+		a b a b a b a b
+		c d c d c d c d
+		a b a b a b a b
+		c d c d c d c d
+*/
+float4 reconstructEighthRes( int2 dstUV, uint2 uFragCoordHalf )
+{
+	int2 uv = int2( dstUV ) + eighthResOffset( uFragCoordHalf );
+	return texelFetch( u_srcTex, uv.xy, 0 );
 }
 
 /** Same as reconstructQuarterRes, but a lot more samples to repeat:
@@ -150,53 +269,88 @@ void reconstructQuarterRes( int2 dstUV, uint2 uFragCoordHalf )
 		a b a b a b a b
 		c d c d c d c d
 */
-void reconstructSixteenthRes( int2 dstUV, uint2 uFragCoordHalf )
+float4 reconstructSixteenthRes( int2 dstUV, uint2 uFragCoordHalf )
 {
-	int2 block = int2( uFragCoordHalf ) & 0x03;
-
-	int2 offset;
-	offset.x = block.x * -2;
-	offset.y = block.y * -2;
+	int2 uv = int2( dstUV ) + sixteenthResOffset( uFragCoordHalf );
+	return texelFetch( u_srcTex, uv.xy, 0 );
+}
 
-	int2 uv = int2( int2( dstUV ) + offset );
-	float4 srcVal = texelFetch( u_srcTex, uv.xy, 0 );
+/** Blends a pixel masked this frame with its reconstruction of the previous frame, which shaded it
+	in another phase. Without motion vectors, the history is clamped to the colours of the block it
+	was filled in from and the value of this frame, which rejects it where the scene moved.
+*/
+float4 blendHistory( int2 dstUV, uint2 uFragCoordHalf, uint level, float4 srcVal )
+{
+	int2 block = int2( uFragCoordHalf << 1u ) + sourceBlockOffset( level, uFragCoordHalf );
+	float4 a = texelFetch( u_srcTex, block, 0 );
+	float4 b = texelFetch( u_srcTex, block + int2( 1, 0 ), 0 );
+	float4 c = texelFetch( u_srcTex, block + int2( 0, 1 ), 0 );
+	float4 d = texelFetch( u_srcTex, block + int2( 1, 1 ), 0 );
+	float4 lo = min( min( min( a, b ), min( c, d ) ), srcVal );
+	float4 hi = max( max( max( a, b ), max( c, d ) ), srcVal );
 
-	imageStore( u_dstTex, dstUV, srcVal );
+	float4 history = clamp( texelFetch( u_historyTex, dstUV, 0 ), lo, hi );
+	return srcVal + ( history - srcVal ) * u_historyWeight;
 }
 
-[numthreads(8, 8, 1)]
-void main(uint3 globalInvocationID : SV_DispatchThreadID) {
-	uint2 currentUV = uint2(globalInvocationID.xy) + u_offset;
+[numthreads(CLUSTER_SIZE, CLUSTER_SIZE, 1)]
+void main(uint3 groupID : SV_GroupID, uint3 threadID : SV_GroupThreadID) {
+	uint tile = u_tiles[groupID.y * RDM_TILES_PER_ROW + groupID.x];
+	uint2 currentUV = (uint2(tile & 0xffff, tile >> 16) << CLUSTER_SHIFT) + threadID.xy;
+	if( tile == RDM_NO_TILE || any( currentUV < u_offset ) || any( currentUV >= u_areaEnd ) )
+		return;
 	uint2 uFragCoordHalf = uint2(currentUV >> 1u);
 
 	//We must work in blocks so the reconstruction filter can work properly
-	float2 toCenter     = (currentUV >> 3u) * u_invClusterResolution - u_projectionCenter;
+	float2 toCenter     = (currentUV >> CLUSTER_SHIFT) * u_invClusterResolution - u_projectionCenter;
 	float  distToCenter = 2 * length(toCenter);
 
-	//We know for a fact distToCenter is in blocks of 8x8
+	//We know for a fact distToCenter is in blocks of CLUSTER_SIZE, so the branches are uniform per group
 	if( anyInvocationARB( distToCenter >= u_radius.x ) && anyInvocationARB( distToCenter <= edgeRadius ) )
 	{
-		if( anyInvocationARB( distToCenter < u_radius.y ) )
+		uint ring = distToCenter < u_radius.y ? 0 : ( distToCenter < u_radius.z ? 1 : 2 );
+		uint level = u_levels[ring];
+		float4 srcVal;
+		if( anyInvocationARB( level == LEVEL_HALF ) )
 		{
-			if( anyInvocationARB( distToCenter + 2 * u_invClusterResolution.x < u_radius.y ) )
+			float ringStart = ring == 0 ? u_radius.x : ( ring == 1 ? u_radius.y : u_radius.z );
+			float ringEnd = ring == 0 ? u_radius.y : ( ring == 1 ? u_radius.z : edgeRadius );
+			float border = 2 * u_invClusterResolution.x;
+			if( anyInvocationARB( distToCenter + border < ringEnd && ( ring == 0 || distToCenter - border >= ringStart ) ) )
 			{
-				reconstructHalfResHigh( int2(currentUV), uFragCoordHalf );
+				srcVal = reconstructHalfResHigh( int2(currentUV), uFragCoordHalf );
 			}
 			else
 			{
-				//Right next to the border with lower res rendering.
+				//Right next to the border with another density.
 				//We can't use anything else than low quality filter
-				reconstructHalfResLow( int2( currentUV ), uFragCoordHalf );
+				srcVal = reconstructHalfResLow( int2( currentUV ), uFragCoordHalf );
 			}
 		}
-		else if( anyInvocationARB( distToCenter < u_radius.z ) )
+		else if( anyInvocationARB( level == LEVEL_HALF_2X1 ) )
 		{
-			reconstructQuarterRes( int2( currentUV ), uFragCoordHalf );
+			srcVal = reconstructHalfRes2x1( int2( currentUV ), uFragCoordHalf );
+		}
+		else if( anyInvocationARB( level == LEVEL_HALF_1X2 ) )
+		{
+			srcVal = reconstructHalfRes1x2( int2( currentUV ), uFragCoordHalf );
+		}
+		else if( anyInvocationARB( level == LEVEL_QUARTER ) )
+		{
+			srcVal = reconstructQuarterRes( int2( currentUV ), uFragCoordHalf );
+		}
+		else if( anyInvocationARB( level == LEVEL_EIGHTH ) )
+		{
+			srcVal = reconstructEighthRes( int2( currentUV ), uFragCoordHalf );
 		}
 		else
 		{
-			reconstructSixteenthRes( int2( currentUV ), uFragCoordHalf );
+			srcVal = reconstructSixteenthRes( int2( currentUV ), uFragCoordHalf );
 		}
+
+		if( u_historyWeight > 0 && !isShaded( level, uFragCoordHalf ) )
+			srcVal = blendHistory( int2( currentUV ), uFragCoordHalf, level, srcVal );
+		imageStore( u_dstTex, int2( currentUV ), srcVal );
 	}
 	else
 	{
@@ -0,0 +1,53 @@
+// Lanczos-2 resampling, shared by the stand-alone upscaler and the periphery fallback of the other methods.
+// Separable weights over a 4x4 texel footprint, with the result clamped to the nearest 2x2 texels to avoid ringing.
+
+float Lanczos2Weight(float x) {
+	x = abs(x);
+	if (x < 1e-5) {
+		return 1;
+	}
+	if (x >= 2) {
+		return 0;
+	}
+	float px = 3.14159265 * x;
+	return 2 * sin(px) * sin(0.5 * px) / (px * px);
+}
+
+// pos is the sample position in texels (texel centres at .5), loads are clamped to [minPos, maxPos]
+float3 Lanczos2(Texture2D tex, float2 pos, int2 minPos, int2 maxPos) {
+	float2 p = pos - 0.5;
+	float2 fp = floor(p);
+	float2 f = p - fp;
+	int2 base = int2(fp) - 1;
+
+	float wx[4];
+	float wy[4];
+	[unroll] for (int i = 0; i < 4; ++i) {
+		wx[i] = Lanczos2Weight(f.x + 1 - i);
+		wy[i] = Lanczos2Weight(f.y + 1 - i);
+	}
+
+	float3 sum = 0;
+	float weightSum = 0;
+	float3 mn = 65504;
+	float3 mx = -65504;
+	[unroll] for (int y = 0; y < 4; ++y) {
+		[unroll] for (int x = 0; x < 4; ++x) {
+			float3 c = tex.Load(int3(clamp(base + int2(x, y), minPos, maxPos), 0)).rgb;
+			float w = wx[x] * wy[y];
+			sum += c * w;
+			weightSum += w;
+			if ((x == 1 || x == 2) && (y == 1 || y == 2)) {
+				mn = min(mn, c);
+				mx = max(mx, c);
+			}
+		}
+	}
+	return clamp(sum / weightSum, mn, mx);
+}
+
+float3 Lanczos2(Texture2D tex, float2 pos) {
+	uint width, height;
+	tex.GetDimensions(width, height);
+	return Lanczos2(tex, pos, int2(0, 0), int2(width, height) - 1);
+}
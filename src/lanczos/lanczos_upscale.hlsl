@@ -0,0 +1,24 @@
+cbuffer cb : register(b0) {
+	uint2 inputOffset;
+	uint2 inputSize;
+	uint2 outputOffset;
+	uint2 outputSize;
+	float2 scale;
+	float2 _padding;
+};
+
+Texture2D InputTexture : register(t0);
+RWTexture2D<float4> OutputTexture : register(u0);
+
+#include "lanczos.h"
+
+[numthreads(8, 8, 1)]
+void main(uint3 Dtid : SV_DispatchThreadID) {
+	if (any(Dtid.xy >= outputSize)) {
+		return;
+	}
+	// clamp to the input viewport so that eyes in a combined texture do not bleed into each other
+	float2 pos = (float2(Dtid.xy) + 0.5) * scale + float2(inputOffset);
+	float3 c = Lanczos2(InputTexture, pos, int2(inputOffset), int2(inputOffset + inputSize) - 1);
+	OutputTexture[Dtid.xy + outputOffset] = float4(c, 1);
+}
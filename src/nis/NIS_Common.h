@@ -44,12 +44,21 @@ cbuffer cb : register(b0)
 
 SamplerState samplerLinearClamp : register(s0);
 Texture2D in_texture            : register(t0);
+#if NIS_HDR_MODE
+RWTexture2D<float4> out_texture : register(u0);
+#else
 RWTexture2D<unorm float4> out_texture : register(u0);
+#endif
 
 
 void DirectCopy(uint2 blockIdx, uint threadIdx)
 {
+#if DEBUG_MODE
+	// tint the area outside the radius
+	const float4 mul = float4(1, 0.6, 0.6, 1);
+#else
 	const float4 mul = float4(1, 1, 1, 1);
+#endif
 	const int dstBlockX = NIS_BLOCK_WIDTH * blockIdx.x;
 	const int dstBlockY = NIS_BLOCK_HEIGHT * blockIdx.y;
 	for (uint k = threadIdx; k < NIS_BLOCK_WIDTH * NIS_BLOCK_HEIGHT; k += NIS_THREAD_GROUP_SIZE)
@@ -333,9 +333,15 @@ NVF4 GetEdgeMap(NVF p[5][5], NVI i, NVI j)
 #ifndef NIS_THREAD_GROUP_SIZE
 #define NIS_THREAD_GROUP_SIZE 256
 #endif
+#ifndef NIS_FILTER_TAPS
+#define NIS_FILTER_TAPS 6
+#endif
 #define kPhaseCount  64
 #define kFilterSize  6
 #define kSupportSize 6
+// range of taps evaluated by the scaler and USM filters, the outer taps are zero for fewer filter taps
+#define kFirstTap    ((kFilterSize - NIS_FILTER_TAPS) / 2)
+#define kLastTap     (kFirstTap + NIS_FILTER_TAPS)
 #define kPadSize     kSupportSize
 // 'Tile' is the region of source luminance values that we load into shPixelsY.
 // It is the area of source pixels covered by the destination 'Block' plus a
@@ -417,7 +423,7 @@ NVF EvalPoly6(const NVF pxl[6], NVI phase_int)
     NVF y = 0.f;
     {
         NIS_UNROLL
-        for (NVI i = 0; i < 6; ++i)
+        for (NVI i = kFirstTap; i < kLastTap; ++i)
         {
             y += shCoefScaler[phase_int][i] * pxl[i];
         }
@@ -425,7 +431,7 @@ NVF EvalPoly6(const NVF pxl[6], NVI phase_int)
     NVF y_usm = 0.f;
     {
         NIS_UNROLL
-        for (NVI i = 0; i < 6; ++i)
+        for (NVI i = kFirstTap; i < kLastTap; ++i)
         {
             y_usm += shCoefUSM[phase_int][i] * pxl[i];
         }
@@ -453,11 +459,11 @@ NVF FilterNormal(const NVF p[6][6], NVI phase_x_frac_int, NVI phase_y_frac_int)
 {
     NVF h_acc = 0.0f;
     NIS_UNROLL
-    for (NVI j = 0; j < 6; ++j)
+    for (NVI j = kFirstTap; j < kLastTap; ++j)
     {
         NVF v_acc = 0.0f;
         NIS_UNROLL
-        for (NVI i = 0; i < 6; ++i)
+        for (NVI i = kFirstTap; i < kLastTap; ++i)
         {
             v_acc += p[i][j] * shCoefScaler[phase_y_frac_int][i];
         }
@@ -21,7 +21,15 @@
 
 #define NIS_HLSL 1
 #define NIS_SCALER 0
+#ifndef NIS_HDR_MODE
 #define NIS_HDR_MODE 0
+#endif
+#ifndef RADIUS_TEST
+#define RADIUS_TEST 1
+#endif
+#ifndef DEBUG_MODE
+#define DEBUG_MODE 0
+#endif
 #define NIS_BLOCK_WIDTH 32
 #define NIS_BLOCK_HEIGHT 32
 #define NIS_THREAD_GROUP_SIZE 256
@@ -33,6 +41,7 @@
 [numthreads(NIS_THREAD_GROUP_SIZE, 1, 1)]
 void main(uint3 blockIdx : SV_GroupID, uint3 threadIdx : SV_GroupThreadID)
 {
+#if RADIUS_TEST
 	uint2 groupCentre = uint2((blockIdx.x * 32) + 16, (blockIdx.y * 32) + 16);
 	uint2 dc = projCentre.xy - groupCentre;
 	if (dot(dc, dc) <= squaredRadius) {
@@ -41,4 +50,7 @@ void main(uint3 blockIdx : SV_GroupID, uint3 threadIdx : SV_GroupThreadID)
 	else {
 		DirectCopy(blockIdx.xy, threadIdx.x);
 	}
+#else
+	NVSharpen(blockIdx.xy, threadIdx.x);
+#endif
 }
@@ -21,7 +21,24 @@
 
 #define NIS_HLSL 1
 #define NIS_SCALER 1
+#ifndef NIS_HDR_MODE
 #define NIS_HDR_MODE 0
+#endif
+#ifndef RADIUS_TEST
+#define RADIUS_TEST 1
+#endif
+#ifndef DEBUG_MODE
+#define DEBUG_MODE 0
+#endif
+#ifndef PERIPHERY_LANCZOS
+#define PERIPHERY_LANCZOS 0
+#endif
+#ifndef NIS_PERFORMANCE
+#define NIS_PERFORMANCE 0
+#endif
+#if NIS_PERFORMANCE
+#define NIS_FILTER_TAPS 4
+#endif
 #define NIS_BLOCK_WIDTH 32
 #define NIS_BLOCK_HEIGHT 24
 #define NIS_THREAD_GROUP_SIZE 256
@@ -33,15 +50,45 @@ Texture2D coef_usm              : register(t2);
 #include "NIS_Common.h"
 #include "NIS_Scaler.h"
 
+#if PERIPHERY_LANCZOS
+#include "../lanczos/lanczos.h"
+
+void LanczosCopy(uint2 blockIdx, uint threadIdx)
+{
+#if DEBUG_MODE
+	const float4 mul = float4(1, 0.6, 0.6, 1);
+#else
+	const float4 mul = float4(1, 1, 1, 1);
+#endif
+	const int dstBlockX = NIS_BLOCK_WIDTH * blockIdx.x;
+	const int dstBlockY = NIS_BLOCK_HEIGHT * blockIdx.y;
+	for (uint k = threadIdx; k < NIS_BLOCK_WIDTH * NIS_BLOCK_HEIGHT; k += NIS_THREAD_GROUP_SIZE)
+	{
+		const int2 pos = int2(k % NIS_BLOCK_WIDTH, k / NIS_BLOCK_WIDTH);
+		const int dstX = dstBlockX + pos.x + kOutputViewportOriginX;
+		const int dstY = dstBlockY + pos.y + kOutputViewportOriginY;
+		float2 srcPos = float2(dstX + 0.5, dstY + 0.5) * float2(kDstNormX, kDstNormY) / float2(kSrcNormX, kSrcNormY);
+		float3 c = Lanczos2(in_texture, srcPos);
+		out_texture[uint2(dstX, dstY)] = float4(c, 1) * mul;
+	}
+}
+#else
+#define LanczosCopy DirectCopy
+#endif
+
 [numthreads(NIS_THREAD_GROUP_SIZE, 1, 1)]
 void main(uint3 blockIdx : SV_GroupID, uint3 threadIdx : SV_GroupThreadID)
 {
+#if RADIUS_TEST
 	uint2 groupCentre = uint2((blockIdx.x * 32) + 16, (blockIdx.y * 24) + 12);
 	uint2 dc = projCentre.xy - groupCentre;
 	if (dot(dc, dc) <= squaredRadius) {
 		NVScaler(blockIdx.xy, threadIdx.x);
 	}
 	else {
-		DirectCopy(blockIdx.xy, threadIdx.x);
+		LanczosCopy(blockIdx.xy, threadIdx.x);
 	}
+#else
+	NVScaler(blockIdx.xy, threadIdx.x);
+#endif
 }
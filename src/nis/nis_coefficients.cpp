@@ -0,0 +1,103 @@
+#include "nis_coefficients.h"
+#include "nis/NIS_Config.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace vrperfkit {
+	namespace {
+		constexpr float kPi = 3.14159265358979f;
+		// offset of the first tap relative to the integer source position
+		constexpr int kFirstTapOffset = -2;
+
+		float Sinc(float x) {
+			if (std::abs(x) < 1e-6f) {
+				return 1;
+			}
+			return std::sin(kPi * x) / (kPi * x);
+		}
+
+		float LanczosWeight(float x, float lobes) {
+			if (std::abs(x) >= lobes) {
+				return 0;
+			}
+			return Sinc(x) * Sinc(x / lobes);
+		}
+
+		// The shipped USM table samples one continuous response at distances n/kPhaseCount, so
+		// it can be evaluated at arbitrary distances by linear interpolation between the rows.
+		float ShippedUsmResponse(float distance) {
+			float pos = distance * kPhaseCount;
+			int lower = (int)std::floor(pos);
+			float frac = pos - lower;
+
+			auto sample = [](int n) -> float {
+				// n = (tap + kFirstTapOffset) * kPhaseCount - phase
+				int tapScaled = n - kFirstTapOffset * (int)kPhaseCount;
+				int tap = (int)std::ceil(tapScaled / (float)kPhaseCount);
+				int phase = tap * (int)kPhaseCount - tapScaled;
+				if (tap < 0 || tap >= (int)kNisMaxFilterTaps) {
+					return 0;
+				}
+				return coef_usm[phase][tap];
+			};
+
+			return sample(lower) * (1 - frac) + sample(lower + 1) * frac;
+		}
+	}
+
+	NisCoefficients GenerateNisCoefficients(uint32_t taps) {
+		if (taps < 2 || taps > kNisMaxFilterTaps || (taps & 1) != 0) {
+			throw std::invalid_argument("NIS filter tap count must be 2, 4 or 6, got " + std::to_string(taps));
+		}
+
+		NisCoefficients result;
+		result.taps = taps;
+		result.scaler.assign(kPhaseCount * kNisCoefficientStride, 0.f);
+		result.usm.assign(kPhaseCount * kNisCoefficientStride, 0.f);
+
+		uint32_t firstTap = (kNisMaxFilterTaps - taps) / 2;
+		float lobes = taps / 2.f;
+		for (uint32_t phase = 0; phase < kPhaseCount; ++phase) {
+			float *scaler = &result.scaler[phase * kNisCoefficientStride];
+			float *usm = &result.usm[phase * kNisCoefficientStride];
+			float fraction = phase / (float)kPhaseCount;
+
+			float scalerSum = 0;
+			float usmSum = 0;
+			for (uint32_t tap = firstTap; tap < firstTap + taps; ++tap) {
+				float distance = (int)tap + kFirstTapOffset - fraction;
+				scaler[tap] = LanczosWeight(distance, lobes);
+				scalerSum += scaler[tap];
+				usm[tap] = ShippedUsmResponse(distance);
+				usmSum += usm[tap];
+			}
+
+			for (uint32_t tap = firstTap; tap < firstTap + taps; ++tap) {
+				scaler[tap] /= scalerSum;
+				if (taps != kNisMaxFilterTaps) {
+					// truncating the response introduces a DC component, which would brighten or darken flat areas
+					usm[tap] -= usmSum / taps;
+				}
+			}
+		}
+
+		return result;
+	}
+
+	bool UpdateNisConfig(NISConfig &config, float sharpness, float radius, const Point<float> &projectionCenter,
+			const Viewport &inputViewport, uint32_t inputWidth, uint32_t inputHeight,
+			const Viewport &outputViewport, uint32_t outputWidth, uint32_t outputHeight, bool hdr, bool debugMode) {
+		bool valid = NVScalerUpdateConfig(config, sharpness, inputViewport.x, inputViewport.y,
+				inputViewport.width, inputViewport.height, inputWidth, inputHeight,
+				outputViewport.x, outputViewport.y, outputViewport.width, outputViewport.height,
+				outputWidth, outputHeight, hdr ? NISHDRMode::Linear : NISHDRMode::None);
+		float radiusPixels = 0.5f * radius * outputViewport.height;
+		config.projCentre[0] = outputViewport.width * projectionCenter.x;
+		config.projCentre[1] = outputViewport.height * projectionCenter.y;
+		config.squaredRadius = radiusPixels * radiusPixels;
+		config.debugMode = debugMode;
+		return valid;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "types.h"
+
+#include <cstdint>
+#include <vector>
+
+struct NISConfig;
+
+namespace vrperfkit {
+	// Filter tables in the layout of coef_scale/coef_usm from NIS_Config.h: kPhaseCount rows of
+	// kNisCoefficientStride floats, with the taps centred in the first six entries. The phase count
+	// is fixed at 64 by the shader, which loads the tables into groupshared arrays of that size.
+	constexpr uint32_t kNisCoefficientStride = 8;
+	constexpr uint32_t kNisMaxFilterTaps = 6;
+
+	struct NisCoefficients {
+		uint32_t taps = 0;
+		std::vector<float> scaler;
+		std::vector<float> usm;
+
+		const float *ScalerRow(uint32_t phase) const { return &scaler[phase * kNisCoefficientStride]; }
+		const float *UsmRow(uint32_t phase) const { return &usm[phase * kNisCoefficientStride]; }
+	};
+
+	// Generates the NIS scaler and USM tables for an even tap count between 2 and 6.
+	// The scaler is a normalized Lanczos kernel with a lobe count of taps / 2, which reproduces
+	// the shipped 6-tap table up to its FP16 rounding. The shipped USM response is used as the
+	// prototype for the sharpening filter, truncated to the tap count and kept free of DC.
+	NisCoefficients GenerateNisCoefficients(uint32_t taps = kNisMaxFilterTaps);
+
+	// NVScalerUpdateConfig for the given viewports, plus the radius test constants read by the
+	// RADIUS_TEST shader variants. radius is relative to the output height as upscaling.radius,
+	// projectionCenter relative to the output viewport.
+	bool UpdateNisConfig(NISConfig &config, float sharpness, float radius, const Point<float> &projectionCenter,
+		const Viewport &inputViewport, uint32_t inputWidth, uint32_t inputHeight,
+		const Viewport &outputViewport, uint32_t outputWidth, uint32_t outputHeight, bool hdr, bool debugMode);
+}
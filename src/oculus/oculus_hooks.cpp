@@ -30,7 +30,7 @@ namespace {
 	};
 
 	ovrSizei ovrHook_GetFovTextureSize(ovrSession session, ovrEyeType eye, ovrFovPort fov, float pixelsPerDisplayPixel) {
-		ovrSizei result = vrperfkit::hooks::CallOriginal(ovrHook_GetFovTextureSize)(session, eye, fov, pixelsPerDisplayPixel);
+		ovrSizei result = vrperfkit::hooks::Original<ovrHook_GetFovTextureSize>()(session, eye, fov, pixelsPerDisplayPixel);
 		if (result.w > 0 && result.h > 0) {
 			vrperfkit::AdjustRenderResolution(result.w, result.h);
 		}
@@ -95,13 +95,13 @@ namespace {
 			ovrOldLayerEyeFovDepth eyeLayer;
 			std::vector<const ovrOldLayerHeader*> modifiedLayers;
 			HandleOldFrameSubmission(session, (ovrOldLayerHeader const * const *)layerPtrList, layerCount, modifiedLayers, eyeLayer);
-			return vrperfkit::hooks::CallOriginal(ovrHook_EndFrame)(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
+			return vrperfkit::hooks::Original<ovrHook_EndFrame>()(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
 		}
 		else {
 			ovrLayerEyeFovDepth eyeLayer;
 			std::vector<const ovrLayerHeader*> modifiedLayers;
 			HandleFrameSubmission(session, (ovrLayerHeader const * const *)layerPtrList, layerCount, modifiedLayers, eyeLayer);
-			return vrperfkit::hooks::CallOriginal(ovrHook_EndFrame)(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
+			return vrperfkit::hooks::Original<ovrHook_EndFrame>()(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
 		}
 	}
 
@@ -110,13 +110,13 @@ namespace {
 			ovrOldLayerEyeFovDepth eyeLayer;
 			std::vector<const ovrOldLayerHeader*> modifiedLayers;
 			HandleOldFrameSubmission(session, (ovrOldLayerHeader const * const *)layerPtrList, layerCount, modifiedLayers, eyeLayer);
-			return vrperfkit::hooks::CallOriginal(ovrHook_SubmitFrame2)(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
+			return vrperfkit::hooks::Original<ovrHook_SubmitFrame2>()(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
 		}
 		else {
 			ovrLayerEyeFovDepth eyeLayer;
 			std::vector<const ovrLayerHeader*> modifiedLayers;
 			HandleFrameSubmission(session, (ovrLayerHeader const * const *)layerPtrList, layerCount, modifiedLayers, eyeLayer);
-			return vrperfkit::hooks::CallOriginal(ovrHook_SubmitFrame2)(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
+			return vrperfkit::hooks::Original<ovrHook_SubmitFrame2>()(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
 		}
 	}
 
@@ -125,20 +125,20 @@ namespace {
 			ovrOldLayerEyeFovDepth eyeLayer;
 			std::vector<const ovrOldLayerHeader*> modifiedLayers;
 			HandleOldFrameSubmission(session, (ovrOldLayerHeader const * const *)layerPtrList, layerCount, modifiedLayers, eyeLayer);
-			return vrperfkit::hooks::CallOriginal(ovrHook_SubmitFrame)(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
+			return vrperfkit::hooks::Original<ovrHook_SubmitFrame>()(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
 		}
 		else {
 			ovrLayerEyeFovDepth eyeLayer;
 			std::vector<const ovrLayerHeader*> modifiedLayers;
 			HandleFrameSubmission(session, (ovrLayerHeader const * const *)layerPtrList, layerCount, modifiedLayers, eyeLayer);
-			return vrperfkit::hooks::CallOriginal(ovrHook_SubmitFrame)(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
+			return vrperfkit::hooks::Original<ovrHook_SubmitFrame>()(session, frameIndex, viewScaleDesc, (const void**)modifiedLayers.data(), layerCount);
 		}
 	}
 
 	ovrResult ovrHook_Initialize(const ovrInitParams* params) {
 		g_oculusVersion = params->RequestedMinorVersion;
 		LOG_INFO << "Oculus runtime initialization for version " << g_oculusVersion;
-		return vrperfkit::hooks::CallOriginal(ovrHook_Initialize)(params);
+		return vrperfkit::hooks::Original<ovrHook_Initialize>()(params);
 	}
 }
 
@@ -160,11 +160,11 @@ namespace vrperfkit {
 			}
 
 			LOG_INFO << dllName << " is loaded in the process, installing hooks...";
-			hooks::InstallHookInDll("ovr_Initialize", handle, (void*)ovrHook_Initialize);
-			hooks::InstallHookInDll("ovr_GetFovTextureSize", handle, (void*)ovrHook_GetFovTextureSize);
-			hooks::InstallHookInDll("ovr_EndFrame", handle, (void*)ovrHook_EndFrame);
-			hooks::InstallHookInDll("ovr_SubmitFrame", handle, (void*)ovrHook_SubmitFrame);
-			hooks::InstallHookInDll("ovr_SubmitFrame2", handle, (void*)ovrHook_SubmitFrame2);
+			hooks::InstallHookInDll<ovrHook_Initialize>("ovr_Initialize", handle);
+			hooks::InstallHookInDll<ovrHook_GetFovTextureSize>("ovr_GetFovTextureSize", handle);
+			hooks::InstallHookInDll<ovrHook_EndFrame>("ovr_EndFrame", handle);
+			hooks::InstallHookInDll<ovrHook_SubmitFrame>("ovr_SubmitFrame", handle);
+			hooks::InstallHookInDll<ovrHook_SubmitFrame2>("ovr_SubmitFrame2", handle);
 
 			g_oculusDll = handle;
 			break;
@@ -211,3 +211,25 @@ OVR_PUBLIC_FUNCTION(ovrResult) ovr_CommitTextureSwapChain(ovrSession session, ov
 	IMPL_ORIG(g_oculusDll, ovr_CommitTextureSwapChain);
 	return orig_ovr_CommitTextureSwapChain(session, chain);
 }
+
+// ovr_GetRenderDesc is a macro for this one
+OVR_PUBLIC_FUNCTION(ovrEyeRenderDesc) ovr_GetRenderDesc2(ovrSession session, ovrEyeType eyeType, ovrFovPort fov) {
+	IMPL_ORIG(g_oculusDll, ovr_GetRenderDesc2);
+	if (orig_ovr_GetRenderDesc2 == nullptr) {
+		ovrEyeRenderDesc desc = {};
+		desc.Eye = eyeType;
+		desc.Fov = fov;
+		desc.HmdToEyePose.Orientation.w = 1;
+		return desc;
+	}
+	return orig_ovr_GetRenderDesc2(session, eyeType, fov);
+}
+
+// older runtimes do not export it
+OVR_PUBLIC_FUNCTION(ovrResult) ovr_GetFovStencil(ovrSession session, const ovrFovStencilDesc* fovStencilDesc, ovrFovStencilMeshBuffer* meshBuffer) {
+	IMPL_ORIG(g_oculusDll, ovr_GetFovStencil);
+	if (orig_ovr_GetFovStencil == nullptr) {
+		return ovrError_Unsupported;
+	}
+	return orig_ovr_GetFovStencil(session, fovStencilDesc, meshBuffer);
+}
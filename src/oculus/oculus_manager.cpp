@@ -1,8 +1,10 @@
 #include "oculus_manager.h"
 
+#include "config.h"
 #include "hotkeys.h"
 #include "logging.h"
 #include "resolution_scaling.h"
+#include "visible_bounds.h"
 #include "d3d11/d3d11_helper.h"
 #include "d3d11/d3d11_injector.h"
 #include "d3d11/d3d11_post_processor.h"
@@ -47,6 +49,57 @@ namespace vrperfkit {
 			}
 		}
 
+		// triangle list of the hidden area stencil of an eye, in eye texture coordinates
+		std::vector<Point<float>> GetHiddenAreaMesh(ovrSession session, ovrEyeType eye, const ovrFovPort &fov, bool originAtBottomLeft) {
+			ovrEyeRenderDesc renderDesc = ovr_GetRenderDesc(session, eye, fov);
+			ovrFovStencilDesc desc;
+			desc.StencilType = ovrFovStencil_HiddenArea;
+			desc.StencilFlags = originAtBottomLeft ? ovrFovStencilFlag_MeshOriginAtBottomLeft : 0;
+			desc.Eye = eye;
+			desc.FovPort = fov;
+			desc.HmdToEyeRotation = renderDesc.HmdToEyePose.Orientation;
+
+			// Without a mesh the radial mask is used, so a runtime that can't provide one is not an error
+			// that should end post-processing.
+			auto failed = [](ovrResult result) {
+				if (OVR_SUCCESS(result)) {
+					return false;
+				}
+				static bool logged = false;
+				if (!logged) {
+					ovrErrorInfo info;
+					ovr_GetLastErrorInfo(&info);
+					LOG_INFO << "Runtime provides no hidden area mesh, using the radial mask: " << info.ErrorString << " (" << result << ")";
+					logged = true;
+				}
+				return true;
+			};
+
+			// the first call only counts the vertices and indices
+			ovrFovStencilMeshBuffer buffer = {};
+			if (failed(ovr_GetFovStencil(session, &desc, &buffer))) {
+				return {};
+			}
+			std::vector<ovrVector2f> vertices (buffer.UsedVertexCount);
+			std::vector<uint16_t> indices (buffer.UsedIndexCount);
+			buffer.AllocVertexCount = vertices.size();
+			buffer.VertexBuffer = vertices.data();
+			buffer.AllocIndexCount = indices.size();
+			buffer.IndexBuffer = indices.data();
+			if (failed(ovr_GetFovStencil(session, &desc, &buffer))) {
+				return {};
+			}
+
+			std::vector<Point<float>> triangles;
+			triangles.reserve(indices.size());
+			for (uint16_t index : indices) {
+				if (index < vertices.size()) {
+					triangles.push_back(Point<float>{ vertices[index].x, vertices[index].y });
+				}
+			}
+			return triangles;
+		}
+
 		bool ShouldCreateTypelessSwapchain(ovrTextureFormat format) {
 			switch (format) {
 			case OVR_FORMAT_B8G8R8A8_UNORM_SRGB:
@@ -78,6 +131,7 @@ namespace vrperfkit {
 		std::vector<ComPtr<ID3D11UnorderedAccessView>> outputUavs[2];
 		bool multisampled[2];
 		bool usingArrayTex;
+		bool hiddenAreaMeshesPassed = false;
 	};
 
 	void OculusManager::Init(ovrSession session, ovrTextureSwapChain leftEyeChain, ovrTextureSwapChain rightEyeChain) {
@@ -280,6 +334,17 @@ namespace vrperfkit {
 		bool successfulPostprocessing = false;
 		bool isFlippedY = eyeLayer.Header.Flags & ovrLayerFlag_TextureOriginAtBottomLeft;
 
+		bool needHiddenAreaMeshes = (g_config.hiddenMask.enabled && g_config.hiddenMask.mode != HiddenMaskMode::RADIAL) || g_config.upscaling.cropToVisible;
+		if (!d3d11Res->hiddenAreaMeshesPassed && needHiddenAreaMeshes) {
+			// the mask is drawn into the game's depth buffer, which has the layout of its color textures
+			for (int eye = 0; eye < 2; ++eye) {
+				std::vector<Point<float>> triangles = GetHiddenAreaMesh(session, (ovrEyeType)eye, eyeLayer.Fov[eye], isFlippedY);
+				LOG_INFO << "Hidden area mesh for eye " << eye << ": " << triangles.size() / 3 << " triangles";
+				d3d11Res->postProcessor->SetHiddenAreaMesh(eye, triangles);
+			}
+			d3d11Res->hiddenAreaMeshesPassed = true;
+		}
+
 		for (int eye = 0; eye < 2; ++eye) {
 			int index;
 			ovrTextureSwapChain curSwapChain = submittedEyeChains[eye] != nullptr ? submittedEyeChains[eye] : submittedEyeChains[0];
@@ -331,13 +396,23 @@ namespace vrperfkit {
 				input.mode = TextureMode::SINGLE;
 			}
 
-			Viewport outputViewport;
-			if (d3d11Res->postProcessor->Apply(input, outputViewport)) {
+			Viewport outputViewport, visibleViewport;
+			if (d3d11Res->postProcessor->Apply(input, outputViewport, &visibleViewport)) {
 				eyeLayer.ColorTexture[eye] = outputEyeChains[eye];
-				eyeLayer.Viewport[eye].Pos.x = outputViewport.x;
-				eyeLayer.Viewport[eye].Pos.y = outputViewport.y;
-				eyeLayer.Viewport[eye].Size.w = outputViewport.width;
-				eyeLayer.Viewport[eye].Size.h = outputViewport.height;
+				if (visibleViewport != outputViewport) {
+					// the compositor takes the field of view of the submitted viewport, so the cropped
+					// part of the eye is shown where it was rendered
+					const ovrFovPort &fov = eyeLayer.Fov[eye];
+					FovTangents cropped = CropFovTangents(FovTangents{ fov.LeftTan, fov.RightTan, fov.UpTan, fov.DownTan }, outputViewport, visibleViewport, isFlippedY);
+					eyeLayer.Fov[eye].LeftTan = cropped.left;
+					eyeLayer.Fov[eye].RightTan = cropped.right;
+					eyeLayer.Fov[eye].UpTan = cropped.up;
+					eyeLayer.Fov[eye].DownTan = cropped.down;
+				}
+				eyeLayer.Viewport[eye].Pos.x = visibleViewport.x;
+				eyeLayer.Viewport[eye].Pos.y = visibleViewport.y;
+				eyeLayer.Viewport[eye].Size.w = visibleViewport.width;
+				eyeLayer.Viewport[eye].Size.h = visibleViewport.height;
 				successfulPostprocessing = true;
 			}
 
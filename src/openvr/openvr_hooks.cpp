@@ -15,7 +15,7 @@ namespace vrperfkit {
 		int g_systemVersion = 0;
 
 		void IVRSystemHook_GetRecommendedRenderTargetSize(vr::IVRSystem *self, uint32_t *pnWidth, uint32_t *pnHeight) {
-			hooks::CallOriginal(IVRSystemHook_GetRecommendedRenderTargetSize)(self, pnWidth, pnHeight);
+			hooks::Original<IVRSystemHook_GetRecommendedRenderTargetSize>()(self, pnWidth, pnHeight);
 
 			if (pnWidth == nullptr || pnHeight == nullptr) {
 				return;
@@ -28,7 +28,7 @@ namespace vrperfkit {
 			OpenVrSubmitInfo info { eEye, pTexture, pBounds, nSubmitFlags };
 			g_openVr.OnSubmit(info);
 			g_openVr.PreCompositorWorkCall(true);
-			auto error = hooks::CallOriginal(IVRCompositor009Hook_Submit)(self, info.eye, info.texture, info.bounds, info.submitFlags);
+			auto error = hooks::Original<IVRCompositor009Hook_Submit>()(self, info.eye, info.texture, info.bounds, info.submitFlags);
 			if (error != vr::VRCompositorError_None) {
 				LOG_DEBUG << "OpenVR submit failed: " << error;
 			}
@@ -41,7 +41,7 @@ namespace vrperfkit {
 			OpenVrSubmitInfo info { eEye, &texInfo, pBounds, nSubmitFlags };
 			g_openVr.OnSubmit(info);
 			g_openVr.PreCompositorWorkCall(true);
-			auto error = hooks::CallOriginal(IVRCompositor008Hook_Submit)(self, info.eye, info.texture->eType, info.texture->handle, info.bounds, info.submitFlags);
+			auto error = hooks::Original<IVRCompositor008Hook_Submit>()(self, info.eye, info.texture->eType, info.texture->handle, info.bounds, info.submitFlags);
 			g_openVr.PostCompositorWorkCall(true);
 			return error;
 		}
@@ -51,7 +51,7 @@ namespace vrperfkit {
 			OpenVrSubmitInfo info { eEye, &texInfo, pBounds, vr::Submit_Default };
 			g_openVr.OnSubmit(info);
 			g_openVr.PreCompositorWorkCall(true);
-			auto error = hooks::CallOriginal(IVRCompositor007Hook_Submit)(self, info.eye, info.texture->eType, info.texture->handle, info.bounds);
+			auto error = hooks::Original<IVRCompositor007Hook_Submit>()(self, info.eye, info.texture->eType, info.texture->handle, info.bounds);
 			g_openVr.PostCompositorWorkCall(true);
 			return error;
 		}
@@ -59,7 +59,7 @@ namespace vrperfkit {
 		vr::EVRCompositorError IVRCompositorHook_WaitGetPoses(vr::IVRCompositor *self, vr::TrackedDevicePose_t *pRenderPoseArray, uint32_t unRenderPoseArrayCount,
 				vr::TrackedDevicePose_t *pGamePoseArray, uint32_t unGamePoseArrayCount) {
 			g_openVr.PreWaitGetPoses();
-			auto error = hooks::CallOriginal(IVRCompositorHook_WaitGetPoses)(self, pRenderPoseArray, unRenderPoseArrayCount, pGamePoseArray, unGamePoseArrayCount);
+			auto error = hooks::Original<IVRCompositorHook_WaitGetPoses>()(self, pRenderPoseArray, unRenderPoseArrayCount, pGamePoseArray, unGamePoseArrayCount);
 			g_openVr.PostWaitGetPoses();
 			if (error != vr::VRCompositorError_None) {
 				LOG_DEBUG << "OpenVR WaitGetPoses failed: " << error;
@@ -69,33 +69,33 @@ namespace vrperfkit {
 
 		void IVRCompositorHook_PostPresentHandoff(vr::IVRCompositor *self) {
 			g_openVr.PreCompositorWorkCall();
-			hooks::CallOriginal(IVRCompositorHook_PostPresentHandoff)(self);
+			hooks::Original<IVRCompositorHook_PostPresentHandoff>()(self);
 			g_openVr.PostCompositorWorkCall();
 		}
 
 		void *Hook_VRClientCoreFactory(const char *pInterfaceName, int *pReturnCode) {
-			void *instance = hooks::CallOriginal(Hook_VRClientCoreFactory)(pInterfaceName, pReturnCode);
+			void *instance = hooks::Original<Hook_VRClientCoreFactory>()(pInterfaceName, pReturnCode);
 			HookOpenVrInterface(pInterfaceName, instance);
 			return instance;
 		}
 
 		void *IVRClientCoreHook_GetGenericInterface(void *self, const char *interfaceName, vr::EVRInitError *error) {
-			void *instance = hooks::CallOriginal(IVRClientCoreHook_GetGenericInterface)(self, interfaceName, error);
+			void *instance = hooks::Original<IVRClientCoreHook_GetGenericInterface>()(self, interfaceName, error);
 			HookOpenVrInterface(interfaceName, instance);
 			return instance;
 		}
 
 		void IVRClientCoreHook_Cleanup(void *self) {
-			hooks::CallOriginal(IVRClientCoreHook_Cleanup)(self);
+			hooks::Original<IVRClientCoreHook_Cleanup>()(self);
 			LOG_INFO << "IVRClientCore::Cleanup was called, deleting hooks...";
-			hooks::RemoveHook((void*)&IVRClientCoreHook_GetGenericInterface);
-			hooks::RemoveHook((void*)&IVRClientCoreHook_Cleanup);
-			hooks::RemoveHook((void*)IVRCompositor009Hook_Submit);
-			hooks::RemoveHook((void*)IVRCompositor008Hook_Submit);
-			hooks::RemoveHook((void*)IVRCompositor007Hook_Submit);
-			hooks::RemoveHook((void*)IVRSystemHook_GetRecommendedRenderTargetSize);
-			hooks::RemoveHook((void*)IVRCompositorHook_WaitGetPoses);
-			hooks::RemoveHook((void*)IVRCompositorHook_PostPresentHandoff);
+			hooks::RemoveHook<IVRClientCoreHook_GetGenericInterface>();
+			hooks::RemoveHook<IVRClientCoreHook_Cleanup>();
+			hooks::RemoveHook<IVRCompositor009Hook_Submit>();
+			hooks::RemoveHook<IVRCompositor008Hook_Submit>();
+			hooks::RemoveHook<IVRCompositor007Hook_Submit>();
+			hooks::RemoveHook<IVRSystemHook_GetRecommendedRenderTargetSize>();
+			hooks::RemoveHook<IVRCompositorHook_WaitGetPoses>();
+			hooks::RemoveHook<IVRCompositorHook_PostPresentHandoff>();
 			g_compositorVersion = 0;
 			g_systemVersion = 0;
 		}
@@ -118,7 +118,7 @@ namespace vrperfkit {
 		}
 
 		LOG_INFO << dllName << " is loaded in the process, installing hooks...";
-		hooks::InstallHookInDll("VRClientCoreFactory", handle, (void*)Hook_VRClientCoreFactory);
+		hooks::InstallHookInDll<Hook_VRClientCoreFactory>("VRClientCoreFactory", handle);
 
 		hooksLoaded = true;
 	}
@@ -130,11 +130,11 @@ namespace vrperfkit {
 		}
 
 		if (unsigned int version = 0; std::sscanf(interfaceName, "IVRClientCore_%u", &version)) {
-			hooks::RemoveHook((void*)&IVRClientCoreHook_Cleanup);
-			hooks::RemoveHook((void*)&IVRClientCoreHook_GetGenericInterface);
+			hooks::RemoveHook<IVRClientCoreHook_Cleanup>();
+			hooks::RemoveHook<IVRClientCoreHook_GetGenericInterface>();
 			if (version <= 3) {
-				hooks::InstallVirtualFunctionHook("IVRClientCore::GetGenericInterface", instance, 3, (void*)&IVRClientCoreHook_GetGenericInterface);
-				hooks::InstallVirtualFunctionHook("IVRClientCore::Cleanup", instance, 1, (void*)&IVRClientCoreHook_Cleanup);
+				hooks::InstallVirtualFunctionHook<IVRClientCoreHook_GetGenericInterface>("IVRClientCore::GetGenericInterface", instance, 3);
+				hooks::InstallVirtualFunctionHook<IVRClientCoreHook_Cleanup>("IVRClientCore::Cleanup", instance, 1);
 				g_clientCoreInstance = instance;
 			}
 			else {
@@ -145,19 +145,19 @@ namespace vrperfkit {
 		if (g_compositorVersion == 0 && std::sscanf(interfaceName, "IVRCompositor_%u", &g_compositorVersion)) {
 			// FIXME: investigate older versions
 			if (g_compositorVersion >= 15) {
-				hooks::InstallVirtualFunctionHook("IVRCompositor::WaitGetPoses", instance, 2, (void*)&IVRCompositorHook_WaitGetPoses);
-				hooks::InstallVirtualFunctionHook("IVRCompositor::PostPresentHandoff", instance, 7, (void*)&IVRCompositorHook_PostPresentHandoff);
+				hooks::InstallVirtualFunctionHook<IVRCompositorHook_WaitGetPoses>("IVRCompositor::WaitGetPoses", instance, 2);
+				hooks::InstallVirtualFunctionHook<IVRCompositorHook_PostPresentHandoff>("IVRCompositor::PostPresentHandoff", instance, 7);
 			}
 
 			if (g_compositorVersion >= 9) {
 				uint32_t methodPos = g_compositorVersion >= 12 ? 5 : 4;
-				hooks::InstallVirtualFunctionHook("IVRCompositor::Submit", instance, methodPos, (void*)&IVRCompositor009Hook_Submit);
+				hooks::InstallVirtualFunctionHook<IVRCompositor009Hook_Submit>("IVRCompositor::Submit", instance, methodPos);
 			}
 			else if (g_compositorVersion == 8) {
-				hooks::InstallVirtualFunctionHook("IVRCompositor::Submit", instance, 6, (void*)&IVRCompositor008Hook_Submit);
+				hooks::InstallVirtualFunctionHook<IVRCompositor008Hook_Submit>("IVRCompositor::Submit", instance, 6);
 			}
 			else if (g_compositorVersion == 7) {
-				hooks::InstallVirtualFunctionHook("IVRCompositor::Submit", instance, 6, (void*)&IVRCompositor007Hook_Submit);
+				hooks::InstallVirtualFunctionHook<IVRCompositor007Hook_Submit>("IVRCompositor::Submit", instance, 6);
 			}
 			else {
 				LOG_ERROR << "Don't know how to inject into version " << g_compositorVersion << " of IVRCompositor";
@@ -166,7 +166,7 @@ namespace vrperfkit {
 
 		if (g_systemVersion == 0 && std::sscanf(interfaceName, "IVRSystem_%u", &g_systemVersion)) {
 			uint32_t methodPos = (g_systemVersion >= 9 ? 0 : 1);
-			hooks::InstallVirtualFunctionHook("IVRSystem::GetRecommendedRenderTargetSize", instance, methodPos, (void*)&IVRSystemHook_GetRecommendedRenderTargetSize);
+			hooks::InstallVirtualFunctionHook<IVRSystemHook_GetRecommendedRenderTargetSize>("IVRSystem::GetRecommendedRenderTargetSize", instance, methodPos);
 		}
 	}
 
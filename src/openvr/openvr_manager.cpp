@@ -11,8 +11,6 @@
 
 #include "dxgi/dxgi_interfaces.h"
 
-#include <unordered_map>
-
 namespace vrperfkit {
 	OpenVrManager g_openVr;
 
@@ -71,7 +69,8 @@ namespace vrperfkit {
 		struct EyeViews {
 			ComPtr<ID3D11ShaderResourceView> view[2];
 		};
-		std::unordered_map<ID3D11Texture2D*, EyeViews> inputViews;
+		// the textures of the game's swap chains, and those it recreates on resolution changes
+		D3D11ViewCache<EyeViews> inputViews { 8 };
 
 		ID3D11ShaderResourceView *GetInputView(ID3D11Texture2D *inputTexture, int eye) {
 			D3D11_TEXTURE2D_DESC td;
@@ -91,9 +90,10 @@ namespace vrperfkit {
 				return resolveView.Get();
 			}
 
-			if (inputViews.find(inputTexture) == inputViews.end()) {
+			EyeViews *cached = inputViews.Find(inputTexture);
+			if (cached == nullptr) {
 				LOG_INFO << "Creating shader resource view for input texture " << inputTexture;
-				EyeViews &views = inputViews[inputTexture];
+				EyeViews views;
 				views.view[0] = CreateShaderResourceView(device.Get(), inputTexture);
 				if (td.ArraySize > 1) {
 					views.view[1] = CreateShaderResourceView(device.Get(), inputTexture, 1);
@@ -101,9 +101,10 @@ namespace vrperfkit {
 				else {
 					views.view[1] = views.view[0];
 				}
+				cached = &inputViews.Insert(inputTexture, std::move(views));
 			}
 
-			return inputViews[inputTexture].view[eye].Get();
+			return cached->view[eye].Get();
 		}
 	};
 
@@ -298,11 +299,19 @@ namespace vrperfkit {
 		d3d11Res->outputTexture = CreatePostProcessTexture(d3d11Res->device.Get(), outputWidth, outputHeight, DetermineOutputFormat(td.Format));
 		d3d11Res->outputView = CreateShaderResourceView(d3d11Res->device.Get(), d3d11Res->outputTexture.Get());
 		d3d11Res->outputUav = CreateUnorderedAccessView(d3d11Res->device.Get(), d3d11Res->outputTexture.Get());
+		if (g_config.upscaling.cropToVisible) {
+			// the bounds stay those of the whole eye, the parts the crop skips must be black
+			const FLOAT black[4] = { 0, 0, 0, 0 };
+			d3d11Res->context->ClearUnorderedAccessViewFloat(d3d11Res->outputUav.Get(), black);
+		}
 
 		CalculateProjectionCenters();
 		CalculateEyeTextureAspectRatio();
 
 		d3d11Res->postProcessor.get()->SetProjCenters(projCenters.eyeCenter[0].x, projCenters.eyeCenter[0].y, projCenters.eyeCenter[1].x, projCenters.eyeCenter[1].y);
+		if ((g_config.hiddenMask.enabled && g_config.hiddenMask.mode != HiddenMaskMode::RADIAL) || g_config.upscaling.cropToVisible) {
+			PassHiddenAreaMeshes();
+		}
 
 		initialized = true;
 	}
@@ -376,6 +385,31 @@ namespace vrperfkit {
 		aspectRatio = float(width) / height;
 	}
 
+	void OpenVrManager::PassHiddenAreaMeshes() {
+		IVRSystem *vrSystem = GetOpenVrSystem();
+		if (vrSystem == nullptr) {
+			LOG_ERROR << "Failed to acquire VRSystem interface, can't get the hidden area meshes";
+			return;
+		}
+
+		for (int eye = 0; eye < 2; ++eye) {
+			// the vertices are eye texture coordinates with the origin at the top left
+			HiddenAreaMesh_t mesh = vrSystem->GetHiddenAreaMesh((EVREye)eye, k_eHiddenAreaMesh_Standard);
+			std::vector<Point<float>> triangles;
+			if (mesh.pVertexData != nullptr) {
+				triangles.reserve(mesh.unTriangleCount * 3);
+				for (uint32_t i = 0; i < mesh.unTriangleCount * 3; ++i) {
+					triangles.push_back(Point<float>{ mesh.pVertexData[i].v[0], mesh.pVertexData[i].v[1] });
+				}
+			}
+			LOG_INFO << "Hidden area mesh for eye " << eye << ": " << mesh.unTriangleCount << " triangles";
+			if (triangles.empty()) {
+				LOG_INFO << "The runtime has no hidden area mesh, masking eye " << eye << " with the edge radius";
+			}
+			d3d11Res->postProcessor->SetHiddenAreaMesh(eye, triangles);
+		}
+	}
+
 	void OpenVrManager::PostProcessD3D11(OpenVrSubmitInfo &info) {
 		ID3D11Texture2D *inputTexture = reinterpret_cast<ID3D11Texture2D *>(info.texture->handle);
 		D3D11_TEXTURE2D_DESC itd, otd;
@@ -401,6 +435,8 @@ namespace vrperfkit {
 		input.outputUav = d3d11Res->outputUav.Get();
 		input.projectionCenter = projCenters.eyeCenter[info.eye];
 		input.mode = d3d11Res->usingArrayTex ? TextureMode::ARRAY : (isCombinedTex ? TextureMode::COMBINED : TextureMode::SINGLE);
+		input.flipX = isFlippedX;
+		input.flipY = isFlippedY;
 
 		if (isFlippedX) {
 			input.projectionCenter.x = 1.f - input.projectionCenter.x;
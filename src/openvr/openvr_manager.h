@@ -50,6 +50,7 @@ namespace vrperfkit {
 
 		void CalculateProjectionCenters();
 		void CalculateEyeTextureAspectRatio();
+		void PassHiddenAreaMeshes();
 
 		void PostProcessD3D11(OpenVrSubmitInfo &info);
 		void PatchDxvkSubmit(OpenVrSubmitInfo & info);
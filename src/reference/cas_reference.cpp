@@ -0,0 +1,318 @@
+#include "cas_reference.h"
+#include "lanczos_reference.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include "tile_grid.h"
+
+#include <cmath>
+#include <type_traits>
+
+#define A_CPU 1
+#include "cas/ffx_a.h"
+#include "cas/ffx_cas.h"
+
+namespace vrperfkit {
+	namespace reference {
+		namespace {
+			template<typename T>
+			struct Color3 {
+				T r, g, b;
+			};
+
+			// 3x3 texels around the output pixel in row order: a b c / d e f / g h i
+			template<typename T>
+			struct CasSharpenInput {
+				T r[9], g[9], b[9];
+			};
+
+			// 4x4 texels around the source position in row order: a b c d / e f g h / i j k l / m n o p,
+			// with f the texel at floor(pp), and the fractional part of pp
+			template<typename T>
+			struct CasUpscaleInput {
+				T r[16], g[16], b[16];
+				T fx, fy;
+			};
+
+			struct CasConstants {
+				AU1 const0[4];
+				AU1 const1[4];
+
+				CasConstants(float sharpness, const Viewport &inputViewport, const Viewport &outputViewport) {
+					CasSetup(const0, const1, sharpness, inputViewport.width, inputViewport.height, outputViewport.width, outputViewport.height);
+				}
+
+				float Scale(int i) const { return BitsToFloat(const0[i]); }
+				float Peak() const { return BitsToFloat(const1[0]); }
+			};
+
+			// soft minimum and maximum of the green channel for a cross of five texels plus four diagonals,
+			// both 2x bigger with the diagonals factored in
+			template<typename T>
+			void SoftMinMax(const T *g, const int cross[5], const int diagonal[4], T &mn, T &mx) {
+				mn = Min3(Min3(g[cross[0]], g[cross[1]], g[cross[2]]), g[cross[3]], g[cross[4]]);
+				T mn2 = Min3(Min3(mn, g[diagonal[0]], g[diagonal[1]]), g[diagonal[2]], g[diagonal[3]]);
+				mn = mn + mn2;
+				mx = Max3(Max3(g[cross[0]], g[cross[1]], g[cross[2]]), g[cross[3]], g[cross[4]]);
+				T mx2 = Max3(Max3(mx, g[diagonal[0]], g[diagonal[1]]), g[diagonal[2]], g[diagonal[3]]);
+				mx = mx + mx2;
+			}
+
+			// the filter weight from the soft minimum and maximum, only green is used (no CAS_SLOW)
+			template<bool GoSlower, typename T>
+			T Weight(T mn, T mx, T peak) {
+				T amp;
+				if constexpr (GoSlower) {
+					amp = Sqrt(Sat(Min(mn, T(2.f) - mx) * Rcp(mx)));
+				} else {
+					amp = PrxLoSqrt(Sat(Min(mn, T(2.f) - mx) * PrxLoRcp(mx)));
+				}
+				return amp * peak;
+			}
+
+			template<bool GoSlower, typename T>
+			Color3<T> CasSharpenFilter(const CasSharpenInput<T> &in, T peak) {
+				const int cross[5] = { 3, 4, 5, 1, 7 };
+				const int diagonal[4] = { 0, 2, 6, 8 };
+				T mn, mx;
+				SoftMinMax(in.g, cross, diagonal, mn, mx);
+				T w = Weight<GoSlower>(mn, mx, peak);
+				T base = T(1.f) + T(4.f) * w;
+				T rcpWeight;
+				if constexpr (GoSlower) {
+					rcpWeight = Rcp(base);
+				} else {
+					rcpWeight = PrxMedRcp(base);
+				}
+				auto filter = [&](const T *c) {
+					return Sat((c[1] * w + c[3] * w + c[5] * w + c[7] * w + c[4]) * rcpWeight);
+				};
+				return Color3<T>{ filter(in.r), filter(in.g), filter(in.b) };
+			}
+
+			template<bool GoSlower, typename T>
+			Color3<T> CasUpscaleFilter(const CasUpscaleInput<T> &in, T peak) {
+				enum { a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p };
+				// the four bilinear taps f, g, j and k, each with its own sharpening weight
+				const int crossF[5] = { b, e, f, g, j }, diagonalF[4] = { a, c, i, k };
+				const int crossG[5] = { c, f, g, h, k }, diagonalG[4] = { b, d, j, l };
+				const int crossJ[5] = { f, i, j, k, n }, diagonalJ[4] = { e, g, m, o };
+				const int crossK[5] = { g, j, k, l, o }, diagonalK[4] = { f, h, n, p };
+				T mnf, mxf, mng, mxg, mnj, mxj, mnk, mxk;
+				SoftMinMax(in.g, crossF, diagonalF, mnf, mxf);
+				SoftMinMax(in.g, crossG, diagonalG, mng, mxg);
+				SoftMinMax(in.g, crossJ, diagonalJ, mnj, mxj);
+				SoftMinMax(in.g, crossK, diagonalK, mnk, mxk);
+				T wf = Weight<GoSlower>(mnf, mxf, peak);
+				T wg = Weight<GoSlower>(mng, mxg, peak);
+				T wj = Weight<GoSlower>(mnj, mxj, peak);
+				T wk = Weight<GoSlower>(mnk, mxk, peak);
+
+				// bilinear weights, reduced where the local contrast is high
+				T s = (T(1.f) - in.fx) * (T(1.f) - in.fy);
+				T t = in.fx * (T(1.f) - in.fy);
+				T u = (T(1.f) - in.fx) * in.fy;
+				T v = in.fx * in.fy;
+				T thinB = T(1.f / 32.f);
+				if constexpr (GoSlower) {
+					s *= Rcp(thinB + (mxf - mnf));
+					t *= Rcp(thinB + (mxg - mng));
+					u *= Rcp(thinB + (mxj - mnj));
+					v *= Rcp(thinB + (mxk - mnk));
+				} else {
+					s *= PrxLoRcp(thinB + (mxf - mnf));
+					t *= PrxLoRcp(thinB + (mxg - mng));
+					u *= PrxLoRcp(thinB + (mxj - mnj));
+					v *= PrxLoRcp(thinB + (mxk - mnk));
+				}
+
+				T qbe = wf * s;
+				T qch = wg * t;
+				T qf = wg * t + wj * u + s;
+				T qg = wf * s + wk * v + t;
+				T qj = wf * s + wk * v + u;
+				T qk = wg * t + wj * u + v;
+				T qin = wj * u;
+				T qlo = wk * v;
+				T sum = T(2.f) * qbe + T(2.f) * qch + T(2.f) * qin + T(2.f) * qlo + qf + qg + qj + qk;
+				T rcpW;
+				if constexpr (GoSlower) {
+					rcpW = Rcp(sum);
+				} else {
+					rcpW = PrxMedRcp(sum);
+				}
+				auto filter = [&](const T *x) {
+					return Sat((x[b] * qbe + x[e] * qbe + x[c] * qch + x[h] * qch + x[i] * qin + x[n] * qin + x[l] * qlo + x[o] * qlo
+						+ x[f] * qf + x[g] * qg + x[j] * qj + x[k] * qk) * rcpW);
+				};
+				return Color3<T>{ filter(in.r), filter(in.g), filter(in.b) };
+			}
+
+			template<typename T>
+			void SetTexel(T *r, T *g, T *b, int index, int lane, const Rgba &c) {
+				SetLane(r[index], lane, c.r);
+				SetLane(g[index], lane, c.g);
+				SetLane(b[index], lane, c.b);
+			}
+
+			// CasLoad: Texture2D.Load relative to the input viewport, zero outside the texture
+			template<typename T>
+			void LoadSharpenInput(CasSharpenInput<T> &in, int lane, const Image &input, const Viewport &inputViewport, uint32_t x, uint32_t y) {
+				for (int i = 0; i < 9; ++i) {
+					SetTexel(in.r, in.g, in.b, i, lane, input.Load(inputViewport.x + x + i % 3 - 1, inputViewport.y + y + i / 3 - 1));
+				}
+			}
+
+			template<typename T>
+			void LoadUpscaleInput(CasUpscaleInput<T> &in, int lane, const Image &input, const Viewport &inputViewport, const CasConstants &con, uint32_t x, uint32_t y) {
+				float ppX = x * con.Scale(0) + con.Scale(2);
+				float ppY = y * con.Scale(1) + con.Scale(3);
+				float fpX = std::floor(ppX);
+				float fpY = std::floor(ppY);
+				SetLane(in.fx, lane, ppX - fpX);
+				SetLane(in.fy, lane, ppY - fpY);
+				int spX = (int)fpX + inputViewport.x;
+				int spY = (int)fpY + inputViewport.y;
+				for (int i = 0; i < 16; ++i) {
+					SetTexel(in.r, in.g, in.b, i, lane, input.Load(spX + i % 4 - 1, spY + i / 4 - 1));
+				}
+			}
+
+			template<typename T>
+			Rgba ToRgba(const Color3<T> &c) {
+				return Rgba{ float(c.r), float(c.g), float(c.b), 1.f };
+			}
+
+			template<typename V>
+			void StoreLanes(Image &output, uint32_t x, uint32_t y, const Color3<V> &c) {
+				float r[V::kLanes], g[V::kLanes], b[V::kLanes];
+				c.r.Store(r);
+				c.g.Store(g);
+				c.b.Store(b);
+				for (int lane = 0; lane < V::kLanes; ++lane) {
+					output.At(x + lane, y) = Rgba{ r[lane], g[lane], b[lane], 1.f };
+				}
+			}
+
+			struct ScalarLanes {
+				static constexpr int kLanes = 1;
+			};
+
+			// output pixels [x0, x1) of row y relative to the output viewport, in vectors of V as far as possible
+			template<typename V, typename T>
+			void SharpenRow(const Image &input, const Viewport &viewport, T peak, Image &output, uint32_t x0, uint32_t x1, uint32_t y) {
+				uint32_t x = x0;
+				if constexpr (V::kLanes > 1) {
+					for (; x + V::kLanes <= x1; x += V::kLanes) {
+						CasSharpenInput<V> in;
+						for (int lane = 0; lane < V::kLanes; ++lane) {
+							LoadSharpenInput(in, lane, input, viewport, x + lane, y);
+						}
+						StoreLanes(output, viewport.x + x, viewport.y + y, CasSharpenFilter<false>(in, V(float(peak))));
+					}
+				}
+				for (; x < x1; ++x) {
+					CasSharpenInput<T> in;
+					LoadSharpenInput(in, 0, input, viewport, x, y);
+					output.At(viewport.x + x, viewport.y + y) = ToRgba(CasSharpenFilter<std::is_same<T, Half>::value>(in, peak));
+				}
+			}
+
+			template<typename V, typename T>
+			void UpscaleRow(const Image &input, const Viewport &inputViewport, const CasConstants &con, T peak, Image &output, const Viewport &outputViewport, uint32_t x0, uint32_t x1, uint32_t y) {
+				uint32_t x = x0;
+				if constexpr (V::kLanes > 1) {
+					for (; x + V::kLanes <= x1; x += V::kLanes) {
+						CasUpscaleInput<V> in;
+						for (int lane = 0; lane < V::kLanes; ++lane) {
+							LoadUpscaleInput(in, lane, input, inputViewport, con, x + lane, y);
+						}
+						StoreLanes(output, outputViewport.x + x, outputViewport.y + y, CasUpscaleFilter<false>(in, V(float(peak))));
+					}
+				}
+				for (; x < x1; ++x) {
+					CasUpscaleInput<T> in;
+					LoadUpscaleInput(in, 0, input, inputViewport, con, x, y);
+					output.At(outputViewport.x + x, outputViewport.y + y) = ToRgba(CasUpscaleFilter<std::is_same<T, Half>::value>(in, peak));
+				}
+			}
+
+			// Bilinear from cas.compute.h for tiles outside the radius, Lanczos-2 with PERIPHERY_LANCZOS
+			void FallbackTile(const Image &input, const Viewport &inputViewport, const CasConstants &con, Image &output, const Viewport &outputViewport, const Viewport &tile, bool lanczos, bool debugMode) {
+				float tint = debugMode ? 0.6f : 1.f;
+				for (uint32_t y = tile.y; y < tile.y + tile.height; ++y) {
+					for (uint32_t x = tile.x; x < tile.x + tile.width; ++x) {
+						float posX = (x + 0.5f) * con.Scale(0) + inputViewport.x;
+						float posY = (y + 0.5f) * con.Scale(1) + inputViewport.y;
+						Rgba c = lanczos ? Lanczos2Sample(input, posX, posY) : input.SampleBilinear(posX / input.width, posY / input.height);
+						output.At(outputViewport.x + x, outputViewport.y + y) = Rgba{ c.r, c.g * tint, c.b * tint, 1.f };
+					}
+				}
+			}
+
+			template<typename T>
+			void Upscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport, float sharpness, const CasOptions &options) {
+				CasConstants con (sharpness, inputViewport, outputViewport);
+				T peak = T(con.Peak());
+				TileGrid grid (outputViewport, options.radiusTest, options.radius, options.projectionCenter);
+				GetThreadPool(options.threads).ParallelFor(grid.Count(), [&](uint32_t index) {
+					Viewport tile = grid.Tile(index);
+					if (!grid.InsideRadius(tile)) {
+						FallbackTile(input, inputViewport, con, output, outputViewport, tile, options.peripheryLanczos, options.debugMode);
+						return;
+					}
+					for (uint32_t y = tile.y; y < tile.y + tile.height; ++y) {
+						if (std::is_same<T, float>::value && options.simd) {
+							UpscaleRow<WidestVector>(input, inputViewport, con, peak, output, outputViewport, tile.x, tile.x + tile.width, y);
+						} else {
+							UpscaleRow<ScalarLanes>(input, inputViewport, con, peak, output, outputViewport, tile.x, tile.x + tile.width, y);
+						}
+					}
+				});
+			}
+
+			template<typename T>
+			void Sharpen(const Image &input, Image &output, const Viewport &viewport, float sharpness, const CasOptions &options) {
+				CasConstants con (sharpness, viewport, viewport);
+				T peak = T(con.Peak());
+				TileGrid grid (viewport, options.radiusTest, options.radius, options.projectionCenter);
+				GetThreadPool(options.threads).ParallelFor(grid.Count(), [&](uint32_t index) {
+					Viewport tile = grid.Tile(index);
+					if (!grid.InsideRadius(tile)) {
+						// the sharpen shader has no periphery filter permutation
+						FallbackTile(input, viewport, con, output, viewport, tile, false, options.debugMode);
+						return;
+					}
+					for (uint32_t y = tile.y; y < tile.y + tile.height; ++y) {
+						if (std::is_same<T, float>::value && options.simd) {
+							SharpenRow<WidestVector>(input, viewport, peak, output, tile.x, tile.x + tile.width, y);
+						} else {
+							SharpenRow<ScalarLanes>(input, viewport, peak, output, tile.x, tile.x + tile.width, y);
+						}
+					}
+				});
+			}
+		}
+
+		void CasUpscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport, float sharpness, const CasOptions &options) {
+			if (options.precision == Precision::FP16) {
+				Upscale<Half>(input, inputViewport, output, outputViewport, sharpness, options);
+			} else {
+				Upscale<float>(input, inputViewport, output, outputViewport, sharpness, options);
+			}
+		}
+
+		void CasSharpen(const Image &input, Image &output, const Viewport &viewport, float sharpness, const CasOptions &options) {
+			if (options.precision == Precision::FP16) {
+				Sharpen<Half>(input, output, viewport, sharpness, options);
+			} else {
+				Sharpen<float>(input, output, viewport, sharpness, options);
+			}
+		}
+
+		void CasSharpen(const Image &input, Image &output, const Viewport &viewport, float sharpness, Precision precision) {
+			CasOptions options;
+			options.precision = precision;
+			CasSharpen(input, output, viewport, sharpness, options);
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "half.h"
+#include "image.h"
+
+namespace vrperfkit {
+	namespace reference {
+		// CPU port of CasFilter from ffx_cas.h as run by D3D11CasUpscaler (with CAS_BETTER_DIAGONALS).
+		// The FP16 variant follows CasFilterH, which in HLSL always takes the CAS_GO_SLOWER path.
+
+		struct CasOptions {
+			Precision precision = Precision::FP32;
+			// emulates the RADIUS_TEST shader variants: 16x16 tiles with their centre outside the radius
+			// are sampled bilinearly (or with Lanczos-2 for peripheryLanczos when upscaling)
+			bool radiusTest = false;
+			// as upscaling.radius, relative to the output height
+			float radius = 0.95f;
+			// projection centre relative to the output viewport
+			Point<float> projectionCenter = {0.5f, 0.5f};
+			// tint the fallback area as with debugMode
+			bool debugMode = false;
+			bool peripheryLanczos = false;
+			// worker threads for the 16x16 tiles, 0 uses all hardware threads
+			uint32_t threads = 0;
+			// process several pixels per call with SSE2/AVX2, FP32 only
+			bool simd = true;
+		};
+
+		// upscale inputViewport of input into outputViewport of output, as cas.upscale.hlsl
+		void CasUpscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport, float sharpness, const CasOptions &options);
+
+		// sharpen the pixels within viewport, sharpness as configured in upscaling.sharpness
+		void CasSharpen(const Image &input, Image &output, const Viewport &viewport, float sharpness, const CasOptions &options);
+		void CasSharpen(const Image &input, Image &output, const Viewport &viewport, float sharpness, Precision precision = Precision::FP32);
+	}
+}
@@ -0,0 +1,363 @@
+#include "fsr_reference.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include "tile_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#define A_CPU 1
+#include "fsr/ffx_a.h"
+#include "fsr/ffx_fsr1.h"
+
+namespace vrperfkit {
+	namespace reference {
+		namespace {
+			template<typename T>
+			struct Color3 {
+				T r, g, b;
+			};
+
+			template<typename T>
+			Color3<T> ToColor(const Rgba &c) {
+				return Color3<T>{T(c.r), T(c.g), T(c.b)};
+			}
+
+			struct EasuConstants {
+				AU1 const0[4];
+				AU1 const1[4];
+				AU1 const2[4];
+				AU1 const3[4];
+			};
+
+			template<typename T>
+			void EasuSet(T &dirX, T &dirY, T &len, T w, T lA, T lB, T lC, T lD, T lE) {
+				T dc = lD - lC;
+				T cb = lC - lB;
+				T lenX = Max(Abs(dc), Abs(cb));
+				lenX = PrxLoRcp(lenX);
+				T dX = lD - lB;
+				dirX += dX * w;
+				lenX = Sat(Abs(dX) * lenX);
+				lenX *= lenX;
+				len += lenX * w;
+				T ec = lE - lC;
+				T ca = lC - lA;
+				T lenY = Max(Abs(ec), Abs(ca));
+				lenY = PrxLoRcp(lenY);
+				T dY = lE - lA;
+				dirY += dY * w;
+				lenY = Sat(Abs(dY) * lenY);
+				lenY *= lenY;
+				len += lenY * w;
+			}
+
+			template<typename T>
+			void EasuTap(Color3<T> &aC, T &aW, T offX, T offY, T dirX, T dirY, T len2X, T len2Y, T lob, T clp, const Color3<T> &c) {
+				T vX = offX * dirX + offY * dirY;
+				T vY = offX * (-dirY) + offY * dirX;
+				vX *= len2X;
+				vY *= len2Y;
+				T d2 = vX * vX + vY * vY;
+				d2 = Min(d2, clp);
+				T wB = T(2.f / 5.f) * d2 + T(-1.f);
+				T wA = lob * d2 + T(-1.f);
+				wB *= wB;
+				wA *= wA;
+				wB = T(25.f / 16.f) * wB + T(-(25.f / 16.f - 1.f));
+				T w = wB * wA;
+				aC.r += c.r * w;
+				aC.g += c.g * w;
+				aC.b += c.b * w;
+				aW += w;
+			}
+
+			template<typename T>
+			struct EasuInput {
+				T pX, pY;
+				// 12-tap kernel
+				//    b c
+				//  e f g h
+				//  i j k l
+				//    n o
+				Color3<T> b, c, e, f, g, h, i, j, k, l, n, o;
+			};
+
+			template<typename T>
+			Color3<T> EasuFilter(const EasuInput<T> &in) {
+				const T pX = in.pX, pY = in.pY;
+				auto luma = [](const Color3<T> &c) { return c.b * T(0.5f) + (c.r * T(0.5f) + c.g); };
+				T bL = luma(in.b), cL = luma(in.c), eL = luma(in.e), fL = luma(in.f), gL = luma(in.g), hL = luma(in.h);
+				T iL = luma(in.i), jL = luma(in.j), kL = luma(in.k), lL = luma(in.l), nL = luma(in.n), oL = luma(in.o);
+
+				T dirX = T(0.f), dirY = T(0.f), len = T(0.f);
+				T one = T(1.f);
+				EasuSet(dirX, dirY, len, (one - pX) * (one - pY), bL, eL, fL, gL, jL);
+				EasuSet(dirX, dirY, len, pX * (one - pY), cL, fL, gL, hL, kL);
+				EasuSet(dirX, dirY, len, (one - pX) * pY, fL, iL, jL, kL, nL);
+				EasuSet(dirX, dirY, len, pX * pY, gL, jL, kL, lL, oL);
+
+				T dirR = dirX * dirX + dirY * dirY;
+				auto zro = dirR < T(1.f / 32768.f);
+				dirR = PrxLoRsq(dirR);
+				dirR = Select(zro, one, dirR);
+				dirX = Select(zro, one, dirX);
+				dirX *= dirR;
+				dirY *= dirR;
+				len = len * T(0.5f);
+				len *= len;
+				T stretch = (dirX * dirX + dirY * dirY) * PrxLoRcp(Max(Abs(dirX), Abs(dirY)));
+				T len2X = one + (stretch - one) * len;
+				T len2Y = one + T(-0.5f) * len;
+				T lob = T(0.5f) + T((1.f / 4.f - 0.04f) - 0.5f) * len;
+				T clp = PrxLoRcp(lob);
+
+				const Color3<T> &f = in.f, &g = in.g, &j = in.j, &k = in.k;
+				Color3<T> min4 {Min(Min3(f.r, g.r, j.r), k.r), Min(Min3(f.g, g.g, j.g), k.g), Min(Min3(f.b, g.b, j.b), k.b)};
+				Color3<T> max4 {Max(Max3(f.r, g.r, j.r), k.r), Max(Max3(f.g, g.g, j.g), k.g), Max(Max3(f.b, g.b, j.b), k.b)};
+
+				Color3<T> aC {T(0.f), T(0.f), T(0.f)};
+				T aW = T(0.f);
+				EasuTap(aC, aW, T( 0.f) - pX, T(-1.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.b);
+				EasuTap(aC, aW, T( 1.f) - pX, T(-1.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.c);
+				EasuTap(aC, aW, T(-1.f) - pX, T( 1.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.i);
+				EasuTap(aC, aW, T( 0.f) - pX, T( 1.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.j);
+				EasuTap(aC, aW, T( 0.f) - pX, T( 0.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.f);
+				EasuTap(aC, aW, T(-1.f) - pX, T( 0.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.e);
+				EasuTap(aC, aW, T( 1.f) - pX, T( 1.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.k);
+				EasuTap(aC, aW, T( 2.f) - pX, T( 1.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.l);
+				EasuTap(aC, aW, T( 2.f) - pX, T( 0.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.h);
+				EasuTap(aC, aW, T( 1.f) - pX, T( 0.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.g);
+				EasuTap(aC, aW, T( 1.f) - pX, T( 2.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.o);
+				EasuTap(aC, aW, T( 0.f) - pX, T( 2.f) - pY, dirX, dirY, len2X, len2Y, lob, clp, in.n);
+
+				T rcpW = Rcp(aW);
+				return Color3<T>{
+					Min(max4.r, Max(min4.r, aC.r * rcpW)),
+					Min(max4.g, Max(min4.g, aC.g * rcpW)),
+					Min(max4.b, Max(min4.b, aC.b * rcpW)),
+				};
+			}
+
+			template<typename T>
+			EasuInput<T> LoadEasuInput(const Image &input, const EasuConstants &con, uint32_t x, uint32_t y) {
+				// position computation stays in FP32 for both variants, as in FsrEasuH
+				float ppX = float(x) * BitsToFloat(con.const0[0]) + BitsToFloat(con.const0[2]);
+				float ppY = float(y) * BitsToFloat(con.const0[1]) + BitsToFloat(con.const0[3]);
+				float fpX = std::floor(ppX);
+				float fpY = std::floor(ppY);
+				int fx = (int)fpX;
+				int fy = (int)fpY;
+
+				// fetched as the gathers with a clamping sampler would
+				EasuInput<T> in;
+				in.pX = T(ppX - fpX);
+				in.pY = T(ppY - fpY);
+				in.b = ToColor<T>(input.LoadClamped(fx, fy - 1));
+				in.c = ToColor<T>(input.LoadClamped(fx + 1, fy - 1));
+				in.e = ToColor<T>(input.LoadClamped(fx - 1, fy));
+				in.f = ToColor<T>(input.LoadClamped(fx, fy));
+				in.g = ToColor<T>(input.LoadClamped(fx + 1, fy));
+				in.h = ToColor<T>(input.LoadClamped(fx + 2, fy));
+				in.i = ToColor<T>(input.LoadClamped(fx - 1, fy + 1));
+				in.j = ToColor<T>(input.LoadClamped(fx, fy + 1));
+				in.k = ToColor<T>(input.LoadClamped(fx + 1, fy + 1));
+				in.l = ToColor<T>(input.LoadClamped(fx + 2, fy + 1));
+				in.n = ToColor<T>(input.LoadClamped(fx, fy + 2));
+				in.o = ToColor<T>(input.LoadClamped(fx + 1, fy + 2));
+				return in;
+			}
+
+			template<typename T>
+			struct RcasInput {
+				//    b
+				//  d e f
+				//    h
+				Color3<T> b, d, e, f, h;
+			};
+
+			template<typename T>
+			Color3<T> RcasFilter(const RcasInput<T> &in, T sharpness) {
+				const Color3<T> &b = in.b, &d = in.d, &e = in.e, &f = in.f, &h = in.h;
+				T mn4R = Min(Min3(b.r, d.r, f.r), h.r);
+				T mn4G = Min(Min3(b.g, d.g, f.g), h.g);
+				T mn4B = Min(Min3(b.b, d.b, f.b), h.b);
+				T mx4R = Max(Max3(b.r, d.r, f.r), h.r);
+				T mx4G = Max(Max3(b.g, d.g, f.g), h.g);
+				T mx4B = Max(Max3(b.b, d.b, f.b), h.b);
+
+				T peakX = T(1.f);
+				T peakY = T(-4.f);
+				T four = T(4.f);
+				T hitMinR = Min(mn4R, e.r) * Rcp(four * mx4R);
+				T hitMinG = Min(mn4G, e.g) * Rcp(four * mx4G);
+				T hitMinB = Min(mn4B, e.b) * Rcp(four * mx4B);
+				T hitMaxR = (peakX - Max(mx4R, e.r)) * Rcp(four * mn4R + peakY);
+				T hitMaxG = (peakX - Max(mx4G, e.g)) * Rcp(four * mn4G + peakY);
+				T hitMaxB = (peakX - Max(mx4B, e.b)) * Rcp(four * mn4B + peakY);
+				T lobeR = Max(-hitMinR, hitMaxR);
+				T lobeG = Max(-hitMinG, hitMaxG);
+				T lobeB = Max(-hitMinB, hitMaxB);
+				T lobe = Max(T(float(-FSR_RCAS_LIMIT)), Min(Max3(lobeR, lobeG, lobeB), T(0.f))) * sharpness;
+
+				T rcpL = PrxMedRcp(four * lobe + T(1.f));
+				return Color3<T>{
+					(lobe * b.r + lobe * d.r + lobe * h.r + lobe * f.r + e.r) * rcpL,
+					(lobe * b.g + lobe * d.g + lobe * h.g + lobe * f.g + e.g) * rcpL,
+					(lobe * b.b + lobe * d.b + lobe * h.b + lobe * f.b + e.b) * rcpL,
+				};
+			}
+
+			template<typename T>
+			RcasInput<T> LoadRcasInput(const Image &input, int x, int y) {
+				return RcasInput<T>{
+					ToColor<T>(input.Load(x, y - 1)),
+					ToColor<T>(input.Load(x - 1, y)),
+					ToColor<T>(input.Load(x, y)),
+					ToColor<T>(input.Load(x + 1, y)),
+					ToColor<T>(input.Load(x, y + 1)),
+				};
+			}
+
+			template<typename T>
+			Rgba ToRgba(const Color3<T> &c) {
+				return Rgba{float(c.r), float(c.g), float(c.b), 1.f};
+			}
+
+			template<typename V>
+			void StoreLanes(Image &output, uint32_t x, uint32_t y, const Color3<V> &c) {
+				float r[V::kLanes], g[V::kLanes], b[V::kLanes];
+				c.r.Store(r);
+				c.g.Store(g);
+				c.b.Store(b);
+				for (int lane = 0; lane < V::kLanes; ++lane) {
+					output.At(x + lane, y) = Rgba{r[lane], g[lane], b[lane], 1.f};
+				}
+			}
+
+			// processes the pixels [x0, x1) of row y, in vectors of V as far as possible
+			template<typename V>
+			void EasuRow(const Image &input, const EasuConstants &con, Image &output, const Viewport &outputViewport, uint32_t x0, uint32_t x1, uint32_t y) {
+				uint32_t x = x0;
+				if constexpr (V::kLanes > 1) {
+					for (; x + V::kLanes <= x1; x += V::kLanes) {
+						EasuInput<float> lanes[V::kLanes];
+						for (int lane = 0; lane < V::kLanes; ++lane) {
+							lanes[lane] = LoadEasuInput<float>(input, con, x + lane, y);
+						}
+						StoreLanes(output, x + outputViewport.x, y + outputViewport.y, EasuFilter(TransposeLanes<V>(lanes)));
+					}
+				}
+				for (; x < x1; ++x) {
+					output.At(x + outputViewport.x, y + outputViewport.y) = ToRgba(EasuFilter(LoadEasuInput<float>(input, con, x, y)));
+				}
+			}
+
+			template<typename V>
+			void RcasRow(const Image &input, float sharpness, Image &output, uint32_t x0, uint32_t x1, uint32_t y) {
+				uint32_t x = x0;
+				if constexpr (V::kLanes > 1) {
+					for (; x + V::kLanes <= x1; x += V::kLanes) {
+						RcasInput<float> lanes[V::kLanes];
+						for (int lane = 0; lane < V::kLanes; ++lane) {
+							lanes[lane] = LoadRcasInput<float>(input, x + lane, y);
+						}
+						StoreLanes(output, x, y, RcasFilter(TransposeLanes<V>(lanes), V(sharpness)));
+					}
+				}
+				for (; x < x1; ++x) {
+					output.At(x, y) = ToRgba(RcasFilter(LoadRcasInput<float>(input, x, y), sharpness));
+				}
+			}
+
+			template<typename T>
+			void Upscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport, const FsrOptions &options) {
+				EasuConstants con;
+				FsrEasuConOffset(con.const0, con.const1, con.const2, con.const3,
+					inputViewport.width, inputViewport.height, input.width, input.height,
+					outputViewport.width, outputViewport.height,
+					inputViewport.x, inputViewport.y);
+
+				TileGrid grid (outputViewport, options.radiusTest, options.radius, options.projectionCenter);
+				GetThreadPool(options.threads).ParallelFor(grid.Count(), [&](uint32_t index) {
+					Viewport tile = grid.Tile(index);
+					for (uint32_t y = tile.y; y < tile.y + tile.height; ++y) {
+						if (!grid.InsideRadius(tile)) {
+							// bilinear fallback as in fsr_easu.hlsl
+							for (uint32_t x = tile.x; x < tile.x + tile.width; ++x) {
+								float u = BitsToFloat(con.const1[0]) * (x * BitsToFloat(con.const0[0]) + BitsToFloat(con.const0[2]) + 0.5f);
+								float v = BitsToFloat(con.const1[1]) * (y * BitsToFloat(con.const0[1]) + BitsToFloat(con.const0[3]) + 0.5f);
+								Rgba c = input.SampleBilinear(u, v);
+								output.At(x + outputViewport.x, y + outputViewport.y) = Rgba{c.r, c.g, c.b, 1.f};
+							}
+						} else if (std::is_same<T, float>::value && options.simd && WidestVector::kLanes > 1) {
+							EasuRow<WidestVector>(input, con, output, outputViewport, tile.x, tile.x + tile.width, y);
+						} else {
+							for (uint32_t x = tile.x; x < tile.x + tile.width; ++x) {
+								output.At(x + outputViewport.x, y + outputViewport.y) = ToRgba(EasuFilter(LoadEasuInput<T>(input, con, x, y)));
+							}
+						}
+					}
+				});
+			}
+
+			template<typename T>
+			void Sharpen(const Image &input, Image &output, const Viewport &viewport, float sharpness, const FsrOptions &options) {
+				AU1 con[4];
+				FsrRcasCon(con, 2.f - 2 * sharpness);
+				float sharp = BitsToFloat(con[0]);
+
+				TileGrid grid (viewport, options.radiusTest, options.radius, options.projectionCenter);
+				GetThreadPool(options.threads).ParallelFor(grid.Count(), [&](uint32_t index) {
+					Viewport tile = grid.Tile(index);
+					for (uint32_t y = viewport.y + tile.y; y < viewport.y + tile.y + tile.height; ++y) {
+						uint32_t x0 = viewport.x + tile.x, x1 = x0 + tile.width;
+						if (!grid.InsideRadius(tile)) {
+							// copy as in fsr_rcas.hlsl, tinted in debug mode
+							float tint = options.debugMode ? 0.6f : 1.f;
+							for (uint32_t x = x0; x < x1; ++x) {
+								Rgba c = input.At(x, y);
+								output.At(x, y) = Rgba{c.r, c.g * tint, c.b * tint, c.a};
+							}
+						} else if (std::is_same<T, float>::value && options.simd && WidestVector::kLanes > 1) {
+							RcasRow<WidestVector>(input, sharp, output, x0, x1, y);
+						} else {
+							for (uint32_t x = x0; x < x1; ++x) {
+								output.At(x, y) = ToRgba(RcasFilter(LoadRcasInput<T>(input, x, y), T(sharp)));
+							}
+						}
+					}
+				});
+			}
+		}
+
+		void FsrUpscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport, const FsrOptions &options) {
+			if (options.precision == Precision::FP16) {
+				Upscale<Half>(input, inputViewport, output, outputViewport, options);
+			} else {
+				Upscale<float>(input, inputViewport, output, outputViewport, options);
+			}
+		}
+
+		void FsrUpscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport, Precision precision) {
+			FsrOptions options;
+			options.precision = precision;
+			FsrUpscale(input, inputViewport, output, outputViewport, options);
+		}
+
+		void FsrSharpen(const Image &input, Image &output, const Viewport &viewport, float sharpness, const FsrOptions &options) {
+			if (options.precision == Precision::FP16) {
+				Sharpen<Half>(input, output, viewport, sharpness, options);
+			} else {
+				Sharpen<float>(input, output, viewport, sharpness, options);
+			}
+		}
+
+		void FsrSharpen(const Image &input, Image &output, const Viewport &viewport, float sharpness, Precision precision) {
+			FsrOptions options;
+			options.precision = precision;
+			FsrSharpen(input, output, viewport, sharpness, options);
+		}
+	}
+}
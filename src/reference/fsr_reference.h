@@ -0,0 +1,35 @@
+#pragma once
+#include "half.h"
+#include "image.h"
+
+namespace vrperfkit {
+	namespace reference {
+		// CPU port of the FSR 1 EASU and RCAS passes as run by D3D11FsrUpscaler.
+		// Constants are produced by the same FsrEasuConOffset/FsrRcasCon functions the upscaler uses.
+
+		struct FsrOptions {
+			Precision precision = Precision::FP32;
+			// emulates the RADIUS_TEST shader variants: 16x16 tiles with their centre outside the radius
+			// are sampled bilinearly by EASU and copied unchanged by RCAS
+			bool radiusTest = false;
+			// as upscaling.radius, relative to the output height
+			float radius = 0.95f;
+			// projection centre relative to the output viewport
+			Point<float> projectionCenter = {0.5f, 0.5f};
+			// tint the RCAS fallback area as with debugMode
+			bool debugMode = false;
+			// worker threads for the 16x16 tiles, 0 uses all hardware threads
+			uint32_t threads = 0;
+			// process several pixels per call with SSE2/AVX2, FP32 only
+			bool simd = true;
+		};
+
+		// upscale inputViewport of input into outputViewport of output
+		void FsrUpscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport, const FsrOptions &options);
+		void FsrUpscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport, Precision precision = Precision::FP32);
+
+		// sharpen the pixels within viewport, sharpness as configured in upscaling.sharpness
+		void FsrSharpen(const Image &input, Image &output, const Viewport &viewport, float sharpness, const FsrOptions &options);
+		void FsrSharpen(const Image &input, Image &output, const Viewport &viewport, float sharpness, Precision precision = Precision::FP32);
+	}
+}
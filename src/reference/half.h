@@ -0,0 +1,133 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace vrperfkit {
+	namespace reference {
+		enum class Precision {
+			FP32,
+			FP16,
+		};
+
+		inline uint32_t FloatBits(float f) {
+			uint32_t u;
+			std::memcpy(&u, &f, sizeof(u));
+			return u;
+		}
+
+		inline float BitsToFloat(uint32_t u) {
+			float f;
+			std::memcpy(&f, &u, sizeof(f));
+			return f;
+		}
+
+		// IEEE 754 binary16 conversion with round-to-nearest-even, including denormals
+		inline uint16_t FloatToHalfBits(float f) {
+			uint32_t x = FloatBits(f);
+			uint32_t sign = (x >> 16) & 0x8000u;
+			uint32_t absx = x & 0x7fffffffu;
+			if (absx >= 0x7f800000u) {
+				// inf or nan
+				return sign | 0x7c00u | (absx > 0x7f800000u ? 0x200u : 0u);
+			}
+			if (absx >= 0x477ff000u) {
+				// overflows to inf after rounding
+				return sign | 0x7c00u;
+			}
+			if (absx < 0x38800000u) {
+				// result is a half denormal (or zero)
+				if (absx < 0x33000000u) {
+					return sign;
+				}
+				uint32_t exponent = absx >> 23;
+				uint32_t mantissa = (absx & 0x7fffffu) | 0x800000u;
+				uint32_t shift = 126 - exponent;
+				uint32_t result = mantissa >> shift;
+				uint32_t remainder = mantissa & ((1u << shift) - 1);
+				uint32_t halfway = 1u << (shift - 1);
+				if (remainder > halfway || (remainder == halfway && (result & 1))) {
+					++result;
+				}
+				return sign | result;
+			}
+			uint32_t result = ((absx - 0x38000000u) >> 13);
+			uint32_t remainder = absx & 0x1fffu;
+			if (remainder > 0x1000u || (remainder == 0x1000u && (result & 1))) {
+				++result;
+			}
+			return sign | result;
+		}
+
+		inline float HalfBitsToFloat(uint16_t h) {
+			uint32_t sign = (h & 0x8000u) << 16;
+			uint32_t exponent = (h >> 10) & 0x1fu;
+			uint32_t mantissa = h & 0x3ffu;
+			if (exponent == 0) {
+				// zero or denormal
+				float f = std::ldexp(static_cast<float>(mantissa), -24);
+				return sign ? -f : f;
+			}
+			if (exponent == 31) {
+				return BitsToFloat(sign | 0x7f800000u | (mantissa << 13));
+			}
+			return BitsToFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+		}
+
+		inline float RoundToHalf(float f) {
+			return HalfBitsToFloat(FloatToHalfBits(f));
+		}
+
+		// Emulates a 16-bit float register: every value and every arithmetic result is
+		// rounded to binary16. Intermediate results are computed in FP32 before rounding,
+		// which matches what hardware with native FP16 ALUs produces for single operations.
+		class Half {
+		public:
+			Half() = default;
+			Half(float f) : value(RoundToHalf(f)) {}
+
+			static Half FromBits(uint16_t bits) { Half h; h.value = HalfBitsToFloat(bits); return h; }
+			uint16_t Bits() const { return FloatToHalfBits(value); }
+
+			operator float() const { return value; }
+
+			Half operator-() const { Half h; h.value = -value; return h; }
+			Half& operator+=(Half o) { return *this = Half(value + o.value); }
+			Half& operator-=(Half o) { return *this = Half(value - o.value); }
+			Half& operator*=(Half o) { return *this = Half(value * o.value); }
+			Half& operator/=(Half o) { return *this = Half(value / o.value); }
+
+			friend Half operator+(Half a, Half b) { return Half(a.value + b.value); }
+			friend Half operator-(Half a, Half b) { return Half(a.value - b.value); }
+			friend Half operator*(Half a, Half b) { return Half(a.value * b.value); }
+			friend Half operator/(Half a, Half b) { return Half(a.value / b.value); }
+
+		private:
+			float value = 0;
+		};
+
+		// Scalar helpers shared by the reference kernels, so that a kernel templated on
+		// the scalar type can be evaluated both in FP32 and in emulated FP16.
+		template<typename T> T Min(T a, T b) { return float(a) < float(b) ? a : b; }
+		template<typename T> T Max(T a, T b) { return float(a) > float(b) ? a : b; }
+		template<typename T> T Min3(T a, T b, T c) { return Min(Min(a, b), c); }
+		template<typename T> T Max3(T a, T b, T c) { return Max(Max(a, b), c); }
+		template<typename T> T Abs(T a) { return float(a) < 0 ? -a : a; }
+		template<typename T> T Sat(T a) { return Min(Max(a, T(0.f)), T(1.f)); }
+		template<typename T> T Rcp(T a) { return T(1.f) / a; }
+		template<typename T> T Sqrt(T a) { return T(std::sqrt(float(a))); }
+		template<typename T> T Lerp(T a, T b, T t) { return a + (b - a) * t; }
+
+		// Bit-trick approximations from ffx_a.h (APrx*F1 / APrx*H1)
+		inline float PrxLoRcp(float a) { return BitsToFloat(0x7ef07ebbu - FloatBits(a)); }
+		inline float PrxMedRcp(float a) { float b = BitsToFloat(0x7ef19fffu - FloatBits(a)); return b * (-b * a + 2.f); }
+		inline float PrxLoRsq(float a) { return BitsToFloat(0x5f347d74u - (FloatBits(a) >> 1)); }
+		inline float PrxLoSqrt(float a) { return BitsToFloat((FloatBits(a) >> 1) + 0x1fbc4639u); }
+
+		inline Half PrxLoRcp(Half a) { return Half::FromBits(uint16_t(0x7784u - a.Bits())); }
+		inline Half PrxMedRcp(Half a) { Half b = Half::FromBits(uint16_t(0x778du - a.Bits())); return b * (-b * a + Half(2.f)); }
+		inline Half PrxLoRsq(Half a) { return Half::FromBits(uint16_t(0x59a3u - (a.Bits() >> 1))); }
+		inline Half PrxLoSqrt(Half a) { return Half::FromBits(uint16_t((a.Bits() >> 1) + 0x1de2u)); }
+	}
+}
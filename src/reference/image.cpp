@@ -0,0 +1,231 @@
+#include "image.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace vrperfkit {
+	namespace reference {
+		namespace {
+			void SkipWhitespaceAndComments(std::istream &in) {
+				while (true) {
+					int c = in.peek();
+					if (c == '#') {
+						std::string line;
+						std::getline(in, line);
+					} else if (std::isspace(c)) {
+						in.get();
+					} else {
+						return;
+					}
+				}
+			}
+
+			uint32_t ReadHeaderValue(std::istream &in) {
+				SkipWhitespaceAndComments(in);
+				uint32_t value = 0;
+				if (!(in >> value)) {
+					throw std::runtime_error("Malformed PPM header");
+				}
+				return value;
+			}
+
+			float Clamp01(float v) {
+				return v < 0 ? 0 : (v > 1 ? 1 : v);
+			}
+		}
+
+		Rgba Image::SampleBilinear(float u, float v) const {
+			float x = u * width - 0.5f;
+			float y = v * height - 0.5f;
+			float fx = std::floor(x);
+			float fy = std::floor(y);
+			float tx = x - fx;
+			float ty = y - fy;
+			int ix = (int)fx;
+			int iy = (int)fy;
+			Rgba c00 = LoadClamped(ix, iy);
+			Rgba c10 = LoadClamped(ix + 1, iy);
+			Rgba c01 = LoadClamped(ix, iy + 1);
+			Rgba c11 = LoadClamped(ix + 1, iy + 1);
+			auto lerp2 = [&](float a, float b, float c, float d) {
+				float top = a + (b - a) * tx;
+				float bottom = c + (d - c) * tx;
+				return top + (bottom - top) * ty;
+			};
+			return Rgba{
+				lerp2(c00.r, c10.r, c01.r, c11.r),
+				lerp2(c00.g, c10.g, c01.g, c11.g),
+				lerp2(c00.b, c10.b, c01.b, c11.b),
+				lerp2(c00.a, c10.a, c01.a, c11.a),
+			};
+		}
+
+		Image LoadPpm(const std::string &path) {
+			std::ifstream in (path, std::ios::binary);
+			if (!in) {
+				throw std::runtime_error("Could not open " + path);
+			}
+			char magic[2];
+			in.read(magic, 2);
+			if (!in || magic[0] != 'P' || magic[1] != '6') {
+				throw std::runtime_error(path + " is not a binary PPM (P6) file");
+			}
+			uint32_t width = ReadHeaderValue(in);
+			uint32_t height = ReadHeaderValue(in);
+			uint32_t maxValue = ReadHeaderValue(in);
+			if (width == 0 || height == 0 || maxValue == 0 || maxValue > 65535) {
+				throw std::runtime_error("Unsupported PPM dimensions or range in " + path);
+			}
+			in.get();
+
+			Image image (width, height);
+			bool wide = maxValue > 255;
+			std::vector<uint8_t> row (width * 3 * (wide ? 2 : 1));
+			for (uint32_t y = 0; y < height; ++y) {
+				in.read(reinterpret_cast<char*>(row.data()), row.size());
+				if (!in) {
+					throw std::runtime_error("Unexpected end of file in " + path);
+				}
+				for (uint32_t x = 0; x < width; ++x) {
+					float c[3];
+					for (int i = 0; i < 3; ++i) {
+						uint32_t v = wide ? (row[(x * 3 + i) * 2] << 8) | row[(x * 3 + i) * 2 + 1] : row[x * 3 + i];
+						c[i] = float(v) / maxValue;
+					}
+					image.At(x, y) = Rgba{c[0], c[1], c[2], 1};
+				}
+			}
+			return image;
+		}
+
+		void SavePpm(const Image &image, const std::string &path, uint32_t bitsPerChannel) {
+			std::ofstream out (path, std::ios::binary);
+			if (!out) {
+				throw std::runtime_error("Could not open " + path + " for writing");
+			}
+			bool wide = bitsPerChannel > 8;
+			uint32_t maxValue = wide ? 65535 : 255;
+			out << "P6\n" << image.width << " " << image.height << "\n" << maxValue << "\n";
+			std::vector<uint8_t> row (image.width * 3 * (wide ? 2 : 1));
+			for (uint32_t y = 0; y < image.height; ++y) {
+				for (uint32_t x = 0; x < image.width; ++x) {
+					const Rgba &c = image.At(x, y);
+					float channels[] = { c.r, c.g, c.b };
+					for (int i = 0; i < 3; ++i) {
+						long v = std::lround(Clamp01(channels[i]) * maxValue);
+						if (wide) {
+							// PPM stores 16-bit samples big-endian
+							row[(x * 3 + i) * 2 + 0] = (uint8_t)(v >> 8);
+							row[(x * 3 + i) * 2 + 1] = (uint8_t)(v & 0xff);
+						} else {
+							row[x * 3 + i] = (uint8_t)v;
+						}
+					}
+				}
+				out.write(reinterpret_cast<const char*>(row.data()), row.size());
+			}
+		}
+
+		TestPattern TestPatternFromString(const std::string &s) {
+			if (s == "gradient") return TestPattern::GRADIENT;
+			if (s == "checker") return TestPattern::CHECKER;
+			if (s == "zoneplate") return TestPattern::ZONE_PLATE;
+			if (s == "noise") return TestPattern::NOISE;
+			if (s == "edges") return TestPattern::EDGES;
+			throw std::runtime_error("Unknown test pattern " + s);
+		}
+
+		std::string TestPatternToString(TestPattern pattern) {
+			switch (pattern) {
+			case TestPattern::GRADIENT:
+				return "gradient";
+			case TestPattern::CHECKER:
+				return "checker";
+			case TestPattern::ZONE_PLATE:
+				return "zoneplate";
+			case TestPattern::NOISE:
+				return "noise";
+			case TestPattern::EDGES:
+				return "edges";
+			}
+			return "unknown";
+		}
+
+		Image Downscale(const Image &input, uint32_t width, uint32_t height) {
+			if (width == 0 || height == 0 || width > input.width || height > input.height) {
+				throw std::runtime_error("Downscale needs a smaller, non-empty target size");
+			}
+			Image output (width, height);
+			for (uint32_t y = 0; y < height; ++y) {
+				// the input texels with their centre inside the footprint of the output pixel
+				uint32_t y0 = (uint32_t)std::ceil(float(y) * input.height / height - 0.5f);
+				uint32_t y1 = std::max(y0 + 1, (uint32_t)std::ceil(float(y + 1) * input.height / height - 0.5f));
+				for (uint32_t x = 0; x < width; ++x) {
+					uint32_t x0 = (uint32_t)std::ceil(float(x) * input.width / width - 0.5f);
+					uint32_t x1 = std::max(x0 + 1, (uint32_t)std::ceil(float(x + 1) * input.width / width - 0.5f));
+					Rgba sum {0, 0, 0, 0};
+					for (uint32_t sy = y0; sy < y1; ++sy) {
+						for (uint32_t sx = x0; sx < x1; ++sx) {
+							const Rgba &c = input.LoadClamped(sx, sy);
+							sum = Rgba{sum.r + c.r, sum.g + c.g, sum.b + c.b, sum.a + c.a};
+						}
+					}
+					float norm = 1.f / ((x1 - x0) * (y1 - y0));
+					output.At(x, y) = Rgba{sum.r * norm, sum.g * norm, sum.b * norm, sum.a * norm};
+				}
+			}
+			return output;
+		}
+
+		Image GenerateTestImage(TestPattern pattern, uint32_t width, uint32_t height, uint32_t seed) {
+			Image image (width, height);
+			uint32_t state = seed * 747796405u + 2891336453u;
+			auto random = [&]() {
+				// PCG-style hash, deterministic across platforms
+				state = state * 747796405u + 2891336453u;
+				uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+				return float((word >> 22u) ^ word) / 4294967296.f;
+			};
+
+			for (uint32_t y = 0; y < height; ++y) {
+				for (uint32_t x = 0; x < width; ++x) {
+					float u = (x + 0.5f) / width;
+					float v = (y + 0.5f) / height;
+					Rgba c {0, 0, 0, 1};
+					switch (pattern) {
+					case TestPattern::GRADIENT:
+						c = Rgba{u, v, 1 - 0.5f * (u + v), 1};
+						break;
+					case TestPattern::CHECKER: {
+						float on = ((x / 8) + (y / 8)) % 2 ? 0.9f : 0.1f;
+						c = Rgba{on, on, on, 1};
+						break;
+					}
+					case TestPattern::ZONE_PLATE: {
+						float dx = u - 0.5f;
+						float dy = v - 0.5f;
+						float val = 0.5f + 0.5f * std::cos(0.25f * width * 3.14159265f * (dx * dx + dy * dy) * 4);
+						c = Rgba{val, val, val, 1};
+						break;
+					}
+					case TestPattern::NOISE:
+						c = Rgba{random(), random(), random(), 1};
+						break;
+					case TestPattern::EDGES: {
+						// rotated bars with sharp transitions plus a smooth background
+						float t = std::sin((u * 0.8f + v * 0.35f) * 40.f);
+						float bar = t > 0 ? 0.85f : 0.15f;
+						c = Rgba{bar, 0.5f * bar + 0.25f * u, 1 - bar * v, 1};
+						break;
+					}
+					}
+					image.At(x, y) = c;
+				}
+			}
+			return image;
+		}
+	}
+}
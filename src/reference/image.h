@@ -0,0 +1,69 @@
+#pragma once
+#include "types.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vrperfkit {
+	namespace reference {
+		struct Rgba {
+			float r;
+			float g;
+			float b;
+			float a;
+		};
+
+		// Linear RGBA float image, row-major. Stands in for a D3D11 texture in the CPU reference kernels.
+		struct Image {
+			uint32_t width = 0;
+			uint32_t height = 0;
+			std::vector<Rgba> pixels;
+
+			Image() = default;
+			Image(uint32_t width, uint32_t height) : width(width), height(height), pixels(width * height, Rgba{0, 0, 0, 1}) {}
+
+			Rgba &At(uint32_t x, uint32_t y) { return pixels[y * width + x]; }
+			const Rgba &At(uint32_t x, uint32_t y) const { return pixels[y * width + x]; }
+
+			// Texture2D.Load semantics: out of bounds reads return zero
+			Rgba Load(int x, int y) const {
+				if (x < 0 || y < 0 || x >= (int)width || y >= (int)height)
+					return Rgba{0, 0, 0, 0};
+				return At(x, y);
+			}
+
+			// point sampling with a clamping sampler
+			Rgba LoadClamped(int x, int y) const {
+				x = x < 0 ? 0 : (x >= (int)width ? width - 1 : x);
+				y = y < 0 ? 0 : (y >= (int)height ? height - 1 : y);
+				return At(x, y);
+			}
+
+			// SampleLevel with a linear clamping sampler, uv in normalized texture coordinates
+			Rgba SampleBilinear(float u, float v) const;
+
+			Viewport FullViewport() const { return Viewport{0, 0, width, height}; }
+		};
+
+		// Binary PPM (P6) with 8 or 16 bits per channel. Values are stored as-is, no gamma conversion.
+		Image LoadPpm(const std::string &path);
+		void SavePpm(const Image &image, const std::string &path, uint32_t bitsPerChannel = 8);
+
+		// box filtered resize to a smaller size, stands in for rendering at a lower resolution
+		Image Downscale(const Image &input, uint32_t width, uint32_t height);
+
+		enum class TestPattern {
+			GRADIENT,
+			CHECKER,
+			ZONE_PLATE,
+			NOISE,
+			EDGES,
+		};
+		TestPattern TestPatternFromString(const std::string &s);
+		std::string TestPatternToString(TestPattern pattern);
+
+		// Deterministic synthetic images for exercising the kernels without captured frames
+		Image GenerateTestImage(TestPattern pattern, uint32_t width, uint32_t height, uint32_t seed = 1);
+	}
+}
@@ -0,0 +1,97 @@
+#include "lanczos_reference.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vrperfkit {
+	namespace reference {
+		namespace {
+			float Lanczos2Weight(float x) {
+				x = std::abs(x);
+				if (x < 1e-5f) {
+					return 1;
+				}
+				if (x >= 2) {
+					return 0;
+				}
+				float px = 3.14159265f * x;
+				return 2 * std::sin(px) * std::sin(0.5f * px) / (px * px);
+			}
+
+			Rgba Lanczos2(const Image &tex, float posX, float posY, int minX, int minY, int maxX, int maxY) {
+				float px = posX - 0.5f;
+				float py = posY - 0.5f;
+				float fx = std::floor(px);
+				float fy = std::floor(py);
+				int baseX = (int)fx - 1;
+				int baseY = (int)fy - 1;
+
+				float wx[4], wy[4];
+				for (int i = 0; i < 4; ++i) {
+					wx[i] = Lanczos2Weight(px - fx + 1 - i);
+					wy[i] = Lanczos2Weight(py - fy + 1 - i);
+				}
+
+				float sum[3] = {0, 0, 0};
+				float weightSum = 0;
+				float mn[3] = {65504, 65504, 65504};
+				float mx[3] = {-65504, -65504, -65504};
+				for (int y = 0; y < 4; ++y) {
+					int sy = std::clamp(baseY + y, minY, maxY);
+					for (int x = 0; x < 4; ++x) {
+						int sx = std::clamp(baseX + x, minX, maxX);
+						const Rgba &c = tex.At(sx, sy);
+						float rgb[3] = {c.r, c.g, c.b};
+						float w = wx[x] * wy[y];
+						weightSum += w;
+						bool inner = (x == 1 || x == 2) && (y == 1 || y == 2);
+						for (int ch = 0; ch < 3; ++ch) {
+							sum[ch] += rgb[ch] * w;
+							if (inner) {
+								mn[ch] = std::min(mn[ch], rgb[ch]);
+								mx[ch] = std::max(mx[ch], rgb[ch]);
+							}
+						}
+					}
+				}
+
+				Rgba result;
+				result.r = std::clamp(sum[0] / weightSum, mn[0], mx[0]);
+				result.g = std::clamp(sum[1] / weightSum, mn[1], mx[1]);
+				result.b = std::clamp(sum[2] / weightSum, mn[2], mx[2]);
+				result.a = 1;
+				return result;
+			}
+		}
+
+		void LanczosUpscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport) {
+			float scaleX = inputViewport.width / (float)outputViewport.width;
+			float scaleY = inputViewport.height / (float)outputViewport.height;
+			int minX = inputViewport.x, minY = inputViewport.y;
+			int maxX = inputViewport.x + inputViewport.width - 1, maxY = inputViewport.y + inputViewport.height - 1;
+			for (uint32_t y = 0; y < outputViewport.height; ++y) {
+				for (uint32_t x = 0; x < outputViewport.width; ++x) {
+					float posX = (x + 0.5f) * scaleX + inputViewport.x;
+					float posY = (y + 0.5f) * scaleY + inputViewport.y;
+					output.At(outputViewport.x + x, outputViewport.y + y) = Lanczos2(input, posX, posY, minX, minY, maxX, maxY);
+				}
+			}
+		}
+
+		Rgba Lanczos2Sample(const Image &input, float posX, float posY) {
+			return Lanczos2(input, posX, posY, 0, 0, input.width - 1, input.height - 1);
+		}
+
+		void BilinearUpscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport) {
+			float scaleX = inputViewport.width / (float)outputViewport.width;
+			float scaleY = inputViewport.height / (float)outputViewport.height;
+			for (uint32_t y = 0; y < outputViewport.height; ++y) {
+				for (uint32_t x = 0; x < outputViewport.width; ++x) {
+					float u = ((x + 0.5f) * scaleX + inputViewport.x) / input.width;
+					float v = ((y + 0.5f) * scaleY + inputViewport.y) / input.height;
+					output.At(outputViewport.x + x, outputViewport.y + y) = input.SampleBilinear(u, v);
+				}
+			}
+		}
+	}
+}
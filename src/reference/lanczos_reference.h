@@ -0,0 +1,17 @@
+#pragma once
+#include "image.h"
+
+namespace vrperfkit {
+	namespace reference {
+		// CPU port of lanczos/lanczos.h as run by D3D11LanczosUpscaler and the periphery filter.
+
+		// upscale inputViewport of input into outputViewport of output
+		void LanczosUpscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport);
+
+		// Lanczos2 from lanczos.h without a clamp region: pos in texels, loads clamped to the texture
+		Rgba Lanczos2Sample(const Image &input, float posX, float posY);
+
+		// plain bilinear upscaling, as used by the periphery fallback of the other methods
+		void BilinearUpscale(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport);
+	}
+}
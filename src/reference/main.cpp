@@ -0,0 +1,2571 @@
+// Command line front end for the portable CPU reference implementations.
+#include "cas_reference.h"
+#include "context_table.h"
+#include "foveation_estimate.h"
+#include "fsr_reference.h"
+#include "hook_table.h"
+#include "image.h"
+#include "lanczos_reference.h"
+#include "metrics.h"
+#include "nis_reference.h"
+#include "nis/NIS_Config.h"
+#include "nis/nis_coefficients.h"
+#include "rdm_reference.h"
+#include "simd.h"
+#include "snapshot_list.h"
+#include "thread_pool.h"
+#include "upscaler_selection.h"
+#include "view_cache.h"
+#include "visible_bounds.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace vrperfkit;
+using namespace vrperfkit::reference;
+
+namespace {
+	class Arguments {
+	public:
+		Arguments(int argc, char **argv, int first) {
+			for (int i = first; i < argc; ++i) {
+				std::string arg = argv[i];
+				if (arg.rfind("--", 0) == 0) {
+					std::string key = arg.substr(2);
+					std::string value = "1";
+					auto eq = key.find('=');
+					if (eq != std::string::npos) {
+						value = key.substr(eq + 1);
+						key = key.substr(0, eq);
+					} else if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+						value = argv[++i];
+					}
+					options[key] = value;
+				} else {
+					positional.push_back(arg);
+				}
+			}
+		}
+
+		std::string Get(const std::string &key, const std::string &def) const {
+			auto it = options.find(key);
+			return it != options.end() ? it->second : def;
+		}
+
+		float GetFloat(const std::string &key, float def) const {
+			auto it = options.find(key);
+			return it != options.end() ? std::stof(it->second) : def;
+		}
+
+		uint32_t GetUint(const std::string &key, uint32_t def) const {
+			auto it = options.find(key);
+			return it != options.end() ? (uint32_t)std::stoul(it->second) : def;
+		}
+
+		bool Has(const std::string &key) const {
+			return options.count(key) > 0;
+		}
+
+		std::vector<std::string> positional;
+
+	private:
+		std::map<std::string, std::string> options;
+	};
+
+	Image LoadOrGenerateInput(const Arguments &args) {
+		if (args.Has("input")) {
+			return LoadPpm(args.Get("input", ""));
+		}
+		TestPattern pattern = TestPatternFromString(args.Get("pattern", "edges"));
+		return GenerateTestImage(pattern, args.GetUint("width", 1440), args.GetUint("height", 1600), args.GetUint("seed", 1));
+	}
+
+	void PrintStats(const char *name, const ErrorStats &stats) {
+		std::printf("  %-14s max abs %.6f  mean abs %.6f  PSNR %.2f dB\n", name, stats.maxAbsError, stats.meanAbsError, stats.psnr);
+	}
+
+	// Compares the FP16 shader path against FP32 for FSR and CAS, to judge whether the
+	// upscaling.halfPrecision option is safe for a given kind of content. With --max-error and
+	// --max-mean-error it exits with a non-zero code when a kernel exceeds them.
+	int Fp16Error(const Arguments &args) {
+		Image input = LoadOrGenerateInput(args);
+		float renderScale = args.GetFloat("scale", 0.77f);
+		float sharpness = args.GetFloat("sharpness", 0.3f);
+		uint32_t outWidth = (uint32_t)(input.width / renderScale);
+		uint32_t outHeight = (uint32_t)(input.height / renderScale);
+		float maxError = args.GetFloat("max-error", 1.f);
+		float maxMeanError = args.GetFloat("max-mean-error", 1.f);
+		bool ok = true;
+		auto check = [&](const char *name, const ErrorStats &stats) {
+			PrintStats(name, stats);
+			ok = ok && stats.maxAbsError <= maxError && stats.meanAbsError <= maxMeanError;
+		};
+
+		std::printf("FP16 vs FP32 error, input %ux%u, output %ux%u, sharpness %.2f\n", input.width, input.height, outWidth, outHeight, sharpness);
+
+		Image upscaled32 (outWidth, outHeight), upscaled16 (outWidth, outHeight);
+		FsrUpscale(input, input.FullViewport(), upscaled32, upscaled32.FullViewport(), Precision::FP32);
+		FsrUpscale(input, input.FullViewport(), upscaled16, upscaled16.FullViewport(), Precision::FP16);
+		check("FSR EASU", CompareImages(upscaled32, upscaled16, upscaled32.FullViewport()));
+
+		Image sharpened32 (outWidth, outHeight), sharpened16 (outWidth, outHeight);
+		FsrSharpen(upscaled32, sharpened32, upscaled32.FullViewport(), sharpness, Precision::FP32);
+		FsrSharpen(upscaled32, sharpened16, upscaled32.FullViewport(), sharpness, Precision::FP16);
+		check("FSR RCAS", CompareImages(sharpened32, sharpened16, sharpened32.FullViewport()));
+
+		Image cas32 (input.width, input.height), cas16 (input.width, input.height);
+		CasSharpen(input, cas32, input.FullViewport(), sharpness, Precision::FP32);
+		CasSharpen(input, cas16, input.FullViewport(), sharpness, Precision::FP16);
+		check("CAS sharpen", CompareImages(cas32, cas16, cas32.FullViewport()));
+
+		if (args.Has("output")) {
+			std::string prefix = args.Get("output", "fp16");
+			SavePpm(upscaled16, prefix + "_fsr_easu.ppm");
+			SavePpm(sharpened16, prefix + "_fsr_rcas.ppm");
+			SavePpm(cas16, prefix + "_cas.ppm");
+		}
+		std::printf("Max error %.6f, max mean error %.6f: %s\n", maxError, maxMeanError, ok ? "OK" : "EXCEEDED");
+		return ok ? 0 : 1;
+	}
+
+	// Times the CPU reference kernels. The absolute numbers are not representative of the GPU,
+	// but the relative cost of the upscaling methods is a useful first indication.
+	int Bench(const Arguments &args) {
+		Image input = LoadOrGenerateInput(args);
+		float renderScale = args.GetFloat("scale", 0.77f);
+		float sharpness = args.GetFloat("sharpness", 0.3f);
+		uint32_t iterations = std::max(1u, args.GetUint("iterations", 5));
+		uint32_t outWidth = (uint32_t)(input.width / renderScale);
+		uint32_t outHeight = (uint32_t)(input.height / renderScale);
+		Viewport inVp = input.FullViewport();
+		Image output (outWidth, outHeight);
+		Viewport outVp = output.FullViewport();
+		Image sharpened (outWidth, outHeight);
+
+		std::printf("Benchmark, input %ux%u, output %ux%u, %u iterations\n", input.width, input.height, outWidth, outHeight, iterations);
+
+		auto run = [&](const char *name, const std::function<void()> &kernel) {
+			kernel(); // warm up
+			auto start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < iterations; ++i) {
+				kernel();
+			}
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+			std::printf("  %-14s %9.2f ms  %8.2f Mpix/s\n", name, ms, outWidth * outHeight / (ms * 1000.0));
+		};
+
+		run("bilinear", [&]() { BilinearUpscale(input, inVp, output, outVp); });
+		run("lanczos", [&]() { LanczosUpscale(input, inVp, output, outVp); });
+		run("FSR EASU", [&]() { FsrUpscale(input, inVp, output, outVp); });
+		run("FSR RCAS", [&]() { FsrSharpen(output, sharpened, outVp, sharpness); });
+		run("CAS upscale", [&]() { CasUpscale(input, inVp, output, outVp, sharpness, CasOptions()); });
+		run("CAS sharpen", [&]() { CasSharpen(output, sharpened, outVp, sharpness); });
+		NISConfig nisConfig;
+		UpdateNisConfig(nisConfig, sharpness, 1.f, Point<float>{0.5f, 0.5f}, inVp, input.width, input.height, outVp, outWidth, outHeight, false, false);
+		run("NIS", [&]() { NisUpscale(input, output, nisConfig, NisOptions()); });
+		return 0;
+	}
+
+	FsrOptions FsrOptionsFromArguments(const Arguments &args) {
+		FsrOptions options;
+		options.precision = args.Has("fp16") ? Precision::FP16 : Precision::FP32;
+		options.radiusTest = args.Has("radius-test");
+		options.radius = args.GetFloat("radius", options.radius);
+		options.projectionCenter.x = args.GetFloat("center-x", options.projectionCenter.x);
+		options.projectionCenter.y = args.GetFloat("center-y", options.projectionCenter.y);
+		options.debugMode = args.Has("debug");
+		options.threads = args.GetUint("threads", 0);
+		options.simd = !args.Has("no-simd");
+		return options;
+	}
+
+	// Writes the result of a single frame command and compares it with a golden image if requested.
+	// Returns the exit code of the command.
+	int SaveAndCheckResult(const Arguments &args, const Image &result) {
+		if (args.Has("output")) {
+			// 16 bits per channel, so that the file can serve as a golden image
+			SavePpm(result, args.Get("output", "result.ppm"), 16);
+		}
+		if (args.Has("golden")) {
+			Image golden = LoadPpm(args.Get("golden", ""));
+			if (golden.width != result.width || golden.height != result.height) {
+				std::printf("Golden image is %ux%u: MISMATCH\n", golden.width, golden.height);
+				return 1;
+			}
+			// the file only holds [0, 1], so HDR results are compared as they were saved
+			Image saved = result;
+			for (Rgba &c : saved.pixels) {
+				c = Rgba{Sat(c.r), Sat(c.g), Sat(c.b), Sat(c.a)};
+			}
+			ErrorStats stats = CompareImages(golden, saved, saved.FullViewport());
+			float tolerance = args.GetFloat("tolerance", 1e-3f);
+			bool ok = stats.maxAbsError <= tolerance;
+			PrintStats("vs golden", stats);
+			std::printf("Max error tolerance %.6f: %s\n", tolerance, ok ? "OK" : "MISMATCH");
+			return ok ? 0 : 1;
+		}
+		return 0;
+	}
+
+	// With --check-scalar, runs a single frame command again without SIMD on one thread and checks
+	// that the vectorized and threaded result matches it within --scalar-tolerance.
+	// Returns the exit code of the check.
+	int CheckAgainstScalar(const Arguments &args, const Image &result, const std::function<Image()> &runScalar) {
+		if (!args.Has("check-scalar")) {
+			return 0;
+		}
+		Image scalar = runScalar();
+		ErrorStats stats = CompareImages(scalar, result, result.FullViewport());
+		float tolerance = args.GetFloat("scalar-tolerance", 1e-5f);
+		bool ok = stats.maxAbsError <= tolerance;
+		PrintStats("vs scalar", stats);
+		std::printf("Scalar tolerance %.6f: %s\n", tolerance, ok ? "OK" : "MISMATCH");
+		return ok ? 0 : 1;
+	}
+
+	// Upscales and sharpens one frame like D3D11FsrUpscaler. With --golden the result is checked
+	// against a previously written image, which makes this usable as a regression test.
+	int Fsr(const Arguments &args) {
+		Image input = LoadOrGenerateInput(args);
+		float renderScale = args.GetFloat("scale", 0.77f);
+		float sharpness = args.GetFloat("sharpness", 0.3f);
+		FsrOptions options = FsrOptionsFromArguments(args);
+		uint32_t outWidth = args.GetUint("output-width", (uint32_t)(input.width / renderScale));
+		uint32_t outHeight = args.GetUint("output-height", (uint32_t)(input.height / renderScale));
+
+		Image upscaled (outWidth, outHeight), sharpened (outWidth, outHeight);
+		auto start = std::chrono::steady_clock::now();
+		FsrUpscale(input, input.FullViewport(), upscaled, upscaled.FullViewport(), options);
+		FsrSharpen(upscaled, sharpened, sharpened.FullViewport(), sharpness, options);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::printf("FSR %ux%u -> %ux%u in %.2f ms (%s, %u threads)\n", input.width, input.height, outWidth, outHeight, ms,
+			options.simd && options.precision == Precision::FP32 ? SimdName() : "scalar", GetThreadPool(options.threads).ThreadCount());
+		int scalarResult = CheckAgainstScalar(args, sharpened, [&]() {
+			FsrOptions scalarOptions = options;
+			scalarOptions.simd = false;
+			scalarOptions.threads = 1;
+			Image scalarUpscaled (outWidth, outHeight), scalarSharpened (outWidth, outHeight);
+			FsrUpscale(input, input.FullViewport(), scalarUpscaled, scalarUpscaled.FullViewport(), scalarOptions);
+			FsrSharpen(scalarUpscaled, scalarSharpened, scalarSharpened.FullViewport(), sharpness, scalarOptions);
+			return scalarSharpened;
+		});
+		return SaveAndCheckResult(args, sharpened) | scalarResult;
+	}
+
+	CasOptions CasOptionsFromArguments(const Arguments &args) {
+		CasOptions options;
+		options.precision = args.Has("fp16") ? Precision::FP16 : Precision::FP32;
+		options.radiusTest = args.Has("radius-test");
+		options.radius = args.GetFloat("radius", options.radius);
+		options.projectionCenter.x = args.GetFloat("center-x", options.projectionCenter.x);
+		options.projectionCenter.y = args.GetFloat("center-y", options.projectionCenter.y);
+		options.debugMode = args.Has("debug");
+		options.peripheryLanczos = args.Has("lanczos");
+		options.threads = args.GetUint("threads", 0);
+		options.simd = !args.Has("no-simd");
+		return options;
+	}
+
+	// Upscales one frame like D3D11CasUpscaler, or only sharpens it at --scale 1.
+	int Cas(const Arguments &args) {
+		Image input = LoadOrGenerateInput(args);
+		float renderScale = args.GetFloat("scale", 0.77f);
+		float sharpness = args.GetFloat("sharpness", 0.3f);
+		CasOptions options = CasOptionsFromArguments(args);
+		uint32_t outWidth = args.GetUint("output-width", (uint32_t)(input.width / renderScale));
+		uint32_t outHeight = args.GetUint("output-height", (uint32_t)(input.height / renderScale));
+
+		Image output (outWidth, outHeight);
+		auto start = std::chrono::steady_clock::now();
+		if (outWidth == input.width && outHeight == input.height) {
+			CasSharpen(input, output, output.FullViewport(), sharpness, options);
+		} else {
+			CasUpscale(input, input.FullViewport(), output, output.FullViewport(), sharpness, options);
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::printf("CAS %ux%u -> %ux%u in %.2f ms (%s, %u threads)\n", input.width, input.height, outWidth, outHeight, ms,
+			options.simd && options.precision == Precision::FP32 ? SimdName() : "scalar", GetThreadPool(options.threads).ThreadCount());
+		int scalarResult = CheckAgainstScalar(args, output, [&]() {
+			CasOptions scalarOptions = options;
+			scalarOptions.simd = false;
+			scalarOptions.threads = 1;
+			Image scalar (outWidth, outHeight);
+			if (outWidth == input.width && outHeight == input.height) {
+				CasSharpen(input, scalar, scalar.FullViewport(), sharpness, scalarOptions);
+			} else {
+				CasUpscale(input, input.FullViewport(), scalar, scalar.FullViewport(), sharpness, scalarOptions);
+			}
+			return scalar;
+		});
+		return SaveAndCheckResult(args, output) | scalarResult;
+	}
+
+	NisOptions NisOptionsFromArguments(const Arguments &args) {
+		NisOptions options;
+		options.hdr = args.Has("hdr");
+		options.radiusTest = args.Has("radius-test");
+		options.debugMode = args.Has("debug");
+		options.peripheryLanczos = args.Has("lanczos");
+		options.filterTaps = args.Has("performance") ? 4 : kNisMaxFilterTaps;
+		options.threads = args.GetUint("threads", 0);
+		options.simd = !args.Has("no-simd");
+		return options;
+	}
+
+	// Runs one eye through the NIS scaler, or the sharpener if the viewports have the same size,
+	// with the NISConfig that D3D11NisUpscaler would upload.
+	bool RunNis(const Image &input, const Viewport &inputViewport, Image &output, const Viewport &outputViewport,
+			float sharpness, float radius, const Point<float> &projectionCenter, const NisOptions &options) {
+		NISConfig config;
+		if (!UpdateNisConfig(config, sharpness, radius, projectionCenter, inputViewport, input.width, input.height,
+				outputViewport, output.width, output.height, options.hdr, options.debugMode)) {
+			return false;
+		}
+		if (inputViewport.width == outputViewport.width && inputViewport.height == outputViewport.height) {
+			NisSharpen(input, output, config, options);
+		} else {
+			NisUpscale(input, output, config, options);
+		}
+		return true;
+	}
+
+	// Upscales one frame like D3D11NisUpscaler. With --combined both eyes share one texture side by
+	// side, as with textureMode COMBINED, to check the viewport offsets.
+	int Nis(const Arguments &args) {
+		Image eye = LoadOrGenerateInput(args);
+		float renderScale = args.GetFloat("scale", 0.77f);
+		float sharpness = args.GetFloat("sharpness", 0.3f);
+		float radius = args.GetFloat("radius", 0.95f);
+		Point<float> projectionCenter { args.GetFloat("center-x", 0.5f), args.GetFloat("center-y", 0.5f) };
+		NisOptions options = NisOptionsFromArguments(args);
+		uint32_t eyeCount = args.Has("combined") ? 2 : 1;
+		uint32_t outWidth = args.GetUint("output-width", (uint32_t)(eye.width / renderScale));
+		uint32_t outHeight = args.GetUint("output-height", (uint32_t)(eye.height / renderScale));
+
+		Image input (eye.width * eyeCount, eye.height);
+		for (uint32_t i = 0; i < eyeCount; ++i) {
+			for (uint32_t y = 0; y < eye.height; ++y) {
+				std::copy_n(&eye.At(0, y), eye.width, &input.At(i * eye.width, y));
+			}
+		}
+
+		Image output (outWidth * eyeCount, outHeight);
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < eyeCount; ++i) {
+			Viewport inputViewport { i * eye.width, 0, eye.width, eye.height };
+			Viewport outputViewport { i * outWidth, 0, outWidth, outHeight };
+			// the right eye's projection centre is mirrored, as for a symmetric headset
+			Point<float> center { i == 0 ? projectionCenter.x : 1 - projectionCenter.x, projectionCenter.y };
+			if (!RunNis(input, inputViewport, output, outputViewport, sharpness, radius, center, options)) {
+				std::printf("NVScalerUpdateConfig rejected the viewports, NIS supports scale factors from 0.5 to 1\n");
+				return 1;
+			}
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::printf("NIS %ux%u -> %ux%u (%u eyes) in %.2f ms (%s, %u threads)\n", eye.width, eye.height, outWidth, outHeight, eyeCount, ms,
+			options.simd ? SimdName() : "scalar", GetThreadPool(options.threads).ThreadCount());
+		return SaveAndCheckResult(args, output);
+	}
+
+	// Checks that the NIS configuration gives the intended output: each eye of a COMBINED texture
+	// matches a run on its own with the projection centre mirrored, the radius test replaces exactly
+	// the blocks outside the radius with the bilinear fallback, and more sharpness sharpens more.
+	int NisCheck(const Arguments &args) {
+		TestPattern pattern = TestPatternFromString(args.Get("pattern", "edges"));
+		Image eye = GenerateTestImage(pattern, args.GetUint("width", 96), args.GetUint("height", 96), args.GetUint("seed", 1));
+		float sharpness = args.GetFloat("sharpness", 0.3f);
+		float radius = args.GetFloat("radius", 0.6f);
+		Point<float> projectionCenter { args.GetFloat("center-x", 0.35f), args.GetFloat("center-y", 0.5f) };
+		NisOptions options = NisOptionsFromArguments(args);
+		int failures = 0;
+		auto check = [&](const char *name, bool ok) {
+			std::printf("%-58s %s\n", name, ok ? "OK" : "FAILED");
+			failures += ok ? 0 : 1;
+		};
+		const uint32_t kSeamWidth = 4;
+		auto mirrored = [&](uint32_t i) {
+			return Point<float> { i == 0 ? projectionCenter.x : 1 - projectionCenter.x, projectionCenter.y };
+		};
+
+		// the scaler and the sharpener, with the radius test so that the mirrored centre matters
+		NisOptions tested = options;
+		tested.radiusTest = true;
+		for (float renderScale : { 0.77f, 1.f }) {
+			uint32_t outWidth = (uint32_t)(eye.width / renderScale);
+			uint32_t outHeight = (uint32_t)(eye.height / renderScale);
+			Image input (eye.width * 2, eye.height);
+			for (uint32_t i = 0; i < 2; ++i) {
+				for (uint32_t y = 0; y < eye.height; ++y) {
+					std::copy_n(&eye.At(0, y), eye.width, &input.At(i * eye.width, y));
+				}
+			}
+			Image combined (outWidth * 2, outHeight);
+			bool ran = true;
+			for (uint32_t i = 0; i < 2; ++i) {
+				ran = ran && RunNis(input, Viewport { i * eye.width, 0, eye.width, eye.height }, combined, Viewport { i * outWidth, 0, outWidth, outHeight },
+					sharpness, radius, mirrored(i), tested);
+			}
+			double maxError = 0;
+			for (uint32_t i = 0; ran && i < 2; ++i) {
+				Image single (outWidth, outHeight), half (outWidth, outHeight);
+				ran = RunNis(eye, eye.FullViewport(), single, single.FullViewport(), sharpness, radius, mirrored(i), tested);
+				for (uint32_t y = 0; y < outHeight; ++y) {
+					std::copy_n(&combined.At(i * outWidth, y), outWidth, &half.At(0, y));
+				}
+				// filter taps next to the seam read the other eye, as they do in the shared texture
+				Viewport interior { i == 0 ? 0 : kSeamWidth, 0, outWidth - kSeamWidth, outHeight };
+				maxError = std::max(maxError, CompareImages(single, half, interior).maxAbsError);
+			}
+			check(renderScale < 1 ? "COMBINED upscaling matches single eyes, centres mirrored" : "COMBINED sharpening matches single eyes, centres mirrored",
+				ran && maxError <= 1e-4);
+		}
+
+		// blocks of 32x24 output pixels, as the upscale shader dispatches them
+		uint32_t outWidth = (uint32_t)(eye.width / 0.77f);
+		uint32_t outHeight = (uint32_t)(eye.height / 0.77f);
+		Image full (outWidth, outHeight), withRadius (outWidth, outHeight);
+		NISConfig config;
+		bool configured = UpdateNisConfig(config, sharpness, radius, projectionCenter, eye.FullViewport(), eye.width, eye.height,
+			full.FullViewport(), outWidth, outHeight, false, false);
+		NisOptions plain = options;
+		plain.radiusTest = false;
+		plain.debugMode = false;
+		plain.peripheryLanczos = false;
+		plain.hdr = false;
+		NisOptions plainWithRadius = plain;
+		plainWithRadius.radiusTest = true;
+		uint32_t outside = 0, inside = 0;
+		float fallbackError = 0, insideError = 0;
+		if (configured) {
+			NisUpscale(eye, full, config, plain);
+			NisUpscale(eye, withRadius, config, plainWithRadius);
+			double centreX = projectionCenter.x * outWidth, centreY = projectionCenter.y * outHeight;
+			double blockRadius = 0.5 * radius * outHeight;
+			for (uint32_t y = 0; y < outHeight; ++y) {
+				for (uint32_t x = 0; x < outWidth; ++x) {
+					double dx = centreX - (x / 32 * 32 + 16), dy = centreY - (y / 24 * 24 + 12);
+					const Rgba &c = withRadius.At(x, y);
+					if (dx * dx + dy * dy > blockRadius * blockRadius + 1) {
+						Rgba expected = eye.SampleBilinear(x * config.kDstNormX, y * config.kDstNormY);
+						fallbackError = std::max({ fallbackError, std::fabs(c.r - expected.r), std::fabs(c.g - expected.g), std::fabs(c.b - expected.b) });
+						++outside;
+					} else if (dx * dx + dy * dy < blockRadius * blockRadius - 1) {
+						const Rgba &expected = full.At(x, y);
+						insideError = std::max({ insideError, std::fabs(c.r - expected.r), std::fabs(c.g - expected.g), std::fabs(c.b - expected.b) });
+						++inside;
+					}
+				}
+			}
+		}
+		std::printf("%u pixels outside and %u inside the radius of %.2f\n", outside, inside, radius);
+		check("pixels outside the radius are the bilinear fallback", configured && outside > 0 && fallbackError <= 1e-5f);
+		check("pixels inside the radius are the full NIS result", configured && inside > 0 && insideError == 0);
+
+		// local contrast: the mean distance of each pixel from the average of its neighbours
+		auto contrast = [](const Image &image) {
+			double sum = 0;
+			for (uint32_t y = 1; y + 1 < image.height; ++y) {
+				for (uint32_t x = 1; x + 1 < image.width; ++x) {
+					auto luma = [&](uint32_t px, uint32_t py) { const Rgba &c = image.At(px, py); return 0.25 * c.r + 0.5 * c.g + 0.25 * c.b; };
+					sum += std::fabs(luma(x, y) - 0.25 * (luma(x - 1, y) + luma(x + 1, y) + luma(x, y - 1) + luma(x, y + 1)));
+				}
+			}
+			return sum / ((image.width - 2) * (image.height - 2));
+		};
+		bool sharper = configured;
+		double previous = 0;
+		for (float level : { 0.f, 0.5f, 1.f }) {
+			Image sharpened (outWidth, outHeight);
+			NISConfig levelConfig;
+			sharper = sharper && UpdateNisConfig(levelConfig, level, radius, projectionCenter, eye.FullViewport(), eye.width, eye.height,
+				sharpened.FullViewport(), outWidth, outHeight, false, false);
+			NisUpscale(eye, sharpened, levelConfig, plain);
+			double value = contrast(sharpened);
+			std::printf("sharpness %.1f: local contrast %.5f\n", level, value);
+			sharper = sharper && value > previous;
+			previous = value;
+		}
+		check("more sharpness gives more local contrast", sharper);
+
+		std::printf("%s\n", failures == 0 ? "All NIS checks passed" : "NIS checks FAILED");
+		return failures == 0 ? 0 : 1;
+	}
+
+	// Measures the throughput of a reference kernel for a list of output resolutions, comparing
+	// the scalar, vectorized and multithreaded paths.
+	int ThroughputBench(const Arguments &args, const char *name, const std::function<void(const Image &input, Image &output, bool simd, uint32_t threads)> &kernel,
+			float defaultScale = 0.77f) {
+		float renderScale = args.GetFloat("scale", defaultScale);
+		uint32_t iterations = std::max(1u, args.GetUint("iterations", 3));
+		TestPattern pattern = TestPatternFromString(args.Get("pattern", "edges"));
+		std::string sizes = args.Get("sizes", "1440x1600,2016x2240,2448x2720");
+		std::replace(sizes.begin(), sizes.end(), ',', ' ');
+
+		struct Variant {
+			const char *name;
+			bool simd;
+			uint32_t threads;
+		};
+		const Variant variants[] = {
+			{ "scalar, 1 thread", false, 1 },
+			{ "SIMD, 1 thread", true, 1 },
+			{ "SIMD, all threads", true, 0 },
+		};
+
+		std::printf("%s reference throughput, %s kernels, %u hardware threads, %u iterations\n", name, SimdName(), GetThreadPool(0).ThreadCount(), iterations);
+		const char *cursor = sizes.c_str();
+		uint32_t outWidth, outHeight;
+		int consumed;
+		while (std::sscanf(cursor, " %ux%u%n", &outWidth, &outHeight, &consumed) == 2) {
+			cursor += consumed;
+			Image input = GenerateTestImage(pattern, (uint32_t)(outWidth * renderScale), (uint32_t)(outHeight * renderScale));
+			Image output (outWidth, outHeight);
+			std::printf("%ux%u -> %ux%u\n", input.width, input.height, outWidth, outHeight);
+
+			for (const Variant &variant : variants) {
+				kernel(input, output, variant.simd, variant.threads); // warm up
+				auto start = std::chrono::steady_clock::now();
+				for (uint32_t i = 0; i < iterations; ++i) {
+					kernel(input, output, variant.simd, variant.threads);
+				}
+				double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+				std::printf("  %-18s %9.2f ms  %8.2f Mpix/s\n", variant.name, ms, outWidth * outHeight / (ms * 1000.0));
+			}
+		}
+		return 0;
+	}
+
+	int FsrBench(const Arguments &args) {
+		float sharpness = args.GetFloat("sharpness", 0.3f);
+		Image upscaled;
+		return ThroughputBench(args, "FSR", [&](const Image &input, Image &output, bool simd, uint32_t threads) {
+			FsrOptions options;
+			options.simd = simd;
+			options.threads = threads;
+			upscaled = Image(output.width, output.height);
+			FsrUpscale(input, input.FullViewport(), upscaled, upscaled.FullViewport(), options);
+			FsrSharpen(upscaled, output, output.FullViewport(), sharpness, options);
+		});
+	}
+
+	int NisBench(const Arguments &args) {
+		float sharpness = args.GetFloat("sharpness", 0.3f);
+		NisOptions defaults = NisOptionsFromArguments(args);
+		return ThroughputBench(args, "NIS", [&](const Image &input, Image &output, bool simd, uint32_t threads) {
+			NisOptions options = defaults;
+			options.simd = simd;
+			options.threads = threads;
+			RunNis(input, input.FullViewport(), output, output.FullViewport(), sharpness, 0.95f, Point<float>{0.5f, 0.5f}, options);
+		});
+	}
+
+	int CasBench(const Arguments &args) {
+		float sharpness = args.GetFloat("sharpness", 0.3f);
+		return ThroughputBench(args, "CAS", [&](const Image &input, Image &output, bool simd, uint32_t threads) {
+			CasOptions options;
+			options.simd = simd;
+			options.threads = threads;
+			CasUpscale(input, input.FullViewport(), output, output.FullViewport(), sharpness, options);
+		});
+	}
+
+	EccentricityWeighting WeightingFromArguments(const Arguments &args) {
+		EccentricityWeighting weighting;
+		weighting.projectionCenter.x = args.GetFloat("center-x", weighting.projectionCenter.x);
+		weighting.projectionCenter.y = args.GetFloat("center-y", weighting.projectionCenter.y);
+		weighting.innerRadius = args.GetFloat("inner-radius", weighting.innerRadius);
+		weighting.midRadius = args.GetFloat("mid-radius", weighting.midRadius);
+		weighting.outerRadius = args.GetFloat("outer-radius", weighting.outerRadius);
+		return weighting;
+	}
+
+	// --cluster-size <n> and --levels <level>,... as ffr.rdmClusterSize and ffr.rdmLevels
+	RdmPattern RdmPatternFromArguments(const Arguments &args) {
+		RdmPattern pattern;
+		pattern.clusterSize = args.GetUint("cluster-size", pattern.clusterSize);
+		if (args.Has("levels")) {
+			std::string list = args.Get("levels", "");
+			std::replace(list.begin(), list.end(), ',', ' ');
+			std::istringstream levels (list);
+			pattern.levelCount = 0;
+			for (std::string level; levels >> level; ++pattern.levelCount) {
+				if (pattern.levelCount < 3) {
+					pattern.levels[pattern.levelCount] = RdmLevelFromString(level);
+				}
+			}
+		}
+		std::string error;
+		if (!IsValidRdmPattern(pattern, error)) {
+			throw std::invalid_argument(error);
+		}
+		return pattern;
+	}
+
+	struct RdmSetup {
+		float radius[3] = { 0.5f, 0.65f, 0.8f };
+		float edgeRadius = 1.15f;
+		Point<float> projectionCenter = {0.5f, 0.5f};
+		RdmPattern pattern;
+		uint32_t phases = 1;
+		float historyWeight = 0.5f;
+		bool checkerboard = false;
+	};
+
+	// --checkerboard as ffr.method checkerboard, applied outside the inner radius or with --whole-eye to all of it
+	void SetupCheckerboard(RdmSetup &setup, bool wholeEye) {
+		setup.checkerboard = true;
+		setup.pattern = CheckerboardRdmPattern();
+		setup.phases = kCheckerboardPhases;
+		if (wholeEye) {
+			setup.radius[0] = 0.f;
+		}
+	}
+
+	RdmSetup RdmSetupFromArguments(const Arguments &args) {
+		RdmSetup setup;
+		setup.pattern = RdmPatternFromArguments(args);
+		setup.radius[0] = args.GetFloat("inner-radius", setup.radius[0]);
+		setup.radius[1] = args.GetFloat("mid-radius", setup.radius[1]);
+		setup.radius[2] = args.GetFloat("outer-radius", setup.radius[2]);
+		setup.edgeRadius = args.GetFloat("edge-radius", setup.edgeRadius);
+		setup.projectionCenter.x = args.GetFloat("center-x", setup.projectionCenter.x);
+		setup.projectionCenter.y = args.GetFloat("center-y", setup.projectionCenter.y);
+		setup.phases = args.GetUint("phases", setup.phases);
+		if (!IsValidRdmPhaseCount(setup.phases)) {
+			throw std::invalid_argument("RDM phases must be 1, 2 or 4");
+		}
+		setup.historyWeight = args.GetFloat("history-weight", setup.historyWeight);
+		if (args.Has("checkerboard")) {
+			SetupCheckerboard(setup, args.Has("whole-eye"));
+		}
+		return setup;
+	}
+
+	RdmReconstructOptions RdmOptionsFromArguments(const Arguments &args) {
+		RdmReconstructOptions options;
+		options.unorm = args.Has("unorm");
+		options.threads = args.GetUint("threads", 0);
+		options.simd = !args.Has("no-simd");
+		options.checkerboard = args.Has("checkerboard");
+		return options;
+	}
+
+	// Constants for one eye rendered to viewport of a texture, set up like D3D11PostProcessor does
+	// for a single eye texture, or for the right half of a side by side texture (projection centre + 1).
+	void SetupRdm(const RdmSetup &setup, const Image &texture, const Viewport &viewport, RdmMaskingConstants &masking, RdmReconstructConstants &reconstruct) {
+		Point<float> center = setup.projectionCenter;
+		if (viewport.x > 0) {
+			center.x += 1.f;
+		}
+		SetupRdmMaskingConstants(masking, 0.f, setup.radius, setup.edgeRadius, viewport.width, viewport.height, center, false, setup.pattern);
+		SetupRdmReconstructConstants(reconstruct, setup.radius, setup.edgeRadius, viewport, texture.width, texture.height, center, setup.pattern);
+	}
+
+	// Renders frames of a still scene as the game would with temporal RDM, each masked in the phase of
+	// its frame, and reconstructs them with the previous output as history, as the post processor does
+	// for one eye. Returns the reconstruction of the last frame.
+	Image RdmTemporalFrames(const RdmSetup &setup, const Image &scene, const Viewport &viewport, uint32_t frames, const RdmReconstructOptions &options) {
+		RdmMaskingConstants masking;
+		RdmReconstructConstants reconstruct;
+		SetupRdm(setup, scene, viewport, masking, reconstruct);
+		Image output (scene.width, scene.height), history (scene.width, scene.height);
+		for (uint32_t frame = 0; frame < frames; ++frame) {
+			GetRdmPhase(setup.phases, frame, masking.phase);
+			GetRdmPhase(setup.phases, frame, reconstruct.phase);
+			reconstruct.historyWeight = frame > 0 ? setup.historyWeight : 0.f;
+			Image masked = scene;
+			ApplyRdmMask(masked, viewport, GenerateRdmMask(masking, viewport), Rgba{0, 0, 0, 0});
+			std::swap(output, history);
+			RdmReconstruct(masked, viewport, output, reconstruct, options, &history);
+		}
+		return output;
+	}
+
+	const char *const kRdmModeNames[kRdmReconstructModeCount] = {
+		"copy", "half high", "half low", "quarter", "sixteenth", "half 2x1", "half 1x2", "eighth",
+	};
+
+	// The patterns rdm-check and mask-mesh-check run with: the one given by --cluster-size/--levels,
+	// or else every cluster size with level sets that put each level into at least one ring, as far
+	// as the cluster size holds their pattern
+	std::vector<RdmPattern> RdmPatternsToCheck(const Arguments &args, const RdmPattern &given) {
+		if (args.Has("cluster-size") || args.Has("levels")) {
+			return { given };
+		}
+		const std::vector<std::vector<RdmLevel>> levelSets = {
+			{ RdmLevel::HALF, RdmLevel::QUARTER, RdmLevel::SIXTEENTH },
+			{ RdmLevel::HALF_2X1, RdmLevel::HALF_1X2, RdmLevel::QUARTER },
+			{ RdmLevel::HALF_1X2, RdmLevel::QUARTER, RdmLevel::EIGHTH },
+			{ RdmLevel::HALF, RdmLevel::QUARTER },
+			{ RdmLevel::QUARTER, RdmLevel::HALF },
+			{ RdmLevel::EIGHTH },
+		};
+		std::vector<RdmPattern> patterns;
+		for (uint32_t clusterSize : { 8u, 4u, 16u }) {
+			for (const std::vector<RdmLevel> &levels : levelSets) {
+				RdmPattern pattern;
+				pattern.clusterSize = clusterSize;
+				pattern.levelCount = (uint32_t)levels.size();
+				std::copy(levels.begin(), levels.end(), pattern.levels);
+				std::string error;
+				if (IsValidRdmPattern(pattern, error)) {
+					patterns.push_back(pattern);
+				}
+			}
+		}
+		return patterns;
+	}
+
+	// Masks one frame as the game would render it with ffr.method RDM and reconstructs it like
+	// D3D11PostProcessor, then scores the result against the unmasked frame.
+	int Rdm(const Arguments &args) {
+		Image input = LoadOrGenerateInput(args);
+		RdmSetup setup = RdmSetupFromArguments(args);
+		RdmReconstructOptions options = RdmOptionsFromArguments(args);
+		Viewport viewport = input.FullViewport();
+		RdmMaskingConstants masking;
+		RdmReconstructConstants reconstruct;
+		SetupRdm(setup, input, viewport, masking, reconstruct);
+
+		std::vector<uint8_t> mask = GenerateRdmMask(masking, viewport);
+		Image masked = input;
+		ApplyRdmMask(masked, viewport, mask, Rgba{0, 0, 0, 0});
+		Image output (input.width, input.height);
+		auto start = std::chrono::steady_clock::now();
+		RdmReconstruct(masked, viewport, output, reconstruct, options);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		uint32_t modeCount[kRdmReconstructModeCount] = {};
+		for (uint32_t y = 0; y < input.height; ++y) {
+			for (uint32_t x = 0; x < input.width; ++x) {
+				++modeCount[(int)GetRdmReconstructMode(reconstruct, x, y)];
+			}
+		}
+		double pixels = viewport.width * viewport.height;
+		size_t shaded = std::count(mask.begin(), mask.end(), 0);
+		std::printf("RDM %ux%u, %s, %.1f%% of pixels shaded, reconstructed in %.2f ms (%s, %u threads)\n", input.width, input.height,
+			setup.checkerboard ? "checkerboard" : RdmPatternToString(setup.pattern).c_str(), 100.0 * shaded / pixels, ms,
+			options.simd ? SimdName() : "scalar", GetThreadPool(options.threads).ThreadCount());
+		if (setup.checkerboard) {
+			// the checkerboard kernel has no modes besides the copy
+			uint32_t copied = modeCount[(int)RdmReconstructMode::COPY];
+			std::fill(std::begin(modeCount), std::end(modeCount), 0);
+			modeCount[(int)RdmReconstructMode::COPY] = copied;
+			modeCount[(int)RdmReconstructMode::HALF_RES_HIGH] = (uint32_t)pixels - copied;
+		}
+		for (int mode = 0; mode < kRdmReconstructModeCount; ++mode) {
+			if (modeCount[mode] > 0) {
+				std::printf("  %s %.1f%%", setup.checkerboard && mode != 0 ? "checkerboard" : kRdmModeNames[mode], 100.0 * modeCount[mode] / pixels);
+			}
+		}
+		std::printf("\n");
+		ErrorStats errors = CompareImages(input, output, viewport);
+		SsimStats ssim = CompareStructure(input, output, viewport, WeightingFromArguments(args), options.threads);
+		std::printf("  vs unmasked   PSNR %.2f dB  SSIM %.5f  eccentricity weighted SSIM %.5f\n", errors.psnr, ssim.ssim, ssim.weightedSsim);
+		if (args.Has("masked")) {
+			SavePpm(masked, args.Get("masked", "masked.ppm"), 16);
+		}
+		if (setup.phases > 1) {
+			// the still frame rendered over and over, the result is the last reconstruction
+			uint32_t frames = args.GetUint("frames", 2 * setup.phases);
+			output = RdmTemporalFrames(setup, input, viewport, frames, options);
+			errors = CompareImages(input, output, viewport);
+			ssim = CompareStructure(input, output, viewport, WeightingFromArguments(args), options.threads);
+			std::printf("  %u phases, frame %u, history weight %.2f: PSNR %.2f dB  SSIM %.5f  eccentricity weighted SSIM %.5f\n",
+				setup.phases, frames, setup.historyWeight, errors.psnr, ssim.ssim, ssim.weightedSsim);
+		}
+		return SaveAndCheckResult(args, output);
+	}
+
+	// Checks the RDM reconstruction against the mask on synthetic frames: unshaded texels must not
+	// contribute to reconstructed pixels, flat colours must survive, the copied centre must be bit
+	// exact, and the vectorized and threaded paths must match the scalar one. The tile lists of the
+	// indirect dispatch must reproduce the full dispatch exactly. Runs for each of RdmPatternsToCheck.
+	// Temporal RDM is checked in the phases of --phases, all four unless given: each phase must only
+	// read its shaded texels, the phases together must shade every block, and the history must be
+	// clamped away where the scene changed while improving a still one.
+	int RdmCheck(const Arguments &args) {
+		RdmSetup setup = RdmSetupFromArguments(args);
+		std::vector<RdmPattern> patterns = RdmPatternsToCheck(args, setup.pattern);
+		const uint32_t phases = args.Has("phases") ? setup.phases : 4;
+		struct Case {
+			const char *name;
+			uint32_t textureWidth, textureHeight;
+			Viewport viewport;
+			Point<float> projectionCenter;
+		};
+		const Case cases[] = {
+			{ "centred 1440x1600", 1440, 1600, {0, 0, 1440, 1600}, setup.projectionCenter },
+			{ "off-centre 1437x1603", 1437, 1603, {0, 0, 1437, 1603}, {0.42f, 0.55f} },
+			{ "side by side, right eye", 2 * 996, 1100, {996, 0, 996, 1100}, {0.47f, 0.5f} },
+		};
+
+		int failures = 0;
+		auto check = [&](const char *what, size_t errors) {
+			std::printf("  %-44s %s", what, errors == 0 ? "OK\n" : "FAILED");
+			if (errors > 0) {
+				std::printf(" (%zu pixels)\n", errors);
+				++failures;
+			}
+		};
+
+		for (size_t run = 0; run < patterns.size() * std::size(cases); ++run) {
+			const RdmPattern &pattern = patterns[run / std::size(cases)];
+			const Case &c = cases[run % std::size(cases)];
+			RdmSetup caseSetup = setup;
+			caseSetup.projectionCenter = c.projectionCenter;
+			caseSetup.pattern = pattern;
+			const Viewport &vp = c.viewport;
+			Image texture (c.textureWidth, c.textureHeight);
+			RdmMaskingConstants masking;
+			RdmReconstructConstants reconstruct;
+			SetupRdm(caseSetup, texture, vp, masking, reconstruct);
+			std::vector<uint8_t> mask = GenerateRdmMask(masking, vp);
+			auto isMasked = [&](uint32_t x, uint32_t y) { return mask[(y - vp.y) * vp.width + (x - vp.x)] != 0; };
+			auto forEachPixel = [&](const std::function<bool(uint32_t x, uint32_t y, RdmReconstructMode mode)> &fails) {
+				size_t count = 0;
+				for (uint32_t y = vp.y; y < vp.y + vp.height; ++y) {
+					for (uint32_t x = vp.x; x < vp.x + vp.width; ++x) {
+						count += fails(x, y, GetRdmReconstructMode(reconstruct, x, y)) ? 1 : 0;
+					}
+				}
+				return count;
+			};
+			std::printf("%s (%ux%u at %u,%u in %ux%u), %s\n", c.name, vp.width, vp.height, vp.x, vp.y, texture.width, texture.height,
+				RdmPatternToString(pattern).c_str());
+
+			// the modes of the pattern's levels, by RdmLevel, the half level filtering with both the high and the low quality one
+			const RdmReconstructMode levelModes[] = {
+				RdmReconstructMode::HALF_RES_HIGH, RdmReconstructMode::HALF_RES_2X1, RdmReconstructMode::HALF_RES_1X2,
+				RdmReconstructMode::QUARTER_RES, RdmReconstructMode::EIGHTH_RES, RdmReconstructMode::SIXTEENTH_RES,
+			};
+			bool expectedMode[kRdmReconstructModeCount] = { true };
+			for (uint32_t i = 0; i < pattern.levelCount; ++i) {
+				expectedMode[(int)levelModes[(int)pattern.levels[i]]] = true;
+				expectedMode[(int)RdmReconstructMode::HALF_RES_LOW] |= pattern.levels[i] == RdmLevel::HALF;
+			}
+			uint32_t modeCount[kRdmReconstructModeCount] = {};
+			forEachPixel([&](uint32_t, uint32_t, RdmReconstructMode mode) { ++modeCount[(int)mode]; return false; });
+			size_t unexpected = 0;
+			for (int mode = 0; mode < kRdmReconstructModeCount; ++mode) {
+				unexpected += (modeCount[mode] > 0) != expectedMode[mode] ? 1 : 0;
+			}
+			check("exactly the modes of the levels are used", unexpected);
+
+			// shaded texels are zero and unshaded ones not, so any contribution from them shows in the output
+			Image holes (texture.width, texture.height), holesOut (texture.width, texture.height);
+			std::fill(holes.pixels.begin(), holes.pixels.end(), Rgba{0, 0, 0, 0});
+			ApplyRdmMask(holes, vp, mask, Rgba{1, 1, 1, 1});
+			RdmReconstruct(holes, vp, holesOut, reconstruct, RdmReconstructOptions{false, 0, false});
+			check("reconstruction reads shaded texels only", forEachPixel([&](uint32_t x, uint32_t y, RdmReconstructMode mode) {
+				bool copiedHole = mode == RdmReconstructMode::COPY && isMasked(x, y);
+				return holesOut.At(x, y).r != 0 && !copiedHole && mode != RdmReconstructMode::HALF_RES_HIGH;
+			}));
+			// The border fallback to the low quality filter keeps two clusters in x away from the next
+			// ring, which does not cover the diagonal neighbour read by the top left quad of a cluster,
+			// and a half ring reaching the texture border samples the clamped masked texels there.
+			// This is how the shader behaves, so it is reported rather than failed.
+			size_t diagonalHoles = forEachPixel([&](uint32_t x, uint32_t y, RdmReconstructMode mode) {
+				return holesOut.At(x, y).r != 0 && mode == RdmReconstructMode::HALF_RES_HIGH;
+			});
+			std::printf("  %-44s %zu pixels\n", "half res high reads of unshaded diagonals", diagonalHoles);
+
+			// a flat colour must come out unchanged away from the texture border, where texelFetch reads zero
+			const Rgba flat { 0.3f, 0.6f, 0.9f, 1.f };
+			Image flatIn (texture.width, texture.height), flatOut (texture.width, texture.height);
+			std::fill(flatIn.pixels.begin(), flatIn.pixels.end(), flat);
+			ApplyRdmMask(flatIn, vp, mask, Rgba{0, 0, 0, 0});
+			RdmReconstruct(flatIn, vp, flatOut, reconstruct, RdmReconstructOptions{false, 0, false});
+			check("flat colour is reconstructed unchanged", forEachPixel([&](uint32_t x, uint32_t y, RdmReconstructMode mode) {
+				bool border = x < 3 || y < 3 || x + 3 >= texture.width || y + 3 >= texture.height;
+				if (border || (mode == RdmReconstructMode::COPY && isMasked(x, y)) || std::fabs(holesOut.At(x, y).r) > 0)
+					return false;
+				const Rgba &o = flatOut.At(x, y);
+				const float tolerance = 1e-6f;
+				return std::fabs(o.r - flat.r) > tolerance || std::fabs(o.g - flat.g) > tolerance
+					|| std::fabs(o.b - flat.b) > tolerance || std::fabs(o.a - flat.a) > tolerance;
+			}));
+
+			// checkerboard render: the centre is copied as is, vector and threaded runs match the scalar one
+			Image checker = GenerateTestImage(TestPattern::CHECKER, texture.width, texture.height);
+			ApplyRdmMask(checker, vp, mask, Rgba{0, 0, 0, 0});
+			Image scalar (texture.width, texture.height);
+			RdmReconstruct(checker, vp, scalar, reconstruct, RdmReconstructOptions{false, 1, false});
+			check("shaded centre is copied unchanged", forEachPixel([&](uint32_t x, uint32_t y, RdmReconstructMode mode) {
+				return mode == RdmReconstructMode::COPY && !isMasked(x, y) && std::memcmp(&scalar.At(x, y), &checker.At(x, y), sizeof(Rgba)) != 0;
+			}));
+			for (bool unorm : { false, true }) {
+				if (unorm) {
+					RdmReconstruct(checker, vp, scalar, reconstruct, RdmReconstructOptions{true, 1, false});
+				}
+				Image vector (texture.width, texture.height);
+				RdmReconstruct(checker, vp, vector, reconstruct, RdmReconstructOptions{unorm, 0, true});
+				check(unorm ? "SIMD and threads match scalar, UNORM" : "SIMD and threads match scalar, float",
+					forEachPixel([&](uint32_t x, uint32_t y, RdmReconstructMode) {
+						return std::memcmp(&vector.At(x, y), &scalar.At(x, y), sizeof(Rgba)) != 0;
+					}));
+			}
+
+			// Temporal RDM. Every phase reads only its own shaded texels, and the blocks of the half levels
+			// are each shaded in one of 2 phases, those of the quarter level in one of 4. The eighth and
+			// sixteenth levels have more blocks than phases.
+			if (phases > 1) {
+				RdmSetup temporalSetup = caseSetup;
+				temporalSetup.phases = phases;
+				std::vector<uint8_t> everMasked (mask);
+				size_t phaseHoles = 0;
+				for (uint32_t frame = 1; frame < phases; ++frame) {
+					RdmMaskingConstants phaseMasking = masking;
+					RdmReconstructConstants phaseReconstruct = reconstruct;
+					GetRdmPhase(phases, frame, phaseMasking.phase);
+					GetRdmPhase(phases, frame, phaseReconstruct.phase);
+					std::vector<uint8_t> phaseMask = GenerateRdmMask(phaseMasking, vp);
+					for (size_t i = 0; i < mask.size(); ++i) {
+						everMasked[i] &= phaseMask[i];
+					}
+					std::fill(holes.pixels.begin(), holes.pixels.end(), Rgba{0, 0, 0, 0});
+					ApplyRdmMask(holes, vp, phaseMask, Rgba{1, 1, 1, 1});
+					RdmReconstruct(holes, vp, holesOut, phaseReconstruct, RdmReconstructOptions{false, 0, false});
+					phaseHoles += forEachPixel([&](uint32_t x, uint32_t y, RdmReconstructMode mode) {
+						bool copiedHole = mode == RdmReconstructMode::COPY && phaseMask[(y - vp.y) * vp.width + (x - vp.x)] != 0;
+						return holesOut.At(x, y).r != 0 && !copiedHole && mode != RdmReconstructMode::HALF_RES_HIGH;
+					});
+				}
+				check("every phase reads its shaded texels only", phaseHoles);
+				check("the phases shade every block in turn", forEachPixel([&](uint32_t x, uint32_t y, RdmReconstructMode mode) {
+					bool halfLevel = mode == RdmReconstructMode::HALF_RES_HIGH || mode == RdmReconstructMode::HALF_RES_LOW
+						|| mode == RdmReconstructMode::HALF_RES_2X1 || mode == RdmReconstructMode::HALF_RES_1X2;
+					bool covered = halfLevel || (phases == 4 && mode == RdmReconstructMode::QUARTER_RES);
+					return covered && everMasked[(y - vp.y) * vp.width + (x - vp.x)] != 0;
+				}));
+
+				// history of another scene, here white, must be clamped to the flat colour of this frame
+				// wherever the frame alone reconstructs it
+				Image stale (texture.width, texture.height), flatTemporal (texture.width, texture.height);
+				std::fill(stale.pixels.begin(), stale.pixels.end(), Rgba{1, 1, 1, 1});
+				RdmReconstructConstants blended = reconstruct;
+				blended.historyWeight = 0.9f;
+				RdmReconstruct(flatIn, vp, flatTemporal, blended, RdmReconstructOptions{false, 0, false}, &stale);
+				check("history of another scene is clamped away", forEachPixel([&](uint32_t x, uint32_t y, RdmReconstructMode) {
+					const Rgba &o = flatOut.At(x, y);
+					bool flatHere = o.r == flat.r && o.g == flat.g && o.b == flat.b && o.a == flat.a;
+					return flatHere && std::memcmp(&flatTemporal.At(x, y), &o, sizeof(Rgba)) != 0;
+				}));
+
+				// a still scene: the pixels masked in the last frame come out closer to the unmasked scene
+				// than without history
+				Image scene = GenerateTestImage(TestPattern::NOISE, texture.width, texture.height);
+				Image sceneMasked = scene, spatial (texture.width, texture.height);
+				ApplyRdmMask(sceneMasked, vp, mask, Rgba{0, 0, 0, 0});
+				RdmReconstruct(sceneMasked, vp, spatial, reconstruct, RdmReconstructOptions{false, 0, true});
+				Image temporal = RdmTemporalFrames(temporalSetup, scene, vp, 2 * phases, RdmReconstructOptions{false, 0, true});
+				double spatialError = 0, temporalError = 0;
+				forEachPixel([&](uint32_t x, uint32_t y, RdmReconstructMode mode) {
+					if (mode != RdmReconstructMode::COPY && isMasked(x, y)) {
+						const Rgba &o = scene.At(x, y), &a = spatial.At(x, y), &b = temporal.At(x, y);
+						spatialError += (a.r - o.r) * (a.r - o.r) + (a.g - o.g) * (a.g - o.g) + (a.b - o.b) * (a.b - o.b);
+						temporalError += (b.r - o.r) * (b.r - o.r) + (b.g - o.g) * (b.g - o.g) + (b.b - o.b) * (b.b - o.b);
+					}
+					return false;
+				});
+				check("history improves a still scene", temporalError < spatialError ? 0 : 1);
+				std::printf("  %-44s %.1f%% of the squared error\n", "masked pixels with history",
+					spatialError > 0 ? 100.0 * temporalError / spatialError : 100.0);
+
+				// vector and threaded runs and the tiled dispatch blend the history like the scalar one
+				RdmReconstructConstants lastPhase = reconstruct;
+				GetRdmPhase(phases, phases - 1, lastPhase.phase);
+				lastPhase.historyWeight = setup.historyWeight;
+				Image scalarBlend (texture.width, texture.height), vectorBlend (texture.width, texture.height), tiledBlend (texture.width, texture.height);
+				RdmReconstruct(sceneMasked, vp, scalarBlend, lastPhase, RdmReconstructOptions{false, 1, false}, &spatial);
+				RdmReconstruct(sceneMasked, vp, vectorBlend, lastPhase, RdmReconstructOptions{false, 0, true}, &spatial);
+				std::vector<uint32_t> tiles;
+				uint32_t groups[3];
+				BuildRdmReconstructTiles(lastPhase, false, tiles, groups);
+				RdmReconstructTiles(sceneMasked, tiledBlend, lastPhase, tiles, RdmReconstructOptions{false, 0, false}, &spatial);
+				check("history blend matches across SIMD and tiles", forEachPixel([&](uint32_t x, uint32_t y, RdmReconstructMode) {
+					return std::memcmp(&vectorBlend.At(x, y), &scalarBlend.At(x, y), sizeof(Rgba)) != 0
+						|| std::memcmp(&tiledBlend.At(x, y), &scalarBlend.At(x, y), sizeof(Rgba)) != 0;
+				}));
+			}
+
+			// The tiled dispatch of the post processor: the full tile list covers the dispatch area once
+			// and the annulus list exactly the clusters that do more than copy. Copying the area and then
+			// reconstructing the annulus tiles must give the result of the full dispatch.
+			const uint32_t clusterSize = pattern.clusterSize;
+			Viewport area = RdmDispatchArea(texture, vp, clusterSize);
+			auto inArea = [&](uint32_t x, uint32_t y) { return x >= area.x && y >= area.y && x < area.x + area.width && y < area.y + area.height; };
+			auto forEachTexel = [&](const std::function<bool(uint32_t x, uint32_t y)> &fails) {
+				size_t count = 0;
+				for (uint32_t y = 0; y < texture.height; ++y) {
+					for (uint32_t x = 0; x < texture.width; ++x) {
+						count += fails(x, y) ? 1 : 0;
+					}
+				}
+				return count;
+			};
+			auto coverage = [&](const std::vector<uint32_t> &tiles, const uint32_t groups[3]) {
+				std::vector<uint8_t> cover (texture.width * texture.height);
+				bool argumentsMatch = groups[0] <= kRdmTilesPerRow && groups[0] * groups[1] * groups[2] == tiles.size();
+				for (uint32_t tile : tiles) {
+					if (tile == kRdmNoTile) {
+						continue;
+					}
+					uint32_t tx = (tile & 0xffff) * clusterSize, ty = (tile >> 16) * clusterSize;
+					for (uint32_t y = ty; y < ty + clusterSize && y < texture.height; ++y) {
+						for (uint32_t x = tx; x < tx + clusterSize && x < texture.width; ++x) {
+							cover[y * texture.width + x] += inArea(x, y) ? 1 : 0;
+						}
+					}
+				}
+				return argumentsMatch ? cover : std::vector<uint8_t>();
+			};
+			std::vector<uint32_t> allTiles, annulusTiles;
+			uint32_t allGroups[3], annulusGroups[3];
+			BuildRdmReconstructTiles(reconstruct, false, allTiles, allGroups);
+			BuildRdmReconstructTiles(reconstruct, true, annulusTiles, annulusGroups);
+			std::vector<uint8_t> allCover = coverage(allTiles, allGroups);
+			std::vector<uint8_t> annulusCover = coverage(annulusTiles, annulusGroups);
+			check("dispatch arguments match the tile lists", (allCover.empty() ? 1 : 0) + (annulusCover.empty() ? 1 : 0));
+			if (allCover.empty() || annulusCover.empty()) {
+				continue;
+			}
+			check("all tiles cover the dispatch area once", forEachTexel([&](uint32_t x, uint32_t y) {
+				return allCover[y * texture.width + x] != (inArea(x, y) ? 1 : 0);
+			}));
+			check("annulus tiles cover what is reconstructed", forEachTexel([&](uint32_t x, uint32_t y) {
+				bool reconstructed = inArea(x, y) && GetRdmReconstructMode(reconstruct, x, y) != RdmReconstructMode::COPY;
+				return annulusCover[y * texture.width + x] != (reconstructed ? 1 : 0);
+			}));
+
+			Image full (texture.width, texture.height), allTiled (texture.width, texture.height), copied (texture.width, texture.height);
+			RdmReconstruct(checker, vp, full, reconstruct, RdmReconstructOptions{false, 0, true});
+			RdmReconstructTiles(checker, allTiled, reconstruct, allTiles);
+			forEachTexel([&](uint32_t x, uint32_t y) {
+				if (inArea(x, y)) {
+					copied.At(x, y) = checker.At(x, y);
+				}
+				return false;
+			});
+			RdmReconstructTiles(checker, copied, reconstruct, annulusTiles);
+			check("all tiles match the full dispatch", forEachTexel([&](uint32_t x, uint32_t y) {
+				return inArea(x, y) && std::memcmp(&allTiled.At(x, y), &full.At(x, y), sizeof(Rgba)) != 0;
+			}));
+			check("copied area plus annulus tiles match it", forEachTexel([&](uint32_t x, uint32_t y) {
+				return inArea(x, y) && std::memcmp(&copied.At(x, y), &full.At(x, y), sizeof(Rgba)) != 0;
+			}));
+			std::printf("  %-44s %zu of %zu clusters\n", "annulus tiles dispatched",
+				(size_t)std::count_if(annulusTiles.begin(), annulusTiles.end(), [](uint32_t t) { return t != kRdmNoTile; }),
+				(size_t)std::count_if(allTiles.begin(), allTiles.end(), [](uint32_t t) { return t != kRdmNoTile; }));
+		}
+		std::printf("%s\n", failures == 0 ? "All RDM checks passed" : "RDM checks FAILED");
+		return failures == 0 ? 0 : 1;
+	}
+
+	// Checks checkerboard rendering on synthetic frames, over the whole eye and outside the inner
+	// radius: the two frames of the cycle shade complementary blocks, each reconstruction reads only
+	// the texels its frame shaded and leaves flat colours unchanged, the history of another scene is
+	// clamped away while a still scene improves, and the vectorized, threaded and tiled runs match.
+	int CheckerboardCheck(const Arguments &args) {
+		RdmSetup setup = RdmSetupFromArguments(args);
+		struct Case {
+			const char *name;
+			uint32_t textureWidth, textureHeight;
+			Viewport viewport;
+			Point<float> projectionCenter;
+		};
+		const Case cases[] = {
+			{ "centred 1440x1600", 1440, 1600, {0, 0, 1440, 1600}, setup.projectionCenter },
+			{ "off-centre 1437x1603", 1437, 1603, {0, 0, 1437, 1603}, {0.42f, 0.55f} },
+			{ "side by side, right eye", 2 * 996, 1100, {996, 0, 996, 1100}, {0.47f, 0.5f} },
+		};
+
+		int failures = 0;
+		auto check = [&](const char *what, size_t errors) {
+			std::printf("  %-44s %s", what, errors == 0 ? "OK\n" : "FAILED");
+			if (errors > 0) {
+				std::printf(" (%zu pixels)\n", errors);
+				++failures;
+			}
+		};
+		const RdmReconstructOptions scalarOptions { false, 1, false, true };
+		const RdmReconstructOptions vectorOptions { false, 0, true, true };
+
+		for (size_t run = 0; run < 2 * std::size(cases); ++run) {
+			const Case &c = cases[run % std::size(cases)];
+			bool wholeEye = run >= std::size(cases);
+			RdmSetup caseSetup = setup;
+			caseSetup.projectionCenter = c.projectionCenter;
+			SetupCheckerboard(caseSetup, wholeEye);
+			const Viewport &vp = c.viewport;
+			Image texture (c.textureWidth, c.textureHeight);
+			RdmMaskingConstants masking[kCheckerboardPhases];
+			RdmReconstructConstants reconstruct[kCheckerboardPhases];
+			std::vector<uint8_t> masks[kCheckerboardPhases];
+			for (uint32_t frame = 0; frame < kCheckerboardPhases; ++frame) {
+				SetupRdm(caseSetup, texture, vp, masking[frame], reconstruct[frame]);
+				GetRdmPhase(kCheckerboardPhases, frame, masking[frame].phase);
+				GetRdmPhase(kCheckerboardPhases, frame, reconstruct[frame].phase);
+				masks[frame] = GenerateRdmMask(masking[frame], vp);
+			}
+			auto isMasked = [&](uint32_t frame, uint32_t x, uint32_t y) { return masks[frame][(y - vp.y) * vp.width + (x - vp.x)] != 0; };
+			auto forEachPixel = [&](const std::function<bool(uint32_t x, uint32_t y, bool reconstructed)> &fails) {
+				size_t count = 0;
+				for (uint32_t y = vp.y; y < vp.y + vp.height; ++y) {
+					for (uint32_t x = vp.x; x < vp.x + vp.width; ++x) {
+						count += fails(x, y, GetRdmReconstructMode(reconstruct[0], x, y) != RdmReconstructMode::COPY) ? 1 : 0;
+					}
+				}
+				return count;
+			};
+			std::printf("%s (%ux%u at %u,%u in %ux%u), %s\n", c.name, vp.width, vp.height, vp.x, vp.y, texture.width, texture.height,
+				wholeEye ? "whole eye" : "outside the inner radius");
+
+			// in the reconstructed area every pixel is shaded in exactly one of the frames, and outside
+			// of it the mask does not change
+			check("parity alternates between the frames", forEachPixel([&](uint32_t x, uint32_t y, bool reconstructed) {
+				bool edge = RdmDistanceToCenter(reconstruct[0].invClusterResolution, reconstruct[0].projectionCenter,
+					(float)(x / kRdmClusterSize), (float)(y / kRdmClusterSize)) >= reconstruct[0].edgeRadius;
+				if (reconstructed && !edge)
+					return isMasked(0, x, y) == isMasked(1, x, y);
+				return isMasked(0, x, y) != isMasked(1, x, y);
+			}));
+			size_t shaded = forEachPixel([&](uint32_t x, uint32_t y, bool reconstructed) { return reconstructed && !isMasked(0, x, y); });
+			size_t reconstructedPixels = forEachPixel([&](uint32_t, uint32_t, bool reconstructed) { return reconstructed; });
+			std::printf("  %-44s %.1f%% of %zu pixels\n", "shaded in the checkerboard area",
+				reconstructedPixels > 0 ? 100.0 * shaded / reconstructedPixels : 0.0, reconstructedPixels);
+
+			// shaded texels are zero and unshaded ones not, so any contribution from them shows in the output
+			size_t holeReads = 0;
+			Image holes (texture.width, texture.height), holesOut (texture.width, texture.height);
+			for (uint32_t frame = 0; frame < kCheckerboardPhases; ++frame) {
+				std::fill(holes.pixels.begin(), holes.pixels.end(), Rgba{0, 0, 0, 0});
+				ApplyRdmMask(holes, vp, masks[frame], Rgba{1, 1, 1, 1});
+				RdmReconstruct(holes, vp, holesOut, reconstruct[frame], scalarOptions);
+				holeReads += forEachPixel([&](uint32_t x, uint32_t y, bool reconstructed) {
+					return holesOut.At(x, y).r != 0 && (reconstructed || !isMasked(frame, x, y));
+				});
+			}
+			check("every frame reads its shaded texels only", holeReads);
+
+			// a flat colour must come out unchanged everywhere the game shaded anything
+			const Rgba flat { 0.3f, 0.6f, 0.9f, 1.f };
+			Image flatIn (texture.width, texture.height), flatOut (texture.width, texture.height);
+			std::fill(flatIn.pixels.begin(), flatIn.pixels.end(), flat);
+			ApplyRdmMask(flatIn, vp, masks[0], Rgba{0, 0, 0, 0});
+			RdmReconstruct(flatIn, vp, flatOut, reconstruct[0], scalarOptions);
+			auto isFlat = [&](const Rgba &o) {
+				const float tolerance = 1e-6f;
+				return std::fabs(o.r - flat.r) <= tolerance && std::fabs(o.g - flat.g) <= tolerance
+					&& std::fabs(o.b - flat.b) <= tolerance && std::fabs(o.a - flat.a) <= tolerance;
+			};
+			check("flat colour is reconstructed unchanged", forEachPixel([&](uint32_t x, uint32_t y, bool reconstructed) {
+				return (reconstructed || !isMasked(0, x, y)) && !isFlat(flatOut.At(x, y));
+			}));
+
+			// history of another scene, here white, is clamped to the flat colour of this frame
+			Image stale (texture.width, texture.height), flatTemporal (texture.width, texture.height);
+			std::fill(stale.pixels.begin(), stale.pixels.end(), Rgba{1, 1, 1, 1});
+			RdmReconstructConstants blended = reconstruct[0];
+			blended.historyWeight = 0.9f;
+			RdmReconstruct(flatIn, vp, flatTemporal, blended, scalarOptions, &stale);
+			check("history of another scene is clamped away", forEachPixel([&](uint32_t x, uint32_t y, bool reconstructed) {
+				return (reconstructed || !isMasked(0, x, y)) && !isFlat(flatTemporal.At(x, y));
+			}));
+
+			// a still scene: the pixels masked in the last frame come out closer to the unmasked scene
+			// than without history
+			Image scene = GenerateTestImage(TestPattern::NOISE, texture.width, texture.height);
+			const uint32_t last = kCheckerboardPhases - 1;
+			Image sceneMasked = scene, spatial (texture.width, texture.height);
+			ApplyRdmMask(sceneMasked, vp, masks[last], Rgba{0, 0, 0, 0});
+			RdmReconstruct(sceneMasked, vp, spatial, reconstruct[last], vectorOptions);
+			Image temporal = RdmTemporalFrames(caseSetup, scene, vp, 2 * kCheckerboardPhases, vectorOptions);
+			double spatialError = 0, temporalError = 0;
+			forEachPixel([&](uint32_t x, uint32_t y, bool reconstructed) {
+				if (reconstructed && isMasked(last, x, y)) {
+					const Rgba &o = scene.At(x, y), &a = spatial.At(x, y), &b = temporal.At(x, y);
+					spatialError += (a.r - o.r) * (a.r - o.r) + (a.g - o.g) * (a.g - o.g) + (a.b - o.b) * (a.b - o.b);
+					temporalError += (b.r - o.r) * (b.r - o.r) + (b.g - o.g) * (b.g - o.g) + (b.b - o.b) * (b.b - o.b);
+				}
+				return false;
+			});
+			check("history improves a still scene", temporalError < spatialError ? 0 : 1);
+			std::printf("  %-44s %.1f%% of the squared error\n", "masked pixels with history",
+				spatialError > 0 ? 100.0 * temporalError / spatialError : 100.0);
+
+			// vector and threaded runs and the annulus tiles of the post processor match the scalar run
+			RdmReconstructConstants lastFrame = reconstruct[last];
+			lastFrame.historyWeight = caseSetup.historyWeight;
+			Image scalarBlend (texture.width, texture.height), vectorBlend (texture.width, texture.height), tiledBlend (texture.width, texture.height);
+			RdmReconstruct(sceneMasked, vp, scalarBlend, lastFrame, scalarOptions, &spatial);
+			RdmReconstruct(sceneMasked, vp, vectorBlend, lastFrame, vectorOptions, &spatial);
+			Viewport area = RdmDispatchArea(texture, vp, kRdmClusterSize);
+			for (uint32_t y = area.y; y < area.y + area.height; ++y) {
+				for (uint32_t x = area.x; x < area.x + area.width; ++x) {
+					tiledBlend.At(x, y) = sceneMasked.At(x, y);
+				}
+			}
+			std::vector<uint32_t> tiles;
+			uint32_t groups[3];
+			BuildRdmReconstructTiles(lastFrame, true, tiles, groups);
+			RdmReconstructTiles(sceneMasked, tiledBlend, lastFrame, tiles, vectorOptions, &spatial);
+			check("SIMD, threads and annulus tiles match scalar", forEachPixel([&](uint32_t x, uint32_t y, bool) {
+				return std::memcmp(&vectorBlend.At(x, y), &scalarBlend.At(x, y), sizeof(Rgba)) != 0
+					|| std::memcmp(&tiledBlend.At(x, y), &scalarBlend.At(x, y), sizeof(Rgba)) != 0;
+			}));
+		}
+		std::printf("%s\n", failures == 0 ? "All checkerboard checks passed" : "Checkerboard checks FAILED");
+		return failures == 0 ? 0 : 1;
+	}
+
+	// Stands in for a runtime's hidden area mesh: the eye texture past an ellipse around center, as a
+	// triangle list in texture coordinates. Rays from center through the ellipse end on the border,
+	// and each pair of rays spans two triangles; rays to the corners keep the border straight.
+	std::vector<Point<float>> SyntheticHiddenAreaMesh(const Point<float> &center) {
+		const float kPi = 3.14159265f;
+		std::vector<float> angles;
+		for (int i = 0; i < 64; ++i) {
+			angles.push_back(2 * kPi * i / 64);
+		}
+		for (float cx : {0.f, 1.f}) {
+			for (float cy : {0.f, 1.f}) {
+				float angle = std::atan2(cy - center.y, cx - center.x);
+				angles.push_back(angle < 0 ? angle + 2 * kPi : angle);
+			}
+		}
+		std::sort(angles.begin(), angles.end());
+
+		std::vector<Point<float>> inner, outer;
+		for (float angle : angles) {
+			float dx = std::cos(angle), dy = std::sin(angle);
+			// distance along the ray to the border of the texture and to the ellipse
+			float toBorder = std::min(dx > 0 ? (1 - center.x) / dx : dx < 0 ? -center.x / dx : 1e9f,
+				dy > 0 ? (1 - center.y) / dy : dy < 0 ? -center.y / dy : 1e9f);
+			float toEllipse = 1 / std::sqrt(dx * dx / (0.62f * 0.62f) + dy * dy / (0.47f * 0.47f));
+			float t = std::min(toBorder, toEllipse);
+			inner.push_back(Point<float>{ center.x + t * dx, center.y + t * dy });
+			outer.push_back(Point<float>{ center.x + toBorder * dx, center.y + toBorder * dy });
+		}
+		std::vector<Point<float>> triangles;
+		for (size_t i = 0; i < angles.size(); ++i) {
+			size_t next = (i + 1) % angles.size();
+			triangles.insert(triangles.end(), { inner[i], outer[i], outer[next], inner[i], outer[next], inner[next] });
+		}
+		return triangles;
+	}
+
+	// Per pixel of viewport: 1 if its centre lies in one of the triangles, 2 if it is within 0.75
+	// pixels of a triangle's edge, where rounding the vertices to whole pixels may go either way.
+	std::vector<uint8_t> HiddenAreaMeshReference(const std::vector<Point<float>> &triangles, const Viewport &vp, bool flipY) {
+		const float kTolerance = 0.75f;
+		std::vector<uint8_t> inside ((size_t)vp.width * vp.height);
+		for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+			Point<float> p[3];
+			for (int v = 0; v < 3; ++v) {
+				const Point<float> &uv = triangles[i + v];
+				p[v] = Point<float>{ uv.x * vp.width, (flipY ? 1 - uv.y : uv.y) * vp.height };
+			}
+			float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+			if (area == 0) {
+				continue;
+			}
+			int x0 = std::max(0, (int)std::floor(std::min({p[0].x, p[1].x, p[2].x}) - 1));
+			int x1 = std::min((int)vp.width, (int)std::ceil(std::max({p[0].x, p[1].x, p[2].x}) + 1));
+			int y0 = std::max(0, (int)std::floor(std::min({p[0].y, p[1].y, p[2].y}) - 1));
+			int y1 = std::min((int)vp.height, (int)std::ceil(std::max({p[0].y, p[1].y, p[2].y}) + 1));
+			for (int y = y0; y < y1; ++y) {
+				for (int x = x0; x < x1; ++x) {
+					// signed distances of the pixel centre to the edges, positive inside
+					float minDistance = 1e9f;
+					for (int e = 0; e < 3; ++e) {
+						const Point<float> &a = p[e], &b = p[(e + 1) % 3];
+						float length = std::hypot(b.x - a.x, b.y - a.y);
+						float cross = (b.x - a.x) * (y + 0.5f - a.y) - (b.y - a.y) * (x + 0.5f - a.x);
+						minDistance = std::min(minDistance, (area > 0 ? cross : -cross) / std::max(length, 1e-6f));
+					}
+					uint8_t &pixel = inside[(size_t)y * vp.width + x];
+					if (minDistance >= kTolerance) {
+						pixel = 1;
+					} else if (minDistance > -kTolerance && pixel == 0) {
+						pixel = 2;
+					}
+				}
+			}
+		}
+		return inside;
+	}
+
+	// Rasterizes the mask meshes the post processor draws for HRM and RDM and checks that they cover
+	// exactly the pixels IsHrmMasked and IsRdmMasked mask, the logic of the former masking shaders.
+	// Side by side and array targets get one mesh for both eyes, drawn at once. RDM runs for each
+	// of RdmPatternsToCheck, in each phase of --phases, all four unless given. The hidden area mesh
+	// of hiddenMask.mode runs on SyntheticHiddenAreaMesh, alone and together with the radial mask,
+	// against the triangles before rounding; the union may draw pixels twice.
+	int MaskMeshCheck(const Arguments &args) {
+		RdmSetup setup = RdmSetupFromArguments(args);
+		std::vector<RdmPattern> patterns = RdmPatternsToCheck(args, setup.pattern);
+		const uint32_t phases = args.Has("phases") ? setup.phases : 4;
+		struct Case {
+			const char *name;
+			uint32_t targetWidth, targetHeight;
+			int eyeCount;
+			Viewport viewports[2];
+			Point<float> projectionCenters[2];
+			bool arrayTex;
+		};
+		const Case cases[] = {
+			{ "centred 2016x2240", 2016, 2240, 1, { {0, 0, 2016, 2240} }, { setup.projectionCenter }, false },
+			{ "off-centre 1437x1603", 1437, 1603, 1, { {0, 0, 1437, 1603} }, { {0.42f, 0.55f} }, false },
+			{ "side by side 2x997x1101", 2 * 997, 1101, 2, { {0, 0, 997, 1101}, {997, 0, 997, 1101} }, { {0.53f, 0.5f}, {0.47f + 1.f, 0.5f} }, false },
+			{ "array 1441x1599, heads down", 1441, 1599, 2, { {0, 0, 1441, 1599}, {0, 0, 1441, 1599} }, { {0.53f, 0.46f}, {0.47f, 0.46f} }, true },
+		};
+
+		int failures = 0;
+		for (const Case &c : cases) {
+			const size_t rdmRuns = patterns.size() * phases;
+			for (size_t run = 0; run < rdmRuns + 3; ++run) {
+				// the RDM patterns in each phase, then the hidden mask radial, from the mesh and both
+				bool hiddenRadialMask = run >= rdmRuns;
+				HiddenMaskMode mode = run == rdmRuns + 1 ? HiddenMaskMode::AREA_MESH : run == rdmRuns + 2 ? HiddenMaskMode::BOTH : HiddenMaskMode::RADIAL;
+				const RdmPattern &pattern = hiddenRadialMask ? setup.pattern : patterns[run / phases];
+				uint32_t frame = hiddenRadialMask ? 0 : run % phases;
+				RdmMaskingConstants constants[2];
+				std::vector<Point<float>> areaMeshes[2];
+				std::vector<MaskVertex> mesh;
+				size_t eyeStart[3] = {};
+				for (int eye = 0; eye < c.eyeCount; ++eye) {
+					Point<float> center = c.projectionCenters[eye];
+					areaMeshes[eye] = SyntheticHiddenAreaMesh(Point<float>{ center.x - std::floor(center.x), center.y });
+				}
+				auto start = std::chrono::steady_clock::now();
+				for (int eye = 0; eye < c.eyeCount; ++eye) {
+					const Viewport &vp = c.viewports[eye];
+					SetupRdmMaskingConstants(constants[eye], 0.f, hiddenRadialMask ? nullptr : setup.radius, setup.edgeRadius,
+						vp.width, vp.height, c.projectionCenters[eye], c.arrayTex, pattern);
+					if (!hiddenRadialMask) {
+						GetRdmPhase(phases, frame, constants[eye].phase);
+					}
+					// as D3D11PostProcessor::GetMaskMesh
+					if (mode != HiddenMaskMode::AREA_MESH) {
+						std::vector<MaskVertex> eyeMesh = GenerateMaskMesh(constants[eye], vp, hiddenRadialMask);
+						mesh.insert(mesh.end(), eyeMesh.begin(), eyeMesh.end());
+					}
+					if (mode != HiddenMaskMode::RADIAL) {
+						std::vector<MaskVertex> eyeMesh = GenerateHiddenAreaMaskMesh(areaMeshes[eye], vp, constants[eye].yFix[0] < 0);
+						mesh.insert(mesh.end(), eyeMesh.begin(), eyeMesh.end());
+					}
+					eyeStart[eye + 1] = mesh.size();
+				}
+				double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				MaskMeshConstants meshConstants;
+				SetupMaskMeshConstants(meshConstants, 0.f, c.targetWidth, c.targetHeight, (uint32_t)eyeStart[1]);
+
+				// each eye's vertices, to its half of the target or its slice
+				size_t masked = 0, mismatches = 0, overdraw = 0, outside = 0, pixels = 0;
+				for (int eye = 0; eye < c.eyeCount; ++eye) {
+					const Viewport &vp = c.viewports[eye];
+					std::vector<uint8_t> mask;
+					if (mode != HiddenMaskMode::AREA_MESH) {
+						mask = GenerateRdmMask(constants[eye], vp, hiddenRadialMask);
+					} else {
+						mask.assign((size_t)vp.width * vp.height, 0);
+					}
+					if (mode != HiddenMaskMode::RADIAL) {
+						std::vector<uint8_t> area = HiddenAreaMeshReference(areaMeshes[eye], vp, constants[eye].yFix[0] < 0);
+						for (size_t i = 0; i < mask.size(); ++i) {
+							mask[i] = mask[i] != 0 ? 1 : area[i];
+						}
+					}
+					std::vector<uint8_t> coverage = RasterizeMaskMesh(mesh, eyeStart[eye], eyeStart[eye + 1], meshConstants, c.targetWidth, c.targetHeight);
+					for (uint32_t y = 0; y < c.targetHeight; ++y) {
+						for (uint32_t x = 0; x < c.targetWidth; ++x) {
+							bool inside = x >= vp.x && x < vp.x + vp.width && y >= vp.y && y < vp.y + vp.height;
+							uint8_t expected = inside ? mask[(y - vp.y) * vp.width + (x - vp.x)] : 0;
+							uint8_t covered = coverage[y * c.targetWidth + x];
+							masked += covered > 0 ? 1 : 0;
+							outside += !inside && covered > 0 ? 1 : 0;
+							// pixels at the edge of the hidden area mesh may go either way
+							mismatches += expected != 2 && (covered > 0) != (expected != 0) ? 1 : 0;
+							overdraw += covered > 1 ? 1 : 0;
+						}
+					}
+					pixels += (size_t)vp.width * vp.height;
+				}
+				// overlapping meshes are fine for the union, but one mesh should draw each pixel once
+				bool ok = mismatches == 0 && outside == 0 && (mode == HiddenMaskMode::BOTH || overdraw == 0);
+				std::string method = !hiddenRadialMask ? "RDM, " + RdmPatternToString(pattern)
+					: mode == HiddenMaskMode::RADIAL ? "HRM" : mode == HiddenMaskMode::AREA_MESH ? "hidden area mesh" : "hidden area mesh + HRM";
+				if (!hiddenRadialMask && phases > 1) {
+					method += ", phase " + std::to_string(frame);
+				}
+				std::printf("%-30s %-53s %7zu vertices in %6.2f ms, covers %5.2f%% of the pixels: %s", c.name, method.c_str(),
+					mesh.size(), ms, 100.0 * masked / pixels, ok ? "OK" : "FAILED");
+				if (mode == HiddenMaskMode::BOTH) {
+					std::printf(" (%zu pixels drawn twice)", overdraw);
+				}
+				if (!ok) {
+					std::printf(" (%zu mismatches, %zu pixels drawn twice, %zu outside the eye)", mismatches, overdraw, outside);
+					++failures;
+				}
+				std::printf("\n");
+			}
+		}
+		return failures == 0 ? 0 : 1;
+	}
+
+	// bounds of the pixels of a width x height mask whose value is in values
+	Viewport MaskRect(const std::vector<uint8_t> &mask, uint32_t width, uint32_t height, std::initializer_list<uint8_t> values) {
+		uint32_t minX = width, maxX = 0, minY = height, maxY = 0;
+		for (uint32_t y = 0; y < height; ++y) {
+			for (uint32_t x = 0; x < width; ++x) {
+				if (std::find(values.begin(), values.end(), mask[(size_t)y * width + x]) != values.end()) {
+					minX = std::min(minX, x);
+					maxX = std::max(maxX, x + 1);
+					minY = std::min(minY, y);
+					maxY = y + 1;
+				}
+			}
+		}
+		return minX < maxX ? Viewport{ minX, minY, maxX - minX, maxY - minY } : Viewport{ 0, 0, 0, 0 };
+	}
+
+	Viewport MirrorRect(const Viewport &rect, uint32_t width, uint32_t height, bool flipX, bool flipY) {
+		Viewport mirrored = rect;
+		mirrored.x = flipX ? width - rect.x - rect.width : rect.x;
+		mirrored.y = flipY ? height - rect.y - rect.height : rect.y;
+		return mirrored;
+	}
+
+	bool ContainsRect(const Viewport &outer, const Viewport &inner) {
+		return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.width <= outer.x + outer.width
+			&& inner.y + inner.height <= outer.y + outer.height;
+	}
+
+	// Checks the cropping of upscaling.cropToVisible: the visible rect of SyntheticHiddenAreaMesh
+	// against the pixels its triangles leave uncovered, the rect of the edge radius against
+	// IsHrmMasked, and that FSR with the radius test gives the same pixels in the visible part of the
+	// eye when only the crop of CropUpscale is upscaled. Also checks the field of view of a cropped
+	// Oculus viewport.
+	int VisibleBoundsCheck(const Arguments &args) {
+		const float edgeRadius = args.GetFloat("edge-radius", 1.f);
+		const float radius = args.GetFloat("radius", 0.6f);
+		const float sharpness = args.GetFloat("sharpness", 0.3f);
+		struct Case {
+			const char *name;
+			uint32_t textureWidth, textureHeight;
+			Viewport viewport;
+			// in image coordinates, before flipping
+			Point<float> center;
+			bool flipX, flipY;
+		};
+		const Case cases[] = {
+			{ "centred 1024x1152", 1024, 1152, { 0, 0, 1024, 1152 }, { 0.5f, 0.5f }, false, false },
+			{ "off-centre 1001x1133", 1001, 1133, { 0, 0, 1001, 1133 }, { 0.42f, 0.55f }, false, false },
+			{ "side by side, right 2x960x1056", 2 * 960, 1056, { 960, 0, 960, 1056 }, { 0.47f, 0.5f }, false, false },
+			{ "flipped X 1024x1152", 1024, 1152, { 0, 0, 1024, 1152 }, { 0.42f, 0.55f }, true, false },
+			{ "bottom left origin 1024x1152", 1024, 1152, { 0, 0, 1024, 1152 }, { 0.42f, 0.55f }, false, true },
+		};
+		const float scales[] = { 0.5f, 0.75f, 0.8f, 0.77f };
+
+		int failures = 0;
+		for (const Case &c : cases) {
+			const uint32_t width = c.viewport.width, height = c.viewport.height;
+			Point<float> center { c.flipX ? 1 - c.center.x : c.center.x, c.flipY ? 1 - c.center.y : c.center.y };
+			std::vector<Point<float>> triangles = SyntheticHiddenAreaMesh(c.center);
+
+			// every pixel the mesh surely leaves uncovered, and nothing it surely covers
+			Viewport meshRect = HiddenAreaMeshVisibleRect(triangles, width, height, c.flipX, c.flipY);
+			std::vector<uint8_t> covered = HiddenAreaMeshReference(triangles, Viewport{ 0, 0, width, height }, false);
+			Viewport surelyVisible = MirrorRect(MaskRect(covered, width, height, { 0 }), width, height, c.flipX, c.flipY);
+			Viewport maybeVisible = MirrorRect(MaskRect(covered, width, height, { 0, 2 }), width, height, c.flipX, c.flipY);
+			bool meshOk = ContainsRect(meshRect, surelyVisible) && ContainsRect(maybeVisible, meshRect);
+
+			RdmMaskingConstants constants;
+			SetupRdmMaskingConstants(constants, 0.f, nullptr, edgeRadius, width, height, center, false);
+			Viewport edgeRect = EdgeRadiusVisibleRect(center, edgeRadius, width, height);
+			bool edgeOk = edgeRect == MaskRect(GenerateRdmMask(constants, Viewport{ 0, 0, width, height }, true), width, height, { 0 });
+
+			Viewport seen = IntersectRects(meshRect, edgeRect);
+			Viewport visible = GrowRect(seen, 4, width, height);
+			std::printf("%-32s visible %4ux%-4u at %3u,%-3u  mesh %s, edge radius %s\n", c.name, visible.width, visible.height,
+				visible.x, visible.y, meshOk ? "OK" : "FAILED", edgeOk ? "OK" : "FAILED");
+			failures += (meshOk ? 0 : 1) + (edgeOk ? 0 : 1);
+
+			Image input = GenerateTestImage(TestPattern::EDGES, c.textureWidth, c.textureHeight, 7);
+			for (float scale : scales) {
+				Viewport outputViewport { 0, 0, (uint32_t)std::lround(width / scale), (uint32_t)std::lround(height / scale) };
+				UpscaleCrop crop;
+				if (!CropUpscale(c.viewport, outputViewport, visible, center, crop)) {
+					std::printf("  %ux%u -> %ux%u: no crop\n", width, height, outputViewport.width, outputViewport.height);
+					continue;
+				}
+
+				Viewport visibleInput { c.viewport.x + visible.x, c.viewport.y + visible.y, visible.width, visible.height };
+				bool cropOk = ContainsRect(crop.inputViewport, visibleInput) && ContainsRect(c.viewport, crop.inputViewport)
+					&& ContainsRect(outputViewport, crop.outputViewport)
+					&& (uint64_t)crop.outputViewport.width * width == (uint64_t)crop.inputViewport.width * outputViewport.width
+					&& (uint64_t)crop.outputViewport.height * height == (uint64_t)crop.inputViewport.height * outputViewport.height
+					&& (uint64_t)(crop.outputViewport.x - outputViewport.x) * width == (uint64_t)(crop.inputViewport.x - c.viewport.x) * outputViewport.width
+					&& (uint64_t)(crop.outputViewport.y - outputViewport.y) * height == (uint64_t)(crop.inputViewport.y - c.viewport.y) * outputViewport.height;
+
+				// as D3D11FsrUpscaler with the radius test, on the whole eye and on the crop only
+				FsrOptions options;
+				options.radiusTest = true;
+				options.simd = !args.Has("no-simd");
+				options.radius = radius;
+				options.projectionCenter = center;
+				Image full (outputViewport.width, outputViewport.height), fullSharpened (outputViewport.width, outputViewport.height);
+				FsrUpscale(input, c.viewport, full, outputViewport, options);
+				FsrSharpen(full, fullSharpened, outputViewport, sharpness, options);
+				options.radius = radius * crop.radiusScale;
+				options.projectionCenter = crop.projectionCenter;
+				Image cropped (outputViewport.width, outputViewport.height), croppedSharpened (outputViewport.width, outputViewport.height);
+				FsrUpscale(input, crop.inputViewport, cropped, crop.outputViewport, options);
+				FsrSharpen(cropped, croppedSharpened, crop.outputViewport, sharpness, options);
+
+				// the output pixels of the part that can be seen, the margin keeps the taps inside the crop
+				uint32_t x0 = (uint32_t)(((uint64_t)seen.x * outputViewport.width + width - 1) / width);
+				uint32_t x1 = (uint32_t)((uint64_t)(seen.x + seen.width) * outputViewport.width / width);
+				uint32_t y0 = (uint32_t)(((uint64_t)seen.y * outputViewport.height + height - 1) / height);
+				uint32_t y1 = (uint32_t)((uint64_t)(seen.y + seen.height) * outputViewport.height / height);
+				size_t differing = 0;
+				float maxError = 0;
+				for (uint32_t y = y0; y < y1; ++y) {
+					for (uint32_t x = x0; x < x1; ++x) {
+						const Rgba &a = fullSharpened.At(x, y), &b = croppedSharpened.At(x, y);
+						float error = std::max({ std::abs(a.r - b.r), std::abs(a.g - b.g), std::abs(a.b - b.b) });
+						maxError = std::max(maxError, error);
+						differing += error > 0 ? 1 : 0;
+					}
+				}
+				bool pixelsOk = maxError <= 1e-5f;
+				double upscaled = (double)crop.outputViewport.width * crop.outputViewport.height / ((double)outputViewport.width * outputViewport.height);
+				std::printf("  %ux%u -> %ux%u: crop %4ux%-4u at %4u,%-4u, %5.1f%% of the output, max error %.2g in %zu pixels: %s\n",
+					width, height, outputViewport.width, outputViewport.height, crop.outputViewport.width, crop.outputViewport.height,
+					crop.outputViewport.x, crop.outputViewport.y, 100 * upscaled, maxError, differing, cropOk && pixelsOk ? "OK" : "FAILED");
+				failures += cropOk && pixelsOk ? 0 : 1;
+			}
+		}
+
+		// the tangents change linearly across the viewport, so each edge of the crop keeps its angle
+		FovTangents fov { 1.1f, 0.9f, 1.2f, 0.8f };
+		Viewport viewport { 100, 0, 1000, 800 };
+		Viewport crop { 200, 100, 600, 500 };
+		for (bool originAtBottom : { false, true }) {
+			FovTangents cropped = CropFovTangents(fov, viewport, crop, originAtBottom);
+			float top = originAtBottom ? 1 - 600 / 800.f : 100 / 800.f;
+			float bottom = originAtBottom ? 1 - 100 / 800.f : 600 / 800.f;
+			bool ok = std::abs(cropped.left - (1.1f - 0.1f * 2)) < 1e-5f && std::abs(cropped.right - (0.7f * 2 - 1.1f)) < 1e-5f
+				&& std::abs(cropped.up - (1.2f - top * 2)) < 1e-5f && std::abs(cropped.down - (bottom * 2 - 1.2f)) < 1e-5f;
+			std::printf("Cropped field of view%s: %.3f %.3f %.3f %.3f: %s\n", originAtBottom ? ", bottom left origin" : "",
+				cropped.left, cropped.right, cropped.up, cropped.down, ok ? "OK" : "FAILED");
+			failures += ok ? 0 : 1;
+		}
+		std::printf("%s\n", failures == 0 ? "All visible bounds checks passed" : "Visible bounds checks FAILED");
+		return failures == 0 ? 0 : 1;
+	}
+
+	int RdmBench(const Arguments &args) {
+		RdmSetup setup = RdmSetupFromArguments(args);
+		bool unorm = args.Has("unorm");
+		Image masked;
+		RdmReconstructConstants reconstruct;
+		// the reconstruction runs at render resolution, so input and output default to the same size
+		return ThroughputBench(args, "RDM reconstruction", [&](const Image &input, Image &output, bool simd, uint32_t threads) {
+			if (masked.width != input.width || masked.height != input.height) {
+				masked = input;
+				RdmMaskingConstants masking;
+				SetupRdm(setup, masked, masked.FullViewport(), masking, reconstruct);
+				ApplyRdmMask(masked, masked.FullViewport(), GenerateRdmMask(masking, masked.FullViewport()), Rgba{0, 0, 0, 0});
+			}
+			RdmReconstruct(masked, masked.FullViewport(), output, reconstruct, RdmReconstructOptions{unorm, threads, simd});
+		}, 1.f);
+	}
+
+	FoveationSetup FoveationSetupFromArguments(const Arguments &args) {
+		FoveationSetup setup;
+		setup.width = args.GetUint("width", 2016);
+		setup.height = args.GetUint("height", 2240);
+		setup.radii.inner = args.GetFloat("inner-radius", setup.radii.inner);
+		setup.radii.mid = args.GetFloat("mid-radius", setup.radii.mid);
+		setup.radii.outer = args.GetFloat("outer-radius", setup.radii.outer);
+		setup.radii.edge = args.GetFloat("edge-radius", setup.radii.edge);
+		setup.projectionCenter.x = args.GetFloat("center-x", setup.projectionCenter.x);
+		setup.projectionCenter.y = args.GetFloat("center-y", setup.projectionCenter.y);
+		setup.verticalOffset = args.GetFloat("vertical-offset", setup.verticalOffset);
+		setup.vrsTileSize = std::max(1u, args.GetUint("tile-size", setup.vrsTileSize));
+		setup.rdmPattern = RdmPatternFromArguments(args);
+		return setup;
+	}
+
+	std::vector<FoveationMethod> FoveationMethodsFromArguments(const Arguments &args) {
+		if (args.Has("method")) {
+			return { FoveationMethodFromString(args.Get("method", "")) };
+		}
+		return { FoveationMethod::VRS, FoveationMethod::RDM, FoveationMethod::HRM };
+	}
+
+	// Counts the pixels shaded per ring for the foveation methods at one eye resolution, so that the
+	// radii can be tuned without a headset. --verify checks the fast counts against a per pixel count.
+	int Foveation(const Arguments &args) {
+		FoveationSetup setup = FoveationSetupFromArguments(args);
+		std::vector<FoveationMethod> methods = FoveationMethodsFromArguments(args);
+
+		std::printf("Foveation at %ux%u per eye, radii %.3f/%.3f/%.3f, edge %.3f\n", setup.width, setup.height,
+			setup.radii.inner, setup.radii.mid, setup.radii.outer, setup.radii.edge);
+		std::printf("  %-6s %9s %9s %9s %9s %9s %9s %9s %9s\n", "method", "full", "half", "quarter", "16th", "culled", "masked", "shaded", "saved");
+		int failures = 0;
+		for (FoveationMethod method : methods) {
+			setup.method = method;
+			FoveationEstimate estimate = EstimateFoveation(setup);
+			double pixels = (double)estimate.pixels;
+			std::printf("  %-6s %8.2f%% %8.2f%% %8.2f%% %8.2f%% %8.2f%% %8.2f%% %8.2f%% %8.2f%%\n", FoveationMethodToString(method).c_str(),
+				100 * estimate.fullRate / pixels, 100 * estimate.halfRate / pixels, 100 * estimate.quarterRate / pixels,
+				100 * estimate.sixteenthRate / pixels, 100 * estimate.culled / pixels, 100 * estimate.masked / pixels,
+				100 * estimate.ShadedFraction(), 100 * estimate.Savings());
+			if (args.Has("verify")) {
+				FoveationEstimate exact = EstimateFoveationPerPixel(setup);
+				bool ok = exact.fullRate == estimate.fullRate && exact.halfRate == estimate.halfRate && exact.quarterRate == estimate.quarterRate
+					&& exact.sixteenthRate == estimate.sixteenthRate && exact.culled == estimate.culled && exact.masked == estimate.masked
+					&& exact.shaded == estimate.shaded;
+				std::printf("         per pixel count: %s\n", ok ? "OK" : "MISMATCH");
+				failures += ok ? 0 : 1;
+			}
+		}
+		return failures == 0 ? 0 : 1;
+	}
+
+	// Solves the radii that save --savings of the shading work at one eye resolution, as done at init
+	// for fixedFoveated.targetSavings and hiddenMask.targetSavings. The configured radii give the
+	// spacing of the rings. --check solves a range of budgets and checks the results.
+	int FoveationSolve(const Arguments &args) {
+		FoveationSetup setup = FoveationSetupFromArguments(args);
+		std::vector<FoveationMethod> methods = FoveationMethodsFromArguments(args);
+		FoveationBudget budget;
+		budget.targetSavings = args.GetFloat("savings", 0.35f);
+		budget.minRadius = args.GetFloat("min-radius", budget.minRadius);
+		budget.maxRadius = args.GetFloat("max-radius", budget.maxRadius);
+
+		if (!args.Has("check")) {
+			std::printf("Radii saving %.2f%% at %ux%u per eye\n", 100 * budget.targetSavings, setup.width, setup.height);
+			for (FoveationMethod method : methods) {
+				setup.method = method;
+				FoveationRadii radii;
+				bool met = SolveFoveationRadii(setup, budget, radii);
+				FoveationSetup solved = setup;
+				solved.radii = radii;
+				std::printf("  %-6s radii %.4f/%.4f/%.4f, edge %.4f, saves %.2f%%%s\n", FoveationMethodToString(method).c_str(),
+					radii.inner, radii.mid, radii.outer, radii.edge, 100 * EstimateFoveation(solved).Savings(), met ? "" : " (target not reachable)");
+			}
+			return 0;
+		}
+
+		int failures = 0;
+		auto check = [&](bool ok, const char *what, FoveationMethod method, float target) {
+			if (!ok) {
+				std::printf("  FAILED %s for %s at %.2f%%\n", what, FoveationMethodToString(method).c_str(), 100 * target);
+				++failures;
+			}
+		};
+		for (FoveationMethod method : methods) {
+			setup.method = method;
+			float previous = budget.maxRadius;
+			for (float target = 0.f; target <= 0.9f; target += 0.05f) {
+				budget.targetSavings = target;
+				FoveationRadii radii, again;
+				bool met = SolveFoveationRadii(setup, budget, radii);
+				bool metAgain = SolveFoveationRadii(setup, budget, again);
+				check(met == metAgain && std::memcmp(&radii, &again, sizeof(radii)) == 0, "determinism", method, target);
+
+				FoveationSetup solved = setup;
+				solved.radii = radii;
+				double savings = EstimateFoveation(solved).Savings();
+				float radius = method == FoveationMethod::HRM ? radii.edge : radii.inner;
+				if (met) {
+					check(savings >= target, "target savings", method, target);
+				} else {
+					check(radius == budget.minRadius && savings < target, "unreachable target", method, target);
+				}
+				// a larger budget never allows larger radii
+				check(radius <= previous, "monotony", method, target);
+				if (method != FoveationMethod::HRM) {
+					check(std::abs((radii.mid - radii.inner) - (setup.radii.mid - setup.radii.inner)) < 1e-4f
+						&& std::abs((radii.outer - radii.inner) - (setup.radii.outer - setup.radii.inner)) < 1e-4f, "ring spacing", method, target);
+				}
+				previous = radius;
+			}
+			std::printf("  %-6s %s\n", FoveationMethodToString(method).c_str(), failures == 0 ? "OK" : "FAILED");
+		}
+		return failures == 0 ? 0 : 1;
+	}
+
+	// Scores a result image against a reference of the same size, e.g. a native resolution capture.
+	int Compare(const Arguments &args) {
+		if (args.positional.size() != 2) {
+			throw std::invalid_argument("compare needs a reference and a test image");
+		}
+		Image reference = LoadPpm(args.positional[0]);
+		Image test = LoadPpm(args.positional[1]);
+		ErrorStats errors = CompareImages(reference, test, reference.FullViewport());
+		SsimStats ssim = CompareStructure(reference, test, reference.FullViewport(), WeightingFromArguments(args), args.GetUint("threads", 0));
+		std::printf("PSNR %.2f dB  SSIM %.5f  eccentricity weighted SSIM %.5f\n", errors.psnr, ssim.ssim, ssim.weightedSsim);
+		return 0;
+	}
+
+	// Renders a native resolution image at the render scale, upscales it with every method and
+	// scores the results against the native image. With --csv the results are appended to a file,
+	// tagged with --label, to follow quality and cost across releases.
+	int Score(const Arguments &args) {
+		Image native = LoadOrGenerateInput(args);
+		float renderScale = args.GetFloat("scale", 0.77f);
+		float sharpness = args.GetFloat("sharpness", 0.3f);
+		float radius = args.GetFloat("radius", 0.95f);
+		Point<float> projectionCenter { args.GetFloat("center-x", 0.5f), args.GetFloat("center-y", 0.5f) };
+		uint32_t iterations = std::max(1u, args.GetUint("iterations", 1));
+		EccentricityWeighting weighting = WeightingFromArguments(args);
+		FsrOptions fsrOptions = FsrOptionsFromArguments(args);
+		NisOptions nisOptions = NisOptionsFromArguments(args);
+		CasOptions casOptions = CasOptionsFromArguments(args);
+
+		Image input = Downscale(native, (uint32_t)(native.width * renderScale), (uint32_t)(native.height * renderScale));
+		Viewport inVp = input.FullViewport();
+		Image output (native.width, native.height);
+		Viewport outVp = output.FullViewport();
+		Image upscaled (native.width, native.height);
+
+		struct Method {
+			const char *name;
+			std::function<void()> run;
+		};
+		const Method methods[] = {
+			{ "bilinear", [&]() { BilinearUpscale(input, inVp, output, outVp); } },
+			{ "lanczos", [&]() { LanczosUpscale(input, inVp, output, outVp); } },
+			{ "fsr", [&]() {
+				FsrUpscale(input, inVp, upscaled, outVp, fsrOptions);
+				FsrSharpen(upscaled, output, outVp, sharpness, fsrOptions);
+			} },
+			{ "nis", [&]() { RunNis(input, inVp, output, outVp, sharpness, radius, projectionCenter, nisOptions); } },
+			{ "cas", [&]() { CasUpscale(input, inVp, output, outVp, sharpness, casOptions); } },
+		};
+
+		FILE *csv = nullptr;
+		if (args.Has("csv")) {
+			csv = std::fopen(args.Get("csv", "").c_str(), "a");
+			if (csv == nullptr) {
+				throw std::runtime_error("Could not open " + args.Get("csv", ""));
+			}
+		}
+		std::printf("Quality vs native %ux%u, render scale %.2f, sharpness %.2f\n", native.width, native.height, renderScale, sharpness);
+		std::printf("  %-10s %9s %9s %9s %9s\n", "method", "CPU ms", "PSNR", "SSIM", "ew-SSIM");
+		for (const Method &method : methods) {
+			auto start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < iterations; ++i) {
+				method.run();
+			}
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+			ErrorStats errors = CompareImages(native, output, outVp);
+			SsimStats ssim = CompareStructure(native, output, outVp, weighting);
+			std::printf("  %-10s %9.2f %9.2f %9.5f %9.5f\n", method.name, ms, errors.psnr, ssim.ssim, ssim.weightedSsim);
+			if (csv != nullptr) {
+				std::fprintf(csv, "%s,%s,%.3f,%.3f,%.3f,%.4f,%.6f,%.6f\n", args.Get("label", "").c_str(), method.name,
+					renderScale, sharpness, ms, errors.psnr, ssim.ssim, ssim.weightedSsim);
+			}
+		}
+		if (csv != nullptr) {
+			std::fclose(csv);
+		}
+		return 0;
+	}
+
+	// Checks the runtime NIS coefficient generator against the tables shipped in NIS_Config.h
+	// and prints the tables for the requested tap count.
+	int NisCoefficientCheck(const Arguments &args) {
+		// the shipped tables are stored rounded to FP16 with four decimals
+		const float tolerance = 1e-3f;
+
+		NisCoefficients generated = GenerateNisCoefficients();
+		float scalerError = 0, usmError = 0;
+		for (uint32_t phase = 0; phase < kPhaseCount; ++phase) {
+			for (uint32_t tap = 0; tap < kNisCoefficientStride; ++tap) {
+				scalerError = std::max(scalerError, std::abs(generated.ScalerRow(phase)[tap] - coef_scale[phase][tap]));
+				usmError = std::max(usmError, std::abs(generated.UsmRow(phase)[tap] - coef_usm[phase][tap]));
+			}
+		}
+		bool ok = scalerError <= tolerance && usmError <= tolerance;
+		std::printf("6-tap tables vs NIS_Config.h: scaler max error %.6f, USM max error %.6f: %s\n", scalerError, usmError, ok ? "OK" : "MISMATCH");
+
+		uint32_t taps = args.GetUint("taps", 4);
+		NisCoefficients requested = GenerateNisCoefficients(taps);
+		float maxScalerDc = 0, maxUsmDc = 0;
+		for (uint32_t phase = 0; phase < kPhaseCount; ++phase) {
+			float scalerSum = 0, usmSum = 0;
+			for (uint32_t tap = 0; tap < kNisCoefficientStride; ++tap) {
+				scalerSum += requested.ScalerRow(phase)[tap];
+				usmSum += requested.UsmRow(phase)[tap];
+			}
+			maxScalerDc = std::max(maxScalerDc, std::abs(scalerSum - 1));
+			maxUsmDc = std::max(maxUsmDc, std::abs(usmSum));
+		}
+		bool normalized = maxScalerDc <= 1e-5f && maxUsmDc <= 1e-5f;
+		std::printf("%u-tap tables: scaler DC error %.2e, USM DC error %.2e: %s\n", taps, maxScalerDc, maxUsmDc, normalized ? "OK" : "MISMATCH");
+
+		if (args.Has("dump")) {
+			for (uint32_t phase = 0; phase < kPhaseCount; ++phase) {
+				std::printf("%3u ", phase);
+				for (uint32_t tap = 0; tap < kNisMaxFilterTaps; ++tap) {
+					std::printf(" %8.4f", requested.ScalerRow(phase)[tap]);
+				}
+				std::printf("   ");
+				for (uint32_t tap = 0; tap < kNisMaxFilterTaps; ++tap) {
+					std::printf(" %8.4f", requested.UsmRow(phase)[tap]);
+				}
+				std::printf("\n");
+			}
+		}
+		return ok && normalized ? 0 : 1;
+	}
+
+	// Stands in for a D3D11 texture: destroying one and creating another may reuse its address, as
+	// the allocator does, which only the generation tells apart.
+	struct FakeResource {
+		uint32_t generation = 0;
+		bool alive = true;
+	};
+
+	// as D3D11ResourceLifetime, with the generation in place of the private data tracker
+	struct FakeResourceLifetime {
+		typedef uint32_t Token;
+		static Token Track(FakeResource *resource) { return resource->generation; }
+		static bool IsCurrent(FakeResource *resource, const Token &token) { return resource->alive && resource->generation == token; }
+	};
+
+	void Destroy(FakeResource &resource) {
+		resource.alive = false;
+	}
+
+	void Recreate(FakeResource &resource) {
+		++resource.generation;
+		resource.alive = true;
+	}
+
+	// Checks the view cache against fake resources: its bound, the least recently used eviction,
+	// that views are released when their entry goes, and that a destroyed resource or another one
+	// at the same address gets no views of the old one.
+	int ViewCacheCheck(const Arguments &args) {
+		const size_t capacity = std::max<size_t>(args.GetUint("capacity", 4), 2);
+		// the views hold a reference, as D3D11 views do on their resource
+		typedef std::shared_ptr<uint32_t> FakeViews;
+		ViewCache<FakeResource, FakeViews, FakeResourceLifetime> cache (capacity);
+		std::vector<FakeResource> resources (capacity + 3);
+		int failures = 0;
+		auto check = [&](const char *name, bool ok) {
+			std::printf("%-58s %s\n", name, ok ? "OK" : "FAILED");
+			failures += ok ? 0 : 1;
+		};
+
+		std::vector<std::weak_ptr<uint32_t>> created;
+		for (uint32_t i = 0; i < capacity; ++i) {
+			FakeViews views = std::make_shared<uint32_t>(i);
+			created.push_back(views);
+			cache.Insert(&resources[i], views);
+		}
+		check("entries up to the capacity are kept", cache.Size() == capacity && cache.Evictions() == 0);
+		bool allFound = true;
+		for (uint32_t i = 0; i < capacity; ++i) {
+			FakeViews *views = cache.Find(&resources[i]);
+			allFound = allFound && views != nullptr && **views == i;
+		}
+		check("each resource finds its own views", allFound);
+
+		// resource 0 was used last but one, so 1 goes first
+		cache.Find(&resources[0]);
+		for (uint32_t i = 2; i < capacity; ++i) {
+			cache.Find(&resources[i]);
+		}
+		cache.Insert(&resources[capacity], std::make_shared<uint32_t>(capacity));
+		check("a full cache evicts the least recently used entry", cache.Size() == capacity && cache.Evictions() == 1
+			&& cache.Find(&resources[1]) == nullptr && cache.Find(&resources[0]) != nullptr && cache.Find(&resources[capacity]) != nullptr);
+		check("evicted views are released", created[1].expired() && !created[0].expired());
+
+		// a game recreating its targets every frame keeps the cache bounded
+		for (uint32_t frame = 0; frame < 100; ++frame) {
+			FakeResource &resource = resources[capacity + 1 + frame % 2];
+			Destroy(resource);
+			Recreate(resource);
+			if (cache.Find(&resource) == nullptr) {
+				cache.Insert(&resource, std::make_shared<uint32_t>(frame));
+			}
+		}
+		check("recreated resources stay within the capacity", cache.Size() == capacity);
+
+		// ABA: destroyed, and another resource created at the same address
+		FakeResource &reused = resources[0];
+		std::weak_ptr<uint32_t> oldViews = cache.Insert(&reused, std::make_shared<uint32_t>(999));
+		uint64_t stale = cache.StaleEntries();
+		Destroy(reused);
+		Recreate(reused);
+		check("a new resource at the same address gets no old views", cache.Find(&reused) == nullptr && cache.StaleEntries() == stale + 1);
+		check("the stale entry is dropped and its views released", oldViews.expired() && cache.Size() == capacity - 1);
+		cache.Insert(&reused, std::make_shared<uint32_t>(1000));
+		FakeViews *fresh = cache.Find(&reused);
+		check("the new resource gets new views", fresh != nullptr && **fresh == 1000);
+
+		// destroyed without reuse, as when the address is not handed out again
+		FakeResource &gone = resources[capacity];
+		cache.Insert(&gone, std::make_shared<uint32_t>(capacity));
+		Destroy(gone);
+		check("a destroyed resource gets no views", cache.Find(&gone) == nullptr);
+
+		// inserting for a resource that has an entry replaces it
+		size_t size = cache.Size();
+		cache.Insert(&reused, std::make_shared<uint32_t>(1001));
+		check("inserting again replaces the entry", cache.Size() == size && **cache.Find(&reused) == 1001);
+
+		cache.Clear();
+		check("clearing releases all views", cache.Size() == 0 && std::all_of(created.begin(), created.end(),
+			[](const std::weak_ptr<uint32_t> &views) { return views.expired(); }));
+
+		std::printf("%s\n", failures == 0 ? "All view cache checks passed" : "View cache checks FAILED");
+		return failures == 0 ? 0 : 1;
+	}
+
+	// Checks the hook table the detours look their originals up in while hooks are installed and
+	// removed on another thread, as when a game records deferred contexts on worker threads while
+	// the injector of another device comes and goes. Readers must find every permanent hook with
+	// its original and never see a transient hook with another hook's original.
+	int HookTableCheck(const Arguments &args) {
+		const uint32_t readerCount = std::max(args.GetUint("threads", 4), 1u);
+		const uint32_t rounds = args.GetUint("rounds", 20000);
+		const intptr_t permanentCount = 16, transientCount = 8;
+		// detours at even addresses, originals derived from them, so that each reader can tell a mixup
+		auto hookAddress = [](intptr_t i) { return 0x10000 + 16 * i; };
+		auto originalOf = [](intptr_t hook) { return hook * 3 + 1; };
+
+		hooks::HookTable table;
+		int failures = 0;
+		auto check = [&](const char *name, bool ok) {
+			std::printf("%-58s %s\n", name, ok ? "OK" : "FAILED");
+			failures += ok ? 0 : 1;
+		};
+
+		for (intptr_t i = 0; i < permanentCount; ++i) {
+			intptr_t hook = hookAddress(2 * i);
+			table.Insert(hooks::HookInfo { hook - 1, originalOf(hook), hook });
+		}
+		bool allFound = table.Size() == permanentCount;
+		for (intptr_t i = 0; i < permanentCount; ++i) {
+			const hooks::HookInfo *info = table.Find(hookAddress(2 * i));
+			allFound = allFound && info != nullptr && info->original == originalOf(hookAddress(2 * i));
+		}
+		check("installed hooks are found with their original", allFound);
+		check("unknown hooks are not found", table.Find(hookAddress(1)) == nullptr && table.Find(0) == nullptr);
+
+		hooks::HookInfo replaced { 1, 2, hookAddress(0) };
+		table.Insert(replaced);
+		check("installing a hook again replaces its entry", table.Size() == permanentCount && table.Find(hookAddress(0))->original == 2);
+		table.Insert(hooks::HookInfo { hookAddress(0) - 1, originalOf(hookAddress(0)), hookAddress(0) });
+		check("removing an unknown hook fails", !table.Remove(hookAddress(1)) && table.Size() == permanentCount);
+
+		// transient hooks sit between the permanent ones, so every insert and remove moves entries
+		std::atomic<bool> writing { true };
+		std::atomic<uint64_t> permanentMisses { 0 }, wrongOriginals { 0 }, transientHits { 0 }, lookups { 0 };
+		std::vector<std::thread> readers;
+		for (uint32_t t = 0; t < readerCount; ++t) {
+			readers.emplace_back([&, t]() {
+				uint64_t misses = 0, wrong = 0, hits = 0, count = 0;
+				for (uint32_t i = t; writing.load(std::memory_order_relaxed); ++i, ++count) {
+					intptr_t permanent = hookAddress(2 * (i % permanentCount));
+					const hooks::HookInfo *info = table.Find(permanent);
+					if (info == nullptr) {
+						++misses;
+					} else if (info->original != originalOf(permanent) || info->hook != permanent) {
+						++wrong;
+					}
+					intptr_t transient = hookAddress(2 * (i % transientCount) + 1);
+					if (const hooks::HookInfo *entry = table.Find(transient)) {
+						++hits;
+						wrong += entry->original != originalOf(transient) || entry->hook != transient || entry->target != transient - 1;
+					}
+				}
+				permanentMisses += misses;
+				wrongOriginals += wrong;
+				transientHits += hits;
+				lookups += count;
+			});
+		}
+
+		bool removedAll = true;
+		for (uint32_t round = 0; round < rounds; ++round) {
+			intptr_t transient = hookAddress(2 * (round % transientCount) + 1);
+			table.Insert(hooks::HookInfo { transient - 1, originalOf(transient), transient });
+			if (round % 2 == 1) {
+				removedAll = table.Remove(transient) && removedAll;
+				removedAll = table.Remove(hookAddress(2 * ((round - 1) % transientCount) + 1)) && removedAll;
+			}
+		}
+		writing = false;
+		for (std::thread &reader : readers) {
+			reader.join();
+		}
+
+		std::printf("%llu lookups on %u threads during %u installs, %llu of transient hooks found\n",
+			(unsigned long long)lookups.load(), readerCount, rounds, (unsigned long long)transientHits.load());
+		check("permanent hooks stay found while others change", permanentMisses == 0);
+		check("readers never see a wrong original", wrongOriginals == 0);
+		check("every transient hook could be removed", removedAll && table.Size() == permanentCount);
+
+		table.Clear();
+		check("clearing removes all hooks", table.Size() == 0 && table.Find(hookAddress(2)) == nullptr);
+
+		std::printf("%s\n", failures == 0 ? "All hook table checks passed" : "Hook table checks FAILED");
+		return failures == 0 ? 0 : 1;
+	}
+
+	// as D3D11ResourceLifetime for contexts, with a flag set on release in place of the private data
+	struct FakeContextLifetime {
+		typedef std::shared_ptr<const std::atomic<bool>> Token;
+		static bool IsCurrent(const Token &token) { return token == nullptr || !token->load(std::memory_order_acquire); }
+	};
+
+	// Checks the table the context hooks find their injector in: the primary entry of the immediate
+	// context, the fallback for other contexts and devices, deferred contexts cached as aliases until
+	// they are released, and lookups on several threads while injectors of other devices are created
+	// and destroyed, as when a game recreates its device.
+	int ContextTableCheck(const Arguments &args) {
+		const uint32_t readerCount = std::max(args.GetUint("threads", 4), 1u);
+		const uint32_t rounds = args.GetUint("rounds", 20000);
+		const size_t maxAliases = 3;
+		struct FakeInjector {
+			uint32_t id;
+		};
+		typedef ContextTable<FakeInjector, FakeContextLifetime> Table;
+		typedef std::shared_ptr<std::atomic<bool>> Released;
+		auto track = []() { return std::make_shared<std::atomic<bool>>(false); };
+
+		Table table (maxAliases);
+		// stand-ins for the contexts and devices, only their addresses are used
+		char objects[16];
+		FakeInjector injectors[4] = { { 0 }, { 1 }, { 2 }, { 3 } };
+		int failures = 0;
+		auto check = [&](const char *name, bool ok) {
+			std::printf("%-58s %s\n", name, ok ? "OK" : "FAILED");
+			failures += ok ? 0 : 1;
+		};
+
+		Table::Hit hit;
+		check("an empty table finds nothing", table.Find(&objects[0], &hit) == nullptr && hit == Table::Hit::MISS);
+		table.Insert(&objects[0], &injectors[0], true);
+		table.Insert(&objects[1], &injectors[0]);
+		check("the immediate context is found first", table.Find(&objects[0], &hit) == &injectors[0] && hit == Table::Hit::PRIMARY);
+		check("the device is found in the fallback", table.Find(&objects[1], &hit) == &injectors[0] && hit == Table::Hit::FALLBACK);
+		check("other objects are not found", table.Find(&objects[2], &hit) == nullptr && hit == Table::Hit::MISS);
+
+		table.Insert(&objects[2], &injectors[1], true);
+		table.Insert(&objects[3], &injectors[1]);
+		check("a new injector's context becomes the primary entry", table.Find(&objects[2], &hit) == &injectors[1] && hit == Table::Hit::PRIMARY);
+		check("the previous one is still found", table.Find(&objects[0], &hit) == &injectors[0] && hit == Table::Hit::FALLBACK);
+		table.Remove(&injectors[1]);
+		check("removing an injector removes all its entries", table.Find(&objects[2]) == nullptr && table.Find(&objects[3]) == nullptr && table.Size() == 2);
+		check("the others stay", table.Find(&objects[0]) == &injectors[0] && table.Find(&objects[1]) == &injectors[0]);
+		table.Insert(&objects[0], &injectors[0], true);
+		check("inserting a key again replaces its entry", table.Size() == 2 && table.Find(&objects[0], &hit) == &injectors[0] && hit == Table::Hit::PRIMARY);
+		Released deferred = track();
+		check("a deferred context gets the injector of its device", table.Alias(&objects[12], &objects[1], deferred) == &injectors[0]
+			&& table.Find(&objects[12], &hit) == &injectors[0] && hit == Table::Hit::FALLBACK && table.Aliases() == 1);
+		check("no alias of an object without injector", table.Alias(&objects[13], &objects[14], track()) == nullptr
+			&& table.Find(&objects[13]) == nullptr && table.Aliases() == 1);
+		table.Insert(&objects[14], &injectors[1]);
+		table.Alias(&objects[13], &objects[14], track());
+		table.Remove(&injectors[1]);
+		check("removing an injector removes its deferred contexts", table.Find(&objects[13]) == nullptr && table.Size() == 3 && table.Aliases() == 1);
+
+		// a context of another device created at the address of a released one
+		deferred->store(true);
+		check("a released deferred context is not found", table.Find(&objects[12], &hit) == nullptr && hit == Table::Hit::STALE);
+		table.Insert(&objects[14], &injectors[1]);
+		Released reused = track();
+		check("its address gets the injector of the new context's device", table.Alias(&objects[12], &objects[14], reused) == &injectors[1]
+			&& table.Find(&objects[12], &hit) == &injectors[1] && hit == Table::Hit::FALLBACK && table.Aliases() == 1);
+		reused->store(true);
+		table.Remove(&injectors[1]);
+		check("released deferred contexts are dropped by the next write", table.Aliases() == 0 && table.Size() == 2);
+
+		std::vector<Released> cached;
+		for (size_t i = 0; i < maxAliases + 1; ++i) {
+			cached.push_back(track());
+			table.Alias(&objects[12 + i], &objects[1], cached.back());
+		}
+		check("only deferred contexts count toward the limit", table.Aliases() == maxAliases
+			&& table.Find(&objects[11 + maxAliases]) == &injectors[0] && table.Find(&objects[12 + maxAliases]) == nullptr);
+		check("a full table still returns the injector without caching", table.Alias(&objects[12 + maxAliases], &objects[1], track()) == &injectors[0]
+			&& table.Size() == 2 + maxAliases);
+		cached[0]->store(true);
+		check("a released alias makes room for another", table.Alias(&objects[12 + maxAliases], &objects[1], cached.back()) == &injectors[0]
+			&& table.Aliases() == maxAliases && table.Find(&objects[12]) == nullptr && table.Find(&objects[12 + maxAliases]) == &injectors[0]);
+		for (const Released &released : cached) {
+			released->store(true);
+		}
+		table.Insert(&objects[0], &injectors[0], true);
+		check("only the injector's own objects are left", table.Aliases() == 0 && table.Size() == 2);
+
+		// the replaced lists, with the time in place of the clock
+		{
+			typedef SnapshotList<uint32_t>::Clock Clock;
+			const size_t keepCount = 4;
+			SnapshotList<uint32_t> snapshots (keepCount, std::chrono::seconds(1));
+			Clock::time_point start = Clock::now();
+			const uint32_t *first = snapshots.Publish(0, start);
+			bool keptInGrace = true;
+			for (uint32_t i = 1; i <= 20; ++i) {
+				keptInGrace = keptInGrace && snapshots.Publish(uint32_t(i), start + std::chrono::milliseconds(10 * i)) != nullptr && snapshots.Size() == i + 1;
+			}
+			check("replaced snapshots are kept within the grace period", keptInGrace && *first == 0);
+			const uint32_t *current = snapshots.Publish(21, start + std::chrono::seconds(2));
+			check("then all but the newest are freed", snapshots.Size() == keepCount + 1 && *current == 21);
+			for (uint32_t i = 22; i < 1000; ++i) {
+				snapshots.Publish(uint32_t(i), start + std::chrono::seconds(i));
+			}
+			check("add and remove cycles keep a bounded number", snapshots.Size() == keepCount + 1);
+		}
+
+		// injector 0 stays, injectors 2 and 3 come and go with keys between and around its own
+		std::atomic<bool> writing { true };
+		std::atomic<uint64_t> misses { 0 }, wrongInjectors { 0 }, transientHits { 0 }, lookups { 0 };
+		std::vector<std::thread> readers;
+		for (uint32_t t = 0; t < readerCount; ++t) {
+			readers.emplace_back([&, t]() {
+				uint64_t missed = 0, wrong = 0, hits = 0, count = 0;
+				for (uint32_t i = t; writing.load(std::memory_order_relaxed); ++i, ++count) {
+					const FakeInjector *injector = table.Find(&objects[i % 2]);
+					if (injector == nullptr) {
+						++missed;
+					} else if (injector->id != 0) {
+						++wrong;
+					}
+					uint32_t transient = 4 + i % 8;
+					if (const FakeInjector *other = table.Find(&objects[transient])) {
+						++hits;
+						wrong += other->id != 2 + (transient - 4) / 4;
+					}
+				}
+				misses += missed;
+				wrongInjectors += wrong;
+				transientHits += hits;
+				lookups += count;
+			});
+		}
+
+		for (uint32_t round = 0; round < rounds; ++round) {
+			FakeInjector &injector = injectors[2 + round % 2];
+			uint32_t first = 4 + 4 * (round % 2);
+			table.Insert(&objects[first], &injector, round % 4 < 2);
+			for (uint32_t key = first + 1; key < first + 4; ++key) {
+				table.Insert(&objects[key], &injector);
+			}
+			if (round % 2 == 1) {
+				table.Remove(&injectors[2]);
+				table.Remove(&injectors[3]);
+			}
+		}
+		writing = false;
+		for (std::thread &reader : readers) {
+			reader.join();
+		}
+
+		std::printf("%llu lookups on %u threads during %u injector changes, %llu of changing injectors found\n",
+			(unsigned long long)lookups.load(), readerCount, rounds, (unsigned long long)transientHits.load());
+		check("a live injector stays found while others change", misses == 0);
+		check("readers never get another object's injector", wrongInjectors == 0);
+		check("only the live injector is left", table.Size() == 2 && table.Find(&objects[4]) == nullptr);
+
+		std::printf("%s\n", failures == 0 ? "All context table checks passed" : "Context table checks FAILED");
+		return failures == 0 ? 0 : 1;
+	}
+
+	// Stand-ins for hooked functions: a detour whose address identifies the hook, and the original
+	// it calls on.
+	typedef uint32_t (*BenchFunction)(uint32_t);
+
+	template<int I>
+	uint32_t BenchOriginal(uint32_t x) {
+		return x * 2654435761u + I;
+	}
+
+	template<int I>
+	uint32_t BenchDetour(uint32_t x) {
+		return x;
+	}
+
+	// the unordered_map the detours looked their originals up in before hook_table.h
+	struct MapLookup {
+		std::unordered_map<intptr_t, intptr_t> originals;
+		template<int I> BenchFunction Get() const {
+			return reinterpret_cast<BenchFunction>(originals.find(reinterpret_cast<intptr_t>(&BenchDetour<I>))->second);
+		}
+	};
+
+	struct TableLookup {
+		hooks::HookTable table;
+		template<int I> BenchFunction Get() const {
+			return reinterpret_cast<BenchFunction>(table.Find(reinterpret_cast<intptr_t>(&BenchDetour<I>))->original);
+		}
+	};
+
+	struct SlotLookup {
+		template<int I> BenchFunction Get() const {
+			return hooks::OriginalSlot<&BenchDetour<I>>::original;
+		}
+	};
+
+	// calls the original of every detour in turn, as a game calling its hooked functions does
+	template<typename Lookup, int... I>
+	double TimeOriginalCalls(const Lookup &lookup, uint32_t iterations, std::integer_sequence<int, I...>, uint32_t &result) {
+		uint32_t x = 1;
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iterations; ++i) {
+			((x = lookup.template Get<I>()(x)), ...);
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		result = x;
+		return ns / ((double)iterations * sizeof...(I));
+	}
+
+	template<int... I>
+	void FillOriginals(MapLookup &map, TableLookup &table, std::integer_sequence<int, I...>) {
+		(map.originals.emplace(reinterpret_cast<intptr_t>(&BenchDetour<I>), reinterpret_cast<intptr_t>(&BenchOriginal<I>)), ...);
+		(table.table.Insert(hooks::HookInfo { 0, reinterpret_cast<intptr_t>(&BenchOriginal<I>), reinterpret_cast<intptr_t>(&BenchDetour<I>) }), ...);
+		((hooks::OriginalSlot<&BenchDetour<I>>::original = &BenchOriginal<I>), ...);
+	}
+
+	// Times how the detours find their original: the hash map lookup they used to do, the hook
+	// table and the per detour slot, for as many hooks as the DLL installs.
+	int HookLookupBench(const Arguments &args) {
+		const uint32_t iterations = args.GetUint("iterations", 2000000);
+		typedef std::make_integer_sequence<int, 16> Hooks;
+		MapLookup map;
+		TableLookup table;
+		FillOriginals(map, table, Hooks());
+
+		uint32_t mapResult, tableResult, slotResult;
+		double mapNs = TimeOriginalCalls(map, iterations, Hooks(), mapResult);
+		double tableNs = TimeOriginalCalls(table, iterations, Hooks(), tableResult);
+		double slotNs = TimeOriginalCalls(SlotLookup(), iterations, Hooks(), slotResult);
+
+		std::printf("%u calls through %u hooks, ns per call including the original:\n", iterations * 16, 16);
+		std::printf("  %-14s %7.2f\n", "hash map", mapNs);
+		std::printf("  %-14s %7.2f\n", "hook table", tableNs);
+		std::printf("  %-14s %7.2f\n", "original slot", slotNs);
+
+		bool same = mapResult == slotResult && tableResult == slotResult;
+		if (!same) {
+			std::printf("The lookups called different originals\n");
+		}
+		return same ? 0 : 1;
+	}
+
+	// Checks the decisions of the automatic upscaler selection for each quality tier on fixed costs,
+	// and that the benchmark cache round-trips and rejects lines it cannot trust.
+	int SelectUpscalerCheck() {
+		int failures = 0;
+		auto check = [&](const char *name, bool ok) {
+			std::printf("%-58s %s\n", name, ok ? "OK" : "FAILED");
+			failures += ok ? 0 : 1;
+		};
+		auto select = [](const std::vector<UpscalerCost> &costs, QualityTier tier, UpscaleMethod expected) {
+			UpscaleMethod selected = UpscaleMethod::FSR;
+			return SelectFastestMethod(costs, tier, selected) && selected == expected;
+		};
+		auto selectsNone = [](const std::vector<UpscalerCost> &costs, QualityTier tier) {
+			UpscaleMethod selected;
+			return !SelectFastestMethod(costs, tier, selected);
+		};
+
+		const std::vector<UpscalerCost> all = {
+			{ UpscaleMethod::FSR, 0.41f }, { UpscaleMethod::NIS, 0.38f }, { UpscaleMethod::CAS, 0.20f }, { UpscaleMethod::LANCZOS, 0.15f },
+		};
+		check("performance takes the cheapest method", select(all, QualityTier::PERFORMANCE, UpscaleMethod::LANCZOS));
+		check("balanced skips lanczos", select(all, QualityTier::BALANCED, UpscaleMethod::CAS));
+		check("quality takes only nis or fsr", select(all, QualityTier::QUALITY, UpscaleMethod::NIS));
+
+		// a method whose measurement failed is left out by the benchmark or has a negative cost
+		const std::vector<UpscalerCost> missing = { { UpscaleMethod::FSR, 0.41f }, { UpscaleMethod::CAS, 0.20f } };
+		check("a missing measurement is not selected", select(missing, QualityTier::PERFORMANCE, UpscaleMethod::CAS)
+			&& select(missing, QualityTier::QUALITY, UpscaleMethod::FSR));
+		const std::vector<UpscalerCost> failed = {
+			{ UpscaleMethod::FSR, 0.41f }, { UpscaleMethod::NIS, -1.f }, { UpscaleMethod::CAS, -1.f }, { UpscaleMethod::LANCZOS, 0.15f },
+		};
+		check("a failed measurement is not selected", select(failed, QualityTier::BALANCED, UpscaleMethod::FSR)
+			&& select(failed, QualityTier::PERFORMANCE, UpscaleMethod::LANCZOS));
+		const std::vector<UpscalerCost> onlyLanczos = { { UpscaleMethod::LANCZOS, 0.15f }, { UpscaleMethod::NIS, -1.f } };
+		check("no method when none meets the tier", selectsNone(onlyLanczos, QualityTier::BALANCED)
+			&& selectsNone(onlyLanczos, QualityTier::QUALITY) && selectsNone({}, QualityTier::PERFORMANCE));
+
+		// entries per adapter, resolution and settings
+		std::vector<std::pair<UpscalerBenchmarkKey, std::vector<UpscalerCost>>> stored;
+		for (uint32_t i = 0; i < 8; ++i) {
+			UpscalerBenchmarkKey key;
+			key.vendorId = i % 2 == 0 ? 0x10de : 0x1002;
+			key.deviceId = 0x2204 + i / 2;
+			key.width = 2016 + 16 * (i % 3);
+			key.height = 2240;
+			key.inputWidth = key.width * 3 / 4;
+			key.inputHeight = key.height * 3 / 4 + i % 2;
+			key.settings = i % 4;
+			std::vector<UpscalerCost> costs = { { UpscaleMethod::FSR, 0.4120f + i }, { UpscaleMethod::CAS, 0.201f } };
+			if (i % 3 != 0) {
+				costs.push_back({ UpscaleMethod::LANCZOS, 0.15f * i });
+			}
+			stored.emplace_back(key, costs);
+		}
+		UpscalerBenchmarkCache cache;
+		for (const auto &entry : stored) {
+			cache.Store(entry.first, entry.second);
+		}
+		std::string serialized = cache.Serialize();
+		UpscalerBenchmarkCache loaded;
+		loaded.Deserialize(serialized);
+		bool roundTrip = loaded.Serialize() == serialized;
+		for (const auto &entry : stored) {
+			const std::vector<UpscalerCost> *costs = loaded.Find(entry.first);
+			roundTrip = roundTrip && costs != nullptr && costs->size() == entry.second.size();
+			for (size_t i = 0; roundTrip && i < costs->size(); ++i) {
+				roundTrip = (*costs)[i].method == entry.second[i].method && std::fabs((*costs)[i].milliseconds - entry.second[i].milliseconds) < 1e-4f;
+			}
+		}
+		check("the cache round-trips every adapter and resolution", roundTrip);
+		UpscalerBenchmarkKey other = stored[0].first;
+		other.inputWidth += 1;
+		bool keyed = loaded.Find(other) == nullptr;
+		other = stored[0].first;
+		other.settings ^= 8;
+		keyed = keyed && loaded.Find(other) == nullptr;
+		check("another input size or setting finds no costs", keyed);
+
+		const std::string header = UpscalerBenchmarkCache().Serialize();
+		const std::string valid = "10de:2204 2016x2240 1552x1724 0 fsr=0.4120 cas=0.2010\n";
+		UpscalerBenchmarkKey validKey;
+		validKey.vendorId = 0x10de;
+		validKey.deviceId = 0x2204;
+		validKey.width = 2016;
+		validKey.height = 2240;
+		validKey.inputWidth = 1552;
+		validKey.inputHeight = 1724;
+		const char *corrupt[] = {
+			"10de:2204 2016x2240 1552x1724 1\n",
+			"10de 2016x2240 1552x1724 2 fsr=0.4120\n",
+			"10de:2204 2016 1552x1724 3 fsr=0.4120\n",
+			"10de:2204 2016x2240 1552x1724 4 fsr=fast\n",
+			"10de:2204 2016x2240 1552x1724 5 dlss=0.3000\n",
+			"10de:2204 2016x2240 1552x1724 6 fsr 0.4120\n",
+			"10de:2204 2016x2240 7 fsr=0.4120\n",
+			"10de:2204 2016x2240 1552x1724 fsr=0.4120\n",
+		};
+		bool rejected = true;
+		for (const char *line : corrupt) {
+			UpscalerBenchmarkCache parsed;
+			parsed.Deserialize(header + line + valid);
+			rejected = rejected && parsed.Find(validKey) != nullptr && parsed.Serialize() == header + valid;
+		}
+		check("corrupt lines are skipped, the others kept", rejected);
+		UpscalerBenchmarkCache oldVersion;
+		oldVersion.Deserialize("# vrperfkit upscaler benchmark cache v1\n10de:2204 2016x2240 0 fsr=0.4120\n" + valid);
+		UpscalerBenchmarkCache noHeader;
+		noHeader.Deserialize(valid);
+		check("a file of another version or without header is ignored", oldVersion.Find(validKey) == nullptr
+			&& oldVersion.Serialize() == header && noHeader.Find(validKey) == nullptr);
+
+		std::printf("%s\n", failures == 0 ? "All upscaler selection checks passed" : "Upscaler selection checks FAILED");
+		return failures == 0 ? 0 : 1;
+	}
+
+	// Runs the automatic upscaler selection on given or cached costs, to check decisions and
+	// cache files written by the DLL without a GPU.
+	int SelectUpscaler(const Arguments &args) {
+		if (args.Has("check")) {
+			return SelectUpscalerCheck();
+		}
+
+		const std::map<std::string, QualityTier> tiers = {
+			{ "performance", QualityTier::PERFORMANCE },
+			{ "balanced", QualityTier::BALANCED },
+			{ "quality", QualityTier::QUALITY },
+		};
+		auto tier = tiers.find(args.Get("tier", "balanced"));
+		if (tier == tiers.end()) {
+			throw std::invalid_argument("unknown quality tier " + args.Get("tier", ""));
+		}
+
+		UpscalerBenchmarkKey key;
+		std::sscanf(args.Get("adapter", "0:0").c_str(), "%x:%x", &key.vendorId, &key.deviceId);
+		key.width = args.GetUint("width", 2016);
+		key.height = args.GetUint("height", 2240);
+		float renderScale = args.GetFloat("scale", 0.77f);
+		key.inputWidth = args.GetUint("input-width", uint32_t(key.width * renderScale));
+		key.inputHeight = args.GetUint("input-height", uint32_t(key.height * renderScale));
+		key.settings = args.GetUint("settings", 0);
+
+		UpscalerBenchmarkCache cache;
+		if (args.Has("cache")) {
+			cache.Load(args.Get("cache", ""));
+		}
+		if (args.Has("costs")) {
+			// parse the costs through the cache format, "fsr=0.41,nis=0.38" becomes a cache entry
+			std::string costs = args.Get("costs", "");
+			std::replace(costs.begin(), costs.end(), ',', ' ');
+			char entry[96];
+			std::snprintf(entry, sizeof(entry), "%04x:%04x %ux%u %ux%u %u ", key.vendorId, key.deviceId, key.width, key.height, key.inputWidth, key.inputHeight, key.settings);
+			UpscalerBenchmarkCache parsed;
+			parsed.Deserialize(UpscalerBenchmarkCache().Serialize() + entry + costs + "\n");
+			if (parsed.Find(key) == nullptr) {
+				throw std::invalid_argument("could not parse costs " + args.Get("costs", ""));
+			}
+			cache.Store(key, *parsed.Find(key));
+			if (args.Has("cache")) {
+				cache.Save(args.Get("cache", ""));
+			}
+		}
+
+		const std::vector<UpscalerCost> *costs = cache.Find(key);
+		if (costs == nullptr) {
+			std::printf("No costs for %04x:%04x at %ux%u from %ux%u\n", key.vendorId, key.deviceId, key.width, key.height, key.inputWidth, key.inputHeight);
+			return 1;
+		}
+		UpscaleMethod selected;
+		if (!SelectFastestMethod(*costs, tier->second, selected)) {
+			std::printf("No method meets the %s quality tier\n", tier->first.c_str());
+			return 1;
+		}
+		const char *names[] = { "fsr", "nis", "cas", "lanczos" };
+		std::printf("%s\n", names[(int)selected]);
+		return 0;
+	}
+
+	void PrintUsage() {
+		std::printf(
+			"Usage: vrperfkit_ref <command> [options]\n"
+			"\n"
+			"Commands:\n"
+			"  bench        Time the CPU reference kernels (--iterations <n>)\n"
+			"  cas          Run CAS on one frame, with the fsr options plus --lanczos; --scale 1 sharpens\n"
+			"  cas-bench    CAS throughput per output resolution (--sizes <w>x<h>,...)\n"
+			"  checkerboard-check  Check checkerboard rendering on synthetic frames, over the whole eye\n"
+			"               and outside the inner radius, with the rdm options\n"
+			"  compare      PSNR, SSIM and eccentricity weighted SSIM of <reference.ppm> <test.ppm>\n"
+			"               (--center-x/-y <f> --inner-radius/--mid-radius/--outer-radius <f>)\n"
+			"  context-table-check  Check the context to injector table, looking injectors up on\n"
+			"               --threads <n> threads while others are created --rounds <n> times\n"
+			"  foveation    Pixels shaded per ring for VRS, RDM and HRM at --width/--height per eye\n"
+			"               (--method <m> --inner-radius/--mid-radius/--outer-radius/--edge-radius <f>\n"
+			"               --center-x/-y <f> --vertical-offset <f> --tile-size <n> --verify and the RDM\n"
+			"               --cluster-size/--levels)\n"
+			"  foveation-solve  Radii that save --savings <f> of the shading work, with the foveation\n"
+			"               options plus --min-radius/--max-radius <f>; --check tests the solver\n"
+			"  fp16-error   Measure the error of the FP16 FSR/CAS path against FP32, failing above\n"
+			"               --max-error <f> (per pixel) or --max-mean-error <f>\n"
+			"  fsr          Run FSR EASU+RCAS on one frame (--radius-test --radius <f> --center-x/-y <f>\n"
+			"               --debug --fp16 --threads <n> --no-simd), check it with --golden <file.ppm>\n"
+			"               and --tolerance <f>, and against one scalar thread with --check-scalar\n"
+			"               (--scalar-tolerance <f>)\n"
+			"  fsr-bench    FSR throughput per output resolution (--sizes <w>x<h>,...)\n"
+			"  hook-lookup-bench  Time how detours find their original: hash map, hook table and\n"
+			"               per detour slot (--iterations <n>)\n"
+			"  hook-table-check  Look installed hooks up on --threads <n> threads while hooks are\n"
+			"               installed and removed --rounds <n> times, as detours do on the game's threads\n"
+			"  mask-mesh-check  Check that the HRM/RDM mask meshes cover exactly the masked pixels,\n"
+			"               with the rdm options; all RDM patterns and 4 phases unless given\n"
+			"  nis          Run the NIS scaler on one frame, with the fsr options plus --hdr --lanczos\n"
+			"               --performance and --combined (both eyes in one texture); --scale 1 sharpens\n"
+			"  nis-bench    NIS throughput per output resolution (--sizes <w>x<h>,...)\n"
+			"  nis-check    Check COMBINED offsets, the radius test and sharpness of NIS on a synthetic\n"
+			"               frame (--pattern --width/--height --radius --center-x/-y --threads --no-simd)\n"
+			"  nis-coef     Check the NIS coefficient generator (--taps <n> [--dump])\n"
+			"  rdm          Mask one frame with the radial density mask and reconstruct it (--inner-radius\n"
+			"               --mid-radius --outer-radius --edge-radius <f> --center-x/-y <f> --unorm\n"
+			"               --threads <n> --no-simd --masked <file.ppm> --cluster-size 4|8|16\n"
+			"               --levels <level>,... of half, half2x1, half1x2, quarter, eighth, sixteenth),\n"
+			"               with --golden as for fsr; --phases 2|4 --history-weight <f> --frames <n>\n"
+			"               reconstruct a still frame with temporal RDM, --checkerboard [--whole-eye]\n"
+			"               with checkerboard rendering\n"
+			"  rdm-bench    RDM reconstruction throughput per resolution (--sizes <w>x<h>,...)\n"
+			"  rdm-check    Check the RDM reconstruction against the mask on synthetic frames, with the\n"
+			"               rdm options; all cluster sizes and level sets unless a pattern is given, and\n"
+			"               temporal RDM in 4 phases unless --phases is given\n"
+			"  score        Downscale a native image by --scale, upscale it with every method and compare,\n"
+			"               with the compare and fsr/nis options; --csv <file> --label <s> appends results\n"
+			"  select-upscaler  Pick the fastest method for --tier from --costs fsr=<ms>,nis=<ms>,...\n"
+			"               and/or a benchmark --cache file (--adapter <vendor:device> --width/--height,\n"
+			"               --scale <f> or --input-width/--input-height, --settings <bits>); --check\n"
+			"               checks the decisions per quality tier and the cache format\n"
+			"  view-cache-check  Check the bounded view cache on fake resources, including eviction and\n"
+			"               resources recreated at the same address (--capacity <n>)\n"
+			"  visible-bounds-check  Check the crop of upscaling.cropToVisible on synthetic hidden area\n"
+			"               meshes (--edge-radius <f> --radius <f> --sharpness <f> --no-simd)\n"
+			"\n"
+			"Common options:\n"
+			"  --input <file.ppm>     input image (binary PPM)\n"
+			"  --pattern <name>       synthetic input: gradient, checker, zoneplate, noise, edges\n"
+			"  --width/--height <n>   size of the synthetic input\n"
+			"  --scale <f>            render scale factor per axis (input / output)\n"
+			"  --sharpness <f>        sharpness as in upscaling.sharpness\n"
+			"  --output <prefix>      write result images with the given file prefix (the file name for fsr)\n");
+	}
+}
+
+int main(int argc, char **argv) {
+	const std::map<std::string, std::function<int(const Arguments&)>> commands = {
+		{ "bench", Bench },
+		{ "cas", Cas },
+		{ "cas-bench", CasBench },
+		{ "checkerboard-check", CheckerboardCheck },
+		{ "compare", Compare },
+		{ "context-table-check", ContextTableCheck },
+		{ "foveation", Foveation },
+		{ "foveation-solve", FoveationSolve },
+		{ "fp16-error", Fp16Error },
+		{ "fsr", Fsr },
+		{ "fsr-bench", FsrBench },
+		{ "hook-lookup-bench", HookLookupBench },
+		{ "hook-table-check", HookTableCheck },
+		{ "mask-mesh-check", MaskMeshCheck },
+		{ "nis", Nis },
+		{ "nis-bench", NisBench },
+		{ "nis-check", NisCheck },
+		{ "nis-coef", NisCoefficientCheck },
+		{ "rdm", Rdm },
+		{ "rdm-bench", RdmBench },
+		{ "rdm-check", RdmCheck },
+		{ "score", Score },
+		{ "select-upscaler", SelectUpscaler },
+		{ "view-cache-check", ViewCacheCheck },
+		{ "visible-bounds-check", VisibleBoundsCheck },
+	};
+
+	if (argc < 2 || commands.count(argv[1]) == 0) {
+		PrintUsage();
+		return 1;
+	}
+
+	try {
+		return commands.at(argv[1])(Arguments(argc, argv, 2));
+	} catch (const std::exception &e) {
+		std::fprintf(stderr, "Error: %s\n", e.what());
+		return 1;
+	}
+}
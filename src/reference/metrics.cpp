@@ -0,0 +1,248 @@
+#include "metrics.h"
+#include "simd.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace vrperfkit {
+	namespace reference {
+		namespace {
+			const int kSsimRadius = 5;
+			const int kSsimWindow = 2 * kSsimRadius + 1;
+			// stabilizing constants for a dynamic range of 1.0
+			const float kSsimC1 = 0.01f * 0.01f;
+			const float kSsimC2 = 0.03f * 0.03f;
+
+			struct GaussianWindow {
+				float weights[kSsimWindow];
+
+				GaussianWindow() {
+					const float sigma = 1.5f;
+					float sum = 0;
+					for (int i = 0; i < kSsimWindow; ++i) {
+						float d = float(i - kSsimRadius);
+						weights[i] = std::exp(-d * d / (2 * sigma * sigma));
+						sum += weights[i];
+					}
+					for (float &w : weights) {
+						w /= sum;
+					}
+				}
+			};
+
+			template<typename T>
+			T LoadValue(const float *p) {
+				if constexpr (std::is_same<T, float>::value) {
+					return *p;
+				} else {
+					return T::Load(p);
+				}
+			}
+
+			template<typename T>
+			void StoreValue(const T &v, float *p) {
+				if constexpr (std::is_same<T, float>::value) {
+					*p = v;
+				} else {
+					v.Store(p);
+				}
+			}
+
+			// the five local moments of the two luma planes, filtered along a row or a column
+			struct Moments {
+				std::vector<float> planes[5];
+
+				Moments(size_t size) {
+					for (auto &plane : planes) {
+						plane.resize(size);
+					}
+				}
+			};
+
+			template<typename T>
+			void FilterRowAt(const float *a, const float *b, const GaussianWindow &window, Moments &out, size_t outIndex) {
+				T muA = T(0.f), muB = T(0.f), aa = T(0.f), bb = T(0.f), ab = T(0.f);
+				for (int k = 0; k < kSsimWindow; ++k) {
+					T w = T(window.weights[k]);
+					T va = LoadValue<T>(a + k);
+					T vb = LoadValue<T>(b + k);
+					muA += w * va;
+					muB += w * vb;
+					aa += w * (va * va);
+					bb += w * (vb * vb);
+					ab += w * (va * vb);
+				}
+				T values[5] = { muA, muB, aa, bb, ab };
+				for (int i = 0; i < 5; ++i) {
+					StoreValue(values[i], &out.planes[i][outIndex]);
+				}
+			}
+
+			template<typename T>
+			T SsimAt(const Moments &in, size_t index, size_t stride, const GaussianWindow &window) {
+				T m[5];
+				for (int i = 0; i < 5; ++i) {
+					m[i] = T(0.f);
+					for (int k = 0; k < kSsimWindow; ++k) {
+						m[i] += T(window.weights[k]) * LoadValue<T>(&in.planes[i][index + k * stride]);
+					}
+				}
+				T muA = m[0], muB = m[1];
+				T varA = m[2] - muA * muA;
+				T varB = m[3] - muB * muB;
+				T covar = m[4] - muA * muB;
+				return ((T(2.f) * muA * muB + T(kSsimC1)) * (T(2.f) * covar + T(kSsimC2)))
+					/ ((muA * muA + muB * muB + T(kSsimC1)) * (varA + varB + T(kSsimC2)));
+			}
+
+			// one row of output values, in vectors of V as far as possible
+			template<typename V>
+			void FilterRow(const float *a, const float *b, const GaussianWindow &window, Moments &out, size_t outIndex, size_t count) {
+				size_t x = 0;
+				if constexpr (V::kLanes > 1) {
+					for (; x + V::kLanes <= count; x += V::kLanes) {
+						FilterRowAt<V>(a + x, b + x, window, out, outIndex + x);
+					}
+				}
+				for (; x < count; ++x) {
+					FilterRowAt<float>(a + x, b + x, window, out, outIndex + x);
+				}
+			}
+
+			template<typename V>
+			void SsimRow(const Moments &in, size_t index, size_t stride, const GaussianWindow &window, float *ssim, size_t count) {
+				size_t x = 0;
+				if constexpr (V::kLanes > 1) {
+					for (; x + V::kLanes <= count; x += V::kLanes) {
+						SsimAt<V>(in, index + x, stride, window).Store(ssim + x);
+					}
+				}
+				for (; x < count; ++x) {
+					ssim[x] = SsimAt<float>(in, index + x, stride, window);
+				}
+			}
+
+			float Luma(const Rgba &c) {
+				return 0.2126f * c.r + 0.7152f * c.g + 0.0722f * c.b;
+			}
+		}
+
+		float EccentricityWeighting::Weight(float fx, float fy) const {
+			float dx = fx - projectionCenter.x;
+			float dy = fy - projectionCenter.y;
+			float squaredDistance = 4 * (dx * dx + dy * dy);
+			if (squaredDistance < innerRadius * innerRadius) {
+				return 1.f;
+			}
+			if (squaredDistance < midRadius * midRadius) {
+				return 0.5f;
+			}
+			if (squaredDistance < outerRadius * outerRadius) {
+				return 0.25f;
+			}
+			return 0.125f;
+		}
+
+		ErrorStats CompareImages(const Image &a, const Image &b, const Viewport &viewport) {
+			if (a.width != b.width || a.height != b.height) {
+				throw std::runtime_error("Cannot compare images of different size");
+			}
+			if (viewport.x + viewport.width > a.width || viewport.y + viewport.height > a.height) {
+				throw std::runtime_error("Comparison viewport exceeds image bounds");
+			}
+
+			ErrorStats stats;
+			double sumAbs = 0;
+			double sumSquared = 0;
+			for (uint32_t y = viewport.y; y < viewport.y + viewport.height; ++y) {
+				for (uint32_t x = viewport.x; x < viewport.x + viewport.width; ++x) {
+					const Rgba &pa = a.At(x, y);
+					const Rgba &pb = b.At(x, y);
+					double diff[3] = { pa.r - pb.r, pa.g - pb.g, pa.b - pb.b };
+					for (double d : diff) {
+						double ad = std::abs(d);
+						stats.maxAbsError = std::max(stats.maxAbsError, ad);
+						sumAbs += ad;
+						sumSquared += d * d;
+					}
+				}
+			}
+
+			double count = 3.0 * viewport.width * viewport.height;
+			if (count == 0) {
+				return stats;
+			}
+			stats.meanAbsError = sumAbs / count;
+			stats.rmse = std::sqrt(sumSquared / count);
+			stats.psnr = stats.rmse > 0 ? 20 * std::log10(1.0 / stats.rmse) : std::numeric_limits<double>::infinity();
+			return stats;
+		}
+
+		SsimStats CompareStructure(const Image &a, const Image &b, const Viewport &viewport, const EccentricityWeighting &weighting, uint32_t threads) {
+			if (a.width != b.width || a.height != b.height) {
+				throw std::runtime_error("Cannot compare images of different size");
+			}
+			if (viewport.x + viewport.width > a.width || viewport.y + viewport.height > a.height) {
+				throw std::runtime_error("Comparison viewport exceeds image bounds");
+			}
+			if (viewport.width < kSsimWindow || viewport.height < kSsimWindow) {
+				throw std::runtime_error("SSIM needs a viewport of at least 11x11 pixels");
+			}
+
+			ThreadPool &pool = GetThreadPool(threads);
+			const GaussianWindow window;
+			const size_t width = viewport.width, height = viewport.height;
+			const size_t outWidth = width - 2 * kSsimRadius, outHeight = height - 2 * kSsimRadius;
+
+			std::vector<float> lumaA (width * height), lumaB (width * height);
+			pool.ParallelFor((uint32_t)height, [&](uint32_t y) {
+				for (size_t x = 0; x < width; ++x) {
+					lumaA[y * width + x] = Luma(a.At(viewport.x + (uint32_t)x, viewport.y + y));
+					lumaB[y * width + x] = Luma(b.At(viewport.x + (uint32_t)x, viewport.y + y));
+				}
+			});
+
+			// separable Gaussian: rows first, then the columns of the row results
+			Moments horizontal (outWidth * height);
+			pool.ParallelFor((uint32_t)height, [&](uint32_t y) {
+				FilterRow<WidestVector>(&lumaA[y * width], &lumaB[y * width], window, horizontal, y * outWidth, outWidth);
+			});
+
+			struct RowSums {
+				double ssim = 0;
+				double weighted = 0;
+				double weights = 0;
+			};
+			std::vector<RowSums> rows (outHeight);
+			pool.ParallelFor((uint32_t)outHeight, [&](uint32_t y) {
+				std::vector<float> ssim (outWidth);
+				SsimRow<WidestVector>(horizontal, y * outWidth, outWidth, window, ssim.data(), outWidth);
+
+				RowSums &sums = rows[y];
+				float fy = float(y + kSsimRadius) / height;
+				for (size_t x = 0; x < outWidth; ++x) {
+					float weight = weighting.Weight(float(x + kSsimRadius) / width, fy);
+					sums.ssim += ssim[x];
+					sums.weighted += weight * ssim[x];
+					sums.weights += weight;
+				}
+			});
+
+			RowSums total;
+			for (const RowSums &row : rows) {
+				total.ssim += row.ssim;
+				total.weighted += row.weighted;
+				total.weights += row.weights;
+			}
+			SsimStats stats;
+			stats.ssim = total.ssim / (double(outWidth) * outHeight);
+			stats.weightedSsim = total.weighted / total.weights;
+			return stats;
+		}
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "image.h"
+
+namespace vrperfkit {
+	namespace reference {
+		struct ErrorStats {
+			double maxAbsError = 0;
+			double meanAbsError = 0;
+			double rmse = 0;
+			// in dB for a peak value of 1.0, infinite for identical images
+			double psnr = 0;
+		};
+
+		// per-channel RGB difference within viewport, alpha is ignored
+		ErrorStats CompareImages(const Image &a, const Image &b, const Viewport &viewport);
+
+		// Weights SSIM by the distance from the projection centre, measured like the fixed foveated
+		// rendering rings (ffr.innerRadius etc.): 2 * the distance in viewport-relative coordinates.
+		// Each ring halves the weight, like the shading rate that ffr applies there.
+		struct EccentricityWeighting {
+			// relative to the viewport
+			Point<float> projectionCenter = {0.5f, 0.5f};
+			float innerRadius = 0.50f;
+			float midRadius = 0.65f;
+			float outerRadius = 0.80f;
+
+			float Weight(float fx, float fy) const;
+		};
+
+		struct SsimStats {
+			// mean SSIM of the luma, with an 11x11 Gaussian window (sigma 1.5)
+			double ssim = 0;
+			// the same, weighted with EccentricityWeighting
+			double weightedSsim = 0;
+		};
+
+		// SSIM over the windows that lie fully within viewport, vectorized and computed on threads
+		// (0 uses all hardware threads)
+		SsimStats CompareStructure(const Image &a, const Image &b, const Viewport &viewport, const EccentricityWeighting &weighting = {}, uint32_t threads = 0);
+	}
+}
@@ -0,0 +1,646 @@
+#include "nis_reference.h"
+#include "lanczos_reference.h"
+#include "simd.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace vrperfkit {
+	namespace reference {
+		namespace {
+			const float kHDRCompressionFactor = 0.282842712f;
+
+			// block sizes from NIS_Upscale.hlsl and NIS_Sharpen.hlsl
+			const uint32_t kBlockWidth = 32;
+			const uint32_t kScalerBlockHeight = 24;
+			const uint32_t kSharpenBlockHeight = 32;
+
+			const int kScalerSupport = 6;
+			const int kSharpenSupport = 5;
+
+			float GetYLinear(const Rgba &c) {
+				return 0.2126f * c.r + 0.7152f * c.g + 0.0722f * c.b;
+			}
+
+			float GetY(const Rgba &c, bool hdr) {
+				return hdr ? std::sqrt(GetYLinear(c)) * kHDRCompressionFactor : GetYLinear(c);
+			}
+
+			// GetEdgeMap for the 3x3 luma neighbourhood p[row][column], weights for 0, 90, 45 and 135 degrees
+			void GetEdgeMap(const float p[3][3], const NISConfig &c, float *weights) {
+				const float g0 = std::abs(p[0][0] + p[0][1] + p[0][2] - p[2][0] - p[2][1] - p[2][2]);
+				const float g45 = std::abs(p[1][0] + p[0][0] + p[0][1] - p[2][1] - p[2][2] - p[1][2]);
+				const float g90 = std::abs(p[0][0] + p[1][0] + p[2][0] - p[0][2] - p[1][2] - p[2][2]);
+				const float g135 = std::abs(p[1][0] + p[2][0] + p[2][1] - p[0][1] - p[0][2] - p[1][2]);
+
+				const float g0_90Max = std::max(g0, g90);
+				const float g0_90Min = std::min(g0, g90);
+				const float g45_135Max = std::max(g45, g135);
+				const float g45_135Min = std::min(g45, g135);
+
+				if (g0_90Max + g45_135Max == 0) {
+					weights[0] = weights[1] = weights[2] = weights[3] = 0;
+					return;
+				}
+
+				float e0_90 = std::min(g0_90Max / (g0_90Max + g45_135Max), 1.0f);
+				float e45_135 = 1.0f - e0_90;
+
+				bool c0_90 = (g0_90Max > (g0_90Min * c.kDetectRatio)) && (g0_90Max > c.kDetectThres) && (g0_90Max > g45_135Min);
+				bool c45_135 = (g45_135Max > (g45_135Min * c.kDetectRatio)) && (g45_135Max > c.kDetectThres) && (g45_135Max > g0_90Min);
+				bool cG0_90 = g0_90Max == g0;
+				bool cG45_135 = g45_135Max == g45;
+
+				float fE0_90 = (c0_90 && c45_135) ? e0_90 : 1.0f;
+				float fE45_135 = (c0_90 && c45_135) ? e45_135 : 1.0f;
+
+				weights[0] = (c0_90 && cG0_90) ? fE0_90 : 0.0f;
+				weights[1] = (c0_90 && !cG0_90) ? fE0_90 : 0.0f;
+				weights[2] = (c45_135 && cG45_135) ? fE45_135 : 0.0f;
+				weights[3] = (c45_135 && !cG45_135) ? fE45_135 : 0.0f;
+			}
+
+			// A value per texel of a region of the input texture, indexed by texture coordinates.
+			template<int Channels>
+			struct Plane {
+				int x0 = 0, y0 = 0;
+				int width = 0, height = 0;
+				std::vector<float> values;
+
+				Plane(int x0, int y0, int width, int height) : x0(x0), y0(y0), width(width), height(height), values(width * height * Channels) {}
+
+				float *At(int x, int y) {
+					return &values[((y - y0) * width + (x - x0)) * Channels];
+				}
+
+				const float *At(int x, int y) const {
+					x = std::clamp(x, x0, x0 + width - 1);
+					y = std::clamp(y, y0, y0 + height - 1);
+					return &values[((y - y0) * width + (x - x0)) * Channels];
+				}
+			};
+
+			// The shaders load luma from clamped texel-centre samples into shared memory per block, and
+			// derive the edge map from it. Neither depends on the block, so both are computed once for
+			// the input viewport plus the border the filters read.
+			struct LumaPlanes {
+				static const int kLumaBorder = 3;
+				static const int kEdgeBorder = 2;
+
+				Plane<1> luma;
+				Plane<4> edges;
+
+				LumaPlanes(const Image &input, const NISConfig &config, bool hdr, ThreadPool &pool)
+					: luma(int(config.kInputViewportOriginX) - kLumaBorder, int(config.kInputViewportOriginY) - kLumaBorder,
+						config.kInputViewportWidth + 2 * kLumaBorder + 1, config.kInputViewportHeight + 2 * kLumaBorder + 1)
+					, edges(int(config.kInputViewportOriginX) - kEdgeBorder, int(config.kInputViewportOriginY) - kEdgeBorder,
+						config.kInputViewportWidth + 2 * kEdgeBorder + 1, config.kInputViewportHeight + 2 * kEdgeBorder + 1) {
+					pool.ParallelFor(luma.height, [&](uint32_t row) {
+						int y = luma.y0 + (int)row;
+						for (int x = luma.x0; x < luma.x0 + luma.width; ++x) {
+							*luma.At(x, y) = GetY(input.LoadClamped(x, y), hdr);
+						}
+					});
+					pool.ParallelFor(edges.height, [&](uint32_t row) {
+						int y = edges.y0 + (int)row;
+						for (int x = edges.x0; x < edges.x0 + edges.width; ++x) {
+							float p[3][3];
+							for (int i = 0; i < 3; ++i) {
+								for (int j = 0; j < 3; ++j) {
+									p[i][j] = Luma(x + j - 1, y + i - 1);
+								}
+							}
+							GetEdgeMap(p, config, edges.At(x, y));
+						}
+					});
+				}
+
+				float Luma(int x, int y) const { return *luma.At(x, y); }
+			};
+
+			template<typename T>
+			struct NisPhase {
+				T scaler[kScalerSupport];
+				T usm[kScalerSupport];
+				// 1 for phases up to half a texel, selects the support used by CalcLTI
+				T lowerHalf;
+			};
+
+			template<typename T>
+			struct NisScalerInput {
+				// 6x6 luma support around the source position, [row][column]
+				T p[kScalerSupport][kScalerSupport];
+				// edge map weights of the 2x2 texels around the source position
+				T edge[2][2][4];
+				T fx, fy;
+				// filter rows for the phases of the normal, 45 and 135 degree filters
+				NisPhase<T> phaseX, phaseY, phase45, phase135;
+			};
+
+			template<typename T>
+			struct NisSharpenInput {
+				T p[kSharpenSupport][kSharpenSupport];
+				T w[4];
+			};
+
+			template<typename T>
+			T CalcLTI(const T p[kScalerSupport], T lowerHalf, const NISConfig &c) {
+				auto selector = lowerHalf > T(0.5f);
+				T sel = Select(selector, p[0], p[3]);
+				const T aMin = Min(Min(p[1], p[2]), sel);
+				const T aMax = Max(Max(p[1], p[2]), sel);
+				sel = Select(selector, p[2], p[5]);
+				const T bMin = Min(Min(p[3], p[4]), sel);
+				const T bMax = Max(Max(p[3], p[4]), sel);
+
+				const T aCont = aMax - aMin;
+				const T bCont = bMax - bMin;
+
+				const T contRatio = Max(aCont, bCont) / (Min(aCont, bCont) + T(c.kEps));
+				return (T(1.0f) - Sat((contRatio - T(c.kMinContrastRatio)) * T(c.kRatioNorm))) * T(c.kContrastBoost);
+			}
+
+			template<typename T>
+			T EvalPoly6(const T pxl[kScalerSupport], const NisPhase<T> &phase, const NISConfig &c, int firstTap, int lastTap) {
+				T y = T(0.f);
+				for (int i = firstTap; i < lastTap; ++i) {
+					y += phase.scaler[i] * pxl[i];
+				}
+				T yUsm = T(0.f);
+				for (int i = firstTap; i < lastTap; ++i) {
+					yUsm += phase.usm[i] * pxl[i];
+				}
+
+				// piece-wise ramp based on luma, scaling sharpening strength and limit
+				const T yScale = T(1.0f) - Sat((y - T(c.kSharpStartY)) * T(c.kSharpScaleY));
+				const T ySharpness = yScale * T(c.kSharpStrengthScale) + T(c.kSharpStrengthMin);
+				yUsm *= ySharpness;
+				const T ySharpnessLimit = (yScale * T(c.kSharpLimitScale) + T(c.kSharpLimitMin)) * y;
+				yUsm = Min(ySharpnessLimit, Max(-ySharpnessLimit, yUsm));
+				// reduce ringing
+				yUsm *= CalcLTI(pxl, phase.lowerHalf, c);
+
+				return y + yUsm;
+			}
+
+			template<typename T>
+			T FilterNormal(const NisScalerInput<T> &in, int firstTap, int lastTap) {
+				T hAcc = T(0.0f);
+				for (int j = firstTap; j < lastTap; ++j) {
+					T vAcc = T(0.0f);
+					for (int i = firstTap; i < lastTap; ++i) {
+						vAcc += in.p[i][j] * in.phaseY.scaler[i];
+					}
+					hAcc += vAcc * in.phaseX.scaler[j];
+				}
+				return hAcc;
+			}
+
+			// Lanes with a zero weight compute the filter, but add nothing, like the skipped branch would.
+			template<typename T>
+			T AddDirFilters(const NisScalerInput<T> &in, const T w[4], const NISConfig &c, int firstTap, int lastTap) {
+				const auto &p = in.p;
+				const T fx = in.fx, fy = in.fy;
+				T f = T(0.f);
+				if (Any(w[0] > T(0.0f))) {
+					// 0 deg filter
+					T interp0Deg[kScalerSupport];
+					for (int i = 0; i < kScalerSupport; ++i) {
+						interp0Deg[i] = Lerp(p[i][2], p[i][3], fx);
+					}
+					f += EvalPoly6(interp0Deg, in.phaseY, c, firstTap, lastTap) * w[0];
+				}
+				if (Any(w[1] > T(0.0f))) {
+					// 90 deg filter
+					T interp90Deg[kScalerSupport];
+					for (int i = 0; i < kScalerSupport; ++i) {
+						interp90Deg[i] = Lerp(p[2][i], p[3][i], fy);
+					}
+					f += EvalPoly6(interp90Deg, in.phaseX, c, firstTap, lastTap) * w[1];
+				}
+				if (Any(w[2] > T(0.0f))) {
+					// 45 deg filter
+					T phaseB45 = T(0.5f) + T(0.5f) * (fx - fy);
+
+					T temp[7];
+					temp[1] = Lerp(p[2][1], p[1][2], phaseB45);
+					temp[3] = Lerp(p[3][2], p[2][3], phaseB45);
+					temp[5] = Lerp(p[4][3], p[3][4], phaseB45);
+					phaseB45 = phaseB45 - T(0.5f);
+					auto positive = phaseB45 >= T(0.f);
+					T weight = Abs(phaseB45);
+					temp[0] = Lerp(p[1][1], Select(positive, p[0][2], p[2][0]), weight);
+					temp[2] = Lerp(p[2][2], Select(positive, p[1][3], p[3][1]), weight);
+					temp[4] = Lerp(p[3][3], Select(positive, p[2][4], p[4][2]), weight);
+					temp[6] = Lerp(p[4][4], Select(positive, p[3][5], p[5][3]), weight);
+
+					auto shift = fx + fy >= T(1.f);
+					T interp45Deg[kScalerSupport];
+					for (int i = 0; i < kScalerSupport; ++i) {
+						interp45Deg[i] = Select(shift, temp[i + 1], temp[i]);
+					}
+					f += EvalPoly6(interp45Deg, in.phase45, c, firstTap, lastTap) * w[2];
+				}
+				if (Any(w[3] > T(0.0f))) {
+					// 135 deg filter
+					T phaseB135 = T(0.5f) * (fx + fy);
+
+					T temp[7];
+					temp[1] = Lerp(p[3][1], p[4][2], phaseB135);
+					temp[3] = Lerp(p[2][2], p[3][3], phaseB135);
+					temp[5] = Lerp(p[1][3], p[2][4], phaseB135);
+					phaseB135 = phaseB135 - T(0.5f);
+					auto positive = phaseB135 >= T(0.f);
+					T weight = Abs(phaseB135);
+					temp[0] = Lerp(p[4][1], Select(positive, p[5][2], p[3][0]), weight);
+					temp[2] = Lerp(p[3][2], Select(positive, p[4][3], p[2][1]), weight);
+					temp[4] = Lerp(p[2][3], Select(positive, p[3][4], p[1][2]), weight);
+					temp[6] = Lerp(p[1][4], Select(positive, p[2][5], p[0][3]), weight);
+
+					auto shift = T(1.f) + (fx - fy) >= T(1.f);
+					T interp135Deg[kScalerSupport];
+					for (int i = 0; i < kScalerSupport; ++i) {
+						interp135Deg[i] = Select(shift, temp[i + 1], temp[i]);
+					}
+					f += EvalPoly6(interp135Deg, in.phase135, c, firstTap, lastTap) * w[3];
+				}
+				return f;
+			}
+
+			// the upscaled luma of one output pixel
+			template<typename T>
+			T ScalePixel(const NisScalerInput<T> &in, const NISConfig &c, int firstTap, int lastTap) {
+				// GetInterpEdgeMap
+				T w[4];
+				for (int k = 0; k < 4; ++k) {
+					T h0 = Lerp(in.edge[0][0][k], in.edge[0][1][k], in.fx);
+					T h1 = Lerp(in.edge[1][0][k], in.edge[1][1][k], in.fx);
+					w[k] = Lerp(h0, h1, in.fy);
+				}
+
+				const T baseWeight = T(1.f) - w[0] - w[1] - w[2] - w[3];
+				T opY = T(0.f);
+				opY += FilterNormal(in, firstTap, lastTap) * baseWeight;
+				opY += AddDirFilters(in, w, c, firstTap, lastTap);
+				return opY;
+			}
+
+			template<typename T>
+			T CalcLTIFast(const T y[kSharpenSupport], const NISConfig &c) {
+				const T aMin = Min(Min(y[0], y[1]), y[2]);
+				const T aMax = Max(Max(y[0], y[1]), y[2]);
+				const T bMin = Min(Min(y[2], y[3]), y[4]);
+				const T bMax = Max(Max(y[2], y[3]), y[4]);
+
+				const T aCont = aMax - aMin;
+				const T bCont = bMax - bMin;
+
+				const T contRatio = Max(aCont, bCont) / (Min(aCont, bCont) + T(c.kEps));
+				return (T(1.0f) - Sat((contRatio - T(c.kMinContrastRatio)) * T(c.kRatioNorm))) * T(c.kContrastBoost);
+			}
+
+			template<typename T>
+			T EvalUSM(const T pxl[kSharpenSupport], T sharpnessStrength, T sharpnessLimit, const NISConfig &c) {
+				T yUsm = T(-0.6001f) * pxl[1] + T(1.2002f) * pxl[2] - T(0.6001f) * pxl[3];
+				yUsm *= sharpnessStrength;
+				yUsm = Min(sharpnessLimit, Max(-sharpnessLimit, yUsm));
+				yUsm *= CalcLTIFast(pxl, c);
+				return yUsm;
+			}
+
+			// the luma change of one sharpened pixel, GetDirUSM weighted by the edge map
+			template<typename T>
+			T SharpenPixel(const NisSharpenInput<T> &in, const NISConfig &c) {
+				const auto &p = in.p;
+				const T scaleY = T(1.0f) - Sat((p[2][2] - T(c.kSharpStartY)) * T(c.kSharpScaleY));
+				const T sharpnessStrength = scaleY * T(c.kSharpStrengthScale) + T(c.kSharpStrengthMin);
+				const T sharpnessLimit = (scaleY * T(c.kSharpLimitScale) + T(c.kSharpLimitMin)) * p[2][2];
+
+				T interp0Deg[kSharpenSupport], interp90Deg[kSharpenSupport];
+				for (int i = 0; i < kSharpenSupport; ++i) {
+					interp0Deg[i] = p[i][2];
+					interp90Deg[i] = p[2][i];
+				}
+				T interp45Deg[kSharpenSupport] = {
+					p[1][1], Lerp(p[2][1], p[1][2], T(0.5f)), p[2][2], Lerp(p[3][2], p[2][3], T(0.5f)), p[3][3],
+				};
+				T interp135Deg[kSharpenSupport] = {
+					p[3][1], Lerp(p[3][2], p[2][1], T(0.5f)), p[2][2], Lerp(p[2][3], p[1][2], T(0.5f)), p[1][3],
+				};
+
+				T usm0 = EvalUSM(interp0Deg, sharpnessStrength, sharpnessLimit, c);
+				T usm90 = EvalUSM(interp90Deg, sharpnessStrength, sharpnessLimit, c);
+				T usm45 = EvalUSM(interp45Deg, sharpnessStrength, sharpnessLimit, c);
+				T usm135 = EvalUSM(interp135Deg, sharpnessStrength, sharpnessLimit, c);
+				return usm0 * in.w[0] + usm90 * in.w[1] + usm45 * in.w[2] + usm135 * in.w[3];
+			}
+
+			// shader conversion of a float coordinate to uint, negative values end up as 0
+			uint32_t ToUint(float f) {
+				return f <= 0 ? 0 : (uint32_t)f;
+			}
+
+			// UAV writes outside the texture are dropped, UNORM targets saturate
+			void Store(Image &output, uint32_t x, uint32_t y, Rgba c, bool hdr) {
+				if (x >= output.width || y >= output.height) {
+					return;
+				}
+				if (!hdr) {
+					c = Rgba{Sat(c.r), Sat(c.g), Sat(c.b), Sat(c.a)};
+				}
+				output.At(x, y) = c;
+			}
+
+			struct NisContext {
+				const Image &input;
+				Image &output;
+				const NISConfig &config;
+				const NisOptions &options;
+				const LumaPlanes &planes;
+				int firstTap;
+				int lastTap;
+				// the coefficient rows as kept in shared memory by the shader
+				NisPhase<float> phases[kPhaseCount];
+
+				NisContext(const Image &input, Image &output, const NISConfig &config, const NisOptions &options, const LumaPlanes &planes)
+						: input(input), output(output), config(config), options(options), planes(planes) {
+					NisCoefficients coefficients = GenerateNisCoefficients(options.filterTaps);
+					firstTap = (kNisMaxFilterTaps - options.filterTaps) / 2;
+					lastTap = firstTap + options.filterTaps;
+					for (int phase = 0; phase < (int)kPhaseCount; ++phase) {
+						for (int i = 0; i < kScalerSupport; ++i) {
+							phases[phase].scaler[i] = coefficients.ScalerRow(phase)[i];
+							phases[phase].usm[i] = coefficients.UsmRow(phase)[i];
+						}
+						phases[phase].lowerHalf = phase <= (int)kPhaseCount / 2 ? 1.f : 0.f;
+					}
+				}
+
+				template<typename T>
+				void LoadPhase(NisPhase<T> &dst, int lane, int phase) const {
+					const NisPhase<float> &src = phases[phase];
+					for (int i = 0; i < kScalerSupport; ++i) {
+						SetLane(dst.scaler[i], lane, src.scaler[i]);
+						SetLane(dst.usm[i], lane, src.usm[i]);
+					}
+					SetLane(dst.lowerHalf, lane, src.lowerHalf);
+				}
+
+				float SrcX(uint32_t dstX) const { return (0.5f + dstX) * config.kScaleX - 0.5f; }
+				float SrcY(uint32_t dstY) const { return (0.5f + dstY) * config.kScaleY - 0.5f; }
+
+				// fills one lane of the kernel input
+				template<typename T>
+				void LoadScalerInput(NisScalerInput<T> &in, int lane, float srcX, float srcY) const {
+					float floorX = std::floor(srcX);
+					float floorY = std::floor(srcY);
+					int ix = (int)floorX + (int)config.kInputViewportOriginX;
+					int iy = (int)floorY + (int)config.kInputViewportOriginY;
+					float fx = srcX - floorX;
+					float fy = srcY - floorY;
+					SetLane(in.fx, lane, fx);
+					SetLane(in.fy, lane, fy);
+
+					for (int i = 0; i < kScalerSupport; ++i) {
+						// the filter supports lie within the plane borders, so rows are read without clamping
+						const float *row = planes.luma.At(ix - 2, iy + i - 2);
+						for (int j = 0; j < kScalerSupport; ++j) {
+							SetLane(in.p[i][j], lane, row[j]);
+						}
+					}
+					for (int i = 0; i < 2; ++i) {
+						for (int j = 0; j < 2; ++j) {
+							const float *edge = planes.edges.At(ix + j, iy + i);
+							for (int k = 0; k < 4; ++k) {
+								SetLane(in.edge[i][j][k], lane, edge[k]);
+							}
+						}
+					}
+
+					LoadPhase(in.phaseX, lane, int(fx * kPhaseCount));
+					LoadPhase(in.phaseY, lane, int(fy * kPhaseCount));
+					float phase45 = fx + fy;
+					if (phase45 >= 1) {
+						phase45 = phase45 - 1;
+					}
+					LoadPhase(in.phase45, lane, int(phase45 * 64));
+					float phase135 = 1 + (fx - fy);
+					if (phase135 >= 1) {
+						phase135 = phase135 - 1;
+					}
+					LoadPhase(in.phase135, lane, int(phase135 * 64));
+				}
+
+				void StoreScaled(float srcX, float srcY, uint32_t dstX, uint32_t dstY, float opY) const {
+					// bilinear tap for chroma, corrected to the filtered luma
+					float u = (srcX + config.kInputViewportOriginX + 0.5f) * config.kSrcNormX;
+					float v = (srcY + config.kInputViewportOriginY + 0.5f) * config.kSrcNormY;
+					Rgba op = input.SampleBilinear(u, v);
+					if (options.hdr) {
+						const float kEps = 1e-4f;
+						const float kNorm = 1.0f / kHDRCompressionFactor;
+						const float opYN = std::max(opY, 0.0f) * kNorm;
+						const float corr = (opYN * opYN + kEps) / (std::max(GetYLinear(op), 0.0f) + kEps);
+						op.r *= corr;
+						op.g *= corr;
+						op.b *= corr;
+					} else {
+						const float corr = opY - GetY(op, false);
+						op.r += corr;
+						op.g += corr;
+						op.b += corr;
+					}
+					Store(output, dstX + config.kOutputViewportOriginX, dstY + config.kOutputViewportOriginY, op, options.hdr);
+				}
+
+				template<typename T>
+				void LoadSharpenInput(NisSharpenInput<T> &in, int lane, uint32_t dstX, uint32_t dstY) const {
+					int x = (int)(dstX + config.kInputViewportOriginX);
+					int y = (int)(dstY + config.kInputViewportOriginY);
+					for (int i = 0; i < kSharpenSupport; ++i) {
+						const float *row = planes.luma.At(x - 2, y + i - 2);
+						for (int j = 0; j < kSharpenSupport; ++j) {
+							SetLane(in.p[i][j], lane, row[j]);
+						}
+					}
+					const float *edge = planes.edges.At(x, y);
+					for (int k = 0; k < 4; ++k) {
+						SetLane(in.w[k], lane, edge[k]);
+					}
+				}
+
+				void StoreSharpened(uint32_t dstX, uint32_t dstY, float oldY, float usmY) const {
+					float u = (dstX + config.kInputViewportOriginX + 0.5f) * config.kSrcNormX;
+					float v = (dstY + config.kInputViewportOriginY + 0.5f) * config.kSrcNormY;
+					Rgba op = input.SampleBilinear(u, v);
+					if (options.hdr) {
+						const float kEps = 1e-4f * kHDRCompressionFactor * kHDRCompressionFactor;
+						const float newY = std::max(oldY + usmY, 0.0f);
+						const float corr = (newY * newY + kEps) / (oldY * oldY + kEps);
+						op.r *= corr;
+						op.g *= corr;
+						op.b *= corr;
+					} else {
+						op.r += usmY;
+						op.g += usmY;
+						op.b += usmY;
+					}
+					Store(output, dstX + config.kOutputViewportOriginX, dstY + config.kOutputViewportOriginY, op, options.hdr);
+				}
+
+				// DirectCopy and LanczosCopy: the whole block, without viewport bounds checks
+				void CopyBlock(uint32_t blockX, uint32_t blockY, uint32_t blockHeight) const {
+					float tint = options.debugMode ? 0.6f : 1.f;
+					for (uint32_t y = 0; y < blockHeight; ++y) {
+						for (uint32_t x = 0; x < kBlockWidth; ++x) {
+							uint32_t dstX = kBlockWidth * blockX + x + config.kOutputViewportOriginX;
+							uint32_t dstY = blockHeight * blockY + y + config.kOutputViewportOriginY;
+							Rgba c;
+							if (options.peripheryLanczos) {
+								c = Lanczos2Sample(input, (dstX + 0.5f) * config.kDstNormX / config.kSrcNormX, (dstY + 0.5f) * config.kDstNormY / config.kSrcNormY);
+							} else {
+								c = input.SampleBilinear(dstX * config.kDstNormX, dstY * config.kDstNormY);
+							}
+							Store(output, dstX, dstY, Rgba{c.r, c.g * tint, c.b * tint, 1.f}, options.hdr);
+						}
+					}
+				}
+
+				// the radius test of the shaders, in the same wrapping uint maths
+				bool InsideRadius(uint32_t blockX, uint32_t blockY, uint32_t blockHeight) const {
+					uint32_t dx = config.projCentre[0] - (blockX * kBlockWidth + kBlockWidth / 2);
+					uint32_t dy = config.projCentre[1] - (blockY * blockHeight + blockHeight / 2);
+					return dx * dx + dy * dy <= config.squaredRadius;
+				}
+			};
+
+			// pixels [x0, x1) of output row dstY, in vectors of V as far as possible
+			template<typename V>
+			void ScaleRow(const NisContext &ctx, uint32_t x0, uint32_t x1, uint32_t dstY) {
+				float srcY = ctx.SrcY(dstY);
+				uint32_t x = x0;
+				if constexpr (V::kLanes > 1) {
+					for (; x + V::kLanes <= x1; x += V::kLanes) {
+						NisScalerInput<V> in;
+						for (int lane = 0; lane < V::kLanes; ++lane) {
+							ctx.LoadScalerInput(in, lane, ctx.SrcX(x + lane), srcY);
+						}
+						float opY[V::kLanes];
+						ScalePixel(in, ctx.config, ctx.firstTap, ctx.lastTap).Store(opY);
+						for (int lane = 0; lane < V::kLanes; ++lane) {
+							ctx.StoreScaled(ctx.SrcX(x + lane), srcY, x + lane, dstY, opY[lane]);
+						}
+					}
+				}
+				for (; x < x1; ++x) {
+					NisScalerInput<float> in;
+					ctx.LoadScalerInput(in, 0, ctx.SrcX(x), srcY);
+					ctx.StoreScaled(ctx.SrcX(x), srcY, x, dstY, ScalePixel(in, ctx.config, ctx.firstTap, ctx.lastTap));
+				}
+			}
+
+			template<typename V>
+			void SharpenRow(const NisContext &ctx, uint32_t x0, uint32_t x1, uint32_t dstY) {
+				uint32_t x = x0;
+				if constexpr (V::kLanes > 1) {
+					for (; x + V::kLanes <= x1; x += V::kLanes) {
+						NisSharpenInput<V> in;
+						for (int lane = 0; lane < V::kLanes; ++lane) {
+							ctx.LoadSharpenInput(in, lane, x + lane, dstY);
+						}
+						float oldY[V::kLanes], usmY[V::kLanes];
+						in.p[2][2].Store(oldY);
+						SharpenPixel(in, ctx.config).Store(usmY);
+						for (int lane = 0; lane < V::kLanes; ++lane) {
+							ctx.StoreSharpened(x + lane, dstY, oldY[lane], usmY[lane]);
+						}
+					}
+				}
+				for (; x < x1; ++x) {
+					NisSharpenInput<float> in;
+					ctx.LoadSharpenInput(in, 0, x, dstY);
+					ctx.StoreSharpened(x, dstY, in.p[2][2], SharpenPixel(in, ctx.config));
+				}
+			}
+
+			template<typename V>
+			void ScaleBlock(const NisContext &ctx, uint32_t blockX, uint32_t blockY) {
+				const NISConfig &c = ctx.config;
+				// the shader skips pixels past the viewports with '>' comparisons, so one extra
+				// column and row is written where the block extends beyond the viewport
+				uint32_t x0 = kBlockWidth * blockX;
+				uint32_t x1 = x0;
+				while (x1 < x0 + kBlockWidth && ToUint(ctx.SrcX(x1)) <= c.kInputViewportWidth && x1 <= c.kOutputViewportWidth) {
+					++x1;
+				}
+				for (uint32_t dstY = kScalerBlockHeight * blockY; dstY < kScalerBlockHeight * (blockY + 1); ++dstY) {
+					if (ToUint(ctx.SrcY(dstY)) > c.kInputViewportHeight || dstY > c.kOutputViewportHeight) {
+						continue;
+					}
+					ScaleRow<V>(ctx, x0, x1, dstY);
+				}
+			}
+
+			template<typename V>
+			void SharpenBlock(const NisContext &ctx, uint32_t blockX, uint32_t blockY) {
+				const NISConfig &c = ctx.config;
+				uint32_t x0 = kBlockWidth * blockX;
+				uint32_t x1 = std::min(x0 + kBlockWidth, c.kOutputViewportWidth + 1);
+				for (uint32_t dstY = kSharpenBlockHeight * blockY; dstY < kSharpenBlockHeight * (blockY + 1); ++dstY) {
+					if (dstY > c.kOutputViewportHeight) {
+						continue;
+					}
+					SharpenRow<V>(ctx, x0, x1, dstY);
+				}
+			}
+
+			template<typename Process>
+			void RunBlocks(const Image &input, Image &output, const NISConfig &config, const NisOptions &options, uint32_t blockHeight, const Process &process) {
+				ThreadPool &pool = GetThreadPool(options.threads);
+				LumaPlanes planes (input, config, options.hdr, pool);
+				NisContext ctx (input, output, config, options, planes);
+
+				uint32_t blocksX = (config.kOutputViewportWidth + kBlockWidth - 1) / kBlockWidth;
+				uint32_t blocksY = (config.kOutputViewportHeight + blockHeight - 1) / blockHeight;
+				pool.ParallelFor(blocksX * blocksY, [&](uint32_t index) {
+					uint32_t blockX = index % blocksX;
+					uint32_t blockY = index / blocksX;
+					if (options.radiusTest && !ctx.InsideRadius(blockX, blockY, blockHeight)) {
+						ctx.CopyBlock(blockX, blockY, blockHeight);
+					} else {
+						process(ctx, blockX, blockY);
+					}
+				});
+			}
+
+			struct ScalarLanes {
+				static constexpr int kLanes = 1;
+			};
+		}
+
+		void NisUpscale(const Image &input, Image &output, const NISConfig &config, const NisOptions &options) {
+			RunBlocks(input, output, config, options, kScalerBlockHeight, [&](const NisContext &ctx, uint32_t blockX, uint32_t blockY) {
+				if (options.simd) {
+					ScaleBlock<WidestVector>(ctx, blockX, blockY);
+				} else {
+					ScaleBlock<ScalarLanes>(ctx, blockX, blockY);
+				}
+			});
+		}
+
+		void NisSharpen(const Image &input, Image &output, const NISConfig &config, const NisOptions &options) {
+			// the sharpen shader has no periphery filter permutation
+			NisOptions sharpenOptions = options;
+			sharpenOptions.peripheryLanczos = false;
+			RunBlocks(input, output, config, sharpenOptions, kSharpenBlockHeight, [&](const NisContext &ctx, uint32_t blockX, uint32_t blockY) {
+				if (options.simd) {
+					SharpenBlock<WidestVector>(ctx, blockX, blockY);
+				} else {
+					SharpenBlock<ScalarLanes>(ctx, blockX, blockY);
+				}
+			});
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "image.h"
+#include "nis/NIS_Config.h"
+#include "nis/nis_coefficients.h"
+
+namespace vrperfkit {
+	namespace reference {
+		// CPU port of NVScaler and NVSharpen from NIS_Scaler.h as run by D3D11NisUpscaler, driven by the
+		// NISConfig the upscaler uploads (see UpdateNisConfig). The output viewport, the input viewport
+		// offsets and the radius test constants are taken from the config, so viewports into a shared
+		// texture (COMBINED) are handled like on the GPU, including the pixels the shader writes just
+		// past the right and bottom edge of the output viewport.
+
+		struct NisOptions {
+			// NIS_HDR_MODE 1, used by D3D11NisUpscaler for float input formats
+			bool hdr = false;
+			// the shader permutations: blocks with their centre outside config.squaredRadius are
+			// bilinearly copied (or with Lanczos-2 for peripheryLanczos), tinted in debug mode
+			bool radiusTest = false;
+			bool debugMode = false;
+			bool peripheryLanczos = false;
+			// 6, or 4 as with upscaling.nisPerformance
+			uint32_t filterTaps = kNisMaxFilterTaps;
+			// worker threads for the shader blocks, 0 uses all hardware threads
+			uint32_t threads = 0;
+			// process several pixels per call with SSE2/AVX2
+			bool simd = true;
+		};
+
+		void NisUpscale(const Image &input, Image &output, const NISConfig &config, const NisOptions &options);
+
+		// the sharpening-only pass, used when the input and output viewports are the same
+		void NisSharpen(const Image &input, Image &output, const NISConfig &config, const NisOptions &options);
+	}
+}
@@ -0,0 +1,507 @@
+#include "rdm_reference.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include "tile_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vrperfkit {
+	namespace reference {
+		namespace {
+			// the four channels of a texel, for builds or runs without SSE2
+			struct Float4 {
+				float v[4];
+
+				Float4() = default;
+				Float4(float f) : v{f, f, f, f} {}
+				Float4(float r, float g, float b, float a) : v{r, g, b, a} {}
+
+				static Float4 Load(const float *p) { return Float4{p[0], p[1], p[2], p[3]}; }
+				void Store(float *p) const { p[0] = v[0]; p[1] = v[1]; p[2] = v[2]; p[3] = v[3]; }
+
+				friend Float4 operator+(Float4 a, Float4 b) { return Float4{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}; }
+				friend Float4 operator-(Float4 a, Float4 b) { return Float4{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}; }
+				friend Float4 operator*(Float4 a, Float4 b) { return Float4{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}; }
+				friend Float4 Min(Float4 a, Float4 b) { return Float4{std::min(a.v[0], b.v[0]), std::min(a.v[1], b.v[1]), std::min(a.v[2], b.v[2]), std::min(a.v[3], b.v[3])}; }
+				friend Float4 Max(Float4 a, Float4 b) { return Float4{std::max(a.v[0], b.v[0]), std::max(a.v[1], b.v[1]), std::max(a.v[2], b.v[2]), std::max(a.v[3], b.v[3])}; }
+			};
+
+			const float kZero[4] = { 0, 0, 0, 0 };
+
+			// texelFetch: out of bounds reads return zero
+			template<typename V>
+			V Fetch(const Image &image, int x, int y) {
+				if (x < 0 || y < 0 || x >= (int)image.width || y >= (int)image.height)
+					return V::Load(kZero);
+				return V::Load(&image.At(x, y).r);
+			}
+
+			template<typename V>
+			V FetchClamped(const Image &image, int x, int y) {
+				x = std::min(std::max(x, 0), (int)image.width - 1);
+				y = std::min(std::max(y, 0), (int)image.height - 1);
+				return V::Load(&image.At(x, y).r);
+			}
+
+			// D3D11 filters with 8 bits of subtexel precision. The reconstruction places many of its taps
+			// exactly on a texel, which only stays free of the (masked) neighbour with the weights snapped.
+			float SnapSubtexel(float f) {
+				return std::round(f * 256.f) * (1.f / 256.f);
+			}
+
+			// textureLod with the linear clamping sampler, as Image::SampleBilinear with snapped weights
+			template<typename V>
+			V Sample(const Image &image, float u, float v) {
+				float x = SnapSubtexel(u * image.width - 0.5f);
+				float y = SnapSubtexel(v * image.height - 0.5f);
+				float fx = std::floor(x);
+				float fy = std::floor(y);
+				V tx (x - fx);
+				V ty (y - fy);
+				int ix = (int)fx;
+				int iy = (int)fy;
+				V c00 = FetchClamped<V>(image, ix, iy);
+				V c10 = FetchClamped<V>(image, ix + 1, iy);
+				V c01 = FetchClamped<V>(image, ix, iy + 1);
+				V c11 = FetchClamped<V>(image, ix + 1, iy + 1);
+				V top = c00 + (c10 - c00) * tx;
+				V bottom = c01 + (c11 - c01) * tx;
+				return top + (bottom - top) * ty;
+			}
+
+			bool IsShaded(const RdmReconstructConstants &c, RdmLevel level, uint32_t halfX, uint32_t halfY) {
+				return IsRdmShaded(level, halfX, halfY, c.phase[0], c.phase[1]);
+			}
+
+			// offsets from a pixel to the same pixel of the shaded block of its 2x2, 4x2 or 4x4 group
+			Point<int> QuarterResOffset(const RdmReconstructConstants &c, uint32_t halfX, uint32_t halfY) {
+				return Point<int>{ ((int)c.phase[0] - (int)(halfX & 1)) * 2, ((int)c.phase[1] - (int)(halfY & 1)) * 2 };
+			}
+
+			Point<int> EighthResOffset(const RdmReconstructConstants &c, uint32_t halfX, uint32_t halfY) {
+				return Point<int>{ ((int)c.phase[0] * 2 - (int)(halfX & 3)) * 2, ((int)c.phase[1] - (int)(halfY & 1)) * 2 };
+			}
+
+			Point<int> SixteenthResOffset(const RdmReconstructConstants &c, uint32_t halfX, uint32_t halfY) {
+				return Point<int>{ ((int)c.phase[0] * 2 - (int)(halfX & 3)) * 2, ((int)c.phase[1] * 2 - (int)(halfY & 3)) * 2 };
+			}
+
+			// offset to the shaded block a masked block is filled in from
+			Point<int> SourceBlockOffset(const RdmReconstructConstants &c, RdmLevel level, uint32_t halfX, uint32_t halfY) {
+				switch (level) {
+				case RdmLevel::HALF:
+				case RdmLevel::HALF_2X1:
+					return Point<int>{ (halfX & 1) != 0 ? -2 : 2, 0 };
+				case RdmLevel::HALF_1X2:
+					return Point<int>{ 0, (halfY & 1) != 0 ? -2 : 2 };
+				case RdmLevel::QUARTER:
+					return QuarterResOffset(c, halfX, halfY);
+				case RdmLevel::EIGHTH:
+					return EighthResOffset(c, halfX, halfY);
+				case RdmLevel::SIXTEENTH:
+					return SixteenthResOffset(c, halfX, halfY);
+				}
+				return Point<int>{ 0, 0 };
+			}
+
+			template<typename V>
+			V ReconstructHalfResLow(const Image &input, const RdmReconstructConstants &c, int x, int y) {
+				uint32_t halfX = x >> 1, halfY = y >> 1;
+				int offset = 0;
+				if (!IsShaded(c, RdmLevel::HALF, halfX, halfY))
+					offset = (halfX & 1) != 0 ? -2 : 2;
+				return Fetch<V>(input, x + offset, y);
+			}
+
+			template<typename V>
+			V ReconstructHalfResHigh(const Image &input, const RdmReconstructConstants &c, int x, int y) {
+				uint32_t halfX = x >> 1, halfY = y >> 1;
+				float invWidth = c.invResolution[0], invHeight = c.invResolution[1];
+				if (!IsShaded(c, RdmLevel::HALF, halfX, halfY)) {
+					float offset0x = (x & 1) == 0 ? -0.5f : 1.5f;
+					float offset0y = (y & 1) == 0 ? 0.75f : 0.25f;
+					float offset1x = (x & 1) == 0 ? 0.75f : 0.25f;
+					float offset1y = (y & 1) == 0 ? -0.5f : 1.5f;
+					float offset0Nx = (x & 1) == 0 ? 2.5f : -1.5f;
+					float offset1Ny = (y & 1) == 0 ? 2.5f : -1.5f;
+
+					V srcVal0 = Sample<V>(input, (x + offset0x) * invWidth, (y + offset0y) * invHeight);
+					V srcVal1 = Sample<V>(input, (x + offset1x) * invWidth, (y + offset1y) * invHeight);
+					V srcVal0N = Sample<V>(input, (x + offset0Nx) * invWidth, (y + offset0y) * invHeight);
+					V srcVal1N = Sample<V>(input, (x + offset1x) * invWidth, (y + offset1Ny) * invHeight);
+					return srcVal0 * V(0.375f) + srcVal1 * V(0.375f) + srcVal0N * V(0.125f) + srcVal1N * V(0.125f);
+				}
+
+				float u = x + ((x & 1) == 0 ? 0.75f : 0.25f);
+				float v = y + ((y & 1) == 0 ? 0.75f : 0.25f);
+				V srcVal = Sample<V>(input, u * invWidth, v * invHeight);
+
+				int x0 = halfX << 1, y0 = halfY << 1;
+				V srcTL = Fetch<V>(input, x0 - 1, y0 - 1);
+				V srcTR = Fetch<V>(input, x0 + 2, y0 - 1);
+				V srcBL = Fetch<V>(input, x0 - 1, y0 + 2);
+				V srcBR = Fetch<V>(input, x0 + 2, y0 + 2);
+
+				const float weights[4] = { 0.28125f, 0.09375f, 0.09375f, 0.03125f };
+				int idx = (x & 1) + ((y & 1) << 1);
+				return srcVal * V(0.5f) +
+					srcTL * V(weights[idx]) +
+					srcTR * V(weights[(idx + 1) & 3]) +
+					srcBL * V(weights[(idx + 2) & 3]) +
+					srcBR * V(weights[(idx + 3) & 3]);
+			}
+
+			template<typename V>
+			V ReconstructQuarterRes(const Image &input, const RdmReconstructConstants &c, int x, int y) {
+				Point<int> offset = QuarterResOffset(c, x >> 1, y >> 1);
+				return Fetch<V>(input, x + offset.x, y + offset.y);
+			}
+
+			// the missing columns average their neighbours, but only within the cluster
+			template<typename V>
+			V ReconstructHalfRes2x1(const Image &input, const RdmReconstructConstants &c, int x, int y) {
+				uint32_t halfX = x >> 1;
+				if (IsShaded(c, RdmLevel::HALF_2X1, halfX, y >> 1))
+					return Fetch<V>(input, x, y);
+				int step = (halfX & 1) != 0 ? 2 : -2;
+				V srcVal = Fetch<V>(input, x - step, y);
+				uint32_t inCluster = x & (c.clusterSize - 1);
+				if (step > 0 ? inCluster + 2 < c.clusterSize : inCluster >= 2)
+					srcVal = (srcVal + Fetch<V>(input, x + step, y)) * V(0.5f);
+				return srcVal;
+			}
+
+			template<typename V>
+			V ReconstructHalfRes1x2(const Image &input, const RdmReconstructConstants &c, int x, int y) {
+				uint32_t halfY = y >> 1;
+				if (IsShaded(c, RdmLevel::HALF_1X2, x >> 1, halfY))
+					return Fetch<V>(input, x, y);
+				int step = (halfY & 1) != 0 ? 2 : -2;
+				V srcVal = Fetch<V>(input, x, y - step);
+				uint32_t inCluster = y & (c.clusterSize - 1);
+				if (step > 0 ? inCluster + 2 < c.clusterSize : inCluster >= 2)
+					srcVal = (srcVal + Fetch<V>(input, x, y + step)) * V(0.5f);
+				return srcVal;
+			}
+
+			template<typename V>
+			V ReconstructEighthRes(const Image &input, const RdmReconstructConstants &c, int x, int y) {
+				Point<int> offset = EighthResOffset(c, x >> 1, y >> 1);
+				return Fetch<V>(input, x + offset.x, y + offset.y);
+			}
+
+			template<typename V>
+			V ReconstructSixteenthRes(const Image &input, const RdmReconstructConstants &c, int x, int y) {
+				Point<int> offset = SixteenthResOffset(c, x >> 1, y >> 1);
+				return Fetch<V>(input, x + offset.x, y + offset.y);
+			}
+
+			// the history of a pixel masked this frame, clamped to the block it was filled in from and
+			// its value of this frame
+			template<typename V>
+			V BlendHistory(const Image &input, const Image &history, const RdmReconstructConstants &c, RdmLevel level, int x, int y, V srcVal) {
+				uint32_t halfX = x >> 1, halfY = y >> 1;
+				Point<int> offset = SourceBlockOffset(c, level, halfX, halfY);
+				int bx = (int)(halfX << 1) + offset.x, by = (int)(halfY << 1) + offset.y;
+				V a = Fetch<V>(input, bx, by);
+				V b = Fetch<V>(input, bx + 1, by);
+				V d = Fetch<V>(input, bx, by + 1);
+				V e = Fetch<V>(input, bx + 1, by + 1);
+				V lo = Min(Min(Min(a, b), Min(d, e)), srcVal);
+				V hi = Max(Max(Max(a, b), Max(d, e)), srcVal);
+
+				V clamped = Min(Max(Fetch<V>(history, x, y), lo), hi);
+				return srcVal + (clamped - srcVal) * V(c.historyWeight);
+			}
+
+			// the texel at (x, y) if the game shaded it, see fetchShaded in checkerboard.compute.hlsl
+			template<typename V>
+			bool FetchShaded(const Image &input, const RdmReconstructConstants &c, int x, int y, V &value) {
+				value = V::Load(kZero);
+				if (x < c.offset[0] || y < c.offset[1] || x >= c.areaEnd[0] || y >= c.areaEnd[1])
+					return false;
+				float distToCenter = RdmDistanceToCenter(c.invClusterResolution, c.projectionCenter, (float)(x / c.clusterSize), (float)(y / c.clusterSize));
+				if (distToCenter >= c.edgeRadius)
+					return false;
+				value = Fetch<V>(input, x, y);
+				return true;
+			}
+
+			// a masked pixel of checkerboard rendering, interpolated from the nearest shaded pixels of its
+			// row and column; lo and hi bound the taps for the history
+			template<typename V>
+			V ReconstructCheckerboard(const Image &input, const RdmReconstructConstants &c, int x, int y, V &lo, V &hi) {
+				const float kNear = 0.6666667f, kFar = 0.3333333f;
+				int inBlockX = x & 1, inBlockY = y & 1;
+				V l, r, u, d;
+				bool hasL = FetchShaded(input, c, x - 1 - inBlockX, y, l);
+				bool hasR = FetchShaded(input, c, x + 2 - inBlockX, y, r);
+				bool hasU = FetchShaded(input, c, x, y - 1 - inBlockY, u);
+				bool hasD = FetchShaded(input, c, x, y + 2 - inBlockY, d);
+				if (!hasL) l = r;
+				if (!hasR) r = l;
+				if (!hasU) u = d;
+				if (!hasD) d = u;
+				if (!hasL && !hasR) { l = u; r = d; }
+				if (!hasU && !hasD) { u = l; d = r; }
+
+				V horizontal = inBlockX == 0 ? l * V(kNear) + r * V(kFar) : l * V(kFar) + r * V(kNear);
+				V vertical = inBlockY == 0 ? u * V(kNear) + d * V(kFar) : u * V(kFar) + d * V(kNear);
+				lo = Min(Min(l, r), Min(u, d));
+				hi = Max(Max(l, r), Max(u, d));
+				return (horizontal + vertical) * V(0.5f);
+			}
+
+			float QuantizeUnorm(float f) {
+				return std::round(std::min(std::max(f, 0.f), 1.f) * 255.f) / 255.f;
+			}
+
+			template<typename V>
+			void Store(Image &output, int x, int y, V value, bool unorm) {
+				Rgba &out = output.At(x, y);
+				value.Store(&out.r);
+				if (unorm) {
+					out = Rgba{QuantizeUnorm(out.r), QuantizeUnorm(out.g), QuantizeUnorm(out.b), QuantizeUnorm(out.a)};
+				}
+			}
+
+			// the level the pixels of a reconstruction branch are masked with
+			RdmLevel ModeLevel(RdmReconstructMode mode) {
+				switch (mode) {
+				case RdmReconstructMode::HALF_RES_2X1:
+					return RdmLevel::HALF_2X1;
+				case RdmReconstructMode::HALF_RES_1X2:
+					return RdmLevel::HALF_1X2;
+				case RdmReconstructMode::QUARTER_RES:
+					return RdmLevel::QUARTER;
+				case RdmReconstructMode::EIGHTH_RES:
+					return RdmLevel::EIGHTH;
+				case RdmReconstructMode::SIXTEENTH_RES:
+					return RdmLevel::SIXTEENTH;
+				default:
+					return RdmLevel::HALF;
+				}
+			}
+
+			template<typename V, typename F>
+			void ReconstructRun(const Image &input, Image &output, const Image *history, const RdmReconstructConstants &c, RdmLevel level,
+					uint32_t start, uint32_t end, uint32_t y, bool unorm, F reconstruct) {
+				bool temporal = history != nullptr && c.historyWeight > 0;
+				for (uint32_t x = start; x < end; ++x) {
+					V value = reconstruct(x);
+					if (temporal && !IsShaded(c, level, x >> 1, y >> 1))
+						value = BlendHistory<V>(input, *history, c, level, x, y, value);
+					Store(output, x, y, value, unorm);
+				}
+			}
+
+			template<typename V>
+			void CheckerboardRun(const Image &input, Image &output, const Image *history, const RdmReconstructConstants &c,
+					uint32_t start, uint32_t end, uint32_t y, bool unorm) {
+				bool temporal = history != nullptr && c.historyWeight > 0;
+				for (uint32_t x = start; x < end; ++x) {
+					if (IsShaded(c, RdmLevel::HALF, x >> 1, y >> 1)) {
+						Store(output, x, y, Fetch<V>(input, x, y), unorm);
+						continue;
+					}
+					V lo, hi;
+					V value = ReconstructCheckerboard<V>(input, c, x, y, lo, hi);
+					if (temporal) {
+						V clamped = Min(Max(Fetch<V>(*history, x, y), lo), hi);
+						value = value + (clamped - value) * V(c.historyWeight);
+					}
+					Store(output, x, y, value, unorm);
+				}
+			}
+
+			// One row of a tile. The distance test only depends on the cluster, so the branch of the
+			// shader is picked once per cluster and the row processed in runs of up to clusterSize pixels.
+			template<typename V>
+			void ReconstructRow(const Image &input, Image &output, const Image *history, const RdmReconstructConstants &c,
+					uint32_t x0, uint32_t x1, uint32_t y, const RdmReconstructOptions &options) {
+				bool unorm = options.unorm;
+				for (uint32_t start = x0; start < x1; ) {
+					uint32_t end = std::min(x1, (start | (c.clusterSize - 1)) + 1);
+					RdmReconstructMode mode = GetRdmReconstructMode(c, start, y);
+					RdmLevel level = ModeLevel(mode);
+					int iy = (int)y;
+					if (options.checkerboard && mode != RdmReconstructMode::COPY) {
+						CheckerboardRun<V>(input, output, history, c, start, end, y, unorm);
+						start = end;
+						continue;
+					}
+					switch (mode) {
+					case RdmReconstructMode::COPY:
+						for (uint32_t x = start; x < end; ++x)
+							Store(output, x, y, Fetch<V>(input, x, y), unorm);
+						break;
+					case RdmReconstructMode::HALF_RES_HIGH:
+						ReconstructRun<V>(input, output, history, c, level, start, end, y, unorm, [&](int x) { return ReconstructHalfResHigh<V>(input, c, x, iy); });
+						break;
+					case RdmReconstructMode::HALF_RES_LOW:
+						ReconstructRun<V>(input, output, history, c, level, start, end, y, unorm, [&](int x) { return ReconstructHalfResLow<V>(input, c, x, iy); });
+						break;
+					case RdmReconstructMode::QUARTER_RES:
+						ReconstructRun<V>(input, output, history, c, level, start, end, y, unorm, [&](int x) { return ReconstructQuarterRes<V>(input, c, x, iy); });
+						break;
+					case RdmReconstructMode::SIXTEENTH_RES:
+						ReconstructRun<V>(input, output, history, c, level, start, end, y, unorm, [&](int x) { return ReconstructSixteenthRes<V>(input, c, x, iy); });
+						break;
+					case RdmReconstructMode::HALF_RES_2X1:
+						ReconstructRun<V>(input, output, history, c, level, start, end, y, unorm, [&](int x) { return ReconstructHalfRes2x1<V>(input, c, x, iy); });
+						break;
+					case RdmReconstructMode::HALF_RES_1X2:
+						ReconstructRun<V>(input, output, history, c, level, start, end, y, unorm, [&](int x) { return ReconstructHalfRes1x2<V>(input, c, x, iy); });
+						break;
+					case RdmReconstructMode::EIGHTH_RES:
+						ReconstructRun<V>(input, output, history, c, level, start, end, y, unorm, [&](int x) { return ReconstructEighthRes<V>(input, c, x, iy); });
+						break;
+					}
+					start = end;
+				}
+			}
+
+#ifdef VRPERFKIT_REFERENCE_SSE2
+			using TexelVector = F32x4;
+#else
+			using TexelVector = Float4;
+#endif
+		}
+
+		std::vector<uint8_t> GenerateRdmMask(const RdmMaskingConstants &constants, const Viewport &viewport, bool hiddenRadialMask) {
+			std::vector<uint8_t> mask (viewport.width * viewport.height);
+			for (uint32_t y = 0; y < viewport.height; ++y) {
+				for (uint32_t x = 0; x < viewport.width; ++x) {
+					// pixel centres, as SV_Position
+					float posX = viewport.x + x + 0.5f;
+					float posY = viewport.y + y + 0.5f;
+					bool masked = hiddenRadialMask ? IsHrmMasked(constants, posX, posY) : IsRdmMasked(constants, posX, posY);
+					mask[y * viewport.width + x] = masked ? 1 : 0;
+				}
+			}
+			return mask;
+		}
+
+		namespace {
+			struct FixedPoint {
+				int64_t x;
+				int64_t y;
+			};
+
+			// the clip space position of mask_mesh.vert.hlsl through the viewport transform
+			FixedPoint ToViewport(const MaskVertex &v, const MaskMeshConstants &constants, uint32_t width, uint32_t height) {
+				float clipX = (float)v.x * constants.pixelToClip[0] - 1.f;
+				float clipY = (float)v.y * -constants.pixelToClip[1] + 1.f;
+				float x = (clipX + 1.f) * 0.5f * width;
+				float y = (1.f - clipY) * 0.5f * height;
+				return FixedPoint{ (int64_t)std::llround(x * 256.f), (int64_t)std::llround(y * 256.f) };
+			}
+
+			int64_t Orient(const FixedPoint &a, const FixedPoint &b, const FixedPoint &p) {
+				return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+			}
+
+			// with the y axis pointing down and the triangle wound so that Orient is positive inside
+			bool IsTopLeft(const FixedPoint &a, const FixedPoint &b) {
+				return (a.y == b.y && b.x > a.x) || b.y < a.y;
+			}
+
+			bool Covers(int64_t w, bool topLeft) {
+				return w > 0 || (w == 0 && topLeft);
+			}
+		}
+
+		std::vector<uint8_t> RasterizeMaskMesh(const std::vector<MaskVertex> &mesh, size_t first, size_t end, const MaskMeshConstants &constants,
+				uint32_t targetWidth, uint32_t targetHeight) {
+			std::vector<uint8_t> coverage (targetWidth * targetHeight);
+			for (size_t i = first; i + 2 < end; i += 3) {
+				FixedPoint v0 = ToViewport(mesh[i], constants, targetWidth, targetHeight);
+				FixedPoint v1 = ToViewport(mesh[i + 1], constants, targetWidth, targetHeight);
+				FixedPoint v2 = ToViewport(mesh[i + 2], constants, targetWidth, targetHeight);
+				int64_t area = Orient(v0, v1, v2);
+				if (area == 0) {
+					continue;
+				}
+				if (area < 0) {
+					std::swap(v1, v2);
+				}
+				bool tl0 = IsTopLeft(v1, v2), tl1 = IsTopLeft(v2, v0), tl2 = IsTopLeft(v0, v1);
+
+				int64_t minX = std::min({v0.x, v1.x, v2.x}) >> 8, maxX = (std::max({v0.x, v1.x, v2.x}) >> 8) + 1;
+				int64_t minY = std::min({v0.y, v1.y, v2.y}) >> 8, maxY = (std::max({v0.y, v1.y, v2.y}) >> 8) + 1;
+				minX = std::max<int64_t>(minX, 0), maxX = std::min<int64_t>(maxX, targetWidth);
+				minY = std::max<int64_t>(minY, 0), maxY = std::min<int64_t>(maxY, targetHeight);
+				for (int64_t y = minY; y < maxY; ++y) {
+					for (int64_t x = minX; x < maxX; ++x) {
+						FixedPoint p { x * 256 + 128, y * 256 + 128 };
+						if (Covers(Orient(v1, v2, p), tl0) && Covers(Orient(v2, v0, p), tl1) && Covers(Orient(v0, v1, p), tl2)) {
+							uint8_t &c = coverage[y * targetWidth + x];
+							c = std::min(c + 1, 255);
+						}
+					}
+				}
+			}
+			return coverage;
+		}
+
+		void ApplyRdmMask(Image &image, const Viewport &viewport, const std::vector<uint8_t> &mask, const Rgba &clear) {
+			for (uint32_t y = 0; y < viewport.height; ++y) {
+				for (uint32_t x = 0; x < viewport.width; ++x) {
+					if (mask[y * viewport.width + x]) {
+						image.At(viewport.x + x, viewport.y + y) = clear;
+					}
+				}
+			}
+		}
+
+		Viewport RdmDispatchArea(const Image &input, const Viewport &inputViewport, uint32_t clusterSize) {
+			uint32_t width = (inputViewport.width + clusterSize - 1) / clusterSize * clusterSize;
+			uint32_t height = (inputViewport.height + clusterSize - 1) / clusterSize * clusterSize;
+			// UAV writes outside of the texture are dropped
+			width = std::min(width, input.width - std::min(input.width, inputViewport.x));
+			height = std::min(height, input.height - std::min(input.height, inputViewport.y));
+			return Viewport{inputViewport.x, inputViewport.y, width, height};
+		}
+
+		void RdmReconstruct(const Image &input, const Viewport &inputViewport, Image &output, const RdmReconstructConstants &constants,
+				const RdmReconstructOptions &options, const Image *history) {
+			Viewport area = RdmDispatchArea(input, inputViewport, constants.clusterSize);
+			TileGrid grid (area, false, 0, Point<float>{0.5f, 0.5f});
+			GetThreadPool(options.threads).ParallelFor(grid.Count(), [&](uint32_t index) {
+				Viewport tile = grid.Tile(index);
+				uint32_t x0 = area.x + tile.x;
+				uint32_t x1 = x0 + tile.width;
+				for (uint32_t y = area.y + tile.y; y < area.y + tile.y + tile.height; ++y) {
+					if (options.simd) {
+						ReconstructRow<TexelVector>(input, output, history, constants, x0, x1, y, options);
+					} else {
+						ReconstructRow<Float4>(input, output, history, constants, x0, x1, y, options);
+					}
+				}
+			});
+		}
+
+		void RdmReconstructTiles(const Image &input, Image &output, const RdmReconstructConstants &constants, const std::vector<uint32_t> &tiles,
+				const RdmReconstructOptions &options, const Image *history) {
+			GetThreadPool(options.threads).ParallelFor((uint32_t)tiles.size(), [&](uint32_t index) {
+				uint32_t tile = tiles[index];
+				if (tile == kRdmNoTile) {
+					return;
+				}
+				uint32_t clusterSize = constants.clusterSize;
+				uint32_t x0 = std::max((tile & 0xffff) * clusterSize, (uint32_t)constants.offset[0]);
+				uint32_t y0 = std::max((tile >> 16) * clusterSize, (uint32_t)constants.offset[1]);
+				uint32_t x1 = std::min((tile & 0xffff) * clusterSize + clusterSize, (uint32_t)constants.areaEnd[0]);
+				uint32_t y1 = std::min((tile >> 16) * clusterSize + clusterSize, (uint32_t)constants.areaEnd[1]);
+				for (uint32_t y = y0; y < y1 && x0 < x1; ++y) {
+					if (options.simd) {
+						ReconstructRow<TexelVector>(input, output, history, constants, x0, x1, y, options);
+					} else {
+						ReconstructRow<Float4>(input, output, history, constants, x0, x1, y, options);
+					}
+				}
+			});
+		}
+	}
+}
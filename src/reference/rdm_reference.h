@@ -0,0 +1,55 @@
+#pragma once
+#include "image.h"
+#include "hrm/mask_mesh.h"
+#include "hrm/radial_density_mask.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace vrperfkit {
+	namespace reference {
+		// CPU port of the radial density mask passes of D3D11PostProcessor: the masking shaders that
+		// keep the game from shading peripheral pixels, and the compute shader that fills them in again.
+		// Constants are produced by the same setup functions the post processor uses.
+
+		struct RdmReconstructOptions {
+			// R8G8B8A8_UNORM render target: stored values are rounded to 8 bits
+			bool unorm = false;
+			// worker threads for the 16x16 tiles, 0 uses all hardware threads
+			uint32_t threads = 0;
+			// process the four channels of a pixel at once with SSE2
+			bool simd = true;
+			// checkerboard.compute.hlsl in place of reconstruction.compute.hlsl, for checkerboard rendering
+			bool checkerboard = false;
+		};
+
+		// One entry per pixel of viewport, 1 where the masking pass writes depth so that the game does
+		// not shade the pixel. viewport is in render target coordinates, as the D3D11 viewport of the pass.
+		std::vector<uint8_t> GenerateRdmMask(const RdmMaskingConstants &constants, const Viewport &viewport, bool hiddenRadialMask = false);
+
+		// Rasterizes vertices [first, end) of a mask mesh like D3D11 does after mask_mesh.vert.hlsl, into
+		// a targetWidth x targetHeight target: the vertices are snapped to 8 bits of subpixel precision
+		// and pixel centres sampled with the top-left rule. Returns the number of triangles covering
+		// each pixel, to compare against GenerateRdmMask.
+		std::vector<uint8_t> RasterizeMaskMesh(const std::vector<MaskVertex> &mesh, size_t first, size_t end, const MaskMeshConstants &constants,
+			uint32_t targetWidth, uint32_t targetHeight);
+
+		// stands in for the game rendering with the mask: masked pixels of viewport are set to clear
+		void ApplyRdmMask(Image &image, const Viewport &viewport, const std::vector<uint8_t> &mask, const Rgba &clear);
+
+		// reconstruction.compute.hlsl (or checkerboard.compute.hlsl) dispatched for inputViewport of input, written to output of the
+		// same size. Like the thread groups of one cluster each, the dispatch covers inputViewport
+		// rounded up to whole clusters, clipped to the texture. history is the previous frame's output
+		// the pixels masked in this phase are blended with, if the constants have a history weight.
+		void RdmReconstruct(const Image &input, const Viewport &inputViewport, Image &output, const RdmReconstructConstants &constants,
+			const RdmReconstructOptions &options = {}, const Image *history = nullptr);
+
+		// the area written by RdmReconstruct
+		Viewport RdmDispatchArea(const Image &input, const Viewport &inputViewport, uint32_t clusterSize = kRdmClusterSize);
+
+		// reconstruction.compute.hlsl dispatched indirectly for a tile list of BuildRdmReconstructTiles:
+		// one thread group per cluster, clipped to the area between offset and areaEnd
+		void RdmReconstructTiles(const Image &input, Image &output, const RdmReconstructConstants &constants, const std::vector<uint32_t> &tiles,
+			const RdmReconstructOptions &options = {}, const Image *history = nullptr);
+	}
+}
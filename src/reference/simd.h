@@ -0,0 +1,165 @@
+#pragma once
+#include "half.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VRPERFKIT_REFERENCE_SSE2 1
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VRPERFKIT_REFERENCE_AVX2 1
+#endif
+
+namespace vrperfkit {
+	namespace reference {
+		// Select for scalar kernels, matching the ternaries in the HLSL code
+		template<typename T> T Select(bool mask, T a, T b) { return mask ? a : b; }
+		// true if the condition holds for any lane, lets the kernels keep the branches of the HLSL code
+		inline bool Any(bool mask) { return mask; }
+
+		// Minimal float vector types, so that the templated FP32 reference kernels can process
+		// several pixels per call. Only the operations used by the kernels are provided.
+#ifdef VRPERFKIT_REFERENCE_SSE2
+		struct F32x4Mask {
+			__m128 v;
+		};
+
+		struct F32x4 {
+			static constexpr int kLanes = 4;
+			__m128 v;
+
+			F32x4() = default;
+			F32x4(float f) : v(_mm_set1_ps(f)) {}
+			explicit F32x4(__m128 v) : v(v) {}
+
+			static F32x4 Load(const float *p) { return F32x4(_mm_loadu_ps(p)); }
+			void Store(float *p) const { _mm_storeu_ps(p, v); }
+
+			F32x4 operator-() const { return F32x4(_mm_xor_ps(v, _mm_set1_ps(-0.f))); }
+			F32x4& operator+=(F32x4 o) { v = _mm_add_ps(v, o.v); return *this; }
+			F32x4& operator-=(F32x4 o) { v = _mm_sub_ps(v, o.v); return *this; }
+			F32x4& operator*=(F32x4 o) { v = _mm_mul_ps(v, o.v); return *this; }
+
+			friend F32x4 operator+(F32x4 a, F32x4 b) { return F32x4(_mm_add_ps(a.v, b.v)); }
+			friend F32x4 operator-(F32x4 a, F32x4 b) { return F32x4(_mm_sub_ps(a.v, b.v)); }
+			friend F32x4 operator*(F32x4 a, F32x4 b) { return F32x4(_mm_mul_ps(a.v, b.v)); }
+			friend F32x4 operator/(F32x4 a, F32x4 b) { return F32x4(_mm_div_ps(a.v, b.v)); }
+			friend F32x4Mask operator<(F32x4 a, F32x4 b) { return F32x4Mask{_mm_cmplt_ps(a.v, b.v)}; }
+			friend F32x4Mask operator>(F32x4 a, F32x4 b) { return F32x4Mask{_mm_cmpgt_ps(a.v, b.v)}; }
+			friend F32x4Mask operator>=(F32x4 a, F32x4 b) { return F32x4Mask{_mm_cmpge_ps(a.v, b.v)}; }
+		};
+
+		inline F32x4 Min(F32x4 a, F32x4 b) { return F32x4(_mm_min_ps(a.v, b.v)); }
+		inline F32x4 Max(F32x4 a, F32x4 b) { return F32x4(_mm_max_ps(a.v, b.v)); }
+		inline F32x4 Abs(F32x4 a) { return F32x4(_mm_andnot_ps(_mm_set1_ps(-0.f), a.v)); }
+		inline F32x4 Select(F32x4Mask m, F32x4 a, F32x4 b) { return F32x4(_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))); }
+		inline bool Any(F32x4Mask m) { return _mm_movemask_ps(m.v) != 0; }
+
+		inline F32x4 FromIntBits(__m128i bits) { return F32x4(_mm_castsi128_ps(bits)); }
+		inline F32x4 PrxLoRcp(F32x4 a) { return FromIntBits(_mm_sub_epi32(_mm_set1_epi32(0x7ef07ebb), _mm_castps_si128(a.v))); }
+		inline F32x4 PrxMedRcp(F32x4 a) { F32x4 b = FromIntBits(_mm_sub_epi32(_mm_set1_epi32(0x7ef19fff), _mm_castps_si128(a.v))); return b * (-b * a + F32x4(2.f)); }
+		inline F32x4 PrxLoRsq(F32x4 a) { return FromIntBits(_mm_sub_epi32(_mm_set1_epi32(0x5f347d74), _mm_srli_epi32(_mm_castps_si128(a.v), 1))); }
+		inline F32x4 PrxLoSqrt(F32x4 a) { return FromIntBits(_mm_add_epi32(_mm_srli_epi32(_mm_castps_si128(a.v), 1), _mm_set1_epi32(0x1fbc4639))); }
+#endif
+
+#ifdef VRPERFKIT_REFERENCE_AVX2
+		struct F32x8Mask {
+			__m256 v;
+		};
+
+		struct F32x8 {
+			static constexpr int kLanes = 8;
+			__m256 v;
+
+			F32x8() = default;
+			F32x8(float f) : v(_mm256_set1_ps(f)) {}
+			explicit F32x8(__m256 v) : v(v) {}
+
+			static F32x8 Load(const float *p) { return F32x8(_mm256_loadu_ps(p)); }
+			void Store(float *p) const { _mm256_storeu_ps(p, v); }
+
+			F32x8 operator-() const { return F32x8(_mm256_xor_ps(v, _mm256_set1_ps(-0.f))); }
+			F32x8& operator+=(F32x8 o) { v = _mm256_add_ps(v, o.v); return *this; }
+			F32x8& operator-=(F32x8 o) { v = _mm256_sub_ps(v, o.v); return *this; }
+			F32x8& operator*=(F32x8 o) { v = _mm256_mul_ps(v, o.v); return *this; }
+
+			friend F32x8 operator+(F32x8 a, F32x8 b) { return F32x8(_mm256_add_ps(a.v, b.v)); }
+			friend F32x8 operator-(F32x8 a, F32x8 b) { return F32x8(_mm256_sub_ps(a.v, b.v)); }
+			friend F32x8 operator*(F32x8 a, F32x8 b) { return F32x8(_mm256_mul_ps(a.v, b.v)); }
+			friend F32x8 operator/(F32x8 a, F32x8 b) { return F32x8(_mm256_div_ps(a.v, b.v)); }
+			friend F32x8Mask operator<(F32x8 a, F32x8 b) { return F32x8Mask{_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+			friend F32x8Mask operator>(F32x8 a, F32x8 b) { return F32x8Mask{_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+			friend F32x8Mask operator>=(F32x8 a, F32x8 b) { return F32x8Mask{_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)}; }
+		};
+
+		inline F32x8 Min(F32x8 a, F32x8 b) { return F32x8(_mm256_min_ps(a.v, b.v)); }
+		inline F32x8 Max(F32x8 a, F32x8 b) { return F32x8(_mm256_max_ps(a.v, b.v)); }
+		inline F32x8 Abs(F32x8 a) { return F32x8(_mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v)); }
+		inline F32x8 Select(F32x8Mask m, F32x8 a, F32x8 b) { return F32x8(_mm256_blendv_ps(b.v, a.v, m.v)); }
+		inline bool Any(F32x8Mask m) { return _mm256_movemask_ps(m.v) != 0; }
+
+		inline F32x8 FromIntBits(__m256i bits) { return F32x8(_mm256_castsi256_ps(bits)); }
+		inline F32x8 PrxLoRcp(F32x8 a) { return FromIntBits(_mm256_sub_epi32(_mm256_set1_epi32(0x7ef07ebb), _mm256_castps_si256(a.v))); }
+		inline F32x8 PrxMedRcp(F32x8 a) { F32x8 b = FromIntBits(_mm256_sub_epi32(_mm256_set1_epi32(0x7ef19fff), _mm256_castps_si256(a.v))); return b * (-b * a + F32x8(2.f)); }
+		inline F32x8 PrxLoRsq(F32x8 a) { return FromIntBits(_mm256_sub_epi32(_mm256_set1_epi32(0x5f347d74), _mm256_srli_epi32(_mm256_castps_si256(a.v), 1))); }
+		inline F32x8 PrxLoSqrt(F32x8 a) { return FromIntBits(_mm256_add_epi32(_mm256_srli_epi32(_mm256_castps_si256(a.v), 1), _mm256_set1_epi32(0x1fbc4639))); }
+#endif
+
+#if defined(VRPERFKIT_REFERENCE_AVX2)
+		using WidestVector = F32x8;
+#elif defined(VRPERFKIT_REFERENCE_SSE2)
+		using WidestVector = F32x4;
+#else
+		// no vector support compiled in, the scalar kernels stand in for a one lane vector
+		struct WidestVector {
+			static constexpr int kLanes = 1;
+		};
+#endif
+
+		// name of the widest vector instruction set compiled into the reference kernels
+		inline const char *SimdName() {
+#if defined(VRPERFKIT_REFERENCE_AVX2)
+			return "AVX2";
+#elif defined(VRPERFKIT_REFERENCE_SSE2)
+			return "SSE2";
+#else
+			return "none";
+#endif
+		}
+
+		// Sets one lane of a kernel input value, so that inputs can be gathered without a transpose
+		inline void SetLane(float &v, int, float f) { v = f; }
+		inline void SetLane(Half &v, int, float f) { v = Half(f); }
+#ifdef VRPERFKIT_REFERENCE_SSE2
+		inline void SetLane(F32x4 &v, int lane, float f) { reinterpret_cast<float *>(&v.v)[lane] = f; }
+#endif
+#ifdef VRPERFKIT_REFERENCE_AVX2
+		inline void SetLane(F32x8 &v, int lane, float f) { reinterpret_cast<float *>(&v.v)[lane] = f; }
+#endif
+
+		// Converts N scalar kernel inputs into one vector input, lane i holding the values of input i.
+		// Inputs are plain aggregates of floats, so they are moved as float arrays.
+		template<typename V, template<typename> class Input>
+		Input<V> TransposeLanes(const Input<float> (&lanes)[V::kLanes]) {
+			constexpr size_t kFields = sizeof(Input<float>) / sizeof(float);
+			static_assert(sizeof(Input<V>) == kFields * sizeof(V), "input must only contain scalars");
+			float soa[kFields][V::kLanes];
+			for (int lane = 0; lane < V::kLanes; ++lane) {
+				float fields[kFields];
+				std::memcpy(fields, &lanes[lane], sizeof(fields));
+				for (size_t i = 0; i < kFields; ++i) {
+					soa[i][lane] = fields[i];
+				}
+			}
+			V vectors[kFields];
+			for (size_t i = 0; i < kFields; ++i) {
+				vectors[i] = V::Load(soa[i]);
+			}
+			Input<V> result;
+			std::memcpy(&result, vectors, sizeof(result));
+			return result;
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace vrperfkit {
+	namespace reference {
+		ThreadPool::ThreadPool(uint32_t threadCount) {
+			if (threadCount == 0) {
+				threadCount = std::max(1u, std::thread::hardware_concurrency());
+			}
+			for (uint32_t i = 1; i < threadCount; ++i) {
+				workers.emplace_back(&ThreadPool::WorkerLoop, this);
+			}
+		}
+
+		ThreadPool::~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock (mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (std::thread &worker : workers) {
+				worker.join();
+			}
+		}
+
+		void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)> &fn) {
+			if (workers.empty() || count <= 1) {
+				for (uint32_t i = 0; i < count; ++i) {
+					fn(i);
+				}
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock (mutex);
+				task = &fn;
+				taskCount = count;
+				nextIndex = 0;
+				activeWorkers = (uint32_t)workers.size();
+				++generation;
+			}
+			wake.notify_all();
+
+			RunTasks();
+
+			std::unique_lock<std::mutex> lock (mutex);
+			done.wait(lock, [this]() { return activeWorkers == 0; });
+			task = nullptr;
+		}
+
+		void ThreadPool::RunTasks() {
+			for (uint32_t i = nextIndex++; i < taskCount; i = nextIndex++) {
+				(*task)(i);
+			}
+		}
+
+		void ThreadPool::WorkerLoop() {
+			uint64_t seenGeneration = 0;
+			while (true) {
+				{
+					std::unique_lock<std::mutex> lock (mutex);
+					wake.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+					if (stopping) {
+						return;
+					}
+					seenGeneration = generation;
+				}
+
+				RunTasks();
+
+				std::lock_guard<std::mutex> lock (mutex);
+				if (--activeWorkers == 0) {
+					done.notify_one();
+				}
+			}
+		}
+
+		ThreadPool &GetThreadPool(uint32_t threadCount) {
+			static std::unique_ptr<ThreadPool> pool;
+			static std::mutex poolMutex;
+			std::lock_guard<std::mutex> lock (poolMutex);
+			uint32_t wanted = threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threadCount;
+			if (pool == nullptr || pool->ThreadCount() != wanted) {
+				pool = std::make_unique<ThreadPool>(wanted);
+			}
+			return *pool;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vrperfkit {
+	namespace reference {
+		// Fixed set of worker threads that process the tiles of a reference kernel.
+		// The calling thread takes part in the work, so a pool with one thread runs inline.
+		class ThreadPool {
+		public:
+			// threadCount 0 uses all hardware threads
+			explicit ThreadPool(uint32_t threadCount = 0);
+			~ThreadPool();
+
+			ThreadPool(const ThreadPool&) = delete;
+			ThreadPool& operator=(const ThreadPool&) = delete;
+
+			uint32_t ThreadCount() const { return (uint32_t)workers.size() + 1; }
+
+			// calls fn(i) for every i in [0, count) and returns once all calls have finished
+			void ParallelFor(uint32_t count, const std::function<void(uint32_t)> &fn);
+
+		private:
+			void WorkerLoop();
+			void RunTasks();
+
+			std::vector<std::thread> workers;
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::condition_variable done;
+			const std::function<void(uint32_t)> *task = nullptr;
+			uint32_t taskCount = 0;
+			std::atomic<uint32_t> nextIndex {0};
+			uint32_t activeWorkers = 0;
+			uint64_t generation = 0;
+			bool stopping = false;
+		};
+
+		// shared pool for the reference kernels, recreated when a different thread count is requested
+		ThreadPool &GetThreadPool(uint32_t threadCount);
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "types.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace vrperfkit {
+	namespace reference {
+		// Matches the tiling of the FSR and CAS compute shaders: 16x16 pixel tiles, with the radius
+		// test done once per tile against its centre.
+		const uint32_t kTileSize = 16;
+
+		struct TileGrid {
+			Viewport viewport;
+			uint32_t tilesX;
+			uint32_t tilesY;
+			bool radiusTest;
+			int64_t centreX;
+			int64_t centreY;
+			int64_t squaredRadius;
+
+			// radius as upscaling.radius, projection centre relative to the viewport
+			TileGrid(const Viewport &viewport, bool radiusTest, float radius, const Point<float> &projectionCenter)
+					: viewport(viewport), radiusTest(radiusTest) {
+				tilesX = (viewport.width + kTileSize - 1) / kTileSize;
+				tilesY = (viewport.height + kTileSize - 1) / kTileSize;
+				// same quantization as the constants set up by the D3D11 upscalers
+				float pixelRadius = 0.5f * radius * viewport.height;
+				centreX = (uint32_t)(viewport.width * projectionCenter.x);
+				centreY = (uint32_t)(viewport.height * projectionCenter.y);
+				squaredRadius = (uint32_t)(pixelRadius * pixelRadius);
+			}
+
+			uint32_t Count() const { return tilesX * tilesY; }
+
+			// tile position relative to the viewport
+			Viewport Tile(uint32_t index) const {
+				uint32_t x = (index % tilesX) * kTileSize;
+				uint32_t y = (index / tilesX) * kTileSize;
+				return Viewport{x, y, std::min(kTileSize, viewport.width - x), std::min(kTileSize, viewport.height - y)};
+			}
+
+			bool InsideRadius(const Viewport &tile) const {
+				if (!radiusTest) {
+					return true;
+				}
+				int64_t dx = centreX - (tile.x + kTileSize / 2);
+				int64_t dy = centreY - (tile.y + kTileSize / 2);
+				return dx * dx + dy * dy <= squaredRadius;
+			}
+		};
+	}
+}
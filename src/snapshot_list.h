@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <memory>
+
+namespace vrperfkit {
+	// Owns the immutable snapshots that readers load through an atomic pointer without locking. A
+	// reader may still be in a snapshot after it was replaced, so a replaced snapshot is only freed
+	// once keepCount newer ones have been published and gracePeriod has passed since it was replaced.
+	// Readers hold a snapshot for one lookup or one round of callbacks, far less than that. At most
+	// keepCount + 1 snapshots are kept, plus those replaced within the last grace period.
+	template<typename T>
+	class SnapshotList {
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		explicit SnapshotList(size_t keepCount = 16, Clock::duration gracePeriod = std::chrono::seconds(10))
+			: keepCount(keepCount), gracePeriod(gracePeriod) {}
+		SnapshotList(const SnapshotList &) = delete;
+		SnapshotList & operator=(const SnapshotList &) = delete;
+
+		// keeps snapshot as the current one and frees the expired ones; called under the writer's lock
+		const T * Publish(T &&snapshot, Clock::time_point now = Clock::now()) {
+			if (!snapshots.empty()) {
+				snapshots.back().replaced = now;
+			}
+			snapshots.push_back(Snapshot { std::make_unique<const T>(std::move(snapshot)), now });
+			while (snapshots.size() > keepCount + 1 && now - snapshots.front().replaced >= gracePeriod) {
+				snapshots.pop_front();
+			}
+			return snapshots.back().value.get();
+		}
+
+		// the snapshots kept, including the current one
+		size_t Size() const {
+			return snapshots.size();
+		}
+
+	private:
+		struct Snapshot {
+			std::unique_ptr<const T> value;
+			Clock::time_point replaced;
+		};
+
+		std::deque<Snapshot> snapshots;
+		size_t keepCount;
+		Clock::duration gracePeriod;
+	};
+}
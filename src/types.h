@@ -50,17 +50,47 @@ namespace vrperfkit {
 		FSR,
 		NIS,
 		CAS,
+		LANCZOS,
 	};
 	UpscaleMethod MethodFromString(std::string s);
 	std::string MethodToString(UpscaleMethod method);
 
+	// filter used outside the upscaling radius
+	enum class PeripheryFilter {
+		BILINEAR,
+		LANCZOS,
+	};
+	PeripheryFilter PeripheryFilterFromString(std::string s);
+	std::string PeripheryFilterToString(PeripheryFilter filter);
+
+	// minimum image quality when the upscaling method is selected automatically
+	enum class QualityTier {
+		PERFORMANCE,
+		BALANCED,
+		QUALITY,
+	};
+	QualityTier QualityTierFromString(std::string s);
+	std::string QualityTierToString(QualityTier tier);
+
 	enum class FixedFoveatedMethod {
 		VRS,
 		RDM,
+		// RDM mask of the half level only, its parity alternating every frame
+		CHECKERBOARD,
 	};
 	FixedFoveatedMethod FFRMethodFromString(std::string s);
 	std::string FFRMethodToString(FixedFoveatedMethod method);
 
+	// what the hidden mask covers: the circle past the edge radius, the runtime's hidden area mesh of
+	// the lens, or both
+	enum class HiddenMaskMode {
+		RADIAL,
+		AREA_MESH,
+		BOTH,
+	};
+	HiddenMaskMode HiddenMaskModeFromString(std::string s);
+	std::string HiddenMaskModeToString(HiddenMaskMode mode);
+
 	enum class GameMode {
 		AUTO,
 		GENERIC_SINGLE,
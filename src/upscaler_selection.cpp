@@ -0,0 +1,186 @@
+#include "upscaler_selection.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace vrperfkit {
+	namespace {
+		const char *kCacheHeader = "# vrperfkit upscaler benchmark cache v2";
+
+		// stable names for the cache file, independent of the display names in the log
+		const struct {
+			UpscaleMethod method;
+			const char *name;
+		} kCacheMethodNames[] = {
+			{ UpscaleMethod::FSR, "fsr" },
+			{ UpscaleMethod::NIS, "nis" },
+			{ UpscaleMethod::CAS, "cas" },
+			{ UpscaleMethod::LANCZOS, "lanczos" },
+		};
+
+		bool CacheNameToMethod(const std::string &name, UpscaleMethod &method) {
+			for (const auto &entry : kCacheMethodNames) {
+				if (name == entry.name) {
+					method = entry.method;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		const char *MethodToCacheName(UpscaleMethod method) {
+			for (const auto &entry : kCacheMethodNames) {
+				if (method == entry.method) {
+					return entry.name;
+				}
+			}
+			return "unknown";
+		}
+
+		bool ParseEntry(const std::string &line, UpscalerBenchmarkKey &key, std::vector<UpscalerCost> &costs) {
+			std::istringstream in (line);
+			std::string adapter, resolution, inputResolution;
+			if (!(in >> adapter >> resolution >> inputResolution >> key.settings)) {
+				return false;
+			}
+			if (std::sscanf(adapter.c_str(), "%x:%x", &key.vendorId, &key.deviceId) != 2
+					|| std::sscanf(resolution.c_str(), "%ux%u", &key.width, &key.height) != 2
+					|| std::sscanf(inputResolution.c_str(), "%ux%u", &key.inputWidth, &key.inputHeight) != 2) {
+				return false;
+			}
+
+			std::string token;
+			while (in >> token) {
+				auto eq = token.find('=');
+				UpscaleMethod method;
+				if (eq == std::string::npos || !CacheNameToMethod(token.substr(0, eq), method)) {
+					return false;
+				}
+				try {
+					costs.push_back(UpscalerCost{method, std::stof(token.substr(eq + 1))});
+				} catch (const std::exception &) {
+					return false;
+				}
+			}
+			return !costs.empty();
+		}
+	}
+
+	int MethodQualityLevel(UpscaleMethod method) {
+		switch (method) {
+		case UpscaleMethod::LANCZOS:
+			return 0;
+		case UpscaleMethod::CAS:
+			return 1;
+		case UpscaleMethod::NIS:
+		case UpscaleMethod::FSR:
+			return 2;
+		}
+		return 0;
+	}
+
+	bool MethodMeetsQualityTier(UpscaleMethod method, QualityTier tier) {
+		return MethodQualityLevel(method) >= (int)tier;
+	}
+
+	bool SelectFastestMethod(const std::vector<UpscalerCost> &costs, QualityTier tier, UpscaleMethod &selected) {
+		const UpscalerCost *best = nullptr;
+		for (const UpscalerCost &cost : costs) {
+			if (!MethodMeetsQualityTier(cost.method, tier) || cost.milliseconds < 0) {
+				continue;
+			}
+			if (best == nullptr || cost.milliseconds < best->milliseconds) {
+				best = &cost;
+			}
+		}
+		if (best == nullptr) {
+			return false;
+		}
+		selected = best->method;
+		return true;
+	}
+
+	void UpscalerBenchmarkCache::Load(const std::filesystem::path &path) {
+		std::ifstream in (path);
+		if (!in) {
+			entries.clear();
+			return;
+		}
+		std::stringstream contents;
+		contents << in.rdbuf();
+		Deserialize(contents.str());
+	}
+
+	void UpscalerBenchmarkCache::Save(const std::filesystem::path &path) const {
+		std::ofstream out (path, std::ios::trunc);
+		out << Serialize();
+	}
+
+	const std::vector<UpscalerCost> * UpscalerBenchmarkCache::Find(const UpscalerBenchmarkKey &key) const {
+		for (const Entry &entry : entries) {
+			if (entry.key == key) {
+				return &entry.costs;
+			}
+		}
+		return nullptr;
+	}
+
+	void UpscalerBenchmarkCache::Store(const UpscalerBenchmarkKey &key, const std::vector<UpscalerCost> &costs) {
+		for (Entry &entry : entries) {
+			if (entry.key == key) {
+				entry.costs = costs;
+				return;
+			}
+		}
+		entries.push_back(Entry{key, costs});
+	}
+
+	std::string UpscalerBenchmarkCache::Serialize() const {
+		std::ostringstream out;
+		out << kCacheHeader << "\n";
+		for (const Entry &entry : entries) {
+			char key[96];
+			std::snprintf(key, sizeof(key), "%04x:%04x %ux%u %ux%u %u", entry.key.vendorId, entry.key.deviceId,
+				entry.key.width, entry.key.height, entry.key.inputWidth, entry.key.inputHeight, entry.key.settings);
+			out << key;
+			for (const UpscalerCost &cost : entry.costs) {
+				char value[32];
+				std::snprintf(value, sizeof(value), "%.4f", cost.milliseconds);
+				out << " " << MethodToCacheName(cost.method) << "=" << value;
+			}
+			out << "\n";
+		}
+		return out.str();
+	}
+
+	void UpscalerBenchmarkCache::Deserialize(const std::string &contents) {
+		entries.clear();
+		std::istringstream in (contents);
+		std::string line;
+		auto nextLine = [&]() {
+			if (!std::getline(in, line)) {
+				return false;
+			}
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			return true;
+		};
+
+		if (!nextLine() || line != kCacheHeader) {
+			// unknown format or version, measurements will simply be repeated
+			return;
+		}
+		while (nextLine()) {
+			if (line.empty() || line[0] == '#') {
+				continue;
+			}
+			UpscalerBenchmarkKey key;
+			std::vector<UpscalerCost> costs;
+			if (ParseEntry(line, key, costs)) {
+				Store(key, costs);
+			}
+		}
+	}
+}
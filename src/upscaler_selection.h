@@ -0,0 +1,64 @@
+#pragma once
+#include "types.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace vrperfkit {
+	struct UpscalerCost {
+		UpscaleMethod method;
+		float milliseconds;
+	};
+
+	// relative image quality of the upscaling methods, higher is better
+	int MethodQualityLevel(UpscaleMethod method);
+	bool MethodMeetsQualityTier(UpscaleMethod method, QualityTier tier);
+
+	// Picks the cheapest measured method that satisfies the quality tier.
+	// Returns false if none of the measured methods qualifies.
+	bool SelectFastestMethod(const std::vector<UpscalerCost> &costs, QualityTier tier, UpscaleMethod &selected);
+
+	struct UpscalerBenchmarkKey {
+		uint32_t vendorId = 0;
+		uint32_t deviceId = 0;
+		// output resolution
+		uint32_t width = 0;
+		uint32_t height = 0;
+		// input resolution, from the render scale
+		uint32_t inputWidth = 0;
+		uint32_t inputHeight = 0;
+		// caller-defined bits for settings that change the shader cost, e.g. FP16 shaders or the
+		// radius test permutation
+		uint32_t settings = 0;
+
+		bool operator==(const UpscalerBenchmarkKey &o) const {
+			return vendorId == o.vendorId && deviceId == o.deviceId && width == o.width && height == o.height
+				&& inputWidth == o.inputWidth && inputHeight == o.inputHeight && settings == o.settings;
+		}
+	};
+
+	// Measured upscaler costs per GPU adapter, output and input resolution and settings, persisted
+	// as a small text file:
+	//   # vrperfkit upscaler benchmark cache v2
+	//   10de:2204 2016x2240 1686x1874 0 fsr=0.4120 nis=0.3800 cas=0.2010 lanczos=0.1500
+	// A file of another version is ignored, and malformed lines are skipped when loading.
+	class UpscalerBenchmarkCache {
+	public:
+		void Load(const std::filesystem::path &path);
+		void Save(const std::filesystem::path &path) const;
+
+		const std::vector<UpscalerCost> *Find(const UpscalerBenchmarkKey &key) const;
+		void Store(const UpscalerBenchmarkKey &key, const std::vector<UpscalerCost> &costs);
+
+		std::string Serialize() const;
+		void Deserialize(const std::string &contents);
+
+	private:
+		struct Entry {
+			UpscalerBenchmarkKey key;
+			std::vector<UpscalerCost> costs;
+		};
+		std::vector<Entry> entries;
+	};
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace vrperfkit {
+	// Views created for resources the game owns, keyed by the resource's address. Holds at most
+	// capacity entries and replaces the least recently used one when full, so that games which
+	// recreate their render targets do not pile up views, and with them the textures they keep alive.
+	//
+	// Lifetime tells whether an entry still belongs to the resource at its address:
+	//   Lifetime::Token                                  remembered with the entry
+	//   static Token Track(Resource *resource)           when the entry is created
+	//   static bool IsCurrent(Resource *resource, const Token &token)
+	// An entry whose resource was destroyed, or whose address now belongs to another resource, is
+	// dropped on the next lookup instead of handing out views of the old one.
+	template<typename Resource, typename Views, typename Lifetime>
+	class ViewCache {
+	public:
+		explicit ViewCache(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {
+			entries.reserve(this->capacity);
+		}
+
+		// the views of resource, or nullptr if there are none; valid until the next Insert
+		Views * Find(Resource *resource) {
+			for (size_t i = 0; i < entries.size(); ++i) {
+				Entry &entry = entries[i];
+				if (entry.resource != resource) {
+					continue;
+				}
+				if (!Lifetime::IsCurrent(resource, entry.token)) {
+					Remove(i);
+					++staleEntries;
+					return nullptr;
+				}
+				entry.lastUse = ++useCounter;
+				return &entry.views;
+			}
+			return nullptr;
+		}
+
+		// stores views for resource, replacing its previous entry or, when full, the least recently used
+		Views & Insert(Resource *resource, Views views) {
+			size_t slot = entries.size();
+			for (size_t i = 0; i < entries.size(); ++i) {
+				if (entries[i].resource == resource) {
+					slot = i;
+					break;
+				}
+			}
+			if (slot == entries.size() && entries.size() >= capacity) {
+				slot = 0;
+				for (size_t i = 1; i < entries.size(); ++i) {
+					if (entries[i].lastUse < entries[slot].lastUse) {
+						slot = i;
+					}
+				}
+				++evictions;
+			}
+
+			Entry entry { resource, Lifetime::Track(resource), std::move(views), ++useCounter };
+			if (slot == entries.size()) {
+				entries.push_back(std::move(entry));
+			} else {
+				entries[slot] = std::move(entry);
+			}
+			return entries[slot].views;
+		}
+
+		void Clear() {
+			entries.clear();
+		}
+
+		size_t Size() const { return entries.size(); }
+		size_t Capacity() const { return capacity; }
+		// entries replaced because the cache was full, and dropped because their resource was gone
+		uint64_t Evictions() const { return evictions; }
+		uint64_t StaleEntries() const { return staleEntries; }
+
+	private:
+		struct Entry {
+			Resource *resource;
+			typename Lifetime::Token token;
+			Views views;
+			uint64_t lastUse;
+		};
+
+		void Remove(size_t index) {
+			if (index + 1 != entries.size()) {
+				entries[index] = std::move(entries.back());
+			}
+			entries.pop_back();
+		}
+
+		std::vector<Entry> entries;
+		size_t capacity;
+		uint64_t useCounter = 0;
+		uint64_t evictions = 0;
+		uint64_t staleEntries = 0;
+	};
+}
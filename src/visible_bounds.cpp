@@ -0,0 +1,221 @@
+#include "visible_bounds.h"
+#include "hrm/radial_density_mask.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace vrperfkit {
+	namespace {
+		struct Interval {
+			float start;
+			float end;
+		};
+
+		// the span of the horizontal line at v inside the triangle, in pixels
+		bool TriangleRowInterval(const Point<float> *p, float v, uint32_t width, Interval &interval) {
+			float lo = INFINITY, hi = -INFINITY;
+			for (int e = 0; e < 3; ++e) {
+				const Point<float> &a = p[e], &b = p[(e + 1) % 3];
+				if ((a.y - v) * (b.y - v) > 0) {
+					continue;
+				}
+				if (a.y == b.y) {
+					lo = std::min({lo, a.x, b.x});
+					hi = std::max({hi, a.x, b.x});
+				} else {
+					float u = a.x + (v - a.y) / (b.y - a.y) * (b.x - a.x);
+					lo = std::min(lo, u);
+					hi = std::max(hi, u);
+				}
+			}
+			if (lo > hi) {
+				return false;
+			}
+			interval = Interval{ lo * width, hi * width };
+			return true;
+		}
+
+		Viewport FlipRect(const Viewport &rect, uint32_t width, uint32_t height, bool flipX, bool flipY) {
+			Viewport flipped = rect;
+			if (flipX) {
+				flipped.x = width - rect.x - rect.width;
+			}
+			if (flipY) {
+				flipped.y = height - rect.y - rect.height;
+			}
+			return flipped;
+		}
+	}
+
+	Viewport HiddenAreaMeshVisibleRect(const std::vector<Point<float>> &triangles, uint32_t width, uint32_t height, bool flipX, bool flipY) {
+		if (triangles.size() < 3) {
+			return Viewport{ 0, 0, width, height };
+		}
+
+		int64_t minX = width, maxX = -1, minY = height, maxY = -1;
+		std::vector<Interval> intervals;
+		for (uint32_t y = 0; y < height; ++y) {
+			float v = (y + 0.5f) / height;
+			intervals.clear();
+			for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+				Interval interval;
+				if (TriangleRowInterval(&triangles[i], v, width, interval)) {
+					intervals.push_back(interval);
+				}
+			}
+
+			// the first pixel from the left whose centre no interval covers
+			std::sort(intervals.begin(), intervals.end(), [](const Interval &a, const Interval &b) { return a.start < b.start; });
+			int64_t first = 0;
+			for (const Interval &interval : intervals) {
+				if (interval.start > first + 0.5f) {
+					break;
+				}
+				if (interval.end >= first + 0.5f) {
+					first = (int64_t)std::floor(interval.end - 0.5f) + 1;
+				}
+			}
+			if (first >= width) {
+				continue;
+			}
+			// and from the right
+			std::sort(intervals.begin(), intervals.end(), [](const Interval &a, const Interval &b) { return a.end > b.end; });
+			int64_t last = width - 1;
+			for (const Interval &interval : intervals) {
+				if (interval.end < last + 0.5f) {
+					break;
+				}
+				if (interval.start <= last + 0.5f) {
+					last = (int64_t)std::ceil(interval.start - 0.5f) - 1;
+				}
+			}
+
+			minX = std::min(minX, first);
+			maxX = std::max(maxX, last);
+			minY = std::min(minY, (int64_t)y);
+			maxY = y;
+		}
+
+		if (maxY < 0) {
+			return Viewport{ 0, 0, 0, 0 };
+		}
+		Viewport rect { (uint32_t)minX, (uint32_t)minY, (uint32_t)(maxX - minX + 1), (uint32_t)(maxY - minY + 1) };
+		return FlipRect(rect, width, height, flipX, flipY);
+	}
+
+	Viewport EdgeRadiusVisibleRect(const Point<float> &projectionCenter, float edgeRadius, uint32_t width, uint32_t height) {
+		RdmMaskingConstants constants;
+		SetupRdmMaskingConstants(constants, 0.f, nullptr, edgeRadius, width, height, projectionCenter, false);
+		uint32_t minX = width, maxX = 0, minY = height, maxY = 0;
+		bool any = false;
+		for (uint32_t y = 0; y < height; ++y) {
+			uint32_t first, end;
+			if (HrmUnmaskedSpan(constants, 0, width, y, first, end)) {
+				minX = std::min(minX, first);
+				maxX = std::max(maxX, end);
+				minY = std::min(minY, y);
+				maxY = y + 1;
+				any = true;
+			}
+		}
+		return any ? Viewport{ minX, minY, maxX - minX, maxY - minY } : Viewport{ 0, 0, 0, 0 };
+	}
+
+	Viewport IntersectRects(const Viewport &a, const Viewport &b) {
+		uint32_t x0 = std::max(a.x, b.x), y0 = std::max(a.y, b.y);
+		uint32_t x1 = std::min(a.x + a.width, b.x + b.width), y1 = std::min(a.y + a.height, b.y + b.height);
+		if (x0 >= x1 || y0 >= y1) {
+			return Viewport{ 0, 0, 0, 0 };
+		}
+		return Viewport{ x0, y0, x1 - x0, y1 - y0 };
+	}
+
+	Viewport GrowRect(const Viewport &rect, uint32_t margin, uint32_t width, uint32_t height) {
+		if (rect.width == 0 || rect.height == 0) {
+			return rect;
+		}
+		uint32_t x0 = rect.x - std::min(rect.x, margin), y0 = rect.y - std::min(rect.y, margin);
+		uint32_t x1 = std::min(rect.x + rect.width + margin, width), y1 = std::min(rect.y + rect.height + margin, height);
+		return Viewport{ x0, y0, x1 - x0, y1 - y0 };
+	}
+
+	namespace {
+		// The radius tests decide per thread group, counted from the output viewport: 16x16 for FSR and
+		// CAS, 32x24 and 32x32 for NIS. A crop starting on these keeps the groups of the full upscale.
+		const uint32_t kCropTileWidth = 32;
+		const uint32_t kCropTileHeight = 96;
+
+		// the upscalers' scale factors, as computed from the viewport sizes, are the same for both
+		bool SameScale(uint32_t in, uint32_t out, uint32_t croppedIn, uint32_t croppedOut) {
+			return (float)in / (float)out == (float)croppedIn / (float)croppedOut
+				&& (float)in * (1.f / (float)out) == (float)croppedIn * (1.f / (float)croppedOut);
+		}
+
+		// Crops [start, end) of an input axis of size in, upscaled to out. Returns the cropped input
+		// range and its output start, on the grid where input and output pixel edges meet.
+		void CropAxis(uint32_t in, uint32_t out, uint32_t tileSize, uint32_t start, uint32_t end, uint32_t &inStart, uint32_t &inEnd, uint32_t &outStart) {
+			uint32_t g = std::gcd(in, out);
+			uint64_t inStep = in / g, outStep = out / g;
+			uint64_t outTileStep = std::lcm(outStep, (uint64_t)tileSize);
+			uint64_t inTileStep = outTileStep / outStep * inStep;
+			inStart = (uint32_t)std::min<uint64_t>(start / inTileStep * inTileStep, in);
+			inEnd = (uint32_t)std::min<uint64_t>((end + inStep - 1) / inStep * inStep, in);
+			// grow the crop until rounding gives the same scale, which it always does for the whole axis
+			while (inEnd < in && inStart < inEnd && !SameScale(in, out, inEnd - inStart, (uint32_t)((uint64_t)(inEnd - inStart) * out / in))) {
+				inEnd = (uint32_t)std::min<uint64_t>(inEnd + inStep, in);
+			}
+			outStart = (uint32_t)((uint64_t)inStart * out / in);
+		}
+	}
+
+	bool CropUpscale(const Viewport &inputViewport, const Viewport &outputViewport, const Viewport &visibleRect,
+			const Point<float> &projectionCenter, UpscaleCrop &crop) {
+		if (visibleRect.width == 0 || visibleRect.height == 0 || inputViewport.width == 0 || inputViewport.height == 0) {
+			return false;
+		}
+
+		uint32_t x0, x1, outX, y0, y1, outY;
+		CropAxis(inputViewport.width, outputViewport.width, kCropTileWidth, visibleRect.x, visibleRect.x + visibleRect.width, x0, x1, outX);
+		CropAxis(inputViewport.height, outputViewport.height, kCropTileHeight, visibleRect.y, visibleRect.y + visibleRect.height, y0, y1, outY);
+		if (x0 >= x1 || y0 >= y1 || (x0 == 0 && y0 == 0 && x1 == inputViewport.width && y1 == inputViewport.height)) {
+			return false;
+		}
+
+		crop.inputViewport = Viewport{ inputViewport.x + x0, inputViewport.y + y0, x1 - x0, y1 - y0 };
+		crop.outputViewport.x = outputViewport.x + outX;
+		crop.outputViewport.y = outputViewport.y + outY;
+		crop.outputViewport.width = (uint32_t)((uint64_t)(x1 - x0) * outputViewport.width / inputViewport.width);
+		crop.outputViewport.height = (uint32_t)((uint64_t)(y1 - y0) * outputViewport.height / inputViewport.height);
+		// The radius tests truncate the centre to whole output pixels. Placing it in the middle of the
+		// full upscale's centre pixel keeps rounding from moving it to a neighbour.
+		float centerX = std::floor(projectionCenter.x * outputViewport.width) - outX;
+		float centerY = std::floor(projectionCenter.y * outputViewport.height) - outY;
+		crop.projectionCenter.x = (centerX + 0.5f) / crop.outputViewport.width;
+		crop.projectionCenter.y = (centerY + 0.5f) / crop.outputViewport.height;
+		crop.radiusScale = (float)inputViewport.height / (y1 - y0);
+		return true;
+	}
+
+	FovTangents CropFovTangents(const FovTangents &fov, const Viewport &viewport, const Viewport &crop, bool originAtBottom) {
+		// the tangents change linearly across the viewport
+		float width = fov.left + fov.right;
+		float height = fov.up + fov.down;
+		float left = (float)(crop.x - viewport.x) / viewport.width;
+		float right = (float)(crop.x + crop.width - viewport.x) / viewport.width;
+		float top = (float)(crop.y - viewport.y) / viewport.height;
+		float bottom = (float)(crop.y + crop.height - viewport.y) / viewport.height;
+		if (originAtBottom) {
+			float flippedTop = 1.f - bottom;
+			bottom = 1.f - top;
+			top = flippedTop;
+		}
+
+		FovTangents cropped;
+		cropped.left = fov.left - left * width;
+		cropped.right = right * width - fov.left;
+		cropped.up = fov.up - top * height;
+		cropped.down = bottom * height - fov.up;
+		return cropped;
+	}
+}
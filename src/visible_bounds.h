@@ -0,0 +1,51 @@
+#pragma once
+#include "types.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace vrperfkit {
+	// Rects in this file are in pixels of one eye, relative to the eye's viewport. An empty rect
+	// (width or height 0) means no pixel of the eye can be seen.
+
+	// Bounds of the pixels of a width x height eye whose centres the runtime's hidden area mesh leaves
+	// uncovered. triangles is the mesh as passed to D3D11PostProcessor::SetHiddenAreaMesh, in eye
+	// texture coordinates with the origin at the top left; flipX and flipY mirror the result for
+	// eyes stored mirrored in their texture, as with flipped OpenVR texture bounds.
+	Viewport HiddenAreaMeshVisibleRect(const std::vector<Point<float>> &triangles, uint32_t width, uint32_t height, bool flipX, bool flipY);
+
+	// Bounds of the pixels the hidden radial mask leaves unmasked at edgeRadius, see IsHrmMasked.
+	// projectionCenter is relative to the eye, as D3D11PostProcessInput::projectionCenter.
+	Viewport EdgeRadiusVisibleRect(const Point<float> &projectionCenter, float edgeRadius, uint32_t width, uint32_t height);
+
+	Viewport IntersectRects(const Viewport &a, const Viewport &b);
+	// rect grown by margin pixels on each side, clipped to width x height
+	Viewport GrowRect(const Viewport &rect, uint32_t margin, uint32_t width, uint32_t height);
+
+	// The part of an upscale from inputViewport to outputViewport that covers visibleRect (relative
+	// to inputViewport). Its edges are moved outwards until they fall on input and output pixels at
+	// once, the output start on the thread groups of the radius test and the scale rounds as for the
+	// whole viewport, so that upscaling the cropped viewports gives exactly the pixels of the full
+	// upscale. projectionCenter and
+	// radiusScale, which multiplies upscaling.radius, are relative to the cropped viewports.
+	struct UpscaleCrop {
+		Viewport inputViewport;
+		Viewport outputViewport;
+		Point<float> projectionCenter;
+		float radiusScale;
+	};
+	// false if the crop is the whole viewport, as when the scale has no small enough common grid
+	bool CropUpscale(const Viewport &inputViewport, const Viewport &outputViewport, const Viewport &visibleRect,
+		const Point<float> &projectionCenter, UpscaleCrop &crop);
+
+	// Field of view of a viewport cropped from a full one, as the tangents of the angles from the
+	// view direction to its left, right, top and bottom edge (ovrFovPort). originAtBottom is set
+	// when the rows of the texture count from the bottom of the image.
+	struct FovTangents {
+		float left;
+		float right;
+		float up;
+		float down;
+	};
+	FovTangents CropFovTangents(const FovTangents &fov, const Viewport &viewport, const Viewport &crop, bool originAtBottom);
+}